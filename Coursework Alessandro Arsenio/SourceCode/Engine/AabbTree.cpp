@@ -0,0 +1,840 @@
+#include "pch.h"
+#include "AabbTree.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+using namespace DX;
+
+namespace
+{
+	const int BuildBinCount = 12;
+
+	//past this depth the build splits at the median, so degenerate input cannot recurse deeply
+	const int MaxSurfaceAreaDepth = 48;
+
+	Aabb Union(const Aabb& a, const Aabb& b)
+	{
+		Aabb result;
+		for (int i = 0; i < 3; i++)
+		{
+			result.min[i] = std::min(a.min[i], b.min[i]);
+			result.max[i] = std::max(a.max[i], b.max[i]);
+		}
+		return result;
+	}
+
+	float Area(const Aabb& box)
+	{
+		float x = box.max[0] - box.min[0];
+		float y = box.max[1] - box.min[1];
+		float z = box.max[2] - box.min[2];
+		return 2.0f * (x * y + y * z + z * x);
+	}
+
+	bool Contains(const Aabb& outer, const Aabb& inner)
+	{
+		return outer.min[0] <= inner.min[0] && outer.min[1] <= inner.min[1] && outer.min[2] <= inner.min[2]
+			&& inner.max[0] <= outer.max[0] && inner.max[1] <= outer.max[1] && inner.max[2] <= outer.max[2];
+	}
+
+	float Centroid(const Aabb& box, int axis)
+	{
+		return (box.min[axis] + box.max[axis]) * 0.5f;
+	}
+
+	float DistanceSquared(const float point[3], const Aabb& box)
+	{
+		float distance = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			float d = std::max(std::max(box.min[i] - point[i], point[i] - box.max[i]), 0.0f);
+			distance += d * d;
+		}
+		return distance;
+	}
+
+	enum FrustumResult
+	{
+		Outside,
+		Intersecting,
+		Inside,
+	};
+
+	FrustumResult TestFrustum(const Meshlets::Frustum& frustum, const Aabb& box)
+	{
+		FrustumResult result = Inside;
+		for (const auto& plane : frustum.planes)
+		{
+			//the corner furthest along the plane normal, and the one furthest against it
+			float ahead = plane[3], behind = plane[3];
+			for (int i = 0; i < 3; i++)
+			{
+				ahead += plane[i] * (plane[i] >= 0 ? box.max[i] : box.min[i]);
+				behind += plane[i] * (plane[i] >= 0 ? box.min[i] : box.max[i]);
+			}
+			if (ahead < 0)
+			{
+				return Outside;
+			}
+			if (behind < 0)
+			{
+				result = Intersecting;
+			}
+		}
+		return result;
+	}
+
+	// Distance along the ray to where it enters the box, or false when it misses within maxDistance.
+	bool IntersectRay(const float origin[3], const float direction[3], float maxDistance, const Aabb& box, float& distance)
+	{
+		float enter = 0;
+		float exit = maxDistance;
+		for (int i = 0; i < 3; i++)
+		{
+			if (direction[i] == 0)
+			{
+				//parallel to the slab, inside it or never
+				if (origin[i] < box.min[i] || origin[i] > box.max[i])
+				{
+					return false;
+				}
+				continue;
+			}
+			float inverse = 1.0f / direction[i];
+			float t1 = (box.min[i] - origin[i]) * inverse;
+			float t2 = (box.max[i] - origin[i]) * inverse;
+			enter = std::max(enter, std::min(t1, t2));
+			exit = std::min(exit, std::max(t1, t2));
+			if (enter > exit)
+			{
+				return false;
+			}
+		}
+		distance = enter;
+		return true;
+	}
+
+	bool HitLess(const AabbRayHit& left, const AabbRayHit& right)
+	{
+		return left.distance < right.distance;
+	}
+}
+
+AabbTree::AabbTree(float margin) :
+	m_root(NullNode),
+	m_freeList(NullNode),
+	m_proxyCount(0),
+	m_margin(margin)
+{
+}
+
+int32_t AabbTree::CreateProxy(const Aabb& box, void* userData)
+{
+	int32_t proxy = AllocateNode();
+	Node& node = m_nodes[proxy];
+	node.tightBox = box;
+	node.box = box;
+	for (int i = 0; i < 3; i++)
+	{
+		node.box.min[i] -= m_margin;
+		node.box.max[i] += m_margin;
+	}
+	node.userData = userData;
+	node.height = 0;
+	InsertLeaf(proxy);
+	m_proxyCount++;
+	return proxy;
+}
+
+void AabbTree::DestroyProxy(int32_t proxy)
+{
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	m_proxyCount--;
+}
+
+bool AabbTree::MoveProxy(int32_t proxy, const Aabb& box)
+{
+	Node& node = m_nodes[proxy];
+	node.tightBox = box;
+	if (Contains(node.box, box))
+	{
+		return false;
+	}
+
+	RemoveLeaf(proxy);
+	Node& moved = m_nodes[proxy];
+	moved.box = box;
+	for (int i = 0; i < 3; i++)
+	{
+		moved.box.min[i] -= m_margin;
+		moved.box.max[i] += m_margin;
+	}
+	InsertLeaf(proxy);
+	return true;
+}
+
+void AabbTree::CreateProxies(const Aabb* boxes, void* const* userData, size_t count, int32_t* proxies)
+{
+	//leaves are only linked by the rebuild, which has to visit every proxy anyway
+	for (size_t i = 0; i < count; i++)
+	{
+		int32_t proxy = AllocateNode();
+		Node& node = m_nodes[proxy];
+		node.tightBox = boxes[i];
+		node.box = boxes[i];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			node.box.min[axis] -= m_margin;
+			node.box.max[axis] += m_margin;
+		}
+		node.userData = userData != nullptr ? userData[i] : nullptr;
+		node.height = 0;
+		node.parent = NullNode;
+		proxies[i] = proxy;
+	}
+	m_proxyCount += count;
+	Rebuild();
+}
+
+void AabbTree::Rebuild()
+{
+	//keep the leaves, free the inner nodes and build new ones over the leaves
+	m_buildLeaves.clear();
+	for (int32_t i = 0; i < (int32_t)m_nodes.size(); i++)
+	{
+		if (m_nodes[i].height == 0)
+		{
+			m_buildLeaves.push_back(i);
+		}
+		else if (m_nodes[i].height > 0)
+		{
+			FreeNode(i);
+		}
+	}
+	m_root = NullNode;
+	if (!m_buildLeaves.empty())
+	{
+		m_root = BuildRange(m_buildLeaves.data(), m_buildLeaves.size(), 0);
+		m_nodes[m_root].parent = NullNode;
+	}
+}
+
+void AabbTree::Clear()
+{
+	m_nodes.clear();
+	m_root = NullNode;
+	m_freeList = NullNode;
+	m_proxyCount = 0;
+}
+
+void* AabbTree::GetUserData(int32_t proxy) const
+{
+	return m_nodes[proxy].userData;
+}
+
+const Aabb& AabbTree::GetBox(int32_t proxy) const
+{
+	return m_nodes[proxy].tightBox;
+}
+
+const Aabb& AabbTree::GetFatBox(int32_t proxy) const
+{
+	return m_nodes[proxy].box;
+}
+
+void AabbTree::QueryFrustum(const Meshlets::Frustum& frustum, std::vector<int32_t>& proxies) const
+{
+	if (m_root == NullNode)
+	{
+		return;
+	}
+
+	//a subtree entirely inside is pushed complemented, its leaves are taken without testing
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while (!m_stack.empty())
+	{
+		int32_t entry = m_stack.back();
+		m_stack.pop_back();
+		if (entry < 0)
+		{
+			const Node& node = m_nodes[~entry];
+			if (node.height == 0)
+			{
+				proxies.push_back(~entry);
+			}
+			else
+			{
+				m_stack.push_back(~node.child1);
+				m_stack.push_back(~node.child2);
+			}
+			continue;
+		}
+
+		const Node& node = m_nodes[entry];
+		if (node.height == 0)
+		{
+			if (TestFrustum(frustum, node.tightBox) != Outside)
+			{
+				proxies.push_back(entry);
+			}
+			continue;
+		}
+		FrustumResult result = TestFrustum(frustum, node.box);
+		if (result == Inside)
+		{
+			m_stack.push_back(~entry);
+		}
+		else if (result == Intersecting)
+		{
+			m_stack.push_back(node.child1);
+			m_stack.push_back(node.child2);
+		}
+	}
+}
+
+void AabbTree::QuerySphere(const float center[3], float radius, std::vector<int32_t>& proxies) const
+{
+	if (m_root == NullNode)
+	{
+		return;
+	}
+	float radiusSquared = radius * radius;
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while (!m_stack.empty())
+	{
+		int32_t index = m_stack.back();
+		m_stack.pop_back();
+		const Node& node = m_nodes[index];
+		if (node.height == 0)
+		{
+			if (DistanceSquared(center, node.tightBox) <= radiusSquared)
+			{
+				proxies.push_back(index);
+			}
+		}
+		else if (DistanceSquared(center, node.box) <= radiusSquared)
+		{
+			m_stack.push_back(node.child1);
+			m_stack.push_back(node.child2);
+		}
+	}
+}
+
+void AabbTree::QueryRay(const float origin[3], const float direction[3], float maxDistance, std::vector<AabbRayHit>& hits) const
+{
+	if (m_root == NullNode)
+	{
+		return;
+	}
+	size_t first = hits.size();
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while (!m_stack.empty())
+	{
+		int32_t index = m_stack.back();
+		m_stack.pop_back();
+		const Node& node = m_nodes[index];
+		float distance;
+		if (node.height == 0)
+		{
+			if (IntersectRay(origin, direction, maxDistance, node.tightBox, distance))
+			{
+				AabbRayHit hit = { index, distance };
+				hits.push_back(hit);
+			}
+		}
+		else if (IntersectRay(origin, direction, maxDistance, node.box, distance))
+		{
+			m_stack.push_back(node.child1);
+			m_stack.push_back(node.child2);
+		}
+	}
+
+	//picking wants the closest first
+	std::sort(hits.begin() + first, hits.end(), HitLess);
+}
+
+void AabbTree::QueryNearest(const float point[3], size_t count, std::vector<AabbNearest>& nearest) const
+{
+	if (m_root == NullNode || count == 0)
+	{
+		return;
+	}
+
+	//best first: inner nodes are queued by the distance to their box, leaves complemented by the
+	//distance to their own box, so a leaf reaching the front is closer than anything left
+	typedef std::pair<float, int32_t> Entry;
+	std::greater<Entry> closer;
+	m_queue.clear();
+	auto push = [&](int32_t index)
+	{
+		const Node& node = m_nodes[index];
+		if (node.height == 0)
+		{
+			m_queue.push_back(Entry(DistanceSquared(point, node.tightBox), ~index));
+		}
+		else
+		{
+			m_queue.push_back(Entry(DistanceSquared(point, node.box), index));
+		}
+		std::push_heap(m_queue.begin(), m_queue.end(), closer);
+	};
+
+	push(m_root);
+	size_t found = 0;
+	while (!m_queue.empty() && found < count)
+	{
+		std::pop_heap(m_queue.begin(), m_queue.end(), closer);
+		Entry entry = m_queue.back();
+		m_queue.pop_back();
+		if (entry.second < 0)
+		{
+			AabbNearest result = { ~entry.second, entry.first };
+			nearest.push_back(result);
+			found++;
+		}
+		else
+		{
+			push(m_nodes[entry.second].child1);
+			push(m_nodes[entry.second].child2);
+		}
+	}
+}
+
+size_t AabbTree::GetProxyCount() const
+{
+	return m_proxyCount;
+}
+
+int32_t AabbTree::GetHeight() const
+{
+	return m_root != NullNode ? m_nodes[m_root].height : 0;
+}
+
+float AabbTree::GetAreaRatio() const
+{
+	if (m_root == NullNode)
+	{
+		return 0;
+	}
+	float rootArea = Area(m_nodes[m_root].box);
+	float total = 0;
+	for (const Node& node : m_nodes)
+	{
+		if (node.height > 0)
+		{
+			total += Area(node.box);
+		}
+	}
+	return rootArea > 0 ? total / rootArea : 0;
+}
+
+bool AabbTree::Validate() const
+{
+	size_t leaves = 0;
+	if (m_root != NullNode && !ValidateNode(m_root, NullNode, leaves))
+	{
+		return false;
+	}
+	size_t free = 0;
+	for (int32_t node = m_freeList; node != NullNode; node = m_nodes[node].parent)
+	{
+		free++;
+	}
+	size_t inner = leaves > 0 ? leaves - 1 : 0;
+	return leaves == m_proxyCount && leaves + inner + free == m_nodes.size();
+}
+
+int32_t AabbTree::AllocateNode()
+{
+	int32_t index;
+	if (m_freeList != NullNode)
+	{
+		index = m_freeList;
+		m_freeList = m_nodes[index].parent;
+	}
+	else
+	{
+		index = (int32_t)m_nodes.size();
+		m_nodes.emplace_back();
+	}
+	Node& node = m_nodes[index];
+	node.userData = nullptr;
+	node.parent = NullNode;
+	node.child1 = NullNode;
+	node.child2 = NullNode;
+	node.height = 0;
+	return index;
+}
+
+void AabbTree::FreeNode(int32_t index)
+{
+	Node& node = m_nodes[index];
+	node.parent = m_freeList;
+	node.height = -1;
+	m_freeList = index;
+}
+
+void AabbTree::InsertLeaf(int32_t leaf)
+{
+	if (m_root == NullNode)
+	{
+		m_root = leaf;
+		m_nodes[leaf].parent = NullNode;
+		return;
+	}
+
+	int32_t sibling = FindBestSibling(m_nodes[leaf].box);
+
+	//a new parent takes the sibling's place, with the sibling and the leaf under it
+	int32_t oldParent = m_nodes[sibling].parent;
+	int32_t newParent = AllocateNode();
+	Node& parent = m_nodes[newParent];
+	parent.parent = oldParent;
+	parent.box = Union(m_nodes[leaf].box, m_nodes[sibling].box);
+	parent.height = m_nodes[sibling].height + 1;
+	parent.child1 = sibling;
+	parent.child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent != NullNode)
+	{
+		if (m_nodes[oldParent].child1 == sibling)
+		{
+			m_nodes[oldParent].child1 = newParent;
+		}
+		else
+		{
+			m_nodes[oldParent].child2 = newParent;
+		}
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	Refit(oldParent);
+}
+
+void AabbTree::RemoveLeaf(int32_t leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = NullNode;
+		return;
+	}
+
+	//the sibling takes the parent's place
+	int32_t parent = m_nodes[leaf].parent;
+	int32_t grandParent = m_nodes[parent].parent;
+	int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+	if (grandParent != NullNode)
+	{
+		if (m_nodes[grandParent].child1 == parent)
+		{
+			m_nodes[grandParent].child1 = sibling;
+		}
+		else
+		{
+			m_nodes[grandParent].child2 = sibling;
+		}
+		m_nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+		Refit(grandParent);
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].parent = NullNode;
+		FreeNode(parent);
+	}
+	m_nodes[leaf].parent = NullNode;
+}
+
+int32_t AabbTree::FindBestSibling(const Aabb& box)
+{
+	//pairing with a node costs the area of the new parent plus the area every ancestor grows by.
+	//Walk down towards the child with the lower bound on that cost, stopping once neither child can
+	//beat the best node seen; a full branch and bound finds slightly better siblings for a lot more work.
+	float leafArea = Area(box);
+	int32_t best = m_root;
+	float directCost = Area(Union(box, m_nodes[m_root].box));
+	float bestCost = directCost;
+	float inheritedCost = 0;
+
+	int32_t index = m_root;
+	while (m_nodes[index].height > 0)
+	{
+		const Node& node = m_nodes[index];
+		float cost = directCost + inheritedCost;
+		if (cost < bestCost)
+		{
+			best = index;
+			bestCost = cost;
+		}
+		inheritedCost += directCost - Area(node.box);
+
+		//a leaf child's cost is exact, an inner child's children could shrink its share by up to its own area
+		int32_t children[2] = { node.child1, node.child2 };
+		float childDirect[2];
+		float lowerCost[2];
+		for (int i = 0; i < 2; i++)
+		{
+			const Node& child = m_nodes[children[i]];
+			childDirect[i] = Area(Union(box, child.box));
+			if (child.height == 0)
+			{
+				float childCost = childDirect[i] + inheritedCost;
+				if (childCost < bestCost)
+				{
+					best = children[i];
+					bestCost = childCost;
+				}
+				lowerCost[i] = std::numeric_limits<float>::max();
+			}
+			else
+			{
+				lowerCost[i] = inheritedCost + childDirect[i] + std::min(leafArea - Area(child.box), 0.0f);
+			}
+		}
+
+		if (lowerCost[0] >= bestCost && lowerCost[1] >= bestCost)
+		{
+			break;
+		}
+		int next = lowerCost[1] < lowerCost[0] ? 1 : 0;
+		index = children[next];
+		directCost = childDirect[next];
+	}
+	return best;
+}
+
+void AabbTree::Refit(int32_t index)
+{
+	while (index != NullNode)
+	{
+		Rotate(index);
+		Node& node = m_nodes[index];
+		const Node& child1 = m_nodes[node.child1];
+		const Node& child2 = m_nodes[node.child2];
+		node.height = 1 + std::max(child1.height, child2.height);
+		node.box = Union(child1.box, child2.box);
+		index = node.parent;
+	}
+}
+
+void AabbTree::Rotate(int32_t indexA)
+{
+	//swap one child of a with a grandchild under the other child when that shrinks the other child's
+	//box the most; a's own box covers the same leaves either way
+	const Node& a = m_nodes[indexA];
+	if (a.height < 2)
+	{
+		return;
+	}
+
+	int32_t swapChild = NullNode;
+	int32_t swapGrandChild = NullNode;
+	float bestGain = 0;
+	int32_t children[2] = { a.child1, a.child2 };
+	for (int i = 0; i < 2; i++)
+	{
+		const Node& child = m_nodes[children[i]];
+		const Node& other = m_nodes[children[1 - i]];
+		if (other.height == 0)
+		{
+			continue;
+		}
+		float otherArea = Area(other.box);
+		int32_t grandChildren[2] = { other.child1, other.child2 };
+		for (int j = 0; j < 2; j++)
+		{
+			//the grandchild moves up, the child takes its place next to the remaining grandchild
+			float gain = otherArea - Area(Union(child.box, m_nodes[grandChildren[1 - j]].box));
+			if (gain > bestGain)
+			{
+				bestGain = gain;
+				swapChild = children[i];
+				swapGrandChild = grandChildren[j];
+			}
+		}
+	}
+	if (swapChild == NullNode)
+	{
+		return;
+	}
+
+	int32_t indexOther = m_nodes[swapGrandChild].parent;
+	Node& node = m_nodes[indexA];
+	Node& other = m_nodes[indexOther];
+	if (node.child1 == swapChild)
+	{
+		node.child1 = swapGrandChild;
+	}
+	else
+	{
+		node.child2 = swapGrandChild;
+	}
+	if (other.child1 == swapGrandChild)
+	{
+		other.child1 = swapChild;
+	}
+	else
+	{
+		other.child2 = swapChild;
+	}
+	m_nodes[swapGrandChild].parent = indexA;
+	m_nodes[swapChild].parent = indexOther;
+	other.box = Union(m_nodes[other.child1].box, m_nodes[other.child2].box);
+	other.height = 1 + std::max(m_nodes[other.child1].height, m_nodes[other.child2].height);
+}
+
+int32_t AabbTree::BuildRange(int32_t* leaves, size_t count, int depth)
+{
+	if (count == 1)
+	{
+		return leaves[0];
+	}
+
+	//split along the axis the centroids spread most on
+	float centroidMin[3], centroidMax[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		centroidMin[axis] = std::numeric_limits<float>::max();
+		centroidMax[axis] = -std::numeric_limits<float>::max();
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		const Aabb& box = m_nodes[leaves[i]].box;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float centroid = Centroid(box, axis);
+			centroidMin[axis] = std::min(centroidMin[axis], centroid);
+			centroidMax[axis] = std::max(centroidMax[axis], centroid);
+		}
+	}
+	int axis = 0;
+	for (int i = 1; i < 3; i++)
+	{
+		if (centroidMax[i] - centroidMin[i] > centroidMax[axis] - centroidMin[axis])
+		{
+			axis = i;
+		}
+	}
+	float extent = centroidMax[axis] - centroidMin[axis];
+
+	size_t split = 0;
+	if (extent > 0 && depth < MaxSurfaceAreaDepth)
+	{
+		//bin the centroids and pick the boundary with the least area * count on both sides
+		float binScale = BuildBinCount / extent;
+		auto binOf = [&](int32_t leaf)
+		{
+			int bin = (int)((Centroid(m_nodes[leaf].box, axis) - centroidMin[axis]) * binScale);
+			return std::min(bin, BuildBinCount - 1);
+		};
+		BuildBin bins[BuildBinCount];
+		for (BuildBin& bin : bins)
+		{
+			bin.count = 0;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			BuildBin& bin = bins[binOf(leaves[i])];
+			bin.box = bin.count == 0 ? m_nodes[leaves[i]].box : Union(bin.box, m_nodes[leaves[i]].box);
+			bin.count++;
+		}
+
+		float rightCost[BuildBinCount];
+		Aabb right = {};
+		uint32_t rightCount = 0;
+		for (int bin = BuildBinCount - 1; bin > 0; bin--)
+		{
+			if (bins[bin].count > 0)
+			{
+				right = rightCount == 0 ? bins[bin].box : Union(right, bins[bin].box);
+				rightCount += bins[bin].count;
+			}
+			rightCost[bin] = rightCount > 0 ? Area(right) * rightCount : 0;
+		}
+
+		float bestCost = std::numeric_limits<float>::max();
+		int bestBin = 0;
+		Aabb left = {};
+		uint32_t leftCount = 0;
+		for (int bin = 1; bin < BuildBinCount; bin++)
+		{
+			if (bins[bin - 1].count > 0)
+			{
+				left = leftCount == 0 ? bins[bin - 1].box : Union(left, bins[bin - 1].box);
+				leftCount += bins[bin - 1].count;
+			}
+			if (leftCount == 0 || leftCount == count)
+			{
+				continue;
+			}
+			float cost = Area(left) * leftCount + rightCost[bin];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestBin = bin;
+			}
+		}
+		if (bestBin > 0)
+		{
+			split = std::partition(leaves, leaves + count, [&](int32_t leaf) { return binOf(leaf) < bestBin; }) - leaves;
+		}
+	}
+	if (split == 0 || split == count)
+	{
+		split = count / 2;
+		std::nth_element(leaves, leaves + split, leaves + count, [&](int32_t left, int32_t right)
+		{
+			return Centroid(m_nodes[left].box, axis) < Centroid(m_nodes[right].box, axis);
+		});
+	}
+
+	//children first, allocating may move the nodes
+	int32_t child1 = BuildRange(leaves, split, depth + 1);
+	int32_t child2 = BuildRange(leaves + split, count - split, depth + 1);
+	int32_t index = AllocateNode();
+	Node& node = m_nodes[index];
+	node.child1 = child1;
+	node.child2 = child2;
+	node.box = Union(m_nodes[child1].box, m_nodes[child2].box);
+	node.height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+	m_nodes[child1].parent = index;
+	m_nodes[child2].parent = index;
+	return index;
+}
+
+bool AabbTree::ValidateNode(int32_t index, int32_t parent, size_t& leaves) const
+{
+	const Node& node = m_nodes[index];
+	if (node.parent != parent)
+	{
+		return false;
+	}
+	if (node.height == 0)
+	{
+		leaves++;
+		return node.child1 == NullNode && node.child2 == NullNode && Contains(node.box, node.tightBox);
+	}
+	if (node.child1 == NullNode || node.child2 == NullNode)
+	{
+		return false;
+	}
+	const Node& child1 = m_nodes[node.child1];
+	const Node& child2 = m_nodes[node.child2];
+	if (node.height != 1 + std::max(child1.height, child2.height) || !Contains(node.box, child1.box) || !Contains(node.box, child2.box))
+	{
+		return false;
+	}
+	return ValidateNode(node.child1, index, leaves) && ValidateNode(node.child2, index, leaves);
+}
@@ -0,0 +1,123 @@
+//
+// AabbTree.h - Dynamic bounding volume hierarchy for scene queries and culling
+//
+// Every object is a leaf holding its box, and every inner node the box around its two children,
+// so a query only descends into the nodes its volume touches. Leaves are fattened by a margin:
+// an object moving inside its fat box costs nothing, and one moving out of it is taken out and
+// reinserted, refitting the boxes on the way up. Insertion looks for the sibling that adds the
+// least surface area to the tree, the surface area heuristic, and tree rotations on the way
+// up swap subtrees when that shrinks their boxes. Static content can be added in bulk and built top down in one pass.
+//
+// Queries test the objects' own boxes, not the fat ones, and append proxy ids.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "Meshlets.h"
+
+namespace DX
+{
+	struct Aabb
+	{
+		float min[3];
+		float max[3];
+	};
+
+	struct AabbRayHit
+	{
+		int32_t proxy;
+		float distance;		//along the ray to where it enters the box, 0 when it starts inside
+	};
+
+	struct AabbNearest
+	{
+		int32_t proxy;
+		float distanceSquared;		//from the point to the box, 0 inside it
+	};
+
+	class AabbTree
+	{
+	public:
+		static const int32_t NullNode = -1;
+
+		// margin is how far a leaf's box is fattened on every side.
+		explicit AabbTree(float margin = 1.0f);
+
+		int32_t CreateProxy(const Aabb& box, void* userData);
+		void DestroyProxy(int32_t proxy);
+
+		// Returns true when the box left the fat box and the proxy was reinserted.
+		bool MoveProxy(int32_t proxy, const Aabb& box);
+
+		// Adds count proxies at once and rebuilds the whole tree top down, for content loaded together.
+		// proxies receives the ids, in the order of the boxes.
+		void CreateProxies(const Aabb* boxes, void* const* userData, size_t count, int32_t* proxies);
+
+		// Rebuilds the tree over the current proxies with binned surface area splits. Proxy ids stay valid.
+		void Rebuild();
+		void Clear();
+
+		void* GetUserData(int32_t proxy) const;
+		const Aabb& GetBox(int32_t proxy) const;
+		const Aabb& GetFatBox(int32_t proxy) const;
+
+		// Boxes touching the frustum, the sphere or the ray, or the count closest to point, nearest first.
+		void QueryFrustum(const Meshlets::Frustum& frustum, std::vector<int32_t>& proxies) const;
+		void QuerySphere(const float center[3], float radius, std::vector<int32_t>& proxies) const;
+		void QueryRay(const float origin[3], const float direction[3], float maxDistance, std::vector<AabbRayHit>& hits) const;
+		void QueryNearest(const float point[3], size_t count, std::vector<AabbNearest>& nearest) const;
+
+		size_t GetProxyCount() const;
+		int32_t GetHeight() const;
+
+		// Sum of the inner nodes' surface areas over the root's, what a query expects to visit.
+		float GetAreaRatio() const;
+
+		// Checks the links, heights and boxes of every node, for tests.
+		bool Validate() const;
+
+	private:
+		struct Node
+		{
+			Aabb box;				//fattened for leaves
+			Aabb tightBox;			//leaves only
+			void* userData;
+			int32_t parent;			//next free node while unused
+			int32_t child1;			//NullNode for leaves
+			int32_t child2;
+			int32_t height;			//0 for leaves, -1 while unused
+		};
+
+		struct BuildBin
+		{
+			Aabb box;
+			uint32_t count;
+		};
+
+		int32_t AllocateNode();
+		void FreeNode(int32_t node);
+		void InsertLeaf(int32_t leaf);
+		void RemoveLeaf(int32_t leaf);
+		int32_t FindBestSibling(const Aabb& box);
+		void Refit(int32_t node);
+		void Rotate(int32_t node);
+		int32_t BuildRange(int32_t* leaves, size_t count, int depth);
+		bool ValidateNode(int32_t node, int32_t parent, size_t& leaves) const;
+
+		std::vector<Node>		m_nodes;
+		int32_t					m_root;
+		int32_t					m_freeList;
+		size_t					m_proxyCount;
+		float					m_margin;
+
+		//scratch, kept between calls so queries and insertions do not allocate
+		mutable std::vector<int32_t>						m_stack;
+		mutable std::vector<std::pair<float, int32_t>>		m_queue;
+		std::vector<int32_t>								m_buildLeaves;
+	};
+}
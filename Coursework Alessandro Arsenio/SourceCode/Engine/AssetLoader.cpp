@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "AssetLoader.h"
+
+#include <wchar.h>
+
+using namespace DX;
+
+namespace
+{
+	thread_local bool t_isWorkerThread = false;
+}
+
+AssetLoader::AssetLoader(unsigned int workerCount) :
+	m_stopping(false),
+	m_start(Clock::now())
+{
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&AssetLoader::WorkerMain, this, i + 1));
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_stopping = true;
+	}
+	m_queueReady.notify_all();
+
+	//workers drain the queue before they exit, so nothing queued is dropped
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+AssetLoader::Handle AssetLoader::Load(const std::wstring& name, std::function<void()> load)
+{
+	Job job;
+	job.name = name;
+	job.task = std::packaged_task<void()>(std::move(load));
+	Handle handle = job.task.get_future().share();
+	m_pending.push_back(handle);
+
+	if (m_workers.empty())
+	{
+		Run(job, 0);
+		return handle;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_queue.push_back(std::move(job));
+	}
+	m_queueReady.notify_one();
+	return handle;
+}
+
+void AssetLoader::WaitAll()
+{
+	for (auto& handle : m_pending)
+	{
+		handle.wait();
+	}
+
+	std::vector<Handle> pending;
+	pending.swap(m_pending);
+	for (auto& handle : pending)
+	{
+		handle.get();
+	}
+}
+
+void AssetLoader::LogTimeline() const
+{
+	std::lock_guard<std::mutex> lock(m_timelineMutex);
+
+	std::vector<TimelineEntry> timeline = m_timeline;
+	std::sort(timeline.begin(), timeline.end(), [](const TimelineEntry& a, const TimelineEntry& b) { return a.startMs < b.startMs; });
+
+	wchar_t line[512];
+	for (const auto& entry : timeline)
+	{
+		swprintf(line, sizeof(line) / sizeof(line[0]), L"  [worker %u] %8.2f - %8.2f ms (%7.2f ms) %ls\n",
+			entry.worker, entry.startMs, entry.endMs, entry.endMs - entry.startMs, entry.name.c_str());
+#ifdef ENGINE_HEADLESS
+		fputws(line, stderr);
+#else
+		OutputDebugStringW(line);
+#endif
+	}
+}
+
+unsigned int AssetLoader::DefaultWorkerCount()
+{
+	unsigned int threads = std::thread::hardware_concurrency();
+	return threads > 1 ? threads - 1 : 1;
+}
+
+bool AssetLoader::IsWorkerThread()
+{
+	return t_isWorkerThread;
+}
+
+void AssetLoader::WorkerMain(unsigned int worker)
+{
+	t_isWorkerThread = true;
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_queueReady.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+			if (m_queue.empty())
+			{
+				return;
+			}
+			job = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+		Run(job, worker);
+	}
+}
+
+void AssetLoader::Run(Job& job, unsigned int worker)
+{
+	Clock::time_point start = Clock::now();
+	job.task();	//exceptions are stored in the future rather than thrown here
+	Clock::time_point end = Clock::now();
+
+	TimelineEntry entry;
+	entry.name = std::move(job.name);
+	entry.worker = worker;
+	entry.startMs = std::chrono::duration<double, std::milli>(start - m_start).count();
+	entry.endMs = std::chrono::duration<double, std::milli>(end - m_start).count();
+
+	std::lock_guard<std::mutex> lock(m_timelineMutex);
+	m_timeline.push_back(std::move(entry));
+}
@@ -0,0 +1,84 @@
+//
+// AssetLoader.h - Worker pool for loading assets in parallel
+//
+// Each load is a whole job: read the file, parse or decode it on the CPU and create the D3D
+// resource. ID3D11Device is free-threaded, so the device calls run on the workers as well;
+// only the immediate context has to stay on the main thread.
+//
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+	class AssetLoader
+	{
+	public:
+		typedef std::shared_future<void> Handle;
+
+		// With no workers every load runs on the calling thread as soon as it is queued.
+		explicit AssetLoader(unsigned int workerCount);
+		~AssetLoader();
+
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+
+		// Queues a load. Waiting on the handle rethrows anything the load threw.
+		Handle Load(const std::wstring& name, std::function<void()> load);
+
+		// Waits for every queued load, then rethrows the first failure.
+		void WaitAll();
+
+		// Writes when and on which worker each asset loaded to the debugger output, or to stderr headless.
+		void LogTimeline() const;
+
+		unsigned int GetWorkerCount() const		{ return (unsigned int)m_workers.size(); }
+
+		// One worker per hardware thread, leaving one for the main thread.
+		static unsigned int DefaultWorkerCount();
+
+		// True on any loader's worker threads. The pool already keeps every core busy, so work inside a
+		// load runs serially there instead of starting threads of its own.
+		static bool IsWorkerThread();
+
+	private:
+		typedef std::chrono::high_resolution_clock Clock;
+
+		struct Job
+		{
+			std::wstring name;
+			std::packaged_task<void()> task;
+		};
+
+		struct TimelineEntry
+		{
+			std::wstring name;
+			unsigned int worker;			//0 is the calling thread
+			double startMs;
+			double endMs;
+		};
+
+		void WorkerMain(unsigned int worker);
+		void Run(Job& job, unsigned int worker);
+
+		std::vector<std::thread>		m_workers;
+		std::deque<Job>					m_queue;
+		std::mutex						m_queueMutex;
+		std::condition_variable			m_queueReady;
+		bool							m_stopping;
+
+		std::vector<Handle>				m_pending;
+		std::vector<TimelineEntry>		m_timeline;
+		mutable std::mutex				m_timelineMutex;
+		Clock::time_point				m_start;
+	};
+}
@@ -0,0 +1,416 @@
+#include "pch.h"
+#include "AssetPack.h"
+#include "AssetLoader.h"
+#include "Lz4.h"
+
+#include <fstream>
+#include <future>
+#include <string.h>
+#include <thread>
+
+#ifndef _WIN32
+#include <stdlib.h>
+#endif
+
+using namespace DX;
+
+namespace
+{
+	AssetPack* s_mountedPack = nullptr;
+
+	inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool ReadWholeFile(const wchar_t* path, std::vector<uint8_t>& blob)
+	{
+		FileView view;
+		if (!view.Open(path))
+		{
+			return false;
+		}
+
+		blob.assign(view.begin(), view.end());
+		return true;
+	}
+
+	//opening a stream from a wide path is an MSVC extension, elsewhere the path goes through the locale like FileView's
+	void OpenForWriting(std::ofstream& file, const wchar_t* filename)
+	{
+		std::ios::openmode mode = std::ios::out | std::ios::binary | std::ios::trunc;
+#ifdef _WIN32
+		file.open(filename, mode);
+#else
+		size_t length = wcstombs(nullptr, filename, 0);
+		if (length != (size_t)-1)
+		{
+			std::string path(length, '\0');
+			wcstombs(&path[0], filename, length + 1);
+			file.open(path, mode);
+		}
+#endif
+	}
+}
+
+AssetPack::AssetPack() :
+	m_header(nullptr),
+	m_entries(nullptr),
+	m_blocks(nullptr)
+{
+}
+
+AssetPack::~AssetPack()
+{
+	if (s_mountedPack == this)
+	{
+		s_mountedPack = nullptr;
+	}
+	Close();
+}
+
+bool AssetPack::Open(const wchar_t* filename)
+{
+	Close();
+
+	if (!m_view.Open(filename) || m_view.size() < sizeof(Header))
+	{
+		Close();
+		return false;
+	}
+
+	//validate the header and the tables before trusting any offsets
+	const uint8_t* view = m_view.data();
+	uint64_t viewSize = m_view.size();
+	const Header* header = reinterpret_cast<const Header*>(view);
+	if (header->magic != Magic || header->version != Version
+		|| header->entryTableOffset + uint64_t(header->entryCount) * sizeof(Entry) > viewSize
+		|| header->blockTableOffset + uint64_t(header->blockCount) * sizeof(Block) > viewSize)
+	{
+		Close();
+		return false;
+	}
+
+	m_header = header;
+	m_entries = reinterpret_cast<const Entry*>(view + header->entryTableOffset);
+	m_blocks = reinterpret_cast<const Block*>(view + header->blockTableOffset);
+
+	//everything in the pack is loaded during startup, so start paging it in now
+	m_view.Prefetch();
+	return true;
+}
+
+void AssetPack::Close()
+{
+	m_view.Close();
+	m_header = nullptr;
+	m_entries = nullptr;
+	m_blocks = nullptr;
+}
+
+bool AssetPack::GetMappedData(const wchar_t* name, const uint8_t** data, size_t* size) const
+{
+	const Entry* entry = Find(HashName(name));
+	if (!entry || entry->flags != EntryStored || entry->offset + entry->size > m_view.size())
+	{
+		return false;
+	}
+
+	*data = m_view.data() + entry->offset;
+	*size = (size_t)entry->size;
+	return true;
+}
+
+bool AssetPack::ReadEntry(const wchar_t* name, std::vector<uint8_t>& blob) const
+{
+	const Entry* entry = Find(HashName(name));
+	if (!entry)
+	{
+		return false;
+	}
+
+	blob.resize((size_t)entry->size);
+
+	if (entry->flags == EntryStored)
+	{
+		if (entry->offset + entry->size > m_view.size())
+		{
+			return false;
+		}
+		memcpy(blob.data(), m_view.data() + entry->offset, (size_t)entry->size);
+		return true;
+	}
+
+	return DecompressBlocks(*entry, blob.data());
+}
+
+bool AssetPack::DecompressBlocks(const Entry& entry, uint8_t* destination) const
+{
+	if (uint64_t(entry.firstBlock) + entry.blockCount > m_header->blockCount)
+	{
+		return false;
+	}
+
+	//every block is independent, so each worker takes every Nth block of the entry
+	auto decompressRange = [this, &entry, destination](uint32_t first, uint32_t stride) -> bool
+	{
+		for (uint32_t i = first; i < entry.blockCount; i += stride)
+		{
+			const Block& block = m_blocks[entry.firstBlock + i];
+			uint64_t outputOffset = uint64_t(i) * BlockSize;
+			if (block.offset + block.compressedSize > m_view.size() || outputOffset + block.uncompressedSize > entry.size)
+			{
+				return false;
+			}
+
+			const uint8_t* source = m_view.data() + block.offset;
+			if (block.compressedSize == block.uncompressedSize)
+			{
+				memcpy(destination + outputOffset, source, block.uncompressedSize);
+			}
+			else if (!Lz4::Decompress(source, block.compressedSize, destination + outputOffset, block.uncompressedSize))
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	//on a loader worker the other workers are loading assets of their own, threads here would only oversubscribe the cores
+	uint32_t workerCount = std::min<uint32_t>(entry.blockCount, std::max(1u, std::thread::hardware_concurrency()));
+	if (workerCount <= 1 || AssetLoader::IsWorkerThread())
+	{
+		return decompressRange(0, 1);
+	}
+
+	std::vector<std::future<bool>> workers;
+	for (uint32_t w = 1; w < workerCount; w++)
+	{
+		workers.push_back(std::async(std::launch::async, decompressRange, w, workerCount));
+	}
+
+	//the calling thread takes a share of the blocks too
+	bool result = decompressRange(0, workerCount);
+	for (auto& worker : workers)
+	{
+		result = worker.get() && result;
+	}
+	return result;
+}
+
+const AssetPack::Entry* AssetPack::Find(uint64_t nameHash) const
+{
+	if (!m_header)
+	{
+		return nullptr;
+	}
+
+	//entries are sorted by hash
+	const Entry* first = m_entries;
+	const Entry* last = m_entries + m_header->entryCount;
+	const Entry* it = std::lower_bound(first, last, nameHash, [](const Entry& entry, uint64_t hash) { return entry.nameHash < hash; });
+	if (it == last || it->nameHash != nameHash)
+	{
+		return nullptr;
+	}
+	return it;
+}
+
+uint64_t AssetPack::HashName(const wchar_t* name)
+{
+	//skip a leading "./" so "./Assets/x" and "Assets/x" hash the same
+	if (name[0] == L'.' && (name[1] == L'/' || name[1] == L'\\'))
+	{
+		name += 2;
+	}
+
+	//64 bit FNV-1a over the normalised UTF-16 code units
+	uint64_t hash = 14695981039346656037ull;
+	for (; *name; name++)
+	{
+		uint16_t c = (uint16_t)*name;
+		if (c == L'\\')
+		{
+			c = L'/';
+		}
+		else if (c >= L'A' && c <= L'Z')
+		{
+			c = c - L'A' + L'a';
+		}
+
+		hash ^= (c & 0xFF);
+		hash *= 1099511628211ull;
+		hash ^= (c >> 8);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void AssetPack::Mount(AssetPack* pack)
+{
+	s_mountedPack = pack;
+}
+
+AssetPack* AssetPack::GetMounted()
+{
+	return s_mountedPack;
+}
+
+void AssetPackWriter::AddFile(const wchar_t* name, const wchar_t* sourcePath, bool compress)
+{
+	Source source;
+	source.name = name;
+	source.path = sourcePath;
+	source.compress = compress;
+	m_sources.push_back(source);
+}
+
+bool AssetPackWriter::Write(const wchar_t* filename) const
+{
+	struct Cooked
+	{
+		AssetPack::Entry entry;
+		std::vector<uint8_t> data;							//raw bytes for stored entries
+		std::vector<std::vector<uint8_t>> blocks;			//compressed (or raw) block payloads
+		std::vector<uint32_t> blockSizes;					//uncompressed size of each block
+	};
+
+	std::vector<Cooked> cooked;
+	for (const Source& source : m_sources)
+	{
+		Cooked item = {};
+		if (!ReadWholeFile(source.path.c_str(), item.data))
+		{
+			//missing sources are left out, the game falls back to the loose file
+			continue;
+		}
+
+		item.entry.nameHash = AssetPack::HashName(source.name.c_str());
+		item.entry.size = item.data.size();
+		item.entry.flags = source.compress ? AssetPack::EntryCompressed : AssetPack::EntryStored;
+
+		if (source.compress)
+		{
+			for (size_t offset = 0; offset < item.data.size(); offset += AssetPack::BlockSize)
+			{
+				size_t blockSize = std::min<size_t>(AssetPack::BlockSize, item.data.size() - offset);
+				std::vector<uint8_t> block(Lz4::CompressBound(blockSize));
+				size_t compressedSize = Lz4::Compress(item.data.data() + offset, blockSize, block.data(), block.size());
+
+				//keep incompressible blocks raw
+				if (compressedSize == 0 || compressedSize >= blockSize)
+				{
+					block.assign(item.data.begin() + offset, item.data.begin() + offset + blockSize);
+				}
+				else
+				{
+					block.resize(compressedSize);
+				}
+				item.blocks.push_back(std::move(block));
+				item.blockSizes.push_back((uint32_t)blockSize);
+			}
+			item.data.clear();
+		}
+		cooked.push_back(std::move(item));
+	}
+
+	std::sort(cooked.begin(), cooked.end(), [](const Cooked& a, const Cooked& b) { return a.entry.nameHash < b.entry.nameHash; });
+	for (size_t i = 1; i < cooked.size(); i++)
+	{
+		if (cooked[i].entry.nameHash == cooked[i - 1].entry.nameHash)
+		{
+			//duplicate name or hash collision
+			return false;
+		}
+	}
+
+	//lay out the tables, then the payload
+	uint32_t blockCount = 0;
+	for (const Cooked& item : cooked)
+	{
+		blockCount += (uint32_t)item.blocks.size();
+	}
+
+	AssetPack::Header header = {};
+	header.magic = AssetPack::Magic;
+	header.version = AssetPack::Version;
+	header.entryCount = (uint32_t)cooked.size();
+	header.blockCount = blockCount;
+	header.entryTableOffset = sizeof(AssetPack::Header);
+	header.blockTableOffset = header.entryTableOffset + cooked.size() * sizeof(AssetPack::Entry);
+
+	uint64_t payloadOffset = AlignUp(header.blockTableOffset + uint64_t(blockCount) * sizeof(AssetPack::Block), 16);
+	std::vector<AssetPack::Block> blockTable;
+	for (Cooked& item : cooked)
+	{
+		if (item.entry.flags == AssetPack::EntryStored)
+		{
+			payloadOffset = AlignUp(payloadOffset, AssetPack::StoredAlignment);
+			item.entry.offset = payloadOffset;
+			payloadOffset += item.data.size();
+		}
+		else
+		{
+			item.entry.firstBlock = (uint32_t)blockTable.size();
+			item.entry.blockCount = (uint32_t)item.blocks.size();
+			for (size_t b = 0; b < item.blocks.size(); b++)
+			{
+				AssetPack::Block block;
+				block.offset = payloadOffset;
+				block.compressedSize = (uint32_t)item.blocks[b].size();
+				block.uncompressedSize = item.blockSizes[b];
+				blockTable.push_back(block);
+				payloadOffset += block.compressedSize;
+			}
+		}
+	}
+
+	std::ofstream outFile;
+	OpenForWriting(outFile, filename);
+	if (!outFile.is_open())
+	{
+		return false;
+	}
+
+	auto writeAt = [&outFile](uint64_t offset, const void* data, size_t size)
+	{
+		//pad up to the requested offset
+		static const char zeros[AssetPack::StoredAlignment] = {};
+		uint64_t position = (uint64_t)outFile.tellp();
+		while (position < offset)
+		{
+			size_t count = (size_t)std::min<uint64_t>(sizeof(zeros), offset - position);
+			outFile.write(zeros, count);
+			position += count;
+		}
+		outFile.write(static_cast<const char*>(data), size);
+	};
+
+	writeAt(0, &header, sizeof(header));
+	for (const Cooked& item : cooked)
+	{
+		outFile.write(reinterpret_cast<const char*>(&item.entry), sizeof(item.entry));
+	}
+	if (!blockTable.empty())
+	{
+		outFile.write(reinterpret_cast<const char*>(blockTable.data()), blockTable.size() * sizeof(AssetPack::Block));
+	}
+
+	//payload is written in the same order it was laid out
+	for (const Cooked& item : cooked)
+	{
+		if (item.entry.flags == AssetPack::EntryStored)
+		{
+			writeAt(item.entry.offset, item.data.data(), item.data.size());
+		}
+		else
+		{
+			for (size_t b = 0; b < item.blocks.size(); b++)
+			{
+				writeAt(blockTable[item.entry.firstBlock + b].offset, item.blocks[b].data(), item.blocks[b].size());
+			}
+		}
+	}
+
+	return !!outFile;
+}
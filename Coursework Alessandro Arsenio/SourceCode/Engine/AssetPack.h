@@ -0,0 +1,114 @@
+//
+// AssetPack.h - Single-file indexed asset archive
+//
+// Layout of a pack file:
+//   Header
+//   Entry table, sorted by the 64-bit hash of the normalised asset name
+//   Block table, one record per 64 KB block of compressed entries
+//   Payload: LZ4 blocks, and uncompressed entries aligned to StoredAlignment so they can be
+//            handed straight to D3D from the mapped view
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "FileView.h"
+
+namespace DX
+{
+	class AssetPack
+	{
+	public:
+		static const uint32_t Magic = 0x314B4150;			// "PAK1"
+		static const uint32_t Version = 1;
+		static const uint32_t BlockSize = 64 * 1024;
+		static const uint32_t StoredAlignment = 4096;
+
+		enum EntryFlags : uint32_t
+		{
+			EntryStored = 0,		//raw bytes, aligned, can be used in place
+			EntryCompressed = 1,	//split into LZ4 blocks
+		};
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t blockCount;
+			uint64_t entryTableOffset;
+			uint64_t blockTableOffset;
+		};
+
+		struct Entry
+		{
+			uint64_t nameHash;
+			uint64_t offset;			//payload offset for stored entries
+			uint64_t size;				//uncompressed size
+			uint32_t flags;
+			uint32_t firstBlock;		//block range for compressed entries
+			uint32_t blockCount;
+			uint32_t padding;
+		};
+
+		struct Block
+		{
+			uint64_t offset;
+			uint32_t compressedSize;	//equal to uncompressedSize when the block did not compress
+			uint32_t uncompressedSize;
+		};
+
+		AssetPack();
+		~AssetPack();
+
+		bool Open(const wchar_t* filename);
+		void Close();
+		bool IsOpen() const							{ return m_header != nullptr; }
+
+		bool Contains(const wchar_t* name) const	{ return Find(HashName(name)) != nullptr; }
+
+		// Zero-copy access to entries written uncompressed. Fails for compressed entries.
+		bool GetMappedData(const wchar_t* name, const uint8_t** data, size_t* size) const;
+
+		// Copies out an entry, decompressing its blocks across worker threads when there are several.
+		bool ReadEntry(const wchar_t* name, std::vector<uint8_t>& blob) const;
+
+		// Hash of the name after normalisation (lower case, forward slashes, no leading "./").
+		static uint64_t HashName(const wchar_t* name);
+
+		// The pack DX::ReadData, the model loader and the texture loader look in before the file system.
+		static void Mount(AssetPack* pack);
+		static AssetPack* GetMounted();
+
+	private:
+		const Entry* Find(uint64_t nameHash) const;
+		bool DecompressBlocks(const Entry& entry, uint8_t* destination) const;
+
+		FileView				m_view;
+		const Header*			m_header;
+		const Entry*			m_entries;
+		const Block*			m_blocks;
+	};
+
+	// Cooks a set of loose files into a pack. Used by the -buildpack command line switch.
+	class AssetPackWriter
+	{
+	public:
+		void AddFile(const wchar_t* name, const wchar_t* sourcePath, bool compress);
+		bool Write(const wchar_t* filename) const;
+
+	private:
+		struct Source
+		{
+			std::wstring name;
+			std::wstring path;
+			bool compress;
+		};
+
+		std::vector<Source> m_sources;
+	};
+}
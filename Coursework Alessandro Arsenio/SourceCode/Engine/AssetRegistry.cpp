@@ -0,0 +1,429 @@
+#include "pch.h"
+#include "AssetRegistry.h"
+
+#include <chrono>
+
+using namespace DX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	template<typename Handle>
+	bool IsReady(const std::shared_future<Handle>& future)
+	{
+		return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	//references held outside the registry
+	template<typename T>
+	long ExternalReferences(const std::shared_ptr<T>& handle)
+	{
+		return handle ? handle.use_count() - 1 : 0;
+	}
+
+	long ExternalReferences(const AssetRegistry::TextureHandle& handle)
+	{
+		if (!handle)
+		{
+			return 0;
+		}
+		handle->AddRef();
+		return (long)handle->Release() - 1;
+	}
+
+	//bytes per 4x4 block for compressed formats, bits per pixel otherwise
+	void GetFormatSize(DXGI_FORMAT format, size_t& blockBytes, size_t& bitsPerPixel)
+	{
+		blockBytes = 0;
+		bitsPerPixel = 0;
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_TYPELESS: case DXGI_FORMAT_BC1_UNORM: case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_TYPELESS: case DXGI_FORMAT_BC4_UNORM: case DXGI_FORMAT_BC4_SNORM:
+			blockBytes = 8;
+			break;
+
+		case DXGI_FORMAT_BC2_TYPELESS: case DXGI_FORMAT_BC2_UNORM: case DXGI_FORMAT_BC2_UNORM_SRGB:
+		case DXGI_FORMAT_BC3_TYPELESS: case DXGI_FORMAT_BC3_UNORM: case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC5_TYPELESS: case DXGI_FORMAT_BC5_UNORM: case DXGI_FORMAT_BC5_SNORM:
+		case DXGI_FORMAT_BC6H_TYPELESS: case DXGI_FORMAT_BC6H_UF16: case DXGI_FORMAT_BC6H_SF16:
+		case DXGI_FORMAT_BC7_TYPELESS: case DXGI_FORMAT_BC7_UNORM: case DXGI_FORMAT_BC7_UNORM_SRGB:
+			blockBytes = 16;
+			break;
+
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			bitsPerPixel = 128;
+			break;
+
+		case DXGI_FORMAT_R16G16B16A16_FLOAT: case DXGI_FORMAT_R16G16B16A16_UNORM:
+			bitsPerPixel = 64;
+			break;
+
+		case DXGI_FORMAT_R8_UNORM: case DXGI_FORMAT_A8_UNORM:
+			bitsPerPixel = 8;
+			break;
+
+		case DXGI_FORMAT_B5G6R5_UNORM: case DXGI_FORMAT_B5G5R5A1_UNORM: case DXGI_FORMAT_R8G8_UNORM:
+			bitsPerPixel = 16;
+			break;
+
+		default:
+			//the remaining formats DDSTextureLoader produces here are all 32 bit
+			bitsPerPixel = 32;
+			break;
+		}
+	}
+
+	size_t GetTextureBytes(const AssetRegistry::TextureHandle& handle)
+	{
+		if (!handle)
+		{
+			return 0;
+		}
+
+		ComPtr<ID3D11Resource> resource;
+		handle->GetResource(resource.GetAddressOf());
+		ComPtr<ID3D11Texture2D> texture;
+		if (FAILED(resource.As(&texture)))
+		{
+			return 0;
+		}
+
+		D3D11_TEXTURE2D_DESC desc;
+		texture->GetDesc(&desc);
+
+		size_t blockBytes, bitsPerPixel;
+		GetFormatSize(desc.Format, blockBytes, bitsPerPixel);
+
+		size_t bytes = 0;
+		size_t width = desc.Width;
+		size_t height = desc.Height;
+		for (UINT mip = 0; mip < desc.MipLevels; mip++)
+		{
+			if (blockBytes)
+			{
+				bytes += ((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+			}
+			else
+			{
+				bytes += (width * height * bitsPerPixel) / 8;
+			}
+			width = std::max<size_t>(width / 2, 1);
+			height = std::max<size_t>(height / 2, 1);
+		}
+		return bytes * desc.ArraySize;
+	}
+
+	DX::VertexFormat GetModelVertexFormat(unsigned int flags)
+	{
+		if (flags & AssetRegistry::ModelVertexQuantized)
+		{
+			return DX::VertexFormatQuantized;
+		}
+		if (flags & AssetRegistry::ModelVertexHalf)
+		{
+			return DX::VertexFormatHalf;
+		}
+		return DX::VertexFormatFull;
+	}
+
+	void LogFailure(const wchar_t* what, const std::wstring& name)
+	{
+		std::wstring message = std::wstring(L"AssetRegistry: failed to create ") + what + L" " + name + L"\n";
+		OutputDebugStringW(message.c_str());
+	}
+}
+
+AssetRegistry::AssetRegistry(ID3D11Device* device) :
+	m_device(device)
+{
+}
+
+template<typename Handle>
+Handle AssetRegistry::Acquire(Cache<Handle>& cache, const std::wstring& key, std::function<Handle()> create)
+{
+	std::shared_future<Handle> existing;
+	std::promise<Handle> promise;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = cache.find(key);
+		if (it != cache.end())
+		{
+			existing = it->second;
+		}
+		else
+		{
+			cache.emplace(key, promise.get_future().share());
+		}
+	}
+
+	//someone else created it, or is creating it right now
+	if (existing.valid())
+	{
+		return existing.get();
+	}
+
+	try
+	{
+		Handle handle = create();
+		promise.set_value(handle);
+		return handle;
+	}
+	catch (...)
+	{
+		//waiters get the same exception, later requests try again
+		promise.set_exception(std::current_exception());
+		std::lock_guard<std::mutex> lock(m_mutex);
+		cache.erase(key);
+		throw;
+	}
+}
+
+AssetRegistry::ModelHandle AssetRegistry::GetModel(const char* filename, unsigned int flags)
+{
+	std::string path(filename);
+	std::wstring name = CanonicalName(std::wstring(path.begin(), path.end()).c_str());
+	return GetProceduralModel(name, [path, flags](ModelClass& model, ID3D11Device* device)
+	{
+		if (flags & ModelGenerateLods)
+		{
+			return model.InitializeModelWithLods(device, path.c_str(), DX::MeshSimplifier::LodChainOptions());
+		}
+		return model.InitializeModel(device, path.c_str());
+	}, flags);
+}
+
+AssetRegistry::ModelHandle AssetRegistry::GetProceduralModel(const std::wstring& key, std::function<bool(ModelClass&, ID3D11Device*)> build, unsigned int flags)
+{
+	std::wstring cacheKey = key;
+	if (flags & ModelKeepGeometry)
+	{
+		cacheKey += L"|geometry";
+	}
+	if (flags & ModelGenerateLods)
+	{
+		cacheKey += L"|lods";
+	}
+	if (flags & ModelBuildMeshlets)
+	{
+		cacheKey += L"|meshlets";
+	}
+	if (GetModelVertexFormat(flags) != DX::VertexFormatFull)
+	{
+		cacheKey += std::wstring(L"|") + DX::GetVertexFormatName(GetModelVertexFormat(flags));
+	}
+	return Acquire<ModelHandle>(m_models, cacheKey, [this, &key, &build, flags]() { return CreateModel(key, build, flags); });
+}
+
+AssetRegistry::ModelHandle AssetRegistry::CreateModel(const std::wstring& name, std::function<bool(ModelClass&, ID3D11Device*)> build, unsigned int flags)
+{
+	//the last reference going away releases the vertex and index buffers
+	ModelHandle model(new ModelClass(), [](ModelClass* model)
+	{
+		model->Shutdown();
+		delete model;
+	});
+
+	model->SetVertexFormat(GetModelVertexFormat(flags));
+	model->SetBuildMeshlets((flags & ModelBuildMeshlets) != 0);
+	if (!build(*model, m_device.Get()))
+	{
+		LogFailure(L"model", name);
+	}
+
+	//textures named by the .mtl come from the registry like any other; the game ships DDS
+	//conversions next to the originals, so other extensions are swapped for .dds
+	for (int material = 0; material < model->GetMaterialCount(); material++)
+	{
+		const std::string& map = model->GetMaterial(material).diffuseMap;
+		if (map.empty())
+		{
+			continue;
+		}
+		std::wstring textureName(map.begin(), map.end());
+		size_t dot = textureName.find_last_of(L'.');
+		if (dot == std::wstring::npos || CanonicalName(textureName.substr(dot).c_str()) != L".dds")
+		{
+			textureName = textureName.substr(0, dot) + L".dds";
+		}
+		TextureHandle texture = GetTexture(textureName.c_str());
+		model->SetMaterialTexture(material, texture.Get());
+	}
+
+	//once the buffers are on the GPU the CPU copy is only needed for collision
+	if (!(flags & ModelKeepGeometry))
+	{
+		model->ReleaseGeometry();
+	}
+	return model;
+}
+
+AssetRegistry::ShaderHandle AssetRegistry::GetShader(const wchar_t* vsFilename, const wchar_t* psFilename)
+{
+	std::wstring key = CanonicalName(vsFilename) + L"|" + CanonicalName(psFilename);
+	return Acquire<ShaderHandle>(m_shaders, key, [this, &key, vsFilename, psFilename]()
+	{
+		ShaderHandle shader = std::make_shared<Shader>();
+		if (!shader->InitStandard(m_device.Get(), vsFilename, psFilename))
+		{
+			LogFailure(L"shader", key);
+		}
+		return shader;
+	});
+}
+
+AssetRegistry::WaterShaderHandle AssetRegistry::GetWaterShader(const wchar_t* vsFilename, const wchar_t* psFilename, const wchar_t* gsFilename)
+{
+	std::wstring key = CanonicalName(vsFilename) + L"|" + CanonicalName(psFilename) + L"|" + CanonicalName(gsFilename);
+	return Acquire<WaterShaderHandle>(m_waterShaders, key, [this, &key, vsFilename, psFilename, gsFilename]()
+	{
+		WaterShaderHandle shader = std::make_shared<WaterShader>();
+		if (!shader->InitStandard(m_device.Get(), vsFilename, psFilename, gsFilename))
+		{
+			LogFailure(L"shader", key);
+		}
+		return shader;
+	});
+}
+
+AssetRegistry::TextureHandle AssetRegistry::GetTexture(const wchar_t* filename, size_t maxsize)
+{
+	std::wstring key = CanonicalName(filename);
+	if (maxsize)
+	{
+		key += L"|" + std::to_wstring(maxsize);
+	}
+
+	return Acquire<TextureHandle>(m_textures, key, [this, &key, filename, maxsize]()
+	{
+		TextureHandle texture;
+		HRESULT result;
+
+		//stored pack entries are created straight from the mapped view
+		const uint8_t* data;
+		size_t size;
+		AssetPack* pack = AssetPack::GetMounted();
+		if (pack && pack->GetMappedData(filename, &data, &size))
+		{
+			result = CreateDDSTextureFromMemory(m_device.Get(), data, size, nullptr, texture.GetAddressOf(), maxsize);
+		}
+		else
+		{
+			result = CreateDDSTextureFromFile(m_device.Get(), filename, nullptr, texture.GetAddressOf(), maxsize);
+		}
+
+		if (FAILED(result))
+		{
+			LogFailure(L"texture", key);
+		}
+		return texture;
+	});
+}
+
+void AssetRegistry::ReleaseUnused()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto prune = [](auto& cache)
+	{
+		for (auto it = cache.begin(); it != cache.end();)
+		{
+			if (IsReady(it->second) && ExternalReferences(it->second.get()) <= 0)
+			{
+				it = cache.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	};
+
+	prune(m_models);
+	prune(m_shaders);
+	prune(m_waterShaders);
+	prune(m_textures);
+}
+
+void AssetRegistry::LogResidentMemory() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	wchar_t line[512];
+	size_t totalCpu = 0;
+	size_t totalGpu = 0;
+
+	OutputDebugStringW(L"Resident assets:\n");
+	for (const auto& entry : m_models)
+	{
+		if (!IsReady(entry.second))
+		{
+			continue;
+		}
+		const ModelHandle& model = entry.second.get();
+		size_t cpu = model->GetCpuMemoryBytes();
+		size_t gpu = model->GetGpuMemoryBytes();
+		totalCpu += cpu;
+		totalGpu += gpu;
+		swprintf_s(line, L"  model    refs %4ld  cpu %8.1f KB  gpu %8.1f KB  %s\n",
+			ExternalReferences(model), cpu / 1024.0, gpu / 1024.0, entry.first.c_str());
+		OutputDebugStringW(line);
+	}
+
+	for (const auto& entry : m_textures)
+	{
+		if (!IsReady(entry.second))
+		{
+			continue;
+		}
+		const TextureHandle& texture = entry.second.get();
+		size_t gpu = GetTextureBytes(texture);
+		totalGpu += gpu;
+		swprintf_s(line, L"  texture  refs %4ld  cpu %8.1f KB  gpu %8.1f KB  %s\n",
+			ExternalReferences(texture), 0.0, gpu / 1024.0, entry.first.c_str());
+		OutputDebugStringW(line);
+	}
+
+	//shader objects and their constant buffers are small, only the sharing is of interest
+	for (const auto& entry : m_shaders)
+	{
+		if (IsReady(entry.second))
+		{
+			swprintf_s(line, L"  shader   refs %4ld  %s\n", ExternalReferences(entry.second.get()), entry.first.c_str());
+			OutputDebugStringW(line);
+		}
+	}
+	for (const auto& entry : m_waterShaders)
+	{
+		if (IsReady(entry.second))
+		{
+			swprintf_s(line, L"  shader   refs %4ld  %s\n", ExternalReferences(entry.second.get()), entry.first.c_str());
+			OutputDebugStringW(line);
+		}
+	}
+
+	swprintf_s(line, L"  total    cpu %.1f KB  gpu %.1f KB\n", totalCpu / 1024.0, totalGpu / 1024.0);
+	OutputDebugStringW(line);
+}
+
+std::wstring AssetRegistry::CanonicalName(const wchar_t* name)
+{
+	if (name[0] == L'.' && (name[1] == L'/' || name[1] == L'\\'))
+	{
+		name += 2;
+	}
+
+	std::wstring canonical(name);
+	for (auto& c : canonical)
+	{
+		if (c == L'\\')
+		{
+			c = L'/';
+		}
+		else if (c >= L'A' && c <= L'Z')
+		{
+			c = c - L'A' + L'a';
+		}
+	}
+	return canonical;
+}
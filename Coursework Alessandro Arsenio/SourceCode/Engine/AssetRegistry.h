@@ -0,0 +1,85 @@
+//
+// AssetRegistry.h - Shared, reference-counted models, shaders and textures
+//
+// Every asset is keyed by its canonical path (lower case, forward slashes) plus the parameters
+// it was created with, so asking for the same thing twice returns the same object. Requests can
+// come from several loader threads at once; the first one creates the asset and the others wait
+// for it.
+//
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "modelclass.h"
+#include "Shader.h"
+#include "WaterShader.h"
+
+namespace DX
+{
+	class AssetRegistry
+	{
+	public:
+		typedef std::shared_ptr<ModelClass> ModelHandle;
+		typedef std::shared_ptr<Shader> ShaderHandle;
+		typedef std::shared_ptr<WaterShader> WaterShaderHandle;
+		typedef Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> TextureHandle;
+
+		enum ModelFlags : unsigned int
+		{
+			ModelDefault = 0,
+			ModelKeepGeometry = 1,		//keep the CPU vertices and indices, e.g. for collision
+			ModelGenerateLods = 2,		//simplified levels of detail in the same buffers, see ModelClass::GenerateLods
+			ModelVertexHalf = 4,		//16 byte vertices, see DX::VertexFormat
+			ModelVertexQuantized = 8,	//16 byte vertices with 16 bit positions
+			ModelBuildMeshlets = 16,	//clusters culled against the view on the CPU, see DX::Meshlets
+		};
+
+		explicit AssetRegistry(ID3D11Device* device);
+
+		AssetRegistry(const AssetRegistry&) = delete;
+		AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+		ModelHandle GetModel(const char* filename, unsigned int flags = ModelDefault);
+
+		// Models built in code (primitives). The key names the shape and its parameters.
+		ModelHandle GetProceduralModel(const std::wstring& key, std::function<bool(ModelClass&, ID3D11Device*)> build, unsigned int flags = ModelDefault);
+
+		ShaderHandle GetShader(const wchar_t* vsFilename, const wchar_t* psFilename);
+		WaterShaderHandle GetWaterShader(const wchar_t* vsFilename, const wchar_t* psFilename, const wchar_t* gsFilename);
+
+		// DDS textures, from the mounted asset pack when it has them.
+		TextureHandle GetTexture(const wchar_t* filename, size_t maxsize = 0);
+
+		// Drops every asset nothing outside the registry refers to any more.
+		void ReleaseUnused();
+
+		// Writes each asset with its reference count and CPU / GPU memory to the debugger output.
+		void LogResidentMemory() const;
+
+		// Lower case, forward slashes, no leading "./".
+		static std::wstring CanonicalName(const wchar_t* name);
+
+	private:
+		template<typename Handle>
+		using Cache = std::map<std::wstring, std::shared_future<Handle>>;
+
+		template<typename Handle>
+		Handle Acquire(Cache<Handle>& cache, const std::wstring& key, std::function<Handle()> create);
+
+		ModelHandle CreateModel(const std::wstring& name, std::function<bool(ModelClass&, ID3D11Device*)> build, unsigned int flags);
+
+		Microsoft::WRL::ComPtr<ID3D11Device>	m_device;
+
+		mutable std::mutex						m_mutex;
+		Cache<ModelHandle>						m_models;
+		Cache<ShaderHandle>						m_shaders;
+		Cache<WaterShaderHandle>				m_waterShaders;
+		Cache<TextureHandle>					m_textures;
+	};
+}
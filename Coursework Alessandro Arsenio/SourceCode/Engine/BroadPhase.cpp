@@ -0,0 +1,167 @@
+#include "pch.h"
+#include "BroadPhase.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DX;
+
+namespace
+{
+	uint32_t HashCell(int32_t x, int32_t z, uint32_t bucketMask)
+	{
+		return (((uint32_t)x * 73856093u) ^ ((uint32_t)z * 19349663u)) & bucketMask;
+	}
+
+	bool BoxesOverlap(const float aMin[3], const float aMax[3], const float bMin[3], const float bMax[3])
+	{
+		return aMin[0] <= bMax[0] && bMin[0] <= aMax[0]
+			&& aMin[1] <= bMax[1] && bMin[1] <= aMax[1]
+			&& aMin[2] <= bMax[2] && bMin[2] <= aMax[2];
+	}
+
+	bool PairLess(const BroadPhasePair& left, const BroadPhasePair& right)
+	{
+		return left.a != right.a ? left.a < right.a : left.b < right.b;
+	}
+}
+
+SpatialHash::SpatialHash(float cellSize)
+{
+	SetCellSize(cellSize);
+}
+
+void SpatialHash::SetCellSize(float cellSize)
+{
+	m_cellSize = cellSize > 0 ? cellSize : 1.0f;
+	m_inverseCellSize = 1.0f / m_cellSize;
+}
+
+float SpatialHash::GetCellSize() const
+{
+	return m_cellSize;
+}
+
+void SpatialHash::Clear()
+{
+	m_colliders.clear();
+}
+
+void SpatialHash::Insert(uint32_t id, const Float3& center, float radius, uint32_t layer, uint32_t mask)
+{
+	Collider collider;
+	collider.id = id;
+	collider.layer = layer;
+	collider.mask = mask;
+	collider.min[0] = center.x - radius;
+	collider.min[1] = center.y - radius;
+	collider.min[2] = center.z - radius;
+	collider.max[0] = center.x + radius;
+	collider.max[1] = center.y + radius;
+	collider.max[2] = center.z + radius;
+	collider.cellMin[0] = (int32_t)std::floor(collider.min[0] * m_inverseCellSize);
+	collider.cellMin[1] = (int32_t)std::floor(collider.min[2] * m_inverseCellSize);
+	collider.cellMax[0] = (int32_t)std::floor(collider.max[0] * m_inverseCellSize);
+	collider.cellMax[1] = (int32_t)std::floor(collider.max[2] * m_inverseCellSize);
+	m_colliders.push_back(collider);
+}
+
+void SpatialHash::FindPairs(std::vector<BroadPhasePair>& pairs)
+{
+	pairs.clear();
+
+	//file every collider under each cell its box covers
+	m_entries.clear();
+	for (size_t i = 0; i < m_colliders.size(); i++)
+	{
+		const Collider& collider = m_colliders[i];
+		for (int32_t z = collider.cellMin[1]; z <= collider.cellMax[1]; z++)
+		{
+			for (int32_t x = collider.cellMin[0]; x <= collider.cellMax[0]; x++)
+			{
+				CellEntry entry = { (uint32_t)i, x, z };
+				m_entries.push_back(entry);
+			}
+		}
+	}
+
+	//twice as many buckets as entries keeps most buckets down to one cell; a counting sort groups them
+	uint32_t bucketCount = 16;
+	while (bucketCount < m_entries.size() * 2)
+	{
+		bucketCount *= 2;
+	}
+	uint32_t bucketMask = bucketCount - 1;
+	m_bucketStart.assign(bucketCount + 1, 0);
+	for (const CellEntry& entry : m_entries)
+	{
+		m_bucketStart[HashCell(entry.x, entry.z, bucketMask) + 1]++;
+	}
+	for (uint32_t bucket = 0; bucket < bucketCount; bucket++)
+	{
+		m_bucketStart[bucket + 1] += m_bucketStart[bucket];
+	}
+	m_sortedEntries.resize(m_entries.size());
+	for (const CellEntry& entry : m_entries)
+	{
+		uint32_t bucket = HashCell(entry.x, entry.z, bucketMask);
+		m_sortedEntries[m_bucketStart[bucket]++] = entry;
+	}
+	//the scatter moved every start to the next bucket's, shift them back
+	for (uint32_t bucket = bucketCount; bucket > 0; bucket--)
+	{
+		m_bucketStart[bucket] = m_bucketStart[bucket - 1];
+	}
+	m_bucketStart[0] = 0;
+
+	for (uint32_t bucket = 0; bucket < bucketCount; bucket++)
+	{
+		uint32_t end = m_bucketStart[bucket + 1];
+		for (uint32_t i = m_bucketStart[bucket]; i < end; i++)
+		{
+			const CellEntry& first = m_sortedEntries[i];
+			const Collider& a = m_colliders[first.collider];
+			for (uint32_t j = i + 1; j < end; j++)
+			{
+				//different cells can share a bucket
+				const CellEntry& second = m_sortedEntries[j];
+				if (second.x != first.x || second.z != first.z)
+				{
+					continue;
+				}
+				const Collider& b = m_colliders[second.collider];
+				if (!(a.mask & b.layer) || !(b.mask & a.layer))
+				{
+					continue;
+				}
+
+				//colliders sharing several cells are reported only from the lowest cell they share
+				if (first.x != std::max(a.cellMin[0], b.cellMin[0]) || first.z != std::max(a.cellMin[1], b.cellMin[1]))
+				{
+					continue;
+				}
+				if (!BoxesOverlap(a.min, a.max, b.min, b.max))
+				{
+					continue;
+				}
+
+				BroadPhasePair pair;
+				pair.a = std::min(a.id, b.id);
+				pair.b = std::max(a.id, b.id);
+				pairs.push_back(pair);
+			}
+		}
+	}
+
+	std::sort(pairs.begin(), pairs.end(), PairLess);
+}
+
+size_t SpatialHash::GetColliderCount() const
+{
+	return m_colliders.size();
+}
+
+size_t SpatialHash::GetCellEntryCount() const
+{
+	return m_entries.size();
+}
@@ -0,0 +1,80 @@
+//
+// BroadPhase.h - Spatial hash over the XZ plane that finds which colliders may touch
+//
+// Every frame the colliders are inserted as spheres and FindPairs reports the pairs whose
+// bounding boxes overlap, for a narrow phase to test exactly. The plane is split into square
+// cells, each collider is filed under every cell its box covers, and only colliders sharing a
+// cell are compared, so the cost follows the number of nearby colliders instead of the number
+// of colliders squared. Cells are hashed into a table sized to the colliders, so the world has
+// no bounds and empty space costs nothing.
+//
+// Layers decide which pairs matter: a pair is reported when each collider's mask has a bit of
+// the other's layer, so missiles can ask for watermines without ever being tested against each other.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Entities.h"
+
+namespace DX
+{
+	// Ids as passed to Insert, a < b.
+	struct BroadPhasePair
+	{
+		uint32_t a;
+		uint32_t b;
+	};
+
+	class SpatialHash
+	{
+	public:
+		// Cells a little wider than the largest collider keep most colliders in one to four cells.
+		explicit SpatialHash(float cellSize);
+
+		void SetCellSize(float cellSize);
+		float GetCellSize() const;
+
+		// Forgets every collider, keeping the storage for the next frame.
+		void Clear();
+
+		// id is the caller's and comes back in the pairs, it must be unique until the next Clear.
+		void Insert(uint32_t id, const Float3& center, float radius, uint32_t layer, uint32_t mask);
+
+		// Replaces pairs with every pair of colliders whose layers match and whose boxes overlap,
+		// each once, sorted by a then b.
+		void FindPairs(std::vector<BroadPhasePair>& pairs);
+
+		size_t GetColliderCount() const;
+		size_t GetCellEntryCount() const;		//colliders filed under more than one cell count once per cell
+
+	private:
+		struct Collider
+		{
+			uint32_t id;
+			uint32_t layer;
+			uint32_t mask;
+			float min[3];
+			float max[3];
+			int32_t cellMin[2];		//x, z
+			int32_t cellMax[2];
+		};
+
+		struct CellEntry
+		{
+			uint32_t collider;
+			int32_t x;
+			int32_t z;
+		};
+
+		std::vector<Collider>	m_colliders;
+		std::vector<CellEntry>	m_entries;
+		std::vector<CellEntry>	m_sortedEntries;	//grouped by bucket
+		std::vector<uint32_t>	m_bucketStart;		//one past the end is the next bucket's start
+		float					m_cellSize;
+		float					m_inverseCellSize;
+	};
+}
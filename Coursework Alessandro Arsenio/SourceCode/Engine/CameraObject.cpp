@@ -2,7 +2,7 @@
 #include "CameraObject.h"
 
 
-void CameraObject::Update()
+void CameraObject::Update(const DX::FrameContext& frame)
 {
-    GameObject::Update();
+    GameObject::Update(frame);
 }
\ No newline at end of file
@@ -6,6 +6,6 @@ class CameraObject : public GameObject
 {
 public:
 
-	void Update();
+	void Update(const DX::FrameContext& frame);
 };
 
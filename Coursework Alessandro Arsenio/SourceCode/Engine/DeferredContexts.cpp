@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "DeferredContexts.h"
+
+using namespace DX;
+using Microsoft::WRL::ComPtr;
+
+DeferredContexts::DeferredContexts() :
+	m_driverCommandLists(false),
+	m_viewportCount(0),
+	m_sampleMask(0xffffffff),
+	m_stencilRef(0),
+	m_topology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+{
+	m_viewport = D3D11_VIEWPORT();
+	m_blendFactor[0] = m_blendFactor[1] = m_blendFactor[2] = m_blendFactor[3] = 0.0f;
+}
+
+bool DeferredContexts::Create(ID3D11Device* device, ID3D11DeviceContext* immediate, unsigned int count)
+{
+	Reset();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		ComPtr<ID3D11DeviceContext> context;
+		if (FAILED(device->CreateDeferredContext(0, context.GetAddressOf())))
+		{
+			Reset();
+			return false;
+		}
+		m_contexts.push_back(context);
+	}
+	m_commandLists.resize(m_contexts.size());
+	m_immediate = immediate;
+
+	D3D11_FEATURE_DATA_THREADING threading = {};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading))))
+	{
+		m_driverCommandLists = threading.DriverCommandLists != FALSE;
+	}
+	return IsCreated();
+}
+
+void DeferredContexts::Reset()
+{
+	m_contexts.clear();
+	m_commandLists.clear();
+	m_immediate.Reset();
+	m_renderTarget.Reset();
+	m_depthStencil.Reset();
+	m_blendState.Reset();
+	m_depthStencilState.Reset();
+	m_rasterizerState.Reset();
+	m_driverCommandLists = false;
+}
+
+void DeferredContexts::CaptureState()
+{
+	m_immediate->OMGetRenderTargets(1, m_renderTarget.ReleaseAndGetAddressOf(), m_depthStencil.ReleaseAndGetAddressOf());
+	m_viewportCount = 1;
+	m_immediate->RSGetViewports(&m_viewportCount, &m_viewport);
+	m_immediate->OMGetBlendState(m_blendState.ReleaseAndGetAddressOf(), m_blendFactor, &m_sampleMask);
+	m_immediate->OMGetDepthStencilState(m_depthStencilState.ReleaseAndGetAddressOf(), &m_stencilRef);
+	m_immediate->RSGetState(m_rasterizerState.ReleaseAndGetAddressOf());
+	m_immediate->IAGetPrimitiveTopology(&m_topology);
+}
+
+void DeferredContexts::SetRecordFunction(RecordFunction record)
+{
+	m_record = std::move(record);
+}
+
+unsigned int DeferredContexts::GetContextCount() const
+{
+	return (unsigned int)m_contexts.size();
+}
+
+void DeferredContexts::RecordBatch(unsigned int context, size_t batch, const DrawBatch& draws)
+{
+	ID3D11DeviceContext* deferred = m_contexts[context].Get();
+	ApplyState(deferred);
+	m_record(deferred, draws);
+	//FALSE: the context starts the next list from the default state, which ApplyState replaces anyway
+	deferred->FinishCommandList(FALSE, m_commandLists[batch].ReleaseAndGetAddressOf());
+}
+
+void DeferredContexts::ExecuteBatch(size_t batch)
+{
+	if (m_commandLists[batch])
+	{
+		m_immediate->ExecuteCommandList(m_commandLists[batch].Get(), TRUE);
+		m_commandLists[batch].Reset();
+	}
+}
+
+void DeferredContexts::ApplyState(ID3D11DeviceContext* context) const
+{
+	ID3D11RenderTargetView* renderTarget = m_renderTarget.Get();
+	context->OMSetRenderTargets(renderTarget ? 1 : 0, renderTarget ? &renderTarget : nullptr, m_depthStencil.Get());
+	if (m_viewportCount != 0)
+	{
+		context->RSSetViewports(1, &m_viewport);
+	}
+	context->OMSetBlendState(m_blendState.Get(), m_blendFactor, m_sampleMask);
+	context->OMSetDepthStencilState(m_depthStencilState.Get(), m_stencilRef);
+	context->RSSetState(m_rasterizerState.Get());
+	context->IASetPrimitiveTopology(m_topology);
+}
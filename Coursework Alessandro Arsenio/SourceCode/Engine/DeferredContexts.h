@@ -0,0 +1,69 @@
+//
+// DeferredContexts.h - Direct3D 11 deferred contexts as a backend for ParallelRecording
+//
+// Each context records one batch of the draw list into a command list, and the immediate
+// context executes the lists in order. A deferred context begins every command list with the
+// default pipeline state, so the immediate context's render targets, viewport and fixed
+// function states are captured before recording and set on each context first. Executing
+// restores the immediate context's own state afterwards, so drawing can carry on there as if
+// the batches had been drawn on it.
+//
+// Drivers without command list support still work, the runtime then records on their behalf.
+//
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "ParallelRecording.h"
+
+namespace DX
+{
+	class DeferredContexts : public RecordingBackend
+	{
+	public:
+		// Draws a batch on the given context. Called from several workers at once.
+		typedef std::function<void(ID3D11DeviceContext* context, const DrawBatch& draws)> RecordFunction;
+
+		DeferredContexts();
+
+		// False, with nothing created, when the device cannot make deferred contexts, as a single threaded device cannot.
+		bool Create(ID3D11Device* device, ID3D11DeviceContext* immediate, unsigned int count);
+		void Reset();
+		bool IsCreated() const						{ return !m_contexts.empty(); }
+
+		// True when the driver builds command lists itself instead of the runtime emulating them.
+		bool HasDriverCommandLists() const			{ return m_driverCommandLists; }
+
+		// Takes the immediate context's targets, viewport and states for the batches recorded next.
+		void CaptureState();
+		void SetRecordFunction(RecordFunction record);
+
+		unsigned int GetContextCount() const override;
+		void RecordBatch(unsigned int context, size_t batch, const DrawBatch& draws) override;
+		void ExecuteBatch(size_t batch) override;
+
+	private:
+		void ApplyState(ID3D11DeviceContext* context) const;
+
+		std::vector<Microsoft::WRL::ComPtr<ID3D11DeviceContext>>	m_contexts;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11CommandList>>		m_commandLists;		//by batch, as many as contexts
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext>				m_immediate;
+		RecordFunction												m_record;
+		bool														m_driverCommandLists;
+
+		//state captured from the immediate context
+		Microsoft::WRL::ComPtr<ID3D11RenderTargetView>				m_renderTarget;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilView>				m_depthStencil;
+		D3D11_VIEWPORT												m_viewport;
+		UINT														m_viewportCount;
+		Microsoft::WRL::ComPtr<ID3D11BlendState>					m_blendState;
+		float														m_blendFactor[4];
+		UINT														m_sampleMask;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilState>			m_depthStencilState;
+		UINT														m_stencilRef;
+		Microsoft::WRL::ComPtr<ID3D11RasterizerState>				m_rasterizerState;
+		D3D11_PRIMITIVE_TOPOLOGY									m_topology;
+	};
+}
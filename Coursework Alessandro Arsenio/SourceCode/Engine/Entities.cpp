@@ -0,0 +1,760 @@
+#include "pch.h"
+#include "Entities.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace DX;
+
+namespace
+{
+	const float DegreesToRadians = 3.14159265f / 180.0f;
+	const uint32_t NoRow = 0xffffffff;
+	const size_t UpdateGrain = 1024;		//rows per job in the parallel systems
+
+	uint32_t SlotOf(Entity entity)
+	{
+		return (uint32_t)(entity & 0xffffffff);
+	}
+
+	uint32_t GenerationOf(Entity entity)
+	{
+		return (uint32_t)(entity >> 32);
+	}
+
+	Entity MakeEntity(uint32_t slot, uint32_t generation)
+	{
+		return ((Entity)generation << 32) | slot;
+	}
+
+	//row major 3x3 product, a * b
+	void Multiply3x3(const float a[9], const float b[9], float result[9])
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 3; column++)
+			{
+				result[row * 3 + column] = a[row * 3] * b[column] + a[row * 3 + 1] * b[3 + column] + a[row * 3 + 2] * b[6 + column];
+			}
+		}
+	}
+
+	//scale * rotation x * rotation y * rotation z * translation, as SimpleMath builds it, from the
+	//sines and cosines of the pitch, yaw and roll
+	void BuildWorldMatrix(const Transform& transform, const float sines[3], const float cosines[3], float world[16])
+	{
+		float sx = sines[0], sy = sines[1], sz = sines[2];
+		float cx = cosines[0], cy = cosines[1], cz = cosines[2];
+		const float rotationX[9] = { 1, 0, 0, 0, cx, sx, 0, -sx, cx };
+		const float rotationY[9] = { cy, 0, -sy, 0, 1, 0, sy, 0, cy };
+		const float rotationZ[9] = { cz, sz, 0, -sz, cz, 0, 0, 0, 1 };
+		float rotationXY[9], rotation[9];
+		Multiply3x3(rotationX, rotationY, rotationXY);
+		Multiply3x3(rotationXY, rotationZ, rotation);
+
+		const float scale[3] = { transform.scale.x, transform.scale.y, transform.scale.z };
+		for (int row = 0; row < 3; row++)
+		{
+			world[row * 4] = rotation[row * 3] * scale[row];
+			world[row * 4 + 1] = rotation[row * 3 + 1] * scale[row];
+			world[row * 4 + 2] = rotation[row * 3 + 2] * scale[row];
+			world[row * 4 + 3] = 0;
+		}
+		world[12] = transform.worldPosition.x;
+		world[13] = transform.worldPosition.y;
+		world[14] = transform.worldPosition.z;
+		world[15] = 1;
+	}
+
+	bool IsUpdated(const EntityStore& store, size_t index, uint32_t required)
+	{
+		return (store.components[index] & required) == required && !store.markedForDelete[index];
+	}
+
+	void AgeEntity(EntityStore& store, size_t index, float deltaTime)
+	{
+		Lifetime& lifetime = store.lifetimes[index];
+		lifetime.age += deltaTime;
+		if (lifetime.maxAge > 0 && lifetime.age > lifetime.maxAge)
+		{
+			store.markedForDelete[index] = 1;
+		}
+	}
+
+	// Writes only the entity's own row, so rows can move in parallel; the caller marks it dirty.
+	void AdvanceEntity(EntityStore& store, size_t index, float deltaTime)
+	{
+		Motion& motion = store.motions[index];
+		Transform& transform = store.transforms[index];
+		motion.time += deltaTime;
+		if (store.components[index] & ComponentCollider)
+		{
+			store.colliders[index].previousCenter = store.colliders[index].center;
+		}
+
+		transform.position.x += transform.forward.x * motion.speed * deltaTime;
+		transform.position.y += transform.forward.y * motion.speed * deltaTime;
+		transform.position.z += transform.forward.z * motion.speed * deltaTime;
+
+		if (motion.bobAmplitude != 0)
+		{
+			transform.position.y = motion.bobCenter + std::sin(motion.time * motion.bobRate * DegreesToRadians + motion.bobPhase) * motion.bobAmplitude;
+		}
+		if (motion.spinRate != 0)
+		{
+			transform.rotation.y = motion.time * motion.spinRate;
+		}
+	}
+
+	//from the end, so an alpha of 1 gives the current value exactly
+	float Lerp(float previous, float current, float alpha)
+	{
+		return current + (previous - current) * (1.0f - alpha);
+	}
+
+	Float3 Lerp(const Float3& previous, const Float3& current, float alpha)
+	{
+		Float3 result = { Lerp(previous.x, current.x, alpha), Lerp(previous.y, current.y, alpha), Lerp(previous.z, current.z, alpha) };
+		return result;
+	}
+
+	void MoveEntity(EntityStore& store, size_t index, float deltaTime)
+	{
+		AdvanceEntity(store, index, deltaTime);
+		store.MarkDirty(store.entities[index]);
+	}
+
+	void PlaceEntity(EntityStore& store, size_t index)
+	{
+		Transform& transform = store.transforms[index];
+
+		//the first placement in a step keeps the last step's for drawing between the two
+		bool firstPlacement = transform.placedStep == NeverPlaced;
+		if (!firstPlacement && transform.placedStep != store.GetStep())
+		{
+			std::copy(transform.world, transform.world + 16, transform.previousWorld);
+			transform.previousWorldPosition = transform.worldPosition;
+			transform.previousLookAt = transform.lookAt;
+		}
+
+		//shared by the direction vectors and the world matrix
+		float sines[3], cosines[3];
+		sines[0] = std::sin(transform.rotation.x * DegreesToRadians);
+		sines[1] = std::sin(transform.rotation.y * DegreesToRadians);
+		sines[2] = std::sin(transform.rotation.z * DegreesToRadians);
+		cosines[0] = std::cos(transform.rotation.x * DegreesToRadians);
+		cosines[1] = std::cos(transform.rotation.y * DegreesToRadians);
+		cosines[2] = std::cos(transform.rotation.z * DegreesToRadians);
+
+		//rotation in yaw and pitch - using the paramateric equation of a sphere
+		Float3 forward = { sines[1] * cosines[0], sines[0], cosines[1] * cosines[0] };
+		float length = std::sqrt(forward.x * forward.x + forward.y * forward.y + forward.z * forward.z);
+		if (length > 0)
+		{
+			forward.x /= length;
+			forward.y /= length;
+			forward.z /= length;
+		}
+
+		//right = forward x unit y, up = right x forward
+		Float3 right = { -forward.z, 0.0f, forward.x };
+		Float3 up = { -right.z * forward.y, right.z * forward.x - right.x * forward.z, right.x * forward.y };
+
+		transform.forward = forward;
+		transform.right = right;
+		transform.up = up;
+
+		//if the entity has a parent, its position is relative to the parent's axes
+		size_t parent = transform.parent != InvalidEntity ? store.IndexOf(transform.parent) : EntityStore::InvalidIndex;
+		if (parent != EntityStore::InvalidIndex)
+		{
+			const Transform& p = store.transforms[parent];
+			transform.worldPosition.x = p.worldPosition.x + p.forward.x * transform.position.z + p.right.x * transform.position.x + p.up.x * transform.position.y;
+			transform.worldPosition.y = p.worldPosition.y + p.forward.y * transform.position.z + p.right.y * transform.position.x + p.up.y * transform.position.y;
+			transform.worldPosition.z = p.worldPosition.z + p.forward.z * transform.position.z + p.right.z * transform.position.x + p.up.z * transform.position.y;
+			transform.lookAt = p.worldPosition;
+		}
+		else
+		{
+			transform.worldPosition = transform.position;
+			transform.lookAt.x = transform.position.x + forward.x;
+			transform.lookAt.y = transform.position.y + forward.y;
+			transform.lookAt.z = transform.position.z + forward.z;
+		}
+		BuildWorldMatrix(transform, sines, cosines, transform.world);
+		if (firstPlacement)
+		{
+			std::copy(transform.world, transform.world + 16, transform.previousWorld);
+			transform.previousWorldPosition = transform.worldPosition;
+			transform.previousLookAt = transform.lookAt;
+		}
+		transform.placedStep = store.GetStep();
+
+		if (store.components[index] & ComponentCollider)
+		{
+			store.colliders[index].center = transform.worldPosition;
+		}
+	}
+
+	// Places the dirty entities of one hierarchy and everything below them, parents first. Touches
+	// only that hierarchy's rows, so hierarchies can be placed in parallel. The stack holds each
+	// entity with the length of the chain of placements above it, 0 when its parent was not placed.
+	void PlaceHierarchy(EntityStore& store, size_t root, std::vector<std::pair<size_t, size_t>>& stack, TransformUpdateStats& stats)
+	{
+		size_t placed = 0;
+		stack.clear();
+		stack.push_back(std::make_pair(root, size_t(0)));
+		while (!stack.empty())
+		{
+			size_t index = stack.back().first;
+			size_t chain = stack.back().second;
+			stack.pop_back();
+			bool place = store.components[index] != 0 && (chain != 0 || store.transformDirty[index]);
+			if (place)
+			{
+				PlaceEntity(store, index);
+				store.transformDirty[index] = 0;
+				placed++;
+				chain++;
+				stats.criticalPath = std::max(stats.criticalPath, chain);
+			}
+			else
+			{
+				chain = 0;
+			}
+			for (Entity child = store.transforms[index].firstChild; child != InvalidEntity; child = store.GetTransform(child).nextSibling)
+			{
+				stack.push_back(std::make_pair(store.IndexOf(child), chain));
+			}
+		}
+		if (placed != 0)
+		{
+			stats.placed += placed;
+			stats.hierarchies++;
+			stats.largestHierarchy = std::max(stats.largestHierarchy, placed);
+		}
+	}
+}
+
+EntityStore::EntityStore() :
+	m_liveCount(0),
+	m_step(0)
+{
+}
+
+Entity EntityStore::Create(uint32_t flags)
+{
+	uint32_t slot;
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = (uint32_t)m_slotIndex.size();
+		m_slotIndex.push_back(NoRow);
+		m_slotGeneration.push_back(0);
+	}
+	Entity entity = MakeEntity(slot, m_slotGeneration[slot]);
+	m_slotIndex[slot] = (uint32_t)entities.size();
+
+	//components start at their defaults so a facade can add them later without setting every field
+	Transform transform = {};
+	transform.scale = { 1.0f, 1.0f, 1.0f };
+	transform.parent = InvalidEntity;
+	transform.firstChild = InvalidEntity;
+	transform.nextSibling = InvalidEntity;
+	transform.forward = { 0.0f, 0.0f, 1.0f };
+	transform.lookAt = { 0.0f, 0.0f, 1.0f };
+	transform.right = { -1.0f, 0.0f, 0.0f };
+	transform.up = { 0.0f, 1.0f, 0.0f };
+	transform.placedStep = NeverPlaced;
+
+	entities.push_back(entity);
+	components.push_back(flags | ComponentTransform);
+	markedForDelete.push_back(0);
+	transformDirty.push_back(0);
+	transforms.push_back(transform);
+	motions.push_back(Motion());
+	colliders.push_back(Collider());
+	RenderHandle renderHandle = { nullptr, -1 };
+	renderHandles.push_back(renderHandle);
+	lifetimes.push_back(Lifetime());
+
+	m_liveCount++;
+	MarkDirty(entity);
+	return entity;
+}
+
+void EntityStore::DestroyLater(Entity entity)
+{
+	size_t index = IndexOf(entity);
+	if (index == InvalidIndex || components[index] == 0)
+	{
+		return;
+	}
+	components[index] = 0;
+	m_destroyQueue.push_back(entity);
+	m_liveCount--;
+}
+
+void EntityStore::FlushDestroyed()
+{
+	for (Entity entity : m_destroyQueue)
+	{
+		Destroy(entity);
+	}
+	m_destroyQueue.clear();
+}
+
+void EntityStore::Destroy(Entity entity)
+{
+	size_t index = IndexOf(entity);
+	if (index == InvalidIndex)
+	{
+		return;
+	}
+	if (components[index] != 0)
+	{
+		m_liveCount--;
+	}
+
+	//the children stay where they were last placed, now relative to the world
+	Unlink(entity);
+	Entity child = transforms[index].firstChild;
+	while (child != InvalidEntity)
+	{
+		Transform& transform = GetTransform(child);
+		Entity next = transform.nextSibling;
+		transform.parent = InvalidEntity;
+		transform.nextSibling = InvalidEntity;
+		transform.position = transform.worldPosition;
+		MarkDirty(child);
+		child = next;
+	}
+
+	//move the last row into the hole so the arrays stay packed
+	size_t last = entities.size() - 1;
+	if (index != last)
+	{
+		entities[index] = entities[last];
+		components[index] = components[last];
+		markedForDelete[index] = markedForDelete[last];
+		transformDirty[index] = transformDirty[last];
+		transforms[index] = transforms[last];
+		motions[index] = motions[last];
+		colliders[index] = colliders[last];
+		renderHandles[index] = renderHandles[last];
+		lifetimes[index] = lifetimes[last];
+		m_slotIndex[SlotOf(entities[index])] = (uint32_t)index;
+	}
+	entities.pop_back();
+	components.pop_back();
+	markedForDelete.pop_back();
+	transformDirty.pop_back();
+	transforms.pop_back();
+	motions.pop_back();
+	colliders.pop_back();
+	renderHandles.pop_back();
+	lifetimes.pop_back();
+
+	//a new generation makes every handle to the old entity stale
+	uint32_t slot = SlotOf(entity);
+	m_slotIndex[slot] = NoRow;
+	m_slotGeneration[slot]++;
+	m_freeSlots.push_back(slot);
+}
+
+void EntityStore::Clear()
+{
+	entities.clear();
+	components.clear();
+	markedForDelete.clear();
+	transformDirty.clear();
+	transforms.clear();
+	motions.clear();
+	colliders.clear();
+	renderHandles.clear();
+	lifetimes.clear();
+	m_slotIndex.clear();
+	m_slotGeneration.clear();
+	m_freeSlots.clear();
+	m_destroyQueue.clear();
+	m_dirtyList.clear();
+	m_liveCount = 0;
+}
+
+size_t EntityStore::IndexOf(Entity entity) const
+{
+	uint32_t slot = SlotOf(entity);
+	if (slot >= m_slotIndex.size() || m_slotGeneration[slot] != GenerationOf(entity) || m_slotIndex[slot] == NoRow)
+	{
+		return InvalidIndex;
+	}
+	return m_slotIndex[slot];
+}
+
+bool EntityStore::IsAlive(Entity entity) const
+{
+	size_t index = IndexOf(entity);
+	return index != InvalidIndex && components[index] != 0;
+}
+
+bool EntityStore::HasComponents(Entity entity, uint32_t flags) const
+{
+	return IsAlive(entity) && (components[IndexOf(entity)] & flags) == flags;
+}
+
+void EntityStore::AddComponents(Entity entity, uint32_t flags)
+{
+	if (IsAlive(entity))
+	{
+		components[IndexOf(entity)] |= flags;
+	}
+}
+
+bool EntityStore::SetParent(Entity child, Entity parent)
+{
+	if (!IsAlive(child))
+	{
+		return false;
+	}
+	if (GetTransform(child).parent == parent)
+	{
+		return true;
+	}
+	if (parent != InvalidEntity)
+	{
+		//refuse to make a cycle, the entity would never find its root
+		if (!IsAlive(parent))
+		{
+			return false;
+		}
+		for (Entity ancestor = parent; ancestor != InvalidEntity; ancestor = GetTransform(ancestor).parent)
+		{
+			if (ancestor == child)
+			{
+				return false;
+			}
+		}
+	}
+
+	Unlink(child);
+	Transform& transform = GetTransform(child);
+	transform.parent = parent;
+	if (parent != InvalidEntity)
+	{
+		Transform& parentTransform = GetTransform(parent);
+		transform.nextSibling = parentTransform.firstChild;
+		parentTransform.firstChild = child;
+	}
+	MarkDirty(child);
+	return true;
+}
+
+void EntityStore::Unlink(Entity child)
+{
+	Transform& transform = GetTransform(child);
+	if (transform.parent == InvalidEntity)
+	{
+		return;
+	}
+	Entity* link = &GetTransform(transform.parent).firstChild;
+	while (*link != InvalidEntity && *link != child)
+	{
+		link = &GetTransform(*link).nextSibling;
+	}
+	if (*link == child)
+	{
+		*link = transform.nextSibling;
+	}
+	transform.parent = InvalidEntity;
+	transform.nextSibling = InvalidEntity;
+}
+
+void EntityStore::SetPosition(Entity entity, const Float3& position)
+{
+	if (IsAlive(entity))
+	{
+		GetTransform(entity).position = position;
+		MarkDirty(entity);
+	}
+}
+
+void EntityStore::SetRotation(Entity entity, const Float3& rotation)
+{
+	if (IsAlive(entity))
+	{
+		GetTransform(entity).rotation = rotation;
+		MarkDirty(entity);
+	}
+}
+
+void EntityStore::SetScale(Entity entity, const Float3& scale)
+{
+	if (IsAlive(entity))
+	{
+		GetTransform(entity).scale = scale;
+		MarkDirty(entity);
+	}
+}
+
+void EntityStore::MarkDirty(Entity entity)
+{
+	size_t index = IndexOf(entity);
+	if (index != InvalidIndex && components[index] != 0 && !transformDirty[index])
+	{
+		transformDirty[index] = 1;
+		m_dirtyList.push_back(entity);
+	}
+}
+
+bool EntityStore::IsDirty(Entity entity) const
+{
+	return IsAlive(entity) && transformDirty[IndexOf(entity)] != 0;
+}
+
+size_t EntityStore::GetDirtyCount() const
+{
+	return m_dirtyList.size();
+}
+
+void EntityStore::PlaceSubtree(Entity root)
+{
+	//parents before children, so every child reads its parent's new axes
+	m_subtreeStack.clear();
+	m_subtreeStack.push_back(root);
+	while (!m_subtreeStack.empty())
+	{
+		Entity entity = m_subtreeStack.back();
+		m_subtreeStack.pop_back();
+		size_t index = IndexOf(entity);
+		PlaceEntity(*this, index);
+		transformDirty[index] = 0;
+		for (Entity child = transforms[index].firstChild; child != InvalidEntity; child = GetTransform(child).nextSibling)
+		{
+			m_subtreeStack.push_back(child);
+		}
+	}
+}
+
+void EntityStore::BeginStep()
+{
+	//NeverPlaced is kept for transforms that were never placed
+	m_step = m_step + 1 == NeverPlaced ? 0 : m_step + 1;
+}
+
+void EntityStore::ResetInterpolation(Entity entity)
+{
+	if (!IsAlive(entity))
+	{
+		return;
+	}
+	//the children move with the entity, so they would be drawn crossing the same gap
+	m_subtreeStack.clear();
+	m_subtreeStack.push_back(entity);
+	while (!m_subtreeStack.empty())
+	{
+		Transform& transform = GetTransform(m_subtreeStack.back());
+		m_subtreeStack.pop_back();
+		transform.placedStep = NeverPlaced;
+		for (Entity child = transform.firstChild; child != InvalidEntity; child = GetTransform(child).nextSibling)
+		{
+			m_subtreeStack.push_back(child);
+		}
+	}
+}
+
+void EntityStore::MarkForDelete(Entity entity, bool marked)
+{
+	if (IsAlive(entity))
+	{
+		markedForDelete[IndexOf(entity)] = marked ? 1 : 0;
+	}
+}
+
+bool EntityStore::IsMarkedForDelete(Entity entity) const
+{
+	return IsAlive(entity) && markedForDelete[IndexOf(entity)] != 0;
+}
+
+size_t EntityStore::GetCount() const
+{
+	return entities.size();
+}
+
+size_t EntityStore::GetLiveCount() const
+{
+	return m_liveCount;
+}
+
+size_t EntityStore::GetSlotCount() const
+{
+	return m_slotIndex.size();
+}
+
+size_t EntityStore::GetDestroyQueueLength() const
+{
+	return m_destroyQueue.size();
+}
+
+void DX::UpdateLifetimes(EntityStore& store, float deltaTime)
+{
+	size_t count = store.components.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		if (IsUpdated(store, i, ComponentLifetime))
+		{
+			AgeEntity(store, i, deltaTime);
+		}
+	}
+}
+
+void DX::UpdateMotion(EntityStore& store, float deltaTime)
+{
+	size_t count = store.components.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		if (IsUpdated(store, i, ComponentMotion))
+		{
+			MoveEntity(store, i, deltaTime);
+		}
+	}
+}
+
+void DX::UpdateTransforms(EntityStore& store)
+{
+	//an entry is stale when its entity was destroyed, or already placed with a dirty parent
+	for (size_t i = 0; i < store.m_dirtyList.size(); i++)
+	{
+		UpdateTransform(store, store.m_dirtyList[i]);
+	}
+	store.m_dirtyList.clear();
+}
+
+TransformUpdateStats DX::UpdateTransforms(EntityStore& store, JobSystem& jobs)
+{
+	//every hierarchy from its root, so a child is always placed by the same job as its parent. Each
+	//piece of the for counts into its own stats, merged once they are all done
+	size_t count = store.entities.size();
+	TransformUpdateStats none = {};
+	std::vector<TransformUpdateStats> pieces((count + UpdateGrain - 1) / UpdateGrain, none);
+	jobs.ParallelFor(0, count, UpdateGrain, [&store, &pieces](size_t begin, size_t end)
+	{
+		TransformUpdateStats& stats = pieces[begin / UpdateGrain];
+		std::vector<std::pair<size_t, size_t>> stack;
+		for (size_t i = begin; i < end; i++)
+		{
+			const Transform& transform = store.transforms[i];
+			if (transform.parent == InvalidEntity && (store.transformDirty[i] || transform.firstChild != InvalidEntity))
+			{
+				PlaceHierarchy(store, i, stack, stats);
+			}
+		}
+	});
+	store.m_dirtyList.clear();
+
+	TransformUpdateStats total = none;
+	for (const TransformUpdateStats& stats : pieces)
+	{
+		total.placed += stats.placed;
+		total.hierarchies += stats.hierarchies;
+		total.largestHierarchy = std::max(total.largestHierarchy, stats.largestHierarchy);
+		total.criticalPath = std::max(total.criticalPath, stats.criticalPath);
+	}
+	return total;
+}
+
+void DX::UpdateTransform(EntityStore& store, Entity entity)
+{
+	if (!store.IsAlive(entity))
+	{
+		return;
+	}
+
+	//start from the topmost dirty ancestor, placing it places everything below it
+	Entity root = InvalidEntity;
+	for (Entity ancestor = entity; ancestor != InvalidEntity; ancestor = store.GetTransform(ancestor).parent)
+	{
+		if (store.transformDirty[store.IndexOf(ancestor)])
+		{
+			root = ancestor;
+		}
+	}
+	if (root != InvalidEntity)
+	{
+		store.PlaceSubtree(root);
+	}
+}
+
+void DX::UpdateEntities(EntityStore& store, float deltaTime)
+{
+	UpdateLifetimes(store, deltaTime);
+	UpdateMotion(store, deltaTime);
+	UpdateTransforms(store);
+}
+
+void DX::InterpolateWorld(const EntityStore& store, Entity entity, float alpha, float world[16])
+{
+	const Transform& transform = store.transforms[store.IndexOf(entity)];
+	bool moved = transform.placedStep == store.GetStep();
+	for (int i = 0; i < 16; i++)
+	{
+		world[i] = moved ? Lerp(transform.previousWorld[i], transform.world[i], alpha) : transform.world[i];
+	}
+}
+
+Float3 DX::InterpolatePosition(const EntityStore& store, Entity entity, float alpha)
+{
+	const Transform& transform = store.transforms[store.IndexOf(entity)];
+	return transform.placedStep == store.GetStep() ? Lerp(transform.previousWorldPosition, transform.worldPosition, alpha) : transform.worldPosition;
+}
+
+Float3 DX::InterpolateLookAt(const EntityStore& store, Entity entity, float alpha)
+{
+	const Transform& transform = store.transforms[store.IndexOf(entity)];
+	return transform.placedStep == store.GetStep() ? Lerp(transform.previousLookAt, transform.lookAt, alpha) : transform.lookAt;
+}
+
+TransformUpdateStats DX::UpdateEntities(EntityStore& store, float deltaTime, JobSystem& jobs)
+{
+	//aging and moving read and write only the entity's own row, so both run in one pass. The flag is set
+	//directly instead of through MarkDirty, UpdateTransforms looks at every row's flag and not the list.
+	jobs.ParallelFor(0, store.entities.size(), UpdateGrain, [&store, deltaTime](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			if (IsUpdated(store, i, ComponentLifetime))
+			{
+				AgeEntity(store, i, deltaTime);
+			}
+			if (IsUpdated(store, i, ComponentMotion))
+			{
+				AdvanceEntity(store, i, deltaTime);
+				store.transformDirty[i] = 1;
+			}
+		}
+	});
+	return UpdateTransforms(store, jobs);
+}
+
+void DX::UpdateEntity(EntityStore& store, Entity entity, float deltaTime)
+{
+	size_t index = store.IndexOf(entity);
+	if (index == EntityStore::InvalidIndex)
+	{
+		return;
+	}
+	if (IsUpdated(store, index, ComponentLifetime))
+	{
+		AgeEntity(store, index, deltaTime);
+	}
+	if (IsUpdated(store, index, ComponentMotion))
+	{
+		MoveEntity(store, index, deltaTime);
+	}
+	UpdateTransform(store, entity);
+}
@@ -0,0 +1,261 @@
+//
+// Entities.h - Component arrays for scene objects and the systems that update them
+//
+// Every scene object is an entity with a row in one array per component type. A system is a
+// loop over those arrays, so updating every watermine is a pass over contiguous memory instead
+// of a virtual call per heap allocated object. GameObject is a facade over one entity and keeps
+// the accessors the rest of the game uses.
+//
+// The arrays stay packed: removing an entity moves the last row into its place. Entities are
+// named by generational handles, a slot number and how many times that slot has been reused,
+// so a handle to a removed entity never finds whatever took its slot. Removal is deferred:
+// DestroyLater takes the entity out of the systems at once and FlushDestroyed compacts the
+// arrays once per frame, so destroying while walking the arrays is safe.
+//
+// Transforms are cached: changing one marks it dirty, and UpdateTransforms only recomputes the
+// dirty entities and their children. A child is offset along its parent's forward, right and up
+// vectors and keeps its own rotation and scale, the way the camera follows the player.
+//
+// At a fixed timestep frames are drawn between two simulation steps. Each transform keeps the
+// placement it had before the current step next to the current one, taken the first time it is
+// placed after BeginStep, and drawing interpolates between the two by how far the clock is into
+// the next step. Entities that did not move in the step are drawn where they are.
+//
+// Angles are in degrees, the same as GameObject's setRotation. Matrices are SimpleMath's:
+// 16 floats, row major, transforming row vectors.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DX
+{
+	class JobSystem;
+	struct TransformUpdateStats;
+
+	// Slot in the low 32 bits, generation in the high 32.
+	typedef uint64_t Entity;
+	const Entity InvalidEntity = 0xffffffffffffffffull;
+
+	enum ComponentFlags
+	{
+		ComponentTransform = 1,
+		ComponentMotion = 2,
+		ComponentCollider = 4,
+		ComponentRender = 8,
+		ComponentLifetime = 16,
+
+		//tags carry no data, they select entities for a view
+		TagScene = 256,
+		TagWatermine = 512,
+		TagMissile = 1024,
+	};
+
+	struct Float3
+	{
+		float x, y, z;
+	};
+
+	// Write position, rotation and scale through the store's setters, or call MarkDirty after.
+	struct Transform
+	{
+		Float3 position;		//local, relative to the parent when there is one
+		Float3 rotation;		//pitch, yaw, roll
+		Float3 scale;
+		Entity parent;			//set with SetParent, which keeps the child lists
+		Entity firstChild;
+		Entity nextSibling;
+
+		//written by UpdateTransforms
+		float world[16];		//scale * rotation x * y * z * translation to the world position
+		Float3 worldPosition;
+		Float3 lookAt;
+		Float3 forward;
+		Float3 right;
+		Float3 up;
+
+		//the placement before the current step's, kept by the first placement after BeginStep
+		float previousWorld[16];
+		Float3 previousWorldPosition;
+		Float3 previousLookAt;
+		uint32_t placedStep;	//step of the last placement, NeverPlaced until the first
+	};
+
+	const uint32_t NeverPlaced = 0xffffffffu;
+
+	// Scripted movement: along the forward vector, bobbing up and down and spinning around y.
+	struct Motion
+	{
+		float speed;			//units per second along forward
+		float bobCenter;		//y the bobbing is around
+		float bobAmplitude;
+		float bobRate;			//degrees of the sine wave per second
+		float bobPhase;			//radians
+		float spinRate;			//yaw is time * spinRate when it is not 0
+		float time;
+	};
+
+	struct Collider
+	{
+		Float3 center;			//follows the world position
+		Float3 previousCenter;	//center before the last move, where swept tests start
+		float radius;
+	};
+
+	// What draws the entity, GameObject in the game.
+	struct RenderHandle
+	{
+		void* owner;
+		int32_t sceneProxy;		//leaf in Game's scene tree, -1 when it has none
+	};
+
+	struct Lifetime
+	{
+		float age;
+		float maxAge;			//0 lives until destroyed
+	};
+
+	class EntityStore
+	{
+	public:
+		EntityStore();
+
+		Entity Create(uint32_t flags);
+
+		// Takes the entity out of the systems and views now and removes it at the next
+		// FlushDestroyed. Destroying it again, or a stale handle, does nothing.
+		void DestroyLater(Entity entity);
+		void FlushDestroyed();
+
+		// Removes the entity now, moving the last row into its place. Not while walking the arrays.
+		void Destroy(Entity entity);
+		void Clear();
+
+		// False once the entity is queued for destruction.
+		bool IsAlive(Entity entity) const;
+
+		// Row of a live or queued entity in the component arrays, InvalidIndex for a stale handle.
+		static const size_t InvalidIndex = (size_t)-1;
+		size_t IndexOf(Entity entity) const;
+
+		// The entity must be alive or queued.
+		Transform& GetTransform(Entity entity)			{ return transforms[IndexOf(entity)]; }
+		Motion& GetMotion(Entity entity)				{ return motions[IndexOf(entity)]; }
+		Collider& GetCollider(Entity entity)			{ return colliders[IndexOf(entity)]; }
+		RenderHandle& GetRenderHandle(Entity entity)	{ return renderHandles[IndexOf(entity)]; }
+		Lifetime& GetLifetime(Entity entity)			{ return lifetimes[IndexOf(entity)]; }
+
+		bool HasComponents(Entity entity, uint32_t flags) const;
+		void AddComponents(Entity entity, uint32_t flags);
+
+		// Destroying a parent leaves its children where they are, at the root. False, changing nothing, when
+		// either entity is dead or the parent is the child or below it, which would make a cycle.
+		bool SetParent(Entity child, Entity parent);
+
+		void SetPosition(Entity entity, const Float3& position);
+		void SetRotation(Entity entity, const Float3& rotation);
+		void SetScale(Entity entity, const Float3& scale);
+
+		// Queues the entity's transform, and so its children's, for the next UpdateTransforms.
+		void MarkDirty(Entity entity);
+		bool IsDirty(Entity entity) const;
+		size_t GetDirtyCount() const;
+
+		// Starts a simulation step, before anything in it moves. Transforms placed from now on keep their
+		// placement from before as the previous one.
+		void BeginStep();
+		uint32_t GetStep() const			{ return m_step; }
+
+		// The entity and its children are drawn from their next placement instead of moving there from
+		// the last one, for teleports and objects taken from a pool.
+		void ResetInterpolation(Entity entity);
+
+		// Entities marked for deletion are skipped by the systems until they are destroyed.
+		void MarkForDelete(Entity entity, bool marked);
+		bool IsMarkedForDelete(Entity entity) const;
+
+		size_t GetCount() const;			//rows, including entities queued for destruction
+		size_t GetLiveCount() const;
+		size_t GetSlotCount() const;		//most entities there have been at once
+		size_t GetDestroyQueueLength() const;
+
+		//one row per entity, packed
+		std::vector<Entity>			entities;
+		std::vector<uint32_t>		components;		//ComponentFlags, 0 once queued for destruction
+		std::vector<uint8_t>		markedForDelete;
+		std::vector<uint8_t>		transformDirty;
+		std::vector<Transform>		transforms;
+		std::vector<Motion>			motions;
+		std::vector<Collider>		colliders;
+		std::vector<RenderHandle>	renderHandles;
+		std::vector<Lifetime>		lifetimes;
+
+	private:
+		friend void UpdateTransforms(EntityStore& store);
+		friend TransformUpdateStats UpdateTransforms(EntityStore& store, JobSystem& jobs);
+		friend void UpdateTransform(EntityStore& store, Entity entity);
+
+		void Unlink(Entity child);
+		void PlaceSubtree(Entity root);
+
+		//slot map, from the slot in a handle to the entity's row
+		std::vector<uint32_t>		m_slotIndex;
+		std::vector<uint32_t>		m_slotGeneration;
+		std::vector<uint32_t>		m_freeSlots;
+
+		std::vector<Entity>			m_destroyQueue;
+		std::vector<Entity>			m_dirtyList;
+		std::vector<Entity>			m_subtreeStack;		//scratch for PlaceSubtree
+		size_t						m_liveCount;
+		uint32_t					m_step;
+	};
+
+	// What a parallel transform update did. Hierarchies are placed one job each, so a frame takes at
+	// least the largest hierarchy's placements however many workers there are. The critical path is
+	// the longest chain of placements that each waited on their parent's.
+	struct TransformUpdateStats
+	{
+		size_t placed;
+		size_t hierarchies;			//roots whose hierarchy had something placed
+		size_t largestHierarchy;	//most placements in one hierarchy
+		size_t criticalPath;
+	};
+
+	// Systems walk every row and skip entities without the components they need, queued for
+	// destruction or marked for deletion.
+
+	// Ages entities and marks the ones past their maxAge for deletion.
+	void UpdateLifetimes(EntityStore& store, float deltaTime);
+
+	// Moves entities with a Motion component and marks them dirty. Uses the forward vector of the
+	// last transform update.
+	void UpdateMotion(EntityStore& store, float deltaTime);
+
+	// Rebuilds the direction vectors, world matrices and collider centers of the dirty entities and
+	// their children, parents first. Costs the number of changed transforms, not the number of entities.
+	void UpdateTransforms(EntityStore& store);
+
+	// The same over every hierarchy in parallel, a whole hierarchy per job. Costs the number of entities.
+	TransformUpdateStats UpdateTransforms(EntityStore& store, JobSystem& jobs);
+
+	// Brings one entity up to date, with whichever of its parents are dirty.
+	void UpdateTransform(EntityStore& store, Entity entity);
+
+	// The entity's placement alpha of the way from the one before the current step to the current one, for
+	// drawing between steps. The current placement when the entity was not placed in the current step.
+	void InterpolateWorld(const EntityStore& store, Entity entity, float alpha, float world[16]);
+	Float3 InterpolatePosition(const EntityStore& store, Entity entity, float alpha);
+	Float3 InterpolateLookAt(const EntityStore& store, Entity entity, float alpha);
+
+	// Lifetimes, then motion, then transforms; the order GameObject subclasses used to update in.
+	void UpdateEntities(EntityStore& store, float deltaTime);
+
+	// The same phases as parallel fors over the rows, each finished before the next starts: lifetimes and
+	// motion, which only write the entity's own row, then transforms. The result is the same as the serial
+	// update's whatever the number of workers.
+	TransformUpdateStats UpdateEntities(EntityStore& store, float deltaTime, JobSystem& jobs);
+	void UpdateEntity(EntityStore& store, Entity entity, float deltaTime);
+}
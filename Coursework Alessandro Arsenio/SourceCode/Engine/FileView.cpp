@@ -0,0 +1,258 @@
+#include "pch.h"
+#include "FileView.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace DX;
+
+namespace
+{
+#ifdef _WIN32
+	//PrefetchVirtualMemory only exists from Windows 8, so it is looked up at runtime rather than linked
+	struct MemoryRange
+	{
+		void* address;
+		size_t size;
+	};
+	typedef BOOL(WINAPI *PrefetchVirtualMemoryFunc)(HANDLE, ULONG_PTR, MemoryRange*, ULONG);
+
+	PrefetchVirtualMemoryFunc GetPrefetchVirtualMemory()
+	{
+		static PrefetchVirtualMemoryFunc function = reinterpret_cast<PrefetchVirtualMemoryFunc>(
+			GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory"));
+		return function;
+	}
+#else
+	std::string NarrowPath(const wchar_t* filename)
+	{
+		size_t length = wcstombs(nullptr, filename, 0);
+		if (length == (size_t)-1)
+		{
+			return std::string();
+		}
+
+		std::string path(length, '\0');
+		wcstombs(&path[0], filename, length + 1);
+		return path;
+	}
+#endif
+}
+
+FileView::FileView() :
+	m_mode(ModeClosed),
+	m_data(nullptr),
+	m_size(0)
+{
+}
+
+FileView::~FileView()
+{
+	Close();
+}
+
+FileView::FileView(FileView&& other) :
+	m_mode(ModeClosed),
+	m_data(nullptr),
+	m_size(0)
+{
+	MoveFrom(other);
+}
+
+FileView& FileView::operator=(FileView&& other)
+{
+	if (this != &other)
+	{
+		Close();
+		MoveFrom(other);
+	}
+	return *this;
+}
+
+void FileView::MoveFrom(FileView& other)
+{
+	m_mode = other.m_mode;
+	m_size = other.m_size;
+	m_buffer = std::move(other.m_buffer);
+	m_data = (m_mode == ModeBuffered) ? m_buffer.data() : other.m_data;
+
+	other.m_mode = ModeClosed;
+	other.m_data = nullptr;
+	other.m_size = 0;
+}
+
+bool FileView::Open(const wchar_t* filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || uint64_t(fileSize.QuadPart) > SIZE_MAX)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	size_t size = (size_t)fileSize.QuadPart;
+
+	if (size < MinMappedSize)
+	{
+		//small files: one read is cheaper than setting up a mapping
+		m_buffer.resize(size);
+		DWORD bytesRead = 0;
+		BOOL read = size == 0 || ReadFile(file, m_buffer.data(), (DWORD)size, &bytesRead, nullptr);
+		CloseHandle(file);
+		if (!read || bytesRead != size)
+		{
+			m_buffer.clear();
+			return false;
+		}
+
+		m_mode = ModeBuffered;
+		m_data = m_buffer.data();
+		m_size = size;
+		return true;
+	}
+
+	//the view keeps the file alive, so both handles can go as soon as it exists
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+	{
+		return false;
+	}
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view)
+	{
+		return false;
+	}
+#else
+	std::string path = NarrowPath(filename);
+	int file = path.empty() ? -1 : open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || !S_ISREG(info.st_mode))
+	{
+		close(file);
+		return false;
+	}
+	size_t size = (size_t)info.st_size;
+
+	if (size < MinMappedSize)
+	{
+		//small files: one read is cheaper than setting up a mapping
+		m_buffer.resize(size);
+		size_t total = 0;
+		while (total < size)
+		{
+			ssize_t count = read(file, m_buffer.data() + total, size - total);
+			if (count <= 0)
+			{
+				break;
+			}
+			total += (size_t)count;
+		}
+		close(file);
+		if (total != size)
+		{
+			m_buffer.clear();
+			return false;
+		}
+
+		m_mode = ModeBuffered;
+		m_data = m_buffer.data();
+		m_size = size;
+		return true;
+	}
+
+	//the mapping holds its own reference to the file
+	void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+#endif
+
+	m_mode = ModeMapped;
+	m_data = static_cast<const uint8_t*>(view);
+	m_size = size;
+	return true;
+}
+
+void FileView::Close()
+{
+	if (m_mode == ModeMapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+#else
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+	}
+
+	m_buffer.clear();
+	m_buffer.shrink_to_fit();
+	m_mode = ModeClosed;
+	m_data = nullptr;
+	m_size = 0;
+}
+
+void FileView::Attach(const uint8_t* data, size_t size)
+{
+	Close();
+	m_mode = ModeAttached;
+	m_data = data;
+	m_size = size;
+}
+
+void FileView::Adopt(std::vector<uint8_t>&& blob)
+{
+	Close();
+	m_buffer = std::move(blob);
+	m_mode = ModeBuffered;
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+}
+
+void FileView::Prefetch() const
+{
+	//buffered views are already resident
+	if ((m_mode != ModeMapped && m_mode != ModeAttached) || m_size == 0)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	PrefetchVirtualMemoryFunc prefetch = GetPrefetchVirtualMemory();
+	if (prefetch)
+	{
+		MemoryRange range = { const_cast<uint8_t*>(m_data), m_size };
+		prefetch(GetCurrentProcess(), 1, &range, 0);
+	}
+#else
+	//madvise wants a page aligned start
+	uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t)m_data & ~(pageSize - 1);
+	madvise(reinterpret_cast<void*>(start), (uintptr_t)m_data + m_size - start, MADV_WILLNEED);
+#endif
+}
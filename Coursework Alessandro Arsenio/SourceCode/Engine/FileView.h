@@ -0,0 +1,70 @@
+//
+// FileView.h - Read-only view of a whole file
+//
+// Large files are mapped into the address space (MapViewOfFile on Windows, mmap elsewhere) so
+// callers read straight from the page cache instead of copying into a heap buffer. Files below
+// MinMappedSize are cheaper to read than to map and are buffered instead. Either way the bytes
+// stay valid for as long as the FileView that owns them is alive.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DX
+{
+	class FileView
+	{
+	public:
+		static const size_t MinMappedSize = 64 * 1024;
+
+		FileView();
+		~FileView();
+
+		FileView(FileView&& other);
+		FileView& operator=(FileView&& other);
+
+		FileView(const FileView&) = delete;
+		FileView& operator=(const FileView&) = delete;
+
+		bool Open(const wchar_t* filename);
+		void Close();
+
+		// Views memory owned elsewhere, e.g. a stored entry of the mounted asset pack.
+		void Attach(const uint8_t* data, size_t size);
+
+		// Takes ownership of an already loaded buffer.
+		void Adopt(std::vector<uint8_t>&& blob);
+
+		bool IsOpen() const					{ return m_mode != ModeClosed; }
+		bool IsMapped() const				{ return m_mode == ModeMapped; }
+
+		// Span style accessors, named like std::vector so ReadData callers move over unchanged.
+		const uint8_t* data() const			{ return m_data; }
+		size_t size() const					{ return m_size; }
+		bool empty() const					{ return m_size == 0; }
+		const uint8_t* begin() const		{ return m_data; }
+		const uint8_t* end() const			{ return m_data + m_size; }
+
+		// Asks the OS to start paging the view in. Returns immediately; does nothing for buffered views.
+		void Prefetch() const;
+
+	private:
+		enum Mode
+		{
+			ModeClosed,
+			ModeMapped,
+			ModeBuffered,
+			ModeAttached,
+		};
+
+		void MoveFrom(FileView& other);
+
+		Mode					m_mode;
+		const uint8_t*			m_data;
+		size_t					m_size;
+		std::vector<uint8_t>	m_buffer;
+	};
+}
@@ -0,0 +1,25 @@
+//
+// FrameContext.h - What an update knows about time and input, shared by everything it updates
+//
+// Game fills one at the start of each update from its timer and the input for the step, and hands
+// it by const reference to the objects it updates and draws. Objects used to keep a copy of the
+// whole timer and input each, refreshed every frame; now nothing is copied per object, and no
+// object can see a different time or input from the rest of the update.
+//
+
+#pragma once
+
+#include <stdint.h>
+
+#include "InputCommands.h"
+
+namespace DX
+{
+	struct FrameContext
+	{
+		float			deltaTime;		//seconds the update covers
+		double			totalTime;		//seconds since the start, at the end of the update
+		uint64_t		frame;			//updates so far, this one included
+		InputCommands	input;
+	};
+}
@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "FramePipeline.h"
+
+#include <chrono>
+
+using namespace DX;
+
+namespace
+{
+	double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+FramePipeline::FramePipeline(bool threaded) :
+	m_simulationTime(0),
+	m_stopping(false)
+{
+	m_timings.simulation = m_timings.render = m_timings.waitForSimulation = 0;
+	if (threaded)
+	{
+		m_thread = std::thread(&FramePipeline::SimulationMain, this);
+	}
+}
+
+FramePipeline::~FramePipeline()
+{
+	if (!IsThreaded())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_changed.notify_all();
+	m_thread.join();
+}
+
+void FramePipeline::Simulate(Frame frame)
+{
+	if (!IsThreaded())
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		frame();
+		m_timings.simulation = MillisecondsSince(start);
+		m_timings.waitForSimulation = 0;
+		return;
+	}
+
+	auto waitStart = std::chrono::high_resolution_clock::now();
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this]() { return !m_frame; });
+		m_timings.waitForSimulation = MillisecondsSince(waitStart);
+		m_timings.simulation = m_simulationTime;
+		m_frame = std::move(frame);
+	}
+	m_changed.notify_all();
+}
+
+void FramePipeline::Render(const Frame& render)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	render();
+	m_timings.render = MillisecondsSince(start);
+}
+
+void FramePipeline::Finish()
+{
+	if (IsThreaded())
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this]() { return !m_frame; });
+		m_timings.simulation = m_simulationTime;
+	}
+}
+
+void FramePipeline::SimulationMain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		//a frame already handed over still runs when stopping
+		m_changed.wait(lock, [this]() { return m_frame || m_stopping; });
+		if (!m_frame)
+		{
+			return;
+		}
+		Frame frame = m_frame;
+		lock.unlock();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		frame();
+		double time = MillisecondsSince(start);
+
+		lock.lock();
+		m_simulationTime = time;
+		m_frame = nullptr;
+		m_changed.notify_all();
+	}
+}
@@ -0,0 +1,66 @@
+//
+// FramePipeline.h - Runs the simulation of one frame while the previous one renders
+//
+// Threaded, Simulate hands the frame to a thread of its own and returns, so the caller renders
+// frame N while frame N + 1 is simulated. Only one frame is simulated at a time: Simulate first
+// waits for the previous one, which keeps input at most a frame behind. Single threaded, the
+// frame runs in Simulate, back to back with rendering, which is easier to step through in a
+// debugger. The frames should publish what rendering needs through a TripleBuffer, so they
+// never share state with it.
+//
+// The pipeline knows nothing of Direct3D and runs headless.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace DX
+{
+	// Milliseconds spent on the last frame each thread finished.
+	struct FramePipelineTimings
+	{
+		double simulation;
+		double render;
+		double waitForSimulation;		//time Simulate blocked on the previous frame, 0 when rendering is the slower
+	};
+
+	class FramePipeline
+	{
+	public:
+		typedef std::function<void()> Frame;
+
+		explicit FramePipeline(bool threaded);
+		~FramePipeline();					//finishes the frame being simulated
+
+		FramePipeline(const FramePipeline&) = delete;
+		FramePipeline& operator=(const FramePipeline&) = delete;
+
+		// Simulates a frame once the previous one has finished. Call it from the thread that renders.
+		void Simulate(Frame frame);
+
+		// Renders on the calling thread, timed.
+		void Render(const Frame& render);
+
+		// Waits for the frame being simulated. Call it before touching anything the simulation uses.
+		void Finish();
+
+		bool IsThreaded() const						{ return m_thread.joinable(); }
+		FramePipelineTimings GetTimings() const		{ return m_timings; }
+
+	private:
+		void SimulationMain();
+
+		std::thread					m_thread;
+		std::mutex					m_mutex;
+		std::condition_variable		m_changed;
+		Frame						m_frame;			//empty when the simulation thread is idle
+		double						m_simulationTime;	//written by the simulation thread under m_mutex
+		bool						m_stopping;
+
+		FramePipelineTimings		m_timings;			//only the rendering thread's
+	};
+}
@@ -8,6 +8,7 @@
 
 //toreorganise
 #include <fstream>
+#include <chrono>
 
 extern void ExitGame();
 
@@ -106,6 +107,89 @@ namespace
 
 	BloomPresets g_Bloom = Blurry;
 
+	//every file loaded in CreateDeviceDependentResources, cooked into the asset pack by -buildpack.
+	//DDS textures are stored uncompressed so they can be created straight from the mapped pack.
+	struct PackedAsset
+	{
+		const wchar_t*	name;
+		bool			compress;
+	};
+
+	static const PackedAsset g_PackedAssets[] =
+	{
+		{ L"Assets/SegoeUI_18.spritefont", true },
+		{ L"Assets/boat.obj", true },
+		{ L"Assets/water.obj", true },
+		{ L"Assets/terrain.obj", true },
+		{ L"Assets/submarine.obj", true },
+		{ L"Assets/palmsTrunck.obj", true },
+		{ L"Assets/palmsLeaves.obj", true },
+		{ L"Assets/rocks.obj", true },
+		{ L"Assets/dolphins.obj", true },
+		{ L"Assets/birds.obj", true },
+		{ L"Assets/rocket.obj", true },
+		{ L"Assets/watermine.obj", true },
+		{ L"Assets/rocket.mtl", true },
+		{ L"Assets/watermine.mtl", true },
+		{ L"light_vs.cso", true },
+		{ L"light_ps.cso", true },
+		{ L"terrain_ps.cso", true },
+		{ L"skybox_vs.cso", true },
+		{ L"skybox_ps.cso", true },
+		{ L"reflective_vs.cso", true },
+		{ L"reflective_ps.cso", true },
+		{ L"water_vs.cso", true },
+		{ L"water_ps.cso", true },
+		{ L"water_gs.cso", true },
+		{ L"shadow_ps.cso", true },
+		{ L"GaussianBlur.cso", true },
+		{ L"Assets/rock.dds", false },
+		{ L"Assets/leavesTexture.dds", false },
+		{ L"Assets/wood.dds", false },
+		{ L"Assets/water3.dds", false },
+		{ L"Assets/shadow.dds", false },
+		{ L"Assets/submarineTexture.dds", false },
+		{ L"Assets/firstBoatTexture.dds", false },
+		{ L"Assets/secondBoatTexture.dds", false },
+		{ L"Assets/dolphinsTexture.dds", false },
+		{ L"Assets/fatality.dds", false },
+		{ L"Assets/moss.dds", false },
+		{ L"Assets/sand.dds", false },
+		{ L"Assets/skybox3.dds", false },
+	};
+
+	//the models in g_PackedAssets, as the plain paths ModelClass loads
+	std::vector<std::string> GetPackedModelPaths()
+	{
+		std::vector<std::string> paths;
+		for (const PackedAsset& asset : g_PackedAssets)
+		{
+			std::wstring name(asset.name);
+			if (name.size() >= 4 && name.compare(name.size() - 4, 4, L".obj") == 0)
+			{
+				paths.push_back(std::string(name.begin(), name.end()));
+			}
+		}
+		return paths;
+	}
+
+	//missiles live five seconds and fire once per click, the pool grows if someone out-clicks it
+	const size_t MissilePoolCapacity = 128;
+
+	//watermines bob two units, so their fat boxes hold them most of the time
+	const float SceneTreeMargin = 2.0f;
+
+	//fewer visible objects than this are drawn straight on the immediate context, a batch is never smaller
+	const size_t MinDrawsPerBatch = 16;
+
+	DX::Aabb BoxAround(const BoundingSphere& sphere)
+	{
+		DX::Aabb box = {
+			{ sphere.Center.x - sphere.Radius, sphere.Center.y - sphere.Radius, sphere.Center.z - sphere.Radius },
+			{ sphere.Center.x + sphere.Radius, sphere.Center.y + sphere.Radius, sphere.Center.z + sphere.Radius } };
+		return box;
+	}
+
 	static const VS_BLOOM_PARAMETERS g_BloomPresets[] =
 	{
 		//Thresh  Blur Bloom  Base  BloomSat BaseSat
@@ -121,7 +205,9 @@ namespace
 
 using Microsoft::WRL::ComPtr;
 
-Game::Game() noexcept(false)
+Game::Game() noexcept(false) :
+	m_jobs(DX::JobSystem::DefaultWorkerCount()),
+	m_sceneTree(SceneTreeMargin)
 {
 	m_deviceResources = std::make_unique<DX::DeviceResources>();
 	m_deviceResources->RegisterDeviceNotify(this);
@@ -129,6 +215,16 @@ Game::Game() noexcept(false)
 
 Game::~Game()
 {
+	//the update being simulated finishes before the objects it uses go, and before the log of it is written
+	m_pipeline.reset();
+	if (m_recording)
+	{
+		std::ofstream file(m_recordPath.c_str(), std::ios::binary);
+		if (!m_inputLog.Write(file))
+		{
+			OutputDebugStringW(L"Game::~Game: could not write the input log\n");
+		}
+	}
 #ifdef DXTK_AUDIO
 	if (m_audEngine)
 	{
@@ -140,6 +236,13 @@ Game::~Game()
 // Initialize the Direct3D resources required to run.
 void Game::Initialize(HWND window, int width, int height)
 {
+	//mount the cooked asset pack if there is one, loose files are used otherwise
+	m_assetPack = std::make_unique<DX::AssetPack>();
+	if (m_assetPack->Open(L"Assets.pak"))
+	{
+		DX::AssetPack::Mount(m_assetPack.get());
+	}
+
 	m_input.Initialise(window);
 	m_deviceResources->SetWindow(window, width, height);
 
@@ -179,42 +282,55 @@ void Game::Initialize(HWND window, int width, int height)
 	m_Camera01.setLocalPosition(Vector3(0.0f, 5.0f, -12.0f));
 	m_Camera01.setRotation(Vector3(0.0f, 0.0f, 0.0f));
 	m_Camera01.setTag("camera");
+	m_Camera01.setParentObject(&m_playerObject);	//follows the player, offset along its axes
 
 	//set up player object
-	m_playerObject.Initialise(m_timer, &m_gameInputCommands, NULL);
-	m_playerObject.setModel(&submarineModel);
+	m_playerObject.setModel(submarineModel);
 	m_playerObject.setTag("player");
-	m_playerObject.setShader(&m_ReflectiveShader);
+	m_playerObject.setShader(m_ReflectiveShader);
 	m_playerObject.setTexture(m_textureSubmarine.Get());
 	m_playerObject.setReflective(true, m_textureSky.Get(), &m_Camera01);
 	m_playerObject.setLocalPosition(Vector3(190.0f, -1.0f, 290.0f));
 	m_playerObject.setRotation(Vector3(0.0f, 180.0f, 0.0f));
 	m_playerObject.setScale(Vector3(0.5f, 0.5f, 0.2f));
 	m_playerObject.setSphereCollider(BoundingSphere(m_playerObject.getPosition(), 3));
-	m_sceneObjectsList.push_back(&m_playerObject); //add player to scene list
+	m_playerObject.addToScene(); //add player to the scene
 
 	//setup terrain object
 	Terrain proceduralTerrain;
 	proceduralTerrain.Initialize(device, 512, 512);
-	m_terrainObject.Initialise(m_timer, &m_gameInputCommands, NULL);
 	m_terrainObject.setTag("terrain");
-	m_terrainObject.setShader(&m_TerrainShader);
+	m_terrainObject.setShader(m_TerrainShader);
 	m_terrainObject.setTexture(m_texture1.Get());
 	m_terrainObject.setHeightTextures(m_textureSand.Get(),m_textureRock.Get(),m_textureMoss.Get());
 	m_terrainObject.setLocalPosition(Vector3(0.0f, 0.0f, 0.0f));
 	m_terrainObject.setRotation(Vector3(0.0f, 0.0f, 0.0f));
 	m_terrainObject.setScale(Vector3(1.0f, 1.0f, 1.0f));
 	m_terrainObject.setTerrain(&proceduralTerrain);
-	m_sceneObjectsList.push_back(&m_terrainObject); //add terrain object to scene list
+	m_terrainObject.addToScene(); //add terrain object to the scene
 	//setup terrain heigh map
 	m_terrainObject.getTerrain()->GenerateRandomHeightMap(device, 240, 200, 400);
+	//missiles are swept against a copy of the height map, the terrain object sits at the origin unscaled
+	{
+		Terrain* terrain = m_terrainObject.getTerrain();
+		int width = terrain->GetTerrainWidth(), depth = terrain->GetTerrainHeight();
+		std::vector<float> heights(size_t(width) * depth);
+		for (int z = 0; z < depth; z++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				heights[size_t(z) * width + x] = terrain->GetHeightMapY(float(x), float(z));
+			}
+		}
+		DX::Float3 origin = { 0, 0, 0 };
+		m_terrainField.Set(heights.data(), width, depth, 1.0f, origin);
+	}
 
 	//setup water object
 	Terrain proceduralWater;
 	proceduralWater.Initialize(device, 512, 512);
-	m_waterObject.Initialise(m_timer, &m_gameInputCommands, NULL);
 	m_waterObject.setTag("water");
-	m_waterObject.setWaterShader(&m_WaterWithGeometryShader);
+	m_waterObject.setWaterShader(m_WaterWithGeometryShader);
 	m_waterObject.setTexture(m_textureWater.Get());
 	m_waterObject.setReflective(true, m_textureSky.Get(), &m_Camera01);
 	m_waterObject.setLocalPosition(Vector3(0.0f, 0.0f, 0.0f));
@@ -222,9 +338,10 @@ void Game::Initialize(HWND window, int width, int height)
 	m_waterObject.setScale(Vector3(1.0f, 1.0f, 1.0f));
 	m_waterObject.setTerrain(&proceduralWater);
 
-	//setup watermine objects
-	std::random_device rd; //obtain a random number from hardware
-	std::mt19937 gen(rd()); //seed the generator
+	//setup watermine objects, the pool holds the whole 25x25 grid in one block
+	m_watermines.Reserve(25 * 25);
+	m_missiles.Reserve(MissilePoolCapacity);
+	std::mt19937 gen(StartInputLog()); //seed the generator, from the replayed log or from hardware
 	for (int i = 0; i < 25; i++)
 	{
 		for (int j = 0; j < 25; j++) {
@@ -233,23 +350,52 @@ void Game::Initialize(HWND window, int width, int height)
 			{
 				std::uniform_int_distribution<> distr(heightPosition, -4.0f);
 				float randomHeight = distr(gen);
-				Watermine* watermine = new Watermine();
-				watermine->Initialise(m_timer, &m_gameInputCommands, NULL);
-				watermine->setModel(&watermineModel);
+				Watermine* watermine = m_watermines.Acquire();
+				watermine->setModel(watermineModel);
 				watermine->setTag("watermine");
-				watermine->setShader(&m_ReflectiveShader);
+				watermine->setShader(m_ReflectiveShader);
 				watermine->setTexture(m_textureSecondBoat.Get());
 				watermine->setReflective(true, m_textureSky.Get(), &m_Camera01);
 				watermine->setLocalPosition(Vector3(j * 20, randomHeight, i * 20));
 				watermine->setRotation(Vector3(0.0f, 90.0f, 0.0f));
 				watermine->setScale(Vector3(1.0f, 1.0f, 1.0f));
 				watermine->setSphereCollider(BoundingSphere(watermine->getPosition(), 2));
-				m_waterminesList.push_back(watermine); //add watermine to watermines list
-				m_sceneObjectsList.push_back(watermine); //add watermine to scene
+				watermine->addToScene(); //add watermine to the scene, its tag already puts it in the watermines view
 			}
 		}
 	}
 
+	//the objects placed at load go into the scene tree with one top down build, later ones are inserted as they appear
+	DX::EntityStore& store = GameObject::getEntityStore();
+	DX::UpdateTransforms(store);
+	std::vector<DX::Aabb> sceneBoxes;
+	std::vector<void*> sceneOwners;
+	for (GameObject* sceneObject : GameObjectView<GameObject>(DX::TagScene))
+	{
+		if (sceneObject->getModel())
+		{
+			sceneBoxes.push_back(BoxAround(sceneObject->getRenderBounds()));
+			sceneOwners.push_back(sceneObject);
+		}
+	}
+	std::vector<int32_t> sceneProxies(sceneBoxes.size());
+	m_sceneTree.CreateProxies(sceneBoxes.data(), sceneOwners.data(), sceneBoxes.size(), sceneProxies.data());
+	for (size_t i = 0; i < sceneProxies.size(); i++)
+	{
+		store.GetRenderHandle(static_cast<GameObject*>(sceneOwners[i])->getEntity()).sceneProxy = sceneProxies[i];
+	}
+
+	//every object now holds its assets, report what is resident and how widely it is shared
+	m_assets->LogResidentMemory();
+
+	//updates cover a fixed step and frames are drawn between the last two, unless -variablestep
+	m_timer.SetFixedTimeStep(m_fixedTimeStep);
+	m_timer.SetTargetElapsedSeconds(1.0 / m_simulationRate);
+	m_timer.SetMaxCatchUpUpdates(m_maxCatchUpUpdates);
+
+	//from the first Tick updates run on the simulation thread
+	m_pipeline = std::make_unique<DX::FramePipeline>(!m_singleThreadedFrames);
+
 #ifdef DXTK_AUDIO
 	// Create DirectXTK for Audio objects
 	AUDIO_ENGINE_FLAGS eflags = AudioEngine_Default;
@@ -278,121 +424,137 @@ void Game::Initialize(HWND window, int width, int height)
 // Executes the basic game loop.
 void Game::Tick()
 {
-	//take in input
+	//take in input, on the thread that owns the window
 	m_input.Update();								//update the hardware
-	m_gameInputCommands = m_input.getGameInput();	//retrieve the input for our game
+	InputCommands input = m_input.getGameInput();	//retrieve the input for our game
+	if (m_input.Quit())
+	{
+		ExitGame();
+	}
+
+	//a replay that ran out of updates reports the world it left and quits
+	if (m_replayFinished.exchange(false))
+	{
+		FinishReplay();
+		return;
+	}
 
-	//Update all game objects
-	m_timer.Tick([&]()
+	//Update all game objects, on the simulation thread unless running single threaded. The input is copied
+	//in, the next frame's is read while this one updates
+	m_pipeline->Simulate([this, input]()
 		{
-			Update(m_timer);
-		});
+			float alpha;
+			if (m_replaying)
+			{
+				//the recorded input and timestep stand in for the live ones, an update a frame drawn where it ends
+				DX::InputTick tick;
+				if (!m_inputReplay.Next(tick))
+				{
+					m_replayFinished = true;
+					return;
+				}
+				m_gameInputCommands = tick.input;
+				m_timer.Advance(tick.elapsedTicks, [&]()
+					{
+						Update(m_timer);
+					});
+				alpha = 1.0f;
+			}
+			else
+			{
+				//as many fixed steps as the clock has passed, maybe none, so a frame's input is gathered
+				//rather than handed straight to a step that might not run
+				m_stepInput.Gather(input);
+				m_timer.Tick([&]()
+					{
+						m_gameInputCommands = m_stepInput.Next();
+						Update(m_timer);
+					});
+				alpha = float(m_timer.GetInterpolationAlpha());
+			}
 
-	//Render all game content. 
-	Render();
+			//hand what Render needs to the render thread, every frame, so it is drawn between the last two steps
+			WriteSnapshot(m_snapshots.GetWriteBuffer(), alpha);
+			m_snapshots.Publish();
 
 #ifdef DXTK_AUDIO
-	// Only update audio engine once per frame
-	if (!m_audEngine->IsCriticalError() && m_audEngine->Update())
-	{
-		// Setup a retry in 1 second
-		m_audioTimerAcc = 1.f;
-		m_retryDefault = true;
-	}
+			// Only update audio engine once per frame, on the thread that plays the sounds in Update
+			if (!m_audEngine->IsCriticalError() && m_audEngine->Update())
+			{
+				// Setup a retry in 1 second
+				m_audioTimerAcc = 1.f;
+				m_retryDefault = true;
+			}
 #endif
+		});
 
-
+	//jobs queued for the immediate context, then render the newest updated frame
+	m_jobs.RunMainThreadJobs();
+	m_pipeline->Render([this]() { Render(); });
 }
 
 // Updates the world.
 void Game::Update(DX::StepTimer const& timer)
 {
-	//check if the mouse left button was released after being pressed
-	previousFireButtonState = currentFireButtonState;
-	currentFireButtonState = m_gameInputCommands.mouseButton;
+	//the placements from before this step are kept for drawing between it and the next
+	GameObject::getEntityStore().BeginStep();
 
-	//shoot only when releasing the left mouse button
-	if (previousFireButtonState && !currentFireButtonState)
+	//the time and input everything updated and drawn this step reads, written once here
+	m_frame.deltaTime = float(timer.GetElapsedSeconds());
+	m_frame.totalTime = timer.GetTotalSeconds();
+	m_frame.frame = timer.GetFrameCount();
+	m_frame.input = m_gameInputCommands;
+
+	if (m_recording)
 	{
-		CreateMissile();
+		m_inputLog.Append(m_frame.input, timer.GetElapsedTicks());
 	}
 
-	//update game objects delta time and inputs
-	m_Camera01.Initialise(m_timer, &m_gameInputCommands, &m_playerObject);
-	m_waterObject.Initialise(m_timer, &m_gameInputCommands, NULL);
-
-	//update camera and water
-	m_Camera01.Update();
-	m_waterObject.Update();
-
-	//update the rest of game objects
-	for (std::vector<GameObject*>::iterator it = m_sceneObjectsList.begin(); it != m_sceneObjectsList.end(); ++it) 
+	//shoot only when releasing the left mouse button
+	if (m_fireTrigger.Update(m_frame.input.mouseButton))
 	{
-		(*it)->Initialise(m_timer, &m_gameInputCommands, NULL);
-		(*it)->Update();
+		CreateMissile();
 	}
 
-	//check collisions between missiles and watermines
-	for (std::vector<Watermine*>::iterator waterminesIterator = m_waterminesList.begin(); waterminesIterator != m_waterminesList.end(); ++waterminesIterator)
+	//the player is the only object driven by input
+	if (!m_playerObject.getToDelete())
 	{
-		for (std::vector<GameObject*>::iterator missilesIterator = m_missilesList.begin(); missilesIterator != m_missilesList.end(); ++missilesIterator)
-		{
-			//if a missile hit a watermine, set both to be deleted
-			if ((*waterminesIterator)->toDelete != true && (*missilesIterator)->toDelete != true && (*missilesIterator)->getSphereCollider().Intersects((*waterminesIterator)->getSphereCollider()))
-			{
-				(*waterminesIterator)->toDelete = true;
-				(*missilesIterator)->toDelete = true;
-			}
-		}
-		if ((*waterminesIterator)->toDelete != true && m_playerObject.getSphereCollider().Intersects((*waterminesIterator)->getSphereCollider()))
-		{
-			m_playerObject.toDelete = true;
-			isGameOver = true;
-		}
+		m_playerObject.Update(m_frame);
 	}
 
-	//delete all the objects which are set to be deleted because of a collision or because their life time ended
-	for (int i = 0; i < m_sceneObjectsList.size(); i++)
+	//age, move and place every other object with one pass of each system over the component arrays. Transforms
+	//are placed parents first, so the camera, a child of the player, follows where the player is this frame
+	m_transformStats = DX::UpdateEntities(GameObject::getEntityStore(), m_frame.deltaTime, m_jobs);
+
+	//missiles against watermines and the terrain, and the player against watermines, the same step the headless driver runs
+	if (m_collisions.Resolve(GameObject::getEntityStore(), m_jobs, m_terrainField, m_playerObject.getEntity()).playerHit)
 	{
-		if (m_sceneObjectsList[i]->toDelete)
-		{
-			if (m_sceneObjectsList[i]->getTag() != "player")
-			{
-				delete m_sceneObjectsList[i];
-			}
-			//delete object from scene list
-			m_sceneObjectsList.erase(m_sceneObjectsList.begin() + i);
-		}
+		isGameOver = true;
 	}
-	//remove dead watermines from the watermines list
-	for (int i = 0; i < m_waterminesList.size(); i++)
+
+	//return the objects set to be deleted because of a collision or because their life time ended to their pools,
+	//the player is only hidden from the scene view until it is restarted
+	for (Watermine* watermine : GameObjectView<Watermine>(DX::TagWatermine, true))
 	{
-		if (m_waterminesList[i]->toDelete)
-		{
-			m_waterminesList.erase(m_waterminesList.begin() + i);
-		}
+		RemoveFromSceneTree(watermine);
+		m_watermines.Release(watermine);
 	}
-	//remove dead missiles from the missiles list
-	for (int i = 0; i < m_missilesList.size(); i++)
+	for (Missile* missile : GameObjectView<Missile>(DX::TagMissile, true))
 	{
-		if (m_missilesList[i]->toDelete)
-		{
-			m_missilesList.erase(m_missilesList.begin() + i);
-		}
+		RemoveFromSceneTree(missile);
+		m_missiles.Release(missile);
 	}
+	//released objects only queued their entities, compact the component arrays once for the whole frame
+	GameObject::getEntityStore().FlushDestroyed();
+	UpdateSceneTree();
 
 	//if the game is over and the player press the restart button
-	if (isGameOver && m_gameInputCommands.restart)
+	if (isGameOver && m_frame.input.restart)
 	{
 		isGameOver = false;
 		RestartGame();
 	}
 
-	//update world and view matrix
-	cameraPosition = m_Camera01.getPosition();
-	m_view = m_Camera01.getCameraMatrix();
-	m_world = Matrix::Identity;
-
 #ifdef DXTK_AUDIO
 	m_audioTimerAcc -= (float)timer.GetElapsedSeconds();
 	if (m_audioTimerAcc < 0)
@@ -417,11 +579,43 @@ void Game::Update(DX::StepTimer const& timer)
 		}
 	}
 #endif
+}
 
-	if (m_input.Quit())
+void Game::WriteSnapshot(FrameSnapshot& snapshot, float alpha)
+{
+	snapshot.frame = m_frame.frame;
+	snapshot.alpha = alpha;
+	snapshot.droppedUpdates = m_timer.GetDroppedUpdates();
+	snapshot.view = m_Camera01.getInterpolatedCameraMatrix(alpha);
+	snapshot.cameraPosition = m_Camera01.getInterpolatedPosition(alpha);
+	snapshot.waterLevel = m_waterObject.getPosition().y;
+	snapshot.gameOver = isGameOver;
+	snapshot.transformStats = m_transformStats;
+
+	//objects without a model, the terrain, are always drawn; the rest only when their bounds reach into the view
+	snapshot.unculled.clear();
+	for (GameObject* sceneObject : GameObjectView<GameObject>(DX::TagScene))
 	{
-		ExitGame();
+		if (!sceneObject->getModel())
+		{
+			snapshot.unculled.emplace_back();
+			sceneObject->recordDraw(snapshot.unculled.back(), m_frame, alpha);
+		}
 	}
+	SimpleMath::Matrix viewProjection = snapshot.view * m_projection;
+	m_visibleProxies.clear();
+	m_sceneTree.QueryFrustum(DX::Meshlets::ExtractFrustum(&viewProjection._11), m_visibleProxies);
+	snapshot.visible.clear();
+	for (int32_t proxy : m_visibleProxies)
+	{
+		GameObject* sceneObject = static_cast<GameObject*>(m_sceneTree.GetUserData(proxy));
+		if (!sceneObject->getToDelete())
+		{
+			snapshot.visible.emplace_back();
+			sceneObject->recordDraw(snapshot.visible.back(), m_frame, alpha);
+		}
+	}
+	m_waterObject.recordDraw(snapshot.water, m_frame, alpha);
 }
 
 #pragma endregion
@@ -431,11 +625,17 @@ void Game::Update(DX::StepTimer const& timer)
 //Draws the scene.
 void Game::Render()
 {
+	//the newest frame updated, which stays the same until the next Render
+	m_snapshots.Acquire();
+	const FrameSnapshot& snapshot = m_snapshots.GetReadBuffer();
+
 	// Don't try to render anything before the first Update.
-	if (m_timer.GetFrameCount() == 0)
+	if (snapshot.frame == 0)
 	{
 		return;
 	}
+	m_view = snapshot.view;
+	cameraPosition = snapshot.cameraPosition;
 	Clear();
 	m_deviceResources->PIXBeginEvent(L"Render");
 	auto context = m_deviceResources->GetD3DDeviceContext();
@@ -443,6 +643,29 @@ void Game::Render()
 	//Draw Text to the screen
 	m_sprites->Begin();
 	m_font->DrawString(m_sprites.get(), L"DirectXTK Demo Window", XMFLOAT2(100, 100), Colors::Yellow);
+	wchar_t transformText[128];
+	swprintf_s(transformText, L"Transforms: %u placed in %u hierarchies, critical path %u",
+		(unsigned)snapshot.transformStats.placed, (unsigned)snapshot.transformStats.hierarchies, (unsigned)snapshot.transformStats.criticalPath);
+	m_font->DrawString(m_sprites.get(), transformText, XMFLOAT2(100, 130), Colors::Yellow);
+	DX::FramePipelineTimings timings = m_pipeline->GetTimings();
+	wchar_t timingText[128];
+	swprintf_s(timingText, L"Update %.2f ms, render %.2f ms, waited %.2f ms%s", timings.simulation, timings.render,
+		timings.waitForSimulation, m_pipeline->IsThreaded() ? L"" : L" (single threaded)");
+	m_font->DrawString(m_sprites.get(), timingText, XMFLOAT2(100, 160), Colors::Yellow);
+	wchar_t drawText[128];
+	swprintf_s(drawText, L"Draws: %u in %u batches, recorded in %.2f ms, executed in %.2f ms",
+		(unsigned)m_drawStats.draws, (unsigned)m_drawStats.batches, m_drawStats.recordTime, m_drawStats.executeTime);
+	m_font->DrawString(m_sprites.get(), drawText, XMFLOAT2(100, 190), Colors::Yellow);
+	wchar_t stepText[128];
+	if (m_fixedTimeStep)
+	{
+		swprintf_s(stepText, L"Simulation: %.0f Hz, drawn %.2f of a step on, %llu steps dropped", m_simulationRate, snapshot.alpha, (unsigned long long)snapshot.droppedUpdates);
+	}
+	else
+	{
+		swprintf_s(stepText, L"Simulation: variable timestep");
+	}
+	m_font->DrawString(m_sprites.get(), stepText, XMFLOAT2(100, 220), Colors::Yellow);
 	m_sprites->End();
 
 	//Set Rendering states. 
@@ -459,13 +682,13 @@ void Game::Render()
 	RenderSceneObjects();
 
 	//UNDERWATER POST-PROCESSING (if the camera is below the level of water)
-	if (m_Camera01.getPosition().y < m_waterObject.getPosition().y)
+	if (cameraPosition.y < snapshot.waterLevel)
 	{
 		PostProcessing();
 	}
 
 	//if the game is over print on screen
-	if(isGameOver) {
+	if(snapshot.gameOver) {
 		m_sprites->Begin();
 		m_sprites->Draw(m_textureGameOver.Get(), m_UIRect);
 		m_sprites->End();
@@ -506,6 +729,7 @@ void Game::RenderTexturePass1()
 void Game::RenderSceneObjects()
 {
 	auto context = m_deviceResources->GetD3DDeviceContext();
+	const FrameSnapshot& snapshot = m_snapshots.GetReadBuffer();
 
 	float blendFactor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
@@ -515,22 +739,52 @@ void Game::RenderSceneObjects()
 
 	//prepare transform for floor object. 
 	m_world = SimpleMath::Matrix::Identity; //set world back to identity
-	SimpleMath::Matrix newPosition0 = SimpleMath::Matrix::CreateTranslation(m_Camera01.getPosition());
+	SimpleMath::Matrix newPosition0 = SimpleMath::Matrix::CreateTranslation(cameraPosition);
 	m_world = m_world * newPosition0;
 
 	//setup and draw skybox
-	m_SkyboxShader.EnableShader(context);
-	m_SkyboxShader.SetShaderParameters(context, &m_world, &m_view, &m_projection, &m_Light, m_textureSky.Get());
-	SkyboxBox.Render(context);
+	m_SkyboxShader->EnableShader(context);
+	m_SkyboxShader->SetShaderParameters(context, &m_world, &m_view, &m_projection, &m_Light, m_textureSky.Get());
+	SkyboxBox->Render(context);
 
 	//enabling the depth buffer
 	context->OMSetDepthStencilState(m_states->DepthDefault(), 0);
 	//END SKYBOX------------------
 
 	//RENDER SCENE OBJECTS--------
-	for (std::vector<GameObject*>::iterator it = m_sceneObjectsList.begin(); it != m_sceneObjectsList.end(); ++it)
+	//culled by the update that recorded them; objects with a model may already be back in their pools, so only the draw is read
+	for (const GameObjectDraw& draw : snapshot.unculled)
+	{
+		draw.object->Render(context, draw, &m_view, &m_projection, &m_Light);
+	}
+	//the rest are split across the workers, each recording on a deferred context, and executed here in list order
+	if (m_deferredContexts.IsCreated() && snapshot.visible.size() >= MinDrawsPerBatch * 2)
 	{
-		(*it)->Render(context, &m_view, &m_projection, &m_Light);
+		//the finest level's triangles stand in for the cost of a draw
+		m_drawCosts.clear();
+		for (const GameObjectDraw& draw : snapshot.visible)
+		{
+			m_drawCosts.push_back(float(draw.model->GetLodTriangleCount(0)));
+		}
+		m_deferredContexts.CaptureState();
+		m_deferredContexts.SetRecordFunction([this, &snapshot](ID3D11DeviceContext* deferred, const DX::DrawBatch& draws)
+		{
+			for (size_t i = draws.begin; i < draws.end; i++)
+			{
+				GameObject::RenderModel(deferred, snapshot.visible[i], &m_view, &m_projection, &m_Light);
+			}
+		});
+		m_drawStats = DX::RecordInParallel(m_jobs, m_deferredContexts, m_drawCosts.data(), m_drawCosts.size(), MinDrawsPerBatch);
+	}
+	else
+	{
+		for (const GameObjectDraw& draw : snapshot.visible)
+		{
+			GameObject::RenderModel(context, draw, &m_view, &m_projection, &m_Light);
+		}
+		m_drawStats = DX::RecordingStats();
+		m_drawStats.draws = snapshot.visible.size();
+		m_drawStats.batches = 1;
 	}
 	//END RENDER SCENE OBJECTS--------
 
@@ -541,12 +795,12 @@ void Game::RenderSceneObjects()
 	context->OMSetBlendState(TransparentBS, blendFactor, 0xFFFFFFFF);
 
 	//if the camera is below the level of water render the water upside down
-	if (m_Camera01.getPosition().y < m_waterObject.getPosition().y)
+	if (cameraPosition.y < snapshot.waterLevel)
 	{
 		context->RSSetState(m_states->CullCounterClockwise());
 	}
 	//prepare transform for water mirror
-	m_waterObject.Render(context, &m_view, &m_projection, &m_Light);
+	m_waterObject.Render(context, snapshot.water, &m_view, &m_projection, &m_Light);
 
 	//set the render back to clockwise
 	context->RSSetState(m_states->CullClockwise());
@@ -600,21 +854,53 @@ void Game::PostProcessing()
 
 void Game::CreateMissile()
 {
-	Missile* missile = new Missile();
+	Missile* missile = m_missiles.Acquire();
+	if (missile == nullptr)
+	{
+		return;
+	}
 	//set up player object
-	missile->Initialise(m_timer, &m_gameInputCommands, NULL);
-	missile->setModel(&missileModel);
-	missile->setShader(&m_ReflectiveShader);
+	missile->setModel(missileModel);
+	missile->setShader(m_ReflectiveShader);
 	missile->setTag("watermine");
 	missile->setTexture(m_textureSubmarine.Get());
 	//missile->setReflective(true, m_textureSky.Get(), &m_Camera01);
-	missile->setLocalPosition(m_playerObject.getPosition() + m_playerObject.getForward() * 4);
-	missile->setRotation(m_playerObject.getRotation());
-	missile->setScale(Vector3(1.0f, 1.0f, 1.0f));
-	missile->setSphereCollider(BoundingSphere(missile->getPosition(), 2));
-	m_missilesList.push_back(missile); //add missile to missile list
-	m_sceneObjectsList.push_back(missile); //add missile to the scene
+	DX::LaunchMissile(GameObject::getEntityStore(), missile->getEntity(), m_playerObject.getEntity());
+	missile->addToScene(); //add missile to the scene, its tag already puts it in the missiles view
 }
+void Game::UpdateSceneTree()
+{
+	//objects that stayed inside their fat boxes cost a containment test
+	DX::EntityStore& store = GameObject::getEntityStore();
+	for (GameObject* sceneObject : GameObjectView<GameObject>(DX::TagScene))
+	{
+		if (!sceneObject->getModel())
+		{
+			continue;
+		}
+		DX::Aabb box = BoxAround(sceneObject->getRenderBounds());
+		int32_t& proxy = store.GetRenderHandle(sceneObject->getEntity()).sceneProxy;
+		if (proxy == DX::AabbTree::NullNode)
+		{
+			proxy = m_sceneTree.CreateProxy(box, sceneObject);
+		}
+		else
+		{
+			m_sceneTree.MoveProxy(proxy, box);
+		}
+	}
+}
+
+void Game::RemoveFromSceneTree(GameObject* gameObject)
+{
+	int32_t& proxy = GameObject::getEntityStore().GetRenderHandle(gameObject->getEntity()).sceneProxy;
+	if (proxy != DX::AabbTree::NullNode)
+	{
+		m_sceneTree.DestroyProxy(proxy);
+		proxy = DX::AabbTree::NullNode;
+	}
+}
+
 void Game::RenderReflectedScene()
 {
 	//float blendFactor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
@@ -704,12 +990,238 @@ void Game::RenderPlanarShadows()
 
 }
 
+// Cooks every asset the game loads into a single pack file.
+bool Game::BuildAssetPack(const wchar_t* filename)
+{
+	DX::AssetPackWriter writer;
+	for (const PackedAsset& asset : g_PackedAssets)
+	{
+		writer.AddFile(asset.name, asset.name, asset.compress);
+	}
+	return writer.Write(filename);
+}
+
+// Generates the levels of detail for every packed model and lists their triangle counts and errors.
+bool Game::WriteLodReport(const wchar_t* filename)
+{
+	std::wofstream report(filename);
+	if (!report)
+	{
+		return false;
+	}
+
+	DX::MeshSimplifier::LodChainOptions options;
+	bool allLoaded = true;
+	for (const std::string& path : GetPackedModelPaths())
+	{
+		std::wstring name(path.begin(), path.end());
+		ModelClass model;
+		if (!model.LoadGeometry(path.c_str()))
+		{
+			report << name << L": failed to load\n";
+			allLoaded = false;
+			continue;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		model.GenerateLods(options);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		wchar_t line[256];
+		swprintf_s(line, L"%s: radius %.3f, %d submeshes, %d levels in %.1f ms\n", name.c_str(), model.GetBoundingRadius(), model.GetSubmeshCount(), model.GetLodCount(), ms);
+		report << line;
+		OutputDebugStringW(line);
+		for (int lod = 0; lod < model.GetLodCount(); lod++)
+		{
+			swprintf_s(line, L"  lod %d  %7d triangles  error %.4f (%.4f units)\n",
+				lod, model.GetLodTriangleCount(lod), model.GetLodError(lod), model.GetLodError(lod) * model.GetBoundingRadius());
+			report << line;
+			OutputDebugStringW(line);
+		}
+	}
+	return allLoaded;
+}
+
+// Encodes every packed model in each vertex format and lists the size and the largest round trip errors.
+bool Game::WriteVertexFormatReport(const wchar_t* filename)
+{
+	std::wofstream report(filename);
+	if (!report)
+	{
+		return false;
+	}
+
+	bool allLoaded = true;
+	for (const std::string& path : GetPackedModelPaths())
+	{
+		std::wstring name(path.begin(), path.end());
+		ModelClass model;
+		if (!model.LoadGeometry(path.c_str()))
+		{
+			report << name << L": failed to load\n";
+			allLoaded = false;
+			continue;
+		}
+
+		wchar_t line[256];
+		swprintf_s(line, L"%s: %d vertices, radius %.3f\n", name.c_str(), model.GetVertexCount(), model.GetBoundingRadius());
+		report << line;
+		OutputDebugStringW(line);
+		for (int format = 0; format < DX::VertexFormatCount; format++)
+		{
+			DX::VertexRoundTripError error = model.MeasureVertexFormat((DX::VertexFormat)format);
+			size_t stride = DX::GetVertexStride((DX::VertexFormat)format);
+			swprintf_s(line, L"  %-9s %2u bytes  %8.1f KB  position %.6f  normal %.3f deg  texcoord %.6f\n",
+				DX::GetVertexFormatName((DX::VertexFormat)format), (unsigned)stride, stride * model.GetVertexCount() / 1024.0,
+				error.position, error.normalDegrees, error.texcoord);
+			report << line;
+			OutputDebugStringW(line);
+		}
+	}
+	return allLoaded;
+}
+
+// Splits every packed model into meshlets and counts the triangles that survive culling from a fixed set of cameras.
+bool Game::WriteMeshletReport(const wchar_t* filename)
+{
+	std::wofstream report(filename);
+	if (!report)
+	{
+		return false;
+	}
+
+	//same projection as CreateWindowSizeDependentResources at the default 1366x768 window
+	Matrix projection = Matrix::CreatePerspectiveFieldOfView(70.0f * XM_PI / 180.0f, 1366.0f / 768.0f, 0.01f, 1000.0f);
+
+	//six views from outside, in units of the bounding radius, then two from close by looking past the model
+	struct ReportCamera
+	{
+		Vector3 position;
+		Vector3 target;
+	};
+	static const ReportCamera cameras[] =
+	{
+		{ Vector3(0, 0, 3), Vector3(0, 0, 0) },
+		{ Vector3(0, 0, -3), Vector3(0, 0, 0) },
+		{ Vector3(3, 0, 0), Vector3(0, 0, 0) },
+		{ Vector3(-3, 0, 0), Vector3(0, 0, 0) },
+		{ Vector3(0, 3, 0.01f), Vector3(0, 0, 0) },
+		{ Vector3(2, 1, 2), Vector3(0, 0, 0) },
+		{ Vector3(0, 0, 1.2f), Vector3(2, 0, 1.2f) },
+		{ Vector3(1.2f, 0.5f, 0), Vector3(1.2f, 0.5f, 2) },
+	};
+
+	bool allLoaded = true;
+	for (const std::string& path : GetPackedModelPaths())
+	{
+		std::wstring name(path.begin(), path.end());
+		ModelClass model;
+		if (!model.LoadGeometry(path.c_str()))
+		{
+			report << name << L": failed to load\n";
+			allLoaded = false;
+			continue;
+		}
+
+		//weld like the game does, the unrolled obj triangles share no vertices
+		DX::MeshSimplifier::LodChainOptions noLods;
+		noLods.ratios.clear();
+		model.GenerateLods(noLods);
+		model.GenerateMeshlets();
+
+		Vector3 center = model.GetBoundingCenter();
+		float radius = model.GetBoundingRadius();
+		std::vector<DX::Meshlets::DrawRange> ranges;
+
+		DX::Meshlets::CullStats total = { 0, 0, 0, 0 };
+		size_t totalRanges = 0;
+		wchar_t line[256];
+		for (const ReportCamera& camera : cameras)
+		{
+			Vector3 eye = center + camera.position * radius;
+			Matrix view = Matrix::CreateLookAt(eye, center + camera.target * radius, Vector3::UnitY);
+			Matrix viewProjection = view * projection;
+
+			ranges.clear();
+			DX::Meshlets::CullStats stats = { 0, 0, 0, 0 };
+			model.CullMeshlets(0, Matrix::Identity, DX::Meshlets::ExtractFrustum(&viewProjection._11), eye, ranges, &stats);
+			total.meshlets += stats.meshlets;
+			total.triangles += stats.triangles;
+			total.frustumCulled += stats.frustumCulled;
+			total.backfaceCulled += stats.backfaceCulled;
+			totalRanges += ranges.size();
+		}
+
+		int triangles = model.GetLodTriangleCount(0);
+		size_t meshlets = total.meshlets / ARRAYSIZE(cameras);
+		swprintf_s(line, L"%s: %d triangles in %u meshlets (%.1f each)\n", name.c_str(), triangles, (unsigned)meshlets, meshlets ? triangles / double(meshlets) : 0.0);
+		report << line;
+		OutputDebugStringW(line);
+		swprintf_s(line, L"  over %u cameras: %.1f%% drawn, %.1f%% outside the frustum, %.1f%% back facing, %.1f draws per view\n",
+			(unsigned)ARRAYSIZE(cameras),
+			100.0 * (total.triangles - total.frustumCulled - total.backfaceCulled) / std::max<size_t>(total.triangles, 1),
+			100.0 * total.frustumCulled / std::max<size_t>(total.triangles, 1),
+			100.0 * total.backfaceCulled / std::max<size_t>(total.triangles, 1),
+			totalRanges / double(ARRAYSIZE(cameras)));
+		report << line;
+		OutputDebugStringW(line);
+	}
+	return allLoaded;
+}
+
+unsigned int Game::StartInputLog()
+{
+	//a replay places the watermines with the seed it was recorded with, a recording keeps the one drawn here
+	if (!m_replayPath.empty())
+	{
+		std::ifstream file(m_replayPath.c_str(), std::ios::binary);
+		if (m_inputLog.Read(file))
+		{
+			m_inputReplay = DX::InputReplay(m_inputLog);
+			m_replaying = true;
+			return m_inputLog.GetSeed();
+		}
+		OutputDebugStringW(L"Game::StartInputLog: the replay is not an input log, playing live\n");
+	}
+	std::random_device rd; //obtain a random number from hardware
+	unsigned int seed = rd();
+	if (!m_recordPath.empty())
+	{
+		m_inputLog.Clear(seed);
+		m_recording = true;
+	}
+	return seed;
+}
+
+void Game::FinishReplay()
+{
+	//the last replayed update has run once the pipeline is idle, and nothing updates until the next Simulate
+	m_pipeline->Finish();
+	m_replaying = false;
+	uint64_t hash = DX::HashWorld(GameObject::getEntityStore());
+	bool matches = !m_hasGoldenHash || hash == m_goldenHash;
+
+	std::wofstream file(L"ReplayResult.txt");
+	wchar_t line[256];
+	swprintf_s(line, L"Replayed %zu updates of %s, seed %u\nWorld hash: %016llx\n", m_inputReplay.GetPosition(), m_replayPath.c_str(), m_inputLog.GetSeed(), (unsigned long long)hash);
+	file << line;
+	OutputDebugStringW(line);
+	if (m_hasGoldenHash)
+	{
+		swprintf_s(line, L"Golden hash: %016llx, %s\n", (unsigned long long)m_goldenHash, matches ? L"the world matches" : L"the world differs");
+		file << line;
+		OutputDebugStringW(line);
+	}
+	PostQuitMessage(matches ? 0 : 1);
+}
+
 void Game::RestartGame()
 {
-	m_playerObject.toDelete = false;
+	m_playerObject.setToDelete(false);
 	m_playerObject.setLocalPosition(Vector3(190.0f, -1.0f, 290.0f));
 	m_playerObject.setRotation(Vector3(0.0f, 180.0f, 0.0f));
-	m_sceneObjectsList.push_back(&m_playerObject);
+	//back at the start at once rather than drawn sliding there, the camera with it
+	GameObject::getEntityStore().ResetInterpolation(m_playerObject.getEntity());
 }
 // Helper method to clear the back buffers.
 void Game::Clear()
@@ -746,6 +1258,12 @@ void Game::OnDeactivated()
 
 void Game::OnSuspending()
 {
+	//the frame being simulated plays sounds and steps the timer, let it finish first
+	if (m_pipeline)
+	{
+		m_pipeline->Finish();
+	}
+
 #ifdef DXTK_AUDIO
 	m_audEngine->Suspend();
 #endif
@@ -753,6 +1271,10 @@ void Game::OnSuspending()
 
 void Game::OnResuming()
 {
+	if (m_pipeline)
+	{
+		m_pipeline->Finish();
+	}
 	m_timer.ResetElapsedTime();
 
 #ifdef DXTK_AUDIO
@@ -771,12 +1293,22 @@ void Game::OnWindowSizeChanged(int width, int height)
 	if (!m_deviceResources->WindowSizeChanged(width, height))
 		return;
 
+	//the update reads the projection to cull
+	if (m_pipeline)
+	{
+		m_pipeline->Finish();
+	}
 	CreateWindowSizeDependentResources();
 }
 
 #ifdef DXTK_AUDIO
 void Game::NewAudioDevice()
 {
+	//the retry is counted down in Update
+	if (m_pipeline)
+	{
+		m_pipeline->Finish();
+	}
 	if (m_audEngine && !m_audEngine->IsAudioDevicePresent())
 	{
 		// Setup a retry in 1 second
@@ -801,51 +1333,102 @@ void Game::CreateDeviceDependentResources()
 	auto context = m_deviceResources->GetD3DDeviceContext();
 	auto device = m_deviceResources->GetD3DDevice();
 
+	//time the asset loading so runs with and without the pack can be compared
+	auto loadStart = std::chrono::high_resolution_clock::now();
+
 	m_states = std::make_unique<CommonStates>(device);
 	m_fxFactory = std::make_unique<EffectFactory>(device);
 	m_sprites = std::make_unique<SpriteBatch>(context);
-	m_font = std::make_unique<SpriteFont>(device, L"Assets/SegoeUI_18.spritefont");
+
+	//one deferred context per thread that can record, the workers and the render thread
+	if (m_jobs.GetWorkerCount() != 0 && m_deferredContexts.Create(device, context, m_jobs.GetWorkerCount() + 1))
+	{
+		OutputDebugStringW(m_deferredContexts.HasDriverCommandLists() ? L"Deferred contexts: driver command lists\n" : L"Deferred contexts: emulated command lists\n");
+	}
+
+	//every asset below is independent, so they are spread over a worker pool and waited on together
+	DX::AssetLoader loader(m_serialAssetLoading ? 0 : DX::AssetLoader::DefaultWorkerCount());
+	DX::AssetPack* pack = DX::AssetPack::GetMounted();
+
+	loader.Load(L"Assets/SegoeUI_18.spritefont", [this, device, pack]()
+	{
+		std::vector<uint8_t> fontData;
+		if (pack && pack->ReadEntry(L"Assets/SegoeUI_18.spritefont", fontData))
+		{
+			m_font = std::make_unique<SpriteFont>(device, fontData.data(), fontData.size());
+		}
+		else
+		{
+			m_font = std::make_unique<SpriteFont>(device, L"Assets/SegoeUI_18.spritefont");
+		}
+	});
+
+	//models, shaders and textures come from the registry, so repeated paths share one copy
+	m_assets = std::make_unique<DX::AssetRegistry>(device);
+
+	auto loadModel = [this, &loader](std::shared_ptr<ModelClass>* model, const char* filename, unsigned int flags)
+	{
+		loader.Load(std::wstring(filename, filename + strlen(filename)), [this, model, filename, flags]() { *model = m_assets->GetModel(filename, flags); });
+	};
+	auto loadTexture = [this, &loader](ComPtr<ID3D11ShaderResourceView>* texture, const wchar_t* filename, size_t maxsize)
+	{
+		loader.Load(filename, [this, texture, filename, maxsize]() { *texture = m_assets->GetTexture(filename, maxsize); });
+	};
 
 	//setup models
-	m_BasicModel.InitializeTeapot(device);
-	boatModel.InitializeModel(device, "Assets/boat.obj");
-	waterModel.InitializeModel(device, "Assets/water.obj");	//box includes dimensions
-	SkyboxBox.InitializeBox(device, 5.0f, 5.0f, 5.0f);
-	terrainModel.InitializeModel(device, "Assets/terrain.obj");
-	submarineModel.InitializeModel(device, "Assets/submarine.obj");
-	palmsTrunckModel.InitializeModel(device, "Assets/palmsTrunck.obj");
-	palmsLeavesModel.InitializeModel(device, "Assets/palmsLeaves.obj");
-	rocksModel.InitializeModel(device, "Assets/rocks.obj");
-	dolphinsModel.InitializeModel(device, "Assets/dolphins.obj");
-	birdsModel.InitializeModel(device, "Assets/birds.obj");
-	missileModel.InitializeModel(device, "Assets/rocket.obj");
-	watermineModel.InitializeModel(device, "Assets/watermine.obj");
+	loader.Load(L"teapot", [this]()
+	{
+		m_BasicModel = m_assets->GetProceduralModel(L"teapot", [](ModelClass& model, ID3D11Device* device) { return model.InitializeTeapot(device); });
+	});
+	loader.Load(L"skybox box", [this]()
+	{
+		SkyboxBox = m_assets->GetProceduralModel(L"box 5x5x5", [](ModelClass& model, ID3D11Device* device) { return model.InitializeBox(device, 5.0f, 5.0f, 5.0f); });
+	});
+	//props get simplified levels of detail, 16 byte vertices and meshlets, the water and terrain surround the camera and always draw in full
+	const unsigned int lods = DX::AssetRegistry::ModelGenerateLods | DX::AssetRegistry::ModelVertexQuantized | DX::AssetRegistry::ModelBuildMeshlets;
+	loadModel(&boatModel, "Assets/boat.obj", lods);
+	loadModel(&waterModel, "Assets/water.obj", DX::AssetRegistry::ModelDefault);	//box includes dimensions
+	loadModel(&terrainModel, "Assets/terrain.obj", DX::AssetRegistry::ModelDefault);
+	loadModel(&submarineModel, "Assets/submarine.obj", lods);
+	loadModel(&palmsTrunckModel, "Assets/palmsTrunck.obj", lods);
+	loadModel(&palmsLeavesModel, "Assets/palmsLeaves.obj", lods);
+	loadModel(&rocksModel, "Assets/rocks.obj", lods);
+	loadModel(&dolphinsModel, "Assets/dolphins.obj", lods);
+	loadModel(&birdsModel, "Assets/birds.obj", lods);
+	loadModel(&missileModel, "Assets/rocket.obj", lods);
+	loadModel(&watermineModel, "Assets/watermine.obj", lods);
 
 
 	//load and set up our Vertex and Pixel Shaders
-	m_DefaultShader.InitStandard(device, L"light_vs.cso", L"light_ps.cso");
-	m_TerrainShader.InitStandard(device, L"light_vs.cso", L"terrain_ps.cso");
-	m_SkyboxShader.InitStandard(device, L"skybox_vs.cso", L"skybox_ps.cso");
-	m_ReflectiveShader.InitStandard(device, L"reflective_vs.cso", L"reflective_ps.cso");
-	m_WaterShader.InitStandard(device, L"water_vs.cso", L"water_ps.cso");
-	m_PlanarShadowShader.InitStandard(device, L"light_vs.cso", L"shadow_ps.cso");
-	m_WaterWithGeometryShader.InitStandard(device, L"water_vs.cso", L"water_ps.cso", L"water_gs.cso");
+	loader.Load(L"light_vs.cso, light_ps.cso", [this]() { m_DefaultShader = m_assets->GetShader(L"light_vs.cso", L"light_ps.cso"); });
+	loader.Load(L"light_vs.cso, terrain_ps.cso", [this]() { m_TerrainShader = m_assets->GetShader(L"light_vs.cso", L"terrain_ps.cso"); });
+	loader.Load(L"skybox_vs.cso, skybox_ps.cso", [this]() { m_SkyboxShader = m_assets->GetShader(L"skybox_vs.cso", L"skybox_ps.cso"); });
+	loader.Load(L"reflective_vs.cso, reflective_ps.cso", [this]() { m_ReflectiveShader = m_assets->GetShader(L"reflective_vs.cso", L"reflective_ps.cso"); });
+	loader.Load(L"water_vs.cso, water_ps.cso", [this]() { m_WaterShader = m_assets->GetShader(L"water_vs.cso", L"water_ps.cso"); });
+	loader.Load(L"light_vs.cso, shadow_ps.cso", [this]() { m_PlanarShadowShader = m_assets->GetShader(L"light_vs.cso", L"shadow_ps.cso"); });
+	loader.Load(L"water_vs.cso, water_ps.cso, water_gs.cso", [this]() { m_WaterWithGeometryShader = m_assets->GetWaterShader(L"water_vs.cso", L"water_ps.cso", L"water_gs.cso"); });
+	loader.Load(L"GaussianBlur.cso", [this, device]()
+	{
+		auto blob = DX::MapData(L"GaussianBlur.cso");
+		DX::ThrowIfFailed(device->CreatePixelShader(blob.data(), blob.size(),
+			nullptr, m_gaussianBlurPS.ReleaseAndGetAddressOf()));
+	});
 
 	//load Textures
-	CreateDDSTextureFromFile(device, L"Assets/rock.dds", nullptr, m_texture1.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/leavesTexture.dds", nullptr, m_textureLeaves.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/wood.dds", nullptr, m_textureWood.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/water3.dds", nullptr, m_textureWater.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/shadow.dds", nullptr, m_textureShadow.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/submarineTexture.dds", nullptr, m_textureSubmarine.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/firstBoatTexture.dds", nullptr, m_textureFirstBoat.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/secondBoatTexture.dds", nullptr, m_textureSecondBoat.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/rock.dds", nullptr, m_textureRock.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/dolphinsTexture.dds", nullptr, m_textureDolphins.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/fatality.dds", nullptr, m_textureGameOver.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/moss.dds", nullptr, m_textureMoss.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/sand.dds", nullptr, m_textureSand.ReleaseAndGetAddressOf());
-	CreateDDSTextureFromFile(device, L"Assets/skybox3.dds", nullptr, m_textureSky.ReleaseAndGetAddressOf(), D3D11_RESOURCE_MISC_TEXTURECUBE);
+	loadTexture(&m_texture1, L"Assets/rock.dds", 0);
+	loadTexture(&m_textureLeaves, L"Assets/leavesTexture.dds", 0);
+	loadTexture(&m_textureWood, L"Assets/wood.dds", 0);
+	loadTexture(&m_textureWater, L"Assets/water3.dds", 0);
+	loadTexture(&m_textureShadow, L"Assets/shadow.dds", 0);
+	loadTexture(&m_textureSubmarine, L"Assets/submarineTexture.dds", 0);
+	loadTexture(&m_textureFirstBoat, L"Assets/firstBoatTexture.dds", 0);
+	loadTexture(&m_textureSecondBoat, L"Assets/secondBoatTexture.dds", 0);
+	loadTexture(&m_textureRock, L"Assets/rock.dds", 0);		//same texture as m_texture1, the registry hands back the first one
+	loadTexture(&m_textureDolphins, L"Assets/dolphinsTexture.dds", 0);
+	loadTexture(&m_textureGameOver, L"Assets/fatality.dds", 0);
+	loadTexture(&m_textureMoss, L"Assets/moss.dds", 0);
+	loadTexture(&m_textureSand, L"Assets/sand.dds", 0);
+	loadTexture(&m_textureSky, L"Assets/skybox3.dds", D3D11_RESOURCE_MISC_TEXTURECUBE);
 	
 	int width = m_CameraViewRect.right;
 	int height = m_CameraViewRect.bottom;
@@ -853,10 +1436,15 @@ void Game::CreateDeviceDependentResources()
 	//Initialise Render to texture
 	m_FirstRenderPass = new RenderTexture(device, width, height, 1, 2);	//for our rendering, We dont use the last two properties. but.  they cant be zero and they cant be the same. 
 
-	//gaussian blur
-	auto blob = DX::ReadData(L"GaussianBlur.cso");
-	DX::ThrowIfFailed(device->CreatePixelShader(blob.data(), blob.size(),
-		nullptr, m_gaussianBlurPS.ReleaseAndGetAddressOf()));
+	loader.WaitAll();
+
+	auto loadEnd = std::chrono::high_resolution_clock::now();
+	char loadMessage[128];
+	sprintf_s(loadMessage, "Asset loading took %.2f ms (%s, %u workers)\n",
+		std::chrono::duration<double, std::milli>(loadEnd - loadStart).count(),
+		pack ? "asset pack" : "loose files", loader.GetWorkerCount());
+	OutputDebugStringA(loadMessage);
+	loader.LogTimeline();
 
 	//blur resources
 	CD3D11_BUFFER_DESC cbDesc(sizeof(VS_BLUR_PARAMETERS),
@@ -1037,11 +1625,20 @@ void Game::CreateWindowSizeDependentResources()
 		0.01f,
 		1000.0f
 	);
+
+	//levels of detail are chosen by their error in pixels, which depends on the window height
+	GameObject::setLodViewport(float(size.bottom - size.top), 1.0f);
 }
 
 
 void Game::OnDeviceLost()
 {
+	if (m_pipeline)
+	{
+		m_pipeline->Finish();
+	}
+	m_deferredContexts.Reset();
+	m_assets.reset();
 	m_states.reset();
 	m_fxFactory.reset();
 	m_sprites.reset();
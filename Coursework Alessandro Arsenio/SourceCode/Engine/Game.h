@@ -20,6 +20,22 @@
 #include "Missile.h"
 #include "TerrainObject.h"
 #include "Watermine.h"
+#include "AssetLoader.h"
+#include "JobSystem.h"
+#include "AssetRegistry.h"
+#include "ObjectPool.h"
+#include "BroadPhase.h"
+#include "AabbTree.h"
+#include "NarrowPhase.h"
+#include "SweptCollision.h"
+#include "Simulation.h"
+#include "FramePipeline.h"
+#include "TripleBuffer.h"
+#include "ParallelRecording.h"
+#include "DeferredContexts.h"
+#include "InputLog.h"
+#include "FrameContext.h"
+#include <atomic>
 #include <random>
 #include <iostream>
 #include <vector>
@@ -71,7 +87,25 @@ public:
 		DirectX::XMMATRIX projection;
 	}; 
 
+    // Everything Render reads from an update. Update fills one as it ends and Render draws the newest,
+    // so Render never touches the objects the next update is moving.
+    struct FrameSnapshot
+    {
+        uint64_t                                frame = 0;				//0 until the first update
+        float                                   alpha = 1;				//how far past the last update the frame is drawn
+        uint64_t                                droppedUpdates = 0;
+        DirectX::SimpleMath::Matrix             view;
+        DirectX::SimpleMath::Vector3            cameraPosition;
+        float                                   waterLevel = 0;
+        bool                                    gameOver = false;
+        DX::TransformUpdateStats                transformStats = {};
+        std::vector<GameObjectDraw>             unculled;				//objects without a model, the terrain
+        std::vector<GameObjectDraw>             visible;				//objects whose bounds reach into the view
+        GameObjectDraw                          water;
+    };
+
     void Update(DX::StepTimer const& timer);
+    void WriteSnapshot(FrameSnapshot& snapshot, float alpha);
     void Render();
     void RenderSceneObjects();
     void PostProcessing();
@@ -82,17 +116,70 @@ public:
     void RenderPlanarShadows();
     void RenderTexturePass1();
     void CreateMissile();
+    void UpdateSceneTree();
+    void RemoveFromSceneTree(GameObject* gameObject);
     void RestartGame();
+    unsigned int StartInputLog();
+    void FinishReplay();
+
+    static bool BuildAssetPack(const wchar_t* filename);
+    static bool WriteLodReport(const wchar_t* filename);
+    static bool WriteVertexFormatReport(const wchar_t* filename);
+    static bool WriteMeshletReport(const wchar_t* filename);
+
+    // Cooked asset archive, mounted for DX::ReadData and the loaders when present.
+    std::unique_ptr<DX::AssetPack>          m_assetPack;
+
+    // Loads every asset on the main thread instead of the worker pool (-serialload), for comparing startup times.
+    bool                                    m_serialAssetLoading = false;
+
+    // Worker threads for the engine's parallel work. Jobs that use the immediate context run on the main thread before Render.
+    DX::JobSystem                           m_jobs;
+
+    // Updates on a thread of its own while the previous frame renders, or back to back on the main thread (-singlethreaded).
+    bool                                    m_singleThreadedFrames = false;
+    std::unique_ptr<DX::FramePipeline>      m_pipeline;
+    DX::TripleBuffer<FrameSnapshot>         m_snapshots;
+
+    // Records every update's input and timestep, and the seed the watermines are placed with, to a log written on exit
+    // (-record file). Or plays a log back instead of the keyboard, mouse and clock, an update a frame (-replay file),
+    // then writes the world hash to ReplayResult.txt and exits with 1 if it is not the -golden hash.
+    std::wstring                            m_recordPath;
+    std::wstring                            m_replayPath;
+    bool                                    m_hasGoldenHash = false;
+    uint64_t                                m_goldenHash = 0;
+    bool                                    m_recording = false;
+    bool                                    m_replaying = false;
+    DX::InputLog                            m_inputLog;
+    DX::InputReplay                         m_inputReplay;
+    std::atomic<bool>                       m_replayFinished{ false };		//set by the simulation thread when the log runs out
+
+    // Records the visible objects on the workers, one deferred context each.
+    DX::DeferredContexts                    m_deferredContexts;
+    std::vector<float>                      m_drawCosts;
+    DX::RecordingStats                      m_drawStats = {};		//the last scene pass's, shown on screen
 
     // Device resources.
     std::unique_ptr<DX::DeviceResources>    m_deviceResources;
 
-    // Rendering loop timer.
+    // Shared models, shaders and textures, deduplicated by path.
+    std::unique_ptr<DX::AssetRegistry>      m_assets;
+
+    // Rendering loop timer. Updates run at a fixed rate (-simrate hz) and frames are drawn between the last two, so
+    // the simulation does the same whatever the framerate; at most -maxcatchup updates run a frame, the time past
+    // that is dropped. -variablestep runs one update a frame covering the time since the last.
     DX::StepTimer                           m_timer;
+    bool                                    m_fixedTimeStep = true;
+    double                                  m_simulationRate = 60.0;
+    uint32_t                                m_maxCatchUpUpdates = 5;
+
+    // The last update's time and input, passed by reference to the objects it updates and draws.
+    DX::FrameContext                        m_frame = {};
 
 	//input manager. 
 	Input									m_input;
 	InputCommands							m_gameInputCommands;
+	DX::StepInput							m_stepInput;			//the live input of the frames since the last update
 
     // DirectXTK objects.
     std::unique_ptr<DirectX::CommonStates>                                  m_states;
@@ -124,29 +211,29 @@ public:
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>                        m_textureSand;
 
 	//Shaders
-	Shader																	m_DefaultShader;
-	Shader																	m_TerrainShader;
-    Shader																	m_SkyboxShader;
-    Shader																	m_ReflectiveShader;
-    Shader																	m_WaterShader;
-    Shader																	m_PlanarShadowShader;
-    WaterShader																m_WaterWithGeometryShader;
+	std::shared_ptr<Shader>												m_DefaultShader;
+	std::shared_ptr<Shader>												m_TerrainShader;
+    std::shared_ptr<Shader>												m_SkyboxShader;
+    std::shared_ptr<Shader>												m_ReflectiveShader;
+    std::shared_ptr<Shader>												m_WaterShader;
+    std::shared_ptr<Shader>												m_PlanarShadowShader;
+    std::shared_ptr<WaterShader>										m_WaterWithGeometryShader;
 
 
     //models
-	ModelClass																m_BasicModel;
-	ModelClass																boatModel;
-    ModelClass																waterModel;
-    ModelClass																SkyboxBox;
-    ModelClass																terrainModel;
-    ModelClass																submarineModel;
-    ModelClass																palmsTrunckModel;
-    ModelClass																palmsLeavesModel;
-    ModelClass																rocksModel;
-    ModelClass																dolphinsModel;
-    ModelClass																birdsModel;
-    ModelClass																missileModel;
-    ModelClass																watermineModel;
+	std::shared_ptr<ModelClass>											m_BasicModel;
+	std::shared_ptr<ModelClass>											boatModel;
+    std::shared_ptr<ModelClass>											waterModel;
+    std::shared_ptr<ModelClass>											SkyboxBox;
+    std::shared_ptr<ModelClass>											terrainModel;
+    std::shared_ptr<ModelClass>											submarineModel;
+    std::shared_ptr<ModelClass>											palmsTrunckModel;
+    std::shared_ptr<ModelClass>											palmsLeavesModel;
+    std::shared_ptr<ModelClass>											rocksModel;
+    std::shared_ptr<ModelClass>											dolphinsModel;
+    std::shared_ptr<ModelClass>											birdsModel;
+    std::shared_ptr<ModelClass>											missileModel;
+    std::shared_ptr<ModelClass>											watermineModel;
 
 
 	//RenderTextures
@@ -160,15 +247,19 @@ public:
     float                                                                   time = 0;
 
    //game objects
-    std::vector<Watermine*>                                                 m_waterminesList;
-    std::vector<GameObject*>                                                m_missilesList;
-    std::vector<GameObject*>                                                m_sceneObjectsList;
+    DX::ObjectPool<Watermine>                                               m_watermines;
+    DX::ObjectPool<Missile>                                                 m_missiles;
+    //the scene, watermine and missile lists are GameObjectViews over the entity store
+    DX::CollisionSystem                                                     m_collisions;
+    DX::HeightField                                                         m_terrainField;
+    DX::TransformUpdateStats                                                m_transformStats = {};	//last frame's, shown on screen
+    DX::AabbTree                                                            m_sceneTree;			//render bounds of the scene objects with a model
+    std::vector<int32_t>                                                    m_visibleProxies;
     Player                                                                  m_playerObject;
     TerrainObject                                                           m_terrainObject;
     TerrainObject                                                           m_waterObject;
 
-    bool                                                                    previousFireButtonState = false;
-    bool                                                                    currentFireButtonState = false;
+    DX::FireTrigger                                                         m_fireTrigger;
     bool                                                                    isGameOver = false;
 #ifdef DXTK_AUDIO
     std::unique_ptr<DirectX::AudioEngine>                                   m_audEngine;
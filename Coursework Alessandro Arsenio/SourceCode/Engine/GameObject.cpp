@@ -1,35 +1,29 @@
 #include "pch.h"
 #include "GameObject.h"
 
-GameObject::GameObject()
-{
-	//initalise values. 
-	//Orientation and Position are how we control the GameObject. 
-	m_orientation.x = 0.0f;		//rotation around x - pitch
-	m_orientation.y = 0.0f;		//rotation around y - yaw
-	m_orientation.z = 0.0f;		//rotation around z - roll	//we tend to not use roll a lot in first person
-
-	m_localPosition.x = 0.0f;		//GameObject position in space. 
-	m_localPosition.y = 0.0f;
-	m_localPosition.z = 0.0f;
+float GameObject::s_lodScreenHeight = 768.0f;
+float GameObject::s_lodMaxPixelError = 1.0f;
+DX::EntityStore GameObject::s_entities;
 
-	m_globalPosition.x = 0.0f;		//GameObject position in space. 
-	m_globalPosition.y = 0.0f;
-	m_globalPosition.z = 0.0f;
-
-	//These variables are used for internal calculations and not set.  but we may want to queary what they 
-	//externally at points
-	m_lookat.x = 0.0f;		//Look target point
-	m_lookat.y = 0.0f;
-	m_lookat.z = 0.0f;
+namespace
+{
+	SimpleMath::Vector3 ToVector3(const DX::Float3& value)
+	{
+		return SimpleMath::Vector3(value.x, value.y, value.z);
+	}
 
-	m_forward.x = 0.0f;		//forward/look direction
-	m_forward.y = 0.0f;
-	m_forward.z = 0.0f;
+	DX::Float3 ToFloat3(const SimpleMath::Vector3& value)
+	{
+		DX::Float3 result = { value.x, value.y, value.z };
+		return result;
+	}
+}
 
-	m_right.x = 0.0f;
-	m_right.y = 0.0f;
-	m_right.z = 0.0f;
+GameObject::GameObject()
+{
+	//Orientation and Position are how we control the GameObject, they start at the origin with no rotation
+	m_entity = s_entities.Create(DX::ComponentRender);
+	s_entities.GetRenderHandle(m_entity).owner = this;
 
 	//movement and rotation default speed
 	m_movespeed = 20;
@@ -39,103 +33,85 @@ GameObject::GameObject()
 	m_parentObject = NULL;
 	m_isReflective = false;
 	hasBoxCollider = false;
-	hasSphereCollider = false;
 	isTerrain = false;
 
 	//set default tag
 	m_tag = "default";
 
-	//set defalut scale
-	m_scale = DirectX::SimpleMath::Vector3(1, 1, 1);
-
 	//force update with initial values to generate other camera data correctly for first update. 
-	Update();
+	DX::UpdateTransform(s_entities, m_entity);
 }
 
 GameObject::~GameObject()
 {
+	//the row stays until Game flushes the store at the end of the frame, views skip it until then
+	s_entities.DestroyLater(m_entity);
 }
 
 
-void GameObject::Initialise(DX::StepTimer const& timer, InputCommands *inputCommands, GameObject* gameObject)
+void GameObject::Update(const DX::FrameContext& frame)
 {
-	m_InputCommands = *inputCommands;
-	m_timer = timer;
-	setParentObject(gameObject);
+	//the same lifetime, motion and transform steps the systems run over every entity, for this one only
+	DX::UpdateEntity(s_entities, m_entity, frame.deltaTime);
 }
 
 
-
-void GameObject::Update()
+void GameObject::recordDraw(GameObjectDraw& draw, const DX::FrameContext& frame, float alpha)
 {
-	//rotation in yaw and pitch - using the paramateric equation of a sphere
-	m_forward.x = sin((m_orientation.y) * 3.1415f / 180.0f) * cos((m_orientation.x) * 3.1415f / 180.0f);
-	m_forward.z = cos((m_orientation.y) * 3.1415f / 180.0f) * cos((m_orientation.x) * 3.1415f / 180.0f);
-	m_forward.y = sin((m_orientation.x) * 3.1415f / 180.0f);
-	m_forward.Normalize();
-
-	//create right vector from look Direction
-	m_forward.Cross(DirectX::SimpleMath::Vector3::UnitY, m_right);
-	m_right.Cross(m_forward, m_up);
-
-	//update lookat point
-	m_globalPosition = m_localPosition;
-	m_lookat = m_globalPosition + m_forward;
-
-	//if the gameobject have a parent object, its coordinates are relative to it
-	if (m_parentObject != NULL)
-	{
-		m_globalPosition = m_parentObject->getPosition() + (m_parentObject->getForward()  * m_localPosition.z);
-		m_globalPosition += (m_parentObject->getRight()  * m_localPosition.x);
-		m_globalPosition += (m_parentObject->getUp()  * m_localPosition.y);
-		m_lookat = m_parentObject->getPosition();
-		
-	}
-
-	//apply GameObject vectors and create GameObject matrix
-	m_gameObjectMatrix = (DirectX::SimpleMath::Matrix::CreateLookAt(m_globalPosition, m_lookat, DirectX::SimpleMath::Vector3::UnitY));
-
+	draw.object = this;
+	draw.world = getInterpolatedWorldMatrix(alpha);
+	draw.bounds = getRenderBounds(draw.world);
+	draw.model = m_gameObjectModel;
+	draw.shader = m_gameObjectShaderPair;
+	draw.albedoTexture = m_albedoTexture;
+	draw.reflective = m_isReflective;
+	draw.environmentTexture = m_isReflective ? m_enviromentTexture : NULL;
+	draw.cameraPosition = m_isReflective ? m_cameraObject->getInterpolatedPosition(alpha) : SimpleMath::Vector3::Zero;
+	draw.totalTime = float(frame.totalTime);
+}
 
-	//update colliders
-	if (hasSphereCollider)
+void GameObject::Render(ID3D11DeviceContext* context, const GameObjectDraw& draw, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight)
+{
+	if (draw.model)
 	{
-		m_sphereCollider.Center = m_globalPosition;
+		RenderModel(context, draw, view, projection, sceneLight);
 	}
 }
 
-
-void GameObject::Render(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight)
+void GameObject::RenderModel(ID3D11DeviceContext* context, const GameObjectDraw& draw, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight)
 {
-
-	SimpleMath::Matrix m_world = SimpleMath::Matrix::Identity;
-	SimpleMath::Matrix translation = SimpleMath::Matrix::CreateTranslation(m_globalPosition);
-	SimpleMath::Matrix rotationX = SimpleMath::Matrix::CreateRotationX(XMConvertToRadians(m_orientation.x));
-	SimpleMath::Matrix rotationY = SimpleMath::Matrix::CreateRotationY(XMConvertToRadians(m_orientation.y));
-	SimpleMath::Matrix rotationZ = SimpleMath::Matrix::CreateRotationZ(XMConvertToRadians(m_orientation.z));
-	SimpleMath::Matrix rotation = rotationX * rotationY * rotationZ;
-	SimpleMath::Matrix scale = SimpleMath::Matrix::CreateScale(m_scale);
-	m_world = scale * rotation * m_world * translation ;
+	//packed vertex formats store positions relative to the mesh bounds, undo that first
+	SimpleMath::Matrix drawWorld = draw.model->GetDequantizeTransform() * draw.world;
+	SimpleMath::Vector3 reflectedCamera = draw.cameraPosition;
 
 	//check if the object is reflective
-	m_gameObjectShaderPair.EnableShader(context);
-	if (!m_isReflective)
+	draw.shader->EnableShader(context, draw.model->GetVertexFormat());
+	if (!draw.reflective)
 	{
-		m_gameObjectShaderPair.SetShaderParameters(context, &m_world,view,projection, sceneLight, m_albedoTexture);
+		draw.shader->SetShaderParameters(context, &drawWorld,view,projection, sceneLight, draw.albedoTexture);
 	}
 	else
 	{
-		m_gameObjectShaderPair.SetReflectionShaderParameters(context, &m_world,view,projection, sceneLight, m_albedoTexture, m_enviromentTexture, &m_cameraObject->getPosition());
+		draw.shader->SetReflectionShaderParameters(context, &drawWorld,view,projection, sceneLight, draw.albedoTexture, draw.environmentTexture, &reflectedCamera);
 	}
 
-	m_gameObjectModel.Render(context);
+	//pick the level of detail from how large the bounding sphere is on screen
+	SimpleMath::Vector3 cameraPosition = view->Invert().Translation();
+	float projectionScale = projection->_22 * s_lodScreenHeight * 0.5f;
+	int lod = draw.model->SelectLod(draw.bounds.Radius, SimpleMath::Vector3::Distance(cameraPosition, draw.bounds.Center), projectionScale, s_lodMaxPixelError);
+
+	//only the meshlets inside the view and facing the camera are drawn
+	SimpleMath::Matrix viewProjection = (*view) * (*projection);
+	DX::Meshlets::Frustum frustum = DX::Meshlets::ExtractFrustum(&viewProjection._11);
+	draw.model->RenderCulled(context, lod, draw.world, frustum, cameraPosition, draw.albedoTexture);
 }
 
-void GameObject::setModel(ModelClass *model)
+void GameObject::setModel(std::shared_ptr<ModelClass> model)
 {
-	m_gameObjectModel = *model;
+	m_gameObjectModel = model;
 }
 
-ModelClass GameObject::getModel()
+std::shared_ptr<ModelClass> GameObject::getModel()
 {
 	return m_gameObjectModel;
 }
@@ -152,9 +128,46 @@ ID3D11ShaderResourceView* GameObject::getTexture()
 
 void GameObject::setParentObject(GameObject* gameObject)
 {
+	//the store refuses a parent below the object, its transform would depend on itself
+	if (!s_entities.SetParent(m_entity, gameObject != NULL ? gameObject->m_entity : DX::InvalidEntity))
+	{
+		OutputDebugStringW(L"GameObject::setParentObject: parent refused, it would make a cycle or is destroyed\n");
+		return;
+	}
 	m_parentObject = gameObject;
 }
 
+void GameObject::setToDelete(bool toDelete)
+{
+	s_entities.MarkForDelete(m_entity, toDelete);
+}
+
+bool GameObject::getToDelete()
+{
+	return s_entities.IsMarkedForDelete(m_entity);
+}
+
+DX::Entity GameObject::getEntity()
+{
+	return m_entity;
+}
+
+void GameObject::addToScene()
+{
+	s_entities.AddComponents(m_entity, DX::TagScene);
+}
+
+DX::EntityStore& GameObject::getEntityStore()
+{
+	return s_entities;
+}
+
+void GameObject::setLodViewport(float screenHeight, float maxPixelError)
+{
+	s_lodScreenHeight = screenHeight;
+	s_lodMaxPixelError = maxPixelError;
+}
+
 void GameObject::setTag(std::string tag)
 {
 	m_tag = tag;
@@ -164,34 +177,66 @@ std::string	GameObject::getTag()
 	return m_tag;
 }
 
-void GameObject::setShader(Shader *shaderPair)
+void GameObject::setShader(std::shared_ptr<Shader> shaderPair)
 {
-	m_gameObjectShaderPair = *shaderPair;
+	m_gameObjectShaderPair = shaderPair;
 }
 
 DirectX::SimpleMath::Matrix GameObject::getCameraMatrix()
 {
-	return m_gameObjectMatrix;
+	//only the camera asks for this, so it is built on demand rather than for every entity
+	const DX::Transform& transform = s_entities.GetTransform(m_entity);
+	return DirectX::SimpleMath::Matrix::CreateLookAt(ToVector3(transform.worldPosition), ToVector3(transform.lookAt), DirectX::SimpleMath::Vector3::UnitY);
+}
+
+DirectX::SimpleMath::Matrix GameObject::getInterpolatedCameraMatrix(float alpha)
+{
+	//the eye and the point looked at are interpolated, not the matrix, so the view stays a rotation
+	DirectX::SimpleMath::Vector3 position = ToVector3(DX::InterpolatePosition(s_entities, m_entity, alpha));
+	DirectX::SimpleMath::Vector3 lookAt = ToVector3(DX::InterpolateLookAt(s_entities, m_entity, alpha));
+	return DirectX::SimpleMath::Matrix::CreateLookAt(position, lookAt, DirectX::SimpleMath::Vector3::UnitY);
 }
 
 void GameObject::setLocalPosition(DirectX::SimpleMath::Vector3 newPosition)
 {
-	m_localPosition = newPosition;
+	s_entities.SetPosition(m_entity, ToFloat3(newPosition));
 }
 
 DirectX::SimpleMath::Vector3 GameObject::getPosition()
 {
-	return m_globalPosition;
+	return ToVector3(s_entities.GetTransform(m_entity).worldPosition);
+}
+
+DirectX::SimpleMath::Matrix GameObject::getWorldMatrix()
+{
+	return DirectX::SimpleMath::Matrix(s_entities.GetTransform(m_entity).world);
+}
+
+DirectX::SimpleMath::Matrix GameObject::getInterpolatedWorldMatrix(float alpha)
+{
+	float world[16];
+	DX::InterpolateWorld(s_entities, m_entity, alpha, world);
+	return DirectX::SimpleMath::Matrix(world);
+}
+
+DirectX::SimpleMath::Vector3 GameObject::getInterpolatedPosition(float alpha)
+{
+	return ToVector3(DX::InterpolatePosition(s_entities, m_entity, alpha));
+}
+
+DirectX::SimpleMath::Vector3 GameObject::getLocalPosition()
+{
+	return ToVector3(s_entities.GetTransform(m_entity).position);
 }
 
 void GameObject::setScale(DirectX::SimpleMath::Vector3 scale)
 {
-	m_scale = scale;
+	s_entities.SetScale(m_entity, ToFloat3(scale));
 }
 
 DirectX::SimpleMath::Vector3 GameObject::getScale()
 {
-	return m_scale;
+	return ToVector3(s_entities.GetTransform(m_entity).scale);
 }
 
 //void GameObject::setSceneObjectsList(Game* game)
@@ -201,28 +246,27 @@ DirectX::SimpleMath::Vector3 GameObject::getScale()
 
 DirectX::SimpleMath::Vector3 GameObject::getForward()
 {
-	return m_forward;
+	return ToVector3(s_entities.GetTransform(m_entity).forward);
 }
 
 DirectX::SimpleMath::Vector3 GameObject::getRight()
 {
-	return m_right;
+	return ToVector3(s_entities.GetTransform(m_entity).right);
 }
 
 DirectX::SimpleMath::Vector3 GameObject::getUp()
 {
-	return m_up;
+	return ToVector3(s_entities.GetTransform(m_entity).up);
 }
 
 void GameObject::setRotation(DirectX::SimpleMath::Vector3 newRotation)
 {
-
-	m_orientation = newRotation;
+	s_entities.SetRotation(m_entity, ToFloat3(newRotation));
 }
 
 DirectX::SimpleMath::Vector3 GameObject::getRotation()
 {
-	return m_orientation;
+	return ToVector3(s_entities.GetTransform(m_entity).rotation);
 }
 
 void GameObject::setReflective(bool isReflective, ID3D11ShaderResourceView* enviromentTexture, GameObject* cameraObject)
@@ -254,11 +298,35 @@ BoundingOrientedBox	GameObject::getBoxCollider()
 }
 void  GameObject::setSphereCollider(BoundingSphere boundingSphere)
 {
-	hasSphereCollider = true;
-	m_sphereCollider = boundingSphere;
+	s_entities.AddComponents(m_entity, DX::ComponentCollider);
+	s_entities.GetCollider(m_entity).center = ToFloat3(boundingSphere.Center);
+	s_entities.GetCollider(m_entity).previousCenter = ToFloat3(boundingSphere.Center);
+	s_entities.GetCollider(m_entity).radius = boundingSphere.Radius;
+}
+
+BoundingSphere GameObject::getRenderBounds()
+{
+	return getRenderBounds(getWorldMatrix());
+}
+
+BoundingSphere GameObject::getRenderBounds(const DirectX::SimpleMath::Matrix& world)
+{
+	if (!m_gameObjectModel)
+	{
+		return BoundingSphere(world.Translation(), 0);
+	}
+	const DX::Transform& transform = s_entities.GetTransform(m_entity);
+	SimpleMath::Vector3 center = SimpleMath::Vector3::Transform(m_gameObjectModel->GetBoundingCenter(), world);
+	float maxScale = std::max(std::max(fabsf(transform.scale.x), fabsf(transform.scale.y)), fabsf(transform.scale.z));
+	return BoundingSphere(center, m_gameObjectModel->GetBoundingRadius() * maxScale);
 }
 
 BoundingSphere	GameObject::getSphereCollider()
 {
-	return m_sphereCollider;
+	if (!s_entities.HasComponents(m_entity, DX::ComponentCollider))
+	{
+		return BoundingSphere();
+	}
+	const DX::Collider& collider = s_entities.GetCollider(m_entity);
+	return BoundingSphere(ToVector3(collider.center), collider.radius);
 }
@@ -2,27 +2,55 @@
 
 #include "modelclass.h"
 #include "Shader.h"
-#include "Input.h"
-#include "StepTimer.h"
+#include "FrameContext.h"
 #include "directxcollision.h"
 #include "Terrain.h"
+#include "Entities.h"
 
 //#include "Game.h"
 
 using namespace DirectX;
 
+class GameObject;
+
+// What drawing an object reads, copied at the end of an update so the object can be drawn while the
+// next update moves it, or releases it to its pool.
+struct GameObjectDraw
+{
+	GameObject*						object;			//only dereferenced for objects without a model, which are never pooled
+	DirectX::SimpleMath::Matrix		world;
+	BoundingSphere					bounds;
+	std::shared_ptr<ModelClass>		model;
+	std::shared_ptr<Shader>			shader;
+	ID3D11ShaderResourceView*		albedoTexture;
+	ID3D11ShaderResourceView*		environmentTexture;
+	DirectX::SimpleMath::Vector3	cameraPosition;	//of the camera the object reflects
+	float							totalTime;
+	bool							reflective;
+};
+
 class GameObject
 {
 public:
 
 	GameObject();
-	~GameObject();
+	virtual ~GameObject();
 
-	void							Initialise(DX::StepTimer const& timer, InputCommands* inputCommands, GameObject* gameObject);
-	virtual void					Update();
+	//each object owns one entity, copying would share it
+	GameObject(const GameObject&) = delete;
+	GameObject& operator=(const GameObject&) = delete;
+
+	virtual void					Update(const DX::FrameContext& frame);
 	DirectX::SimpleMath::Matrix		getCameraMatrix();
+	DirectX::SimpleMath::Matrix		getInterpolatedCameraMatrix(float alpha);	//alpha of the way from the last step's camera to this one's
 	virtual void					setLocalPosition(DirectX::SimpleMath::Vector3 newPosition);
 	virtual DirectX::SimpleMath::Vector3	getPosition();
+	DirectX::SimpleMath::Vector3	getLocalPosition();
+	DirectX::SimpleMath::Matrix		getWorldMatrix();			//cached, rebuilt by the transform system when the object moves
+	DirectX::SimpleMath::Matrix		getInterpolatedWorldMatrix(float alpha);
+	DirectX::SimpleMath::Vector3	getInterpolatedPosition(float alpha);
+	BoundingSphere					getRenderBounds();			//the model's bounding sphere in world space, empty without a model
+	BoundingSphere					getRenderBounds(const DirectX::SimpleMath::Matrix& world);
 	void							setScale(DirectX::SimpleMath::Vector3 scale);
 	DirectX::SimpleMath::Vector3	getScale();
 	void							setTag(std::string tag);
@@ -39,38 +67,36 @@ public:
 	DirectX::SimpleMath::Vector3	getRotation();
 	float							getMoveSpeed();
 	float							getRotationSpeed();
-	void							setModel(ModelClass	*model);
-	ModelClass						getModel();
+	void							setModel(std::shared_ptr<ModelClass> model);
+	std::shared_ptr<ModelClass>		getModel();
 	void							setTexture(ID3D11ShaderResourceView * texture);
 	ID3D11ShaderResourceView*		getTexture();
-	virtual void					Render(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight);
-	void							setShader(Shader *shaderPair);
+	void							recordDraw(GameObjectDraw& draw, const DX::FrameContext& frame, float alpha);	//drawn alpha of the way from the last step to this one
+	virtual void					Render(ID3D11DeviceContext* context, const GameObjectDraw& draw, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight);
+	//draws a recorded object with a model without touching the object
+	static void						RenderModel(ID3D11DeviceContext* context, const GameObjectDraw& draw, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight);
+	void							setShader(std::shared_ptr<Shader> shaderPair);
 	void							setReflective(bool isReflective, ID3D11ShaderResourceView* enviromentTexture, GameObject* cameraObject);
 	void							setParentObject(GameObject *gameObject);
+	void							setToDelete(bool toDelete);
+	bool							getToDelete();
+	DX::Entity						getEntity();
+	void							addToScene();			//drawn by Game through the scene view
+
+	//component arrays shared by every GameObject, the systems in Entities.h update them all at once
+	static DX::EntityStore&			getEntityStore();
+
+	//screen height in pixels and how many pixels of error a level of detail may show
+	static void						setLodViewport(float screenHeight, float maxPixelError);
 
 
 public:
-	DirectX::SimpleMath::Matrix		m_gameObjectMatrix;			//GameObject matrix to be passed out and used to set GameObject position and angle
-	DirectX::SimpleMath::Vector3	m_lookat;
-	DirectX::SimpleMath::Vector3	m_localPosition;
-	DirectX::SimpleMath::Vector3	m_globalPosition;
-	DirectX::SimpleMath::Vector3	m_scale;
-	DirectX::SimpleMath::Vector3	m_forward;
-	DirectX::SimpleMath::Vector3	m_right;
-	DirectX::SimpleMath::Vector3	m_up;
-	DirectX::SimpleMath::Vector3	m_orientation;			//vector storing pitch yaw and roll. 
-
-
-	//input manager. 
-	Input																	m_input;
-	InputCommands															m_InputCommands;
-	std::string																m_tag;
+	DX::Entity						m_entity;				//position, rotation, scale, colliders and lifetime live in s_entities
 
-	// Rendering loop timer.
-	DX::StepTimer															m_timer;
+	std::string																m_tag;
 
-	ModelClass																m_gameObjectModel;
-	Shader																	m_gameObjectShaderPair;
+	std::shared_ptr<ModelClass>												m_gameObjectModel;		//shared with every object using the same asset
+	std::shared_ptr<Shader>													m_gameObjectShaderPair;
 	ID3D11ShaderResourceView*												m_albedoTexture;
 	ID3D11ShaderResourceView*												m_enviromentTexture;
 
@@ -78,7 +104,6 @@ public:
 	GameObject*																m_cameraObject;	//GameObject camera  to be used for reflection
 
 	BoundingOrientedBox														m_boxCollider;
-	BoundingSphere															m_sphereCollider;
 
 	//Game*																	m_Game;
 
@@ -86,9 +111,88 @@ public:
 	float	m_rotateSpeed;
 	bool	m_isReflective;
 	bool	hasBoxCollider;
-	bool	hasSphereCollider;
 	bool	isTerrain;
-	bool    toDelete = false;
+
+	static float	s_lodScreenHeight;
+	static float	s_lodMaxPixelError;
+
+	static DX::EntityStore	s_entities;
 
 };
 
+
+// The objects whose entities carry every flag in required, in component array order. Walks the
+// live objects, or with markedForDelete only the ones marked for deletion. Objects destroyed
+// while walking are skipped, their rows are only removed by FlushDestroyed.
+template<typename T>
+class GameObjectView
+{
+public:
+	class iterator
+	{
+	public:
+		iterator(const GameObjectView* view, size_t index) :
+			m_view(view),
+			m_index(index)
+		{
+			Skip();
+		}
+
+		T* operator*() const
+		{
+			void* owner = GameObject::getEntityStore().renderHandles[m_index].owner;
+			return static_cast<T*>(static_cast<GameObject*>(owner));
+		}
+
+		iterator& operator++()
+		{
+			m_index++;
+			Skip();
+			return *this;
+		}
+
+		bool operator!=(const iterator& other) const
+		{
+			return m_index != other.m_index;
+		}
+
+	private:
+		void Skip()
+		{
+			const DX::EntityStore& store = GameObject::getEntityStore();
+			while (m_index < store.GetCount() && !m_view->Selects(store, m_index))
+			{
+				m_index++;
+			}
+		}
+
+		const GameObjectView*	m_view;
+		size_t					m_index;
+	};
+
+	explicit GameObjectView(uint32_t required, bool markedForDelete = false) :
+		m_required(required | DX::ComponentRender),
+		m_markedForDelete(markedForDelete)
+	{
+	}
+
+	iterator begin() const
+	{
+		return iterator(this, 0);
+	}
+
+	//rows added while walking are visited too
+	iterator end() const
+	{
+		return iterator(this, GameObject::getEntityStore().GetCount());
+	}
+
+private:
+	bool Selects(const DX::EntityStore& store, size_t index) const
+	{
+		return (store.components[index] & m_required) == m_required && (store.markedForDelete[index] != 0) == m_markedForDelete;
+	}
+
+	uint32_t	m_required;
+	bool		m_markedForDelete;
+};
@@ -0,0 +1,388 @@
+//
+// HeadlessMain.cpp - Runs the game's update with no window, device or input hardware
+//
+// Builds the world Game::Initialize builds, minus everything that draws: the 512 by 512 terrain
+// from the same noise, the player with the camera as its child, and a watermine wherever the
+// grid reaches deep enough water. Each tick then does what Game::Update does, fed by scripted
+// input that circles over the watermines, diving and firing, so missiles hit them and they hit the
+// player, who restarts as soon as it is hit.
+//
+// HeadlessSimulation [-ticks n] [-workers n] [-grid n] [-seed n] [-record file | -replay file] [-golden hash]
+//
+// -grid sets the watermine grid to n by n over the same area, 25 by default as in the game, to
+// soak test with more of them. The seed only moves the watermines; the same seed and tick count
+// always give the same world hash, whatever the number of workers.
+//
+// -record writes the run's input, timesteps and seed to an InputLog. -replay runs a log instead
+// of the scripted input, the game's own recordings included, taking the seed and tick count from
+// it; the grid must be the one it was recorded with. -golden fails the run when the final world
+// hash is not the one given, in hex as it is printed. Any value that is not a whole number, or
+// does not fit, prints the usage and fails.
+//
+
+#include "pch.h"
+#include "Entities.h"
+#include "FrameContext.h"
+#include "HeightMap.h"
+#include "InputLog.h"
+#include "JobSystem.h"
+#include "Simulation.h"
+#include "StepTimer.h"
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+namespace
+{
+	//the game's terrain and update rate
+	const int TerrainSize = 512;
+	const float TerrainIntensity = 240.0f;
+	const float TerrainScale = 200.0f;
+	const float TerrainNoiseHeight = 400.0f;
+	const float WatermineGridExtent = 500.0f;
+	const float WatermineMaxHeight = -4.0f;
+	const uint64_t TickLength = DX::StepTimer::TicksPerSecond / 60;
+
+	//GameObject's default speeds
+	const float PlayerMoveSpeed = 20.0f;
+	const float PlayerRotateSpeed = 100.0f;
+
+	const DX::Float3 PlayerStart = { 190.0f, -1.0f, 290.0f };
+	const DX::Float3 PlayerStartRotation = { 0.0f, 180.0f, 0.0f };
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Options
+	{
+		unsigned long ticks;
+		unsigned int workers;
+		int grid;
+		unsigned int seed;
+		const char* record;
+		const char* replay;
+		bool hasGolden;
+		uint64_t golden;
+	};
+
+	struct Totals
+	{
+		size_t fired;
+		size_t watermineHits;
+		size_t terrainHits;
+		size_t playerHits;
+		size_t candidates;
+		double updateTime;			//milliseconds in the player, the systems and the transforms
+		double collisionTime;
+		double cleanupTime;
+	};
+
+	//the whole argument has to be a number, not just the start of it
+	bool ReadNumber(const char* text, int base, unsigned long long& value)
+	{
+		char* end = nullptr;
+		errno = 0;
+		value = std::strtoull(text, &end, base);
+		return end != text && *end == '\0' && *text != '-' && errno == 0;
+	}
+
+	bool ReadOptions(int argc, char** argv, Options& options)
+	{
+		options.ticks = 10000;
+		options.workers = DX::JobSystem::DefaultWorkerCount();
+		options.grid = 25;
+		options.seed = 1;
+		options.record = nullptr;
+		options.replay = nullptr;
+		options.hasGolden = false;
+		options.golden = 0;
+		for (int i = 1; i < argc; i++)
+		{
+			if (i + 1 >= argc)
+			{
+				return false;
+			}
+			unsigned long long value = 0;
+			if (std::strcmp(argv[i], "-record") == 0)
+			{
+				options.record = argv[i + 1];
+			}
+			else if (std::strcmp(argv[i], "-replay") == 0)
+			{
+				options.replay = argv[i + 1];
+			}
+			else if (std::strcmp(argv[i], "-golden") == 0)
+			{
+				if (!ReadNumber(argv[i + 1], 16, value))
+				{
+					return false;
+				}
+				options.hasGolden = true;
+				options.golden = value;
+			}
+			else if (!ReadNumber(argv[i + 1], 10, value))
+			{
+				return false;
+			}
+			else if (std::strcmp(argv[i], "-ticks") == 0 && value <= ULONG_MAX)
+			{
+				options.ticks = (unsigned long)value;
+			}
+			else if (std::strcmp(argv[i], "-workers") == 0 && value <= UINT_MAX)
+			{
+				options.workers = (unsigned int)value;
+			}
+			else if (std::strcmp(argv[i], "-grid") == 0 && value > 0 && value <= INT_MAX)
+			{
+				options.grid = (int)value;
+			}
+			else if (std::strcmp(argv[i], "-seed") == 0 && value <= UINT_MAX)
+			{
+				options.seed = (unsigned int)value;
+			}
+			else
+			{
+				return false;
+			}
+			i++;
+		}
+		return !(options.record && options.replay);
+	}
+
+	// Dives for a second and climbs for one, always going forward, and circles over the watermines by
+	// the start, the circles slowly widening and tightening so they sweep a wider patch. Clicks five
+	// times a second. Restart is held, so a hit player comes straight back.
+	InputCommands ScriptedInput(unsigned long tick)
+	{
+		InputCommands input = {};
+		unsigned long phase = (tick / 60) % 4;
+		input.forward = true;
+		input.down = phase == 0;
+		input.up = phase == 2;
+		input.m_yaw = 0.25f + 0.1f * std::sin(float(tick) * 0.002f);
+		input.mouseButton = (tick % 12) < 6;
+		input.restart = true;
+		return input;
+	}
+
+	void PlaceCollider(DX::EntityStore& store, DX::Entity entity, float radius)
+	{
+		DX::UpdateTransform(store, entity);
+		DX::Collider& collider = store.GetCollider(entity);
+		collider.center = collider.previousCenter = store.GetTransform(entity).worldPosition;
+		collider.radius = radius;
+	}
+
+	DX::Entity CreatePlayer(DX::EntityStore& store)
+	{
+		const DX::Float3 scale = { 0.5f, 0.5f, 0.2f };
+		DX::Entity player = store.Create(DX::ComponentTransform | DX::ComponentCollider);
+		store.SetPosition(player, PlayerStart);
+		store.SetRotation(player, PlayerStartRotation);
+		store.SetScale(player, scale);
+		PlaceCollider(store, player, DX::PlayerRadius);
+
+		//the camera follows the player as its child, as it does in the game
+		const DX::Float3 cameraOffset = { 0.0f, 5.0f, -12.0f };
+		DX::Entity camera = store.Create(DX::ComponentTransform);
+		store.SetPosition(camera, cameraOffset);
+		store.SetParent(camera, player);
+		return player;
+	}
+
+	size_t CreateWatermines(DX::EntityStore& store, const std::vector<float>& heights, int grid, unsigned int seed)
+	{
+		std::mt19937 generator(seed);
+		const DX::Float3 rotation = { 0.0f, 90.0f, 0.0f };
+		float spacing = WatermineGridExtent / float(grid);
+		size_t count = 0;
+		for (int i = 0; i < grid; i++)
+		{
+			for (int j = 0; j < grid; j++)
+			{
+				int x = int(float(j) * spacing), z = int(float(i) * spacing);
+				float depth = heights[size_t(z) * TerrainSize + x];
+				if (depth >= WatermineMaxHeight)
+				{
+					continue;
+				}
+				std::uniform_int_distribution<> distribution(static_cast<int>(depth), static_cast<int>(WatermineMaxHeight));
+				DX::Float3 position = { float(x), float(distribution(generator)), float(z) };
+				DX::Entity watermine = store.Create(DX::ComponentTransform | DX::ComponentCollider);
+				DX::AddWatermineComponents(store, watermine);
+				store.SetPosition(watermine, position);
+				store.SetRotation(watermine, rotation);
+				DX::SetWatermineCenter(store, watermine, position.y);
+				PlaceCollider(store, watermine, DX::WatermineRadius);
+				count++;
+			}
+		}
+		return count;
+	}
+
+	double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	size_t CountTagged(const DX::EntityStore& store, uint32_t tag)
+	{
+		size_t count = 0;
+		for (size_t index = 0; index < store.GetCount(); index++)
+		{
+			count += (store.components[index] & tag) ? 1 : 0;
+		}
+		return count;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ReadOptions(argc, argv, options))
+	{
+		fprintf(stderr, "usage: %s [-ticks n] [-workers n] [-grid n] [-seed n] [-record file | -replay file] [-golden hash]\n", argv[0]);
+		return 1;
+	}
+
+	//a replay brings its own seed and length
+	DX::InputLog log;
+	DX::InputReplay replay;
+	if (options.replay)
+	{
+		std::ifstream file(options.replay, std::ios::binary);
+		if (!log.Read(file))
+		{
+			fprintf(stderr, "%s is not an input log\n", options.replay);
+			return 1;
+		}
+		options.seed = log.GetSeed();
+		options.ticks = (unsigned long)log.GetTickCount();
+		replay = DX::InputReplay(log);
+	}
+	else if (options.record)
+	{
+		log.Clear(options.seed);
+	}
+
+	std::vector<float> heights;
+	DX::GenerateHeightMap(heights, TerrainSize, TerrainSize, TerrainIntensity, TerrainScale, TerrainNoiseHeight);
+	DX::HeightField terrain;
+	const DX::Float3 origin = { 0, 0, 0 };
+	terrain.Set(heights.data(), TerrainSize, TerrainSize, 1.0f, origin);
+
+	DX::EntityStore store;
+	DX::Entity player = CreatePlayer(store);
+	size_t watermines = CreateWatermines(store, heights, options.grid, options.seed);
+	DX::UpdateTransforms(store);
+
+	DX::JobSystem jobs(options.workers);
+	DX::CollisionSystem collisions;
+	DX::FireTrigger fireTrigger;
+	Totals totals = {};
+	DX::FrameContext frame = {};
+
+	auto start = Clock::now();
+	for (unsigned long tick = 0; tick < options.ticks; tick++)
+	{
+		DX::InputTick step;
+		if (options.replay)
+		{
+			replay.Next(step);
+		}
+		else
+		{
+			step.input = ScriptedInput(tick);
+			step.elapsedTicks = TickLength;
+		}
+		if (options.record)
+		{
+			log.Append(step.input, step.elapsedTicks);
+		}
+
+		//one context for everything this tick updates, filled the way Game::Update fills it from its timer
+		frame.deltaTime = float(DX::StepTimer::TicksToSeconds(step.elapsedTicks));
+		frame.totalTime += DX::StepTimer::TicksToSeconds(step.elapsedTicks);
+		frame.frame++;
+		frame.input = step.input;
+
+		auto phase = Clock::now();
+		store.BeginStep();
+		if (fireTrigger.Update(frame.input.mouseButton))
+		{
+			DX::Entity missile = store.Create(DX::ComponentTransform);
+			DX::AddMissileComponents(store, missile);
+			DX::LaunchMissile(store, missile, player);
+			totals.fired++;
+		}
+		if (!store.IsMarkedForDelete(player))
+		{
+			DX::MovePlayer(store, player, frame.input, frame.deltaTime, PlayerMoveSpeed, PlayerRotateSpeed);
+		}
+		DX::UpdateEntities(store, frame.deltaTime, jobs);
+		totals.updateTime += MillisecondsSince(phase);
+
+		phase = Clock::now();
+		DX::CollisionResult result = collisions.Resolve(store, jobs, terrain, player);
+		totals.collisionTime += MillisecondsSince(phase);
+		totals.candidates += result.candidates;
+		totals.watermineHits += result.watermineHits;
+		totals.terrainHits += result.terrainHits;
+		totals.playerHits += result.playerHit ? 1 : 0;
+
+		//what the game returns to its pools is destroyed here, the player only waits for the restart
+		phase = Clock::now();
+		for (size_t index = 0; index < store.GetCount(); index++)
+		{
+			if ((store.components[index] & (DX::TagWatermine | DX::TagMissile)) && store.markedForDelete[index])
+			{
+				store.DestroyLater(store.entities[index]);
+			}
+		}
+		store.FlushDestroyed();
+		if (store.IsMarkedForDelete(player) && frame.input.restart)
+		{
+			store.MarkForDelete(player, false);
+			store.SetPosition(player, PlayerStart);
+			store.SetRotation(player, PlayerStartRotation);
+		}
+		totals.cleanupTime += MillisecondsSince(phase);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	uint64_t hash = DX::HashWorld(store);
+	if (options.record)
+	{
+		std::ofstream file(options.record, std::ios::binary);
+		if (!log.Write(file))
+		{
+			fprintf(stderr, "could not write %s\n", options.record);
+			return 1;
+		}
+	}
+
+	double ticks = options.ticks > 0 ? double(options.ticks) : 1.0;
+	printf("Headless simulation: %lu ticks %s, %u workers, %dx%d watermine grid, seed %u\n", options.ticks, options.replay ? "replayed" : "of scripted input", jobs.GetWorkerCount(), options.grid, options.grid, options.seed);
+	printf("Watermines: %zu at the start, %zu left\n", watermines, CountTagged(store, DX::TagWatermine));
+	printf("Missiles: %zu fired, %zu in flight, %zu hit a watermine, %zu hit the terrain\n", totals.fired, CountTagged(store, DX::TagMissile), totals.watermineHits, totals.terrainHits);
+	printf("Player hits: %zu, broad phase candidates: %.2f a tick\n", totals.playerHits, double(totals.candidates) / ticks);
+	printf("Time: %.3f s, %.0f ticks/s, %.4f ms/tick (update %.4f, collisions %.4f, cleanup %.4f)\n",
+		seconds, seconds > 0 ? double(options.ticks) / seconds : 0.0, seconds * 1000.0 / ticks,
+		totals.updateTime / ticks, totals.collisionTime / ticks, totals.cleanupTime / ticks);
+	if (options.record)
+	{
+		printf("Recorded %zu ticks in %zu bytes to %s\n", log.GetTickCount(), log.GetByteCount(), options.record);
+	}
+	printf("World hash: %016llx\n", (unsigned long long)hash);
+	if (options.hasGolden && hash != options.golden)
+	{
+		printf("Golden hash: %016llx, the world differs\n", (unsigned long long)options.golden);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,16 @@
+#include "pch.h"
+#include "HeightMap.h"
+#include "SimplexNoise.h"
+
+void DX::GenerateHeightMap(std::vector<float>& heights, int width, int depth, float intensity, float scaleFactor, float height)
+{
+	SimplexNoise simplexnoise;
+	heights.resize(size_t(width) * depth);
+	for (int z = 0; z < depth; z++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			heights[size_t(z) * width + x] = simplexnoise.fractal(8, (float(x) / scaleFactor), height, (float(z) / scaleFactor)) * intensity;
+		}
+	}
+}
@@ -0,0 +1,18 @@
+//
+// HeightMap.h - The terrain's heights, generated without a device
+//
+// Terrain builds its vertex buffers from these heights and the game copies them into the height
+// field missiles are swept against. Nothing here touches Direct3D, so the headless driver makes
+// the same terrain from the same parameters.
+//
+
+#pragma once
+
+#include <vector>
+
+namespace DX
+{
+	// heights[z * width + x] is intensity times eight octaves of simplex noise at (x / scaleFactor, height, z / scaleFactor).
+	// The noise has no seed, the same parameters always give the same terrain.
+	void GenerateHeightMap(std::vector<float>& heights, int width, int depth, float intensity, float scaleFactor, float height);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+//this struct is the information we want to pass thru to the game processing.  We never want to be dealing with the hardware directly.
+//thats the job for the Input class.  The other benefit of this abstraction of input data is that when we want to change the input
+//to different hardware.  its really easily done in that class by mapping to the inputcommands. 
+
+struct InputCommands
+{
+	bool forward;
+	bool back;
+	bool right;
+	bool left;
+	bool rotRight;
+	bool rotLeft;
+	bool up;
+	bool down;
+	bool mouseButton;
+	bool restart;
+	float m_pitch;
+	float m_yaw;
+};
@@ -0,0 +1,298 @@
+#include "pch.h"
+#include "InputLog.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	const char Magic[4] = { 'I', 'N', 'P', 'L' };
+	const uint32_t Version = 1;
+
+	//which fields of a tick follow its first byte
+	enum ChangedFields
+	{
+		ChangedButtons = 1,
+		ChangedYaw = 2,
+		ChangedPitch = 4,
+		ChangedElapsed = 8,
+	};
+
+	uint16_t PackButtons(const InputCommands& input)
+	{
+		const bool buttons[] = { input.forward, input.back, input.right, input.left, input.rotRight, input.rotLeft, input.up, input.down, input.mouseButton, input.restart };
+		uint16_t packed = 0;
+		for (unsigned int i = 0; i < sizeof(buttons) / sizeof(buttons[0]); i++)
+		{
+			packed |= buttons[i] ? uint16_t(1u << i) : uint16_t(0);
+		}
+		return packed;
+	}
+
+	void UnpackButtons(uint16_t packed, InputCommands& input)
+	{
+		bool* buttons[] = { &input.forward, &input.back, &input.right, &input.left, &input.rotRight, &input.rotLeft, &input.up, &input.down, &input.mouseButton, &input.restart };
+		for (unsigned int i = 0; i < sizeof(buttons) / sizeof(buttons[0]); i++)
+		{
+			*buttons[i] = (packed & (1u << i)) != 0;
+		}
+	}
+
+	//floats are compared and stored by their bits, so a replay gets back exactly what was recorded
+	uint32_t FloatBits(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	float BitsFloat(uint32_t bits)
+	{
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	void PutInteger(std::vector<uint8_t>& data, uint64_t value, unsigned int bytes)
+	{
+		for (unsigned int i = 0; i < bytes; i++)
+		{
+			data.push_back(uint8_t(value >> (8 * i)));
+		}
+	}
+
+	bool GetInteger(const std::vector<uint8_t>& data, size_t& offset, unsigned int bytes, uint64_t& value)
+	{
+		if (data.size() - offset < bytes)
+		{
+			return false;
+		}
+		value = 0;
+		for (unsigned int i = 0; i < bytes; i++)
+		{
+			value |= uint64_t(data[offset++]) << (8 * i);
+		}
+		return true;
+	}
+
+	//seven bits a byte, the high bit set on every byte but the last
+	void PutVariable(std::vector<uint8_t>& data, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			data.push_back(uint8_t(value | 0x80));
+			value >>= 7;
+		}
+		data.push_back(uint8_t(value));
+	}
+
+	bool GetVariable(const std::vector<uint8_t>& data, size_t& offset, uint64_t& value)
+	{
+		value = 0;
+		for (unsigned int shift = 0; shift < 64; shift += 7)
+		{
+			if (offset >= data.size())
+			{
+				return false;
+			}
+			uint8_t byte = data[offset++];
+			value |= uint64_t(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	InputTick EmptyTick()
+	{
+		InputTick tick = {};
+		return tick;
+	}
+}
+
+InputLog::InputLog()
+{
+	Clear(0);
+}
+
+void InputLog::Clear(uint32_t seed)
+{
+	m_data.clear();
+	m_seed = seed;
+	m_tickCount = 0;
+	m_last = EmptyTick();
+}
+
+void InputLog::Append(const InputCommands& input, uint64_t elapsedTicks)
+{
+	uint16_t buttons = PackButtons(input);
+	uint8_t changed = 0;
+	changed |= buttons != PackButtons(m_last.input) ? ChangedButtons : 0;
+	changed |= FloatBits(input.m_yaw) != FloatBits(m_last.input.m_yaw) ? ChangedYaw : 0;
+	changed |= FloatBits(input.m_pitch) != FloatBits(m_last.input.m_pitch) ? ChangedPitch : 0;
+	changed |= elapsedTicks != m_last.elapsedTicks ? ChangedElapsed : 0;
+
+	m_data.push_back(changed);
+	if (changed & ChangedButtons)
+	{
+		PutInteger(m_data, buttons, 2);
+	}
+	if (changed & ChangedYaw)
+	{
+		PutInteger(m_data, FloatBits(input.m_yaw), 4);
+	}
+	if (changed & ChangedPitch)
+	{
+		PutInteger(m_data, FloatBits(input.m_pitch), 4);
+	}
+	if (changed & ChangedElapsed)
+	{
+		PutVariable(m_data, elapsedTicks);
+	}
+
+	m_last.input = input;
+	m_last.elapsedTicks = elapsedTicks;
+	m_tickCount++;
+}
+
+bool InputLog::Write(std::ostream& stream) const
+{
+	std::vector<uint8_t> header(Magic, Magic + sizeof(Magic));
+	PutInteger(header, Version, 4);
+	PutInteger(header, m_seed, 4);
+	PutInteger(header, m_tickCount, 8);
+	PutInteger(header, m_data.size(), 8);
+	stream.write(reinterpret_cast<const char*>(header.data()), header.size());
+	stream.write(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+	return bool(stream);
+}
+
+bool InputLog::Read(std::istream& stream)
+{
+	Clear(0);
+	std::vector<uint8_t> header(sizeof(Magic) + 4 + 4 + 8 + 8);
+	if (!stream.read(reinterpret_cast<char*>(header.data()), header.size()) || std::memcmp(header.data(), Magic, sizeof(Magic)) != 0)
+	{
+		return false;
+	}
+	size_t offset = sizeof(Magic);
+	uint64_t version, seed, tickCount, byteCount;
+	GetInteger(header, offset, 4, version);
+	GetInteger(header, offset, 4, seed);
+	GetInteger(header, offset, 8, tickCount);
+	GetInteger(header, offset, 8, byteCount);
+	//every tick is at least a byte, which also keeps a corrupt count from asking for a huge buffer
+	if (version != Version || tickCount > byteCount)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> data;
+	const size_t ChunkSize = 1 << 16;
+	while (data.size() < byteCount)
+	{
+		size_t chunk = size_t(std::min<uint64_t>(ChunkSize, byteCount - data.size()));
+		size_t start = data.size();
+		data.resize(start + chunk);
+		if (!stream.read(reinterpret_cast<char*>(data.data() + start), chunk))
+		{
+			return false;
+		}
+	}
+
+	//the ticks must decode to the end of the data and no further
+	m_data.swap(data);
+	m_seed = uint32_t(seed);
+	m_tickCount = size_t(tickCount);
+	InputReplay replay(*this);
+	InputTick tick;
+	while (replay.Next(tick))
+	{
+		m_last = tick;
+	}
+	if (replay.GetPosition() != m_tickCount || !replay.IsFinished())
+	{
+		Clear(0);
+		return false;
+	}
+	return true;
+}
+
+InputReplay::InputReplay() :
+	m_log(nullptr),
+	m_offset(0),
+	m_position(0),
+	m_last(EmptyTick())
+{
+}
+
+InputReplay::InputReplay(const InputLog& log) :
+	m_log(&log),
+	m_offset(0),
+	m_position(0),
+	m_last(EmptyTick())
+{
+}
+
+bool InputReplay::Next(InputTick& tick)
+{
+	if (!m_log || m_position >= m_log->m_tickCount || m_offset >= m_log->m_data.size())
+	{
+		return false;
+	}
+	const std::vector<uint8_t>& data = m_log->m_data;
+	size_t offset = m_offset;
+	uint8_t changed = data[offset++];
+	if (changed & ~uint8_t(ChangedButtons | ChangedYaw | ChangedPitch | ChangedElapsed))
+	{
+		return false;
+	}
+	InputTick next = m_last;
+	uint64_t value;
+	if (changed & ChangedButtons)
+	{
+		if (!GetInteger(data, offset, 2, value))
+		{
+			return false;
+		}
+		UnpackButtons(uint16_t(value), next.input);
+	}
+	if (changed & ChangedYaw)
+	{
+		if (!GetInteger(data, offset, 4, value))
+		{
+			return false;
+		}
+		next.input.m_yaw = BitsFloat(uint32_t(value));
+	}
+	if (changed & ChangedPitch)
+	{
+		if (!GetInteger(data, offset, 4, value))
+		{
+			return false;
+		}
+		next.input.m_pitch = BitsFloat(uint32_t(value));
+	}
+	if (changed & ChangedElapsed)
+	{
+		if (!GetVariable(data, offset, next.elapsedTicks))
+		{
+			return false;
+		}
+	}
+
+	m_offset = offset;
+	m_position++;
+	m_last = next;
+	tick = next;
+	return true;
+}
+
+bool InputReplay::IsFinished() const
+{
+	return !m_log || (m_position == m_log->m_tickCount && m_offset == m_log->m_data.size());
+}
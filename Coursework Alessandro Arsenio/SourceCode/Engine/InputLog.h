@@ -0,0 +1,78 @@
+//
+// InputLog.h - The input, timesteps and random seed of a play session, for replaying it exactly
+//
+// The update only learns about the outside world from three things: each tick's InputCommands,
+// the time each tick covers, and the seed of the random numbers drawn when the world is built.
+// A log holds all three, so feeding it back through the same update rebuilds the same world tick
+// by tick, at whatever speed the replay runs and whether it renders or not.
+//
+// Each tick is stored as what changed since the tick before: a byte saying which fields follow,
+// then those fields. Buttons take a bit each and the timestep is a variable length integer, so a
+// tick that repeats the last one's input and timestep, most of them at a fixed timestep, is one
+// byte. Files are little endian whatever the machine.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "InputCommands.h"
+
+namespace DX
+{
+	struct InputTick
+	{
+		InputCommands input;
+		uint64_t elapsedTicks;		//StepTimer ticks, TicksPerSecond to the second
+	};
+
+	class InputLog
+	{
+	public:
+		InputLog();
+
+		// Empties the log for a session whose world is built from seed.
+		void Clear(uint32_t seed);
+		void Append(const InputCommands& input, uint64_t elapsedTicks);
+
+		uint32_t GetSeed() const			{ return m_seed; }
+		size_t GetTickCount() const			{ return m_tickCount; }
+		size_t GetByteCount() const			{ return m_data.size(); }
+
+		bool Write(std::ostream& stream) const;
+
+		// False, leaving the log empty, when the stream is not a log or ends before the log does.
+		bool Read(std::istream& stream);
+
+	private:
+		friend class InputReplay;
+
+		std::vector<uint8_t>	m_data;
+		uint32_t				m_seed;
+		size_t					m_tickCount;
+		InputTick				m_last;			//the tick the next one is stored against
+	};
+
+	// Reads a log's ticks back in order. The log must outlive the replay and not change under it.
+	class InputReplay
+	{
+	public:
+		InputReplay();
+		explicit InputReplay(const InputLog& log);
+
+		// False once every tick has been read.
+		bool Next(InputTick& tick);
+		bool IsFinished() const;
+		size_t GetPosition() const			{ return m_position; }		//ticks read so far
+
+	private:
+		const InputLog*		m_log;
+		size_t				m_offset;
+		size_t				m_position;
+		InputTick			m_last;
+	};
+}
@@ -0,0 +1,274 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+using namespace DX;
+
+namespace
+{
+	//which system and worker the current thread belongs to, unset on the main thread
+	thread_local const JobSystem* t_system = nullptr;
+	thread_local unsigned int t_worker = 0;
+}
+
+JobSystem::JobSystem(unsigned int workerCount) :
+	m_mainThread(std::this_thread::get_id()),
+	m_queuedCount(0),
+	m_sleepingCount(0),
+	m_stopping(false)
+{
+	for (unsigned int i = 0; i <= workerCount; i++)
+	{
+		m_queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+	}
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerMain, this, i + 1));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::Run(Job job, JobCounter* counter, JobCounter* after)
+{
+	if (counter)
+	{
+		counter->m_pending.fetch_add(1, std::memory_order_acq_rel);
+	}
+	if (after)
+	{
+		//the check and the append are under the lock Finish takes, so the job is either held or queued, never lost
+		std::lock_guard<std::mutex> lock(after->m_mutex);
+		if (!after->IsDone())
+		{
+			JobCounter::Continuation continuation = { std::move(job), counter, false };
+			after->m_continuations.push_back(std::move(continuation));
+			return;
+		}
+	}
+	Submit(job, counter, false);
+}
+
+void JobSystem::RunOnMainThread(Job job, JobCounter* counter, JobCounter* after)
+{
+	if (counter)
+	{
+		counter->m_pending.fetch_add(1, std::memory_order_acq_rel);
+	}
+	if (after)
+	{
+		std::lock_guard<std::mutex> lock(after->m_mutex);
+		if (!after->IsDone())
+		{
+			JobCounter::Continuation continuation = { std::move(job), counter, true };
+			after->m_continuations.push_back(std::move(continuation));
+			return;
+		}
+	}
+	Submit(job, counter, true);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	unsigned int worker = CurrentWorker();
+	bool mainThread = IsMainThread();
+	while (!counter.IsDone())
+	{
+		Queued queued;
+		if ((mainThread && TakeMainThreadJob(queued)) || TakeJob(worker, queued))
+		{
+			Execute(queued);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	//the job that finished the count may still hold the lock, the counter can go once it is released
+	std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grain, const RangeJob& body)
+{
+	if (end <= begin)
+	{
+		return;
+	}
+	size_t count = end - begin;
+	if (grain == 0)
+	{
+		grain = std::max<size_t>(count / ((m_workers.size() + 1) * 4), 1);
+	}
+
+	//the calling thread takes the first piece itself
+	JobCounter counter;
+	size_t first = std::min(end, begin + grain);
+	for (size_t start = first; start < end; start += std::min(grain, end - start))
+	{
+		size_t stop = start + std::min(grain, end - start);
+		Run([&body, start, stop]() { body(start, stop); }, &counter);
+	}
+	body(begin, first);
+	Wait(counter);
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+	//jobs queued while these run wait for the next call
+	std::deque<Queued> jobs;
+	{
+		std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+		jobs.swap(m_mainThreadJobs);
+	}
+	for (Queued& queued : jobs)
+	{
+		Execute(queued);
+	}
+}
+
+unsigned int JobSystem::DefaultWorkerCount()
+{
+	unsigned int threads = std::thread::hardware_concurrency();
+	return threads > 1 ? threads - 1 : 1;
+}
+
+void JobSystem::Submit(Job& job, JobCounter* counter, bool mainThread)
+{
+	Queued queued = { std::move(job), counter };
+	if (mainThread)
+	{
+		std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+		m_mainThreadJobs.push_back(std::move(queued));
+		return;
+	}
+	Push(std::move(queued));
+}
+
+void JobSystem::Push(Queued&& queued)
+{
+	WorkerQueue& queue = *m_queues[CurrentWorker()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(queued));
+	}
+
+	//a worker going to sleep counts itself before it checks for jobs, and this counts the job before it checks for
+	//sleepers, so one of the two always sees the other
+	m_queuedCount.fetch_add(1, std::memory_order_seq_cst);
+	if (m_sleepingCount.load(std::memory_order_seq_cst) > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wake.notify_one();
+	}
+}
+
+bool JobSystem::TakeJob(unsigned int worker, Queued& queued)
+{
+	//newest of our own first, then the oldest of the others'
+	size_t count = m_queues.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		WorkerQueue& queue = *m_queues[(worker + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+		{
+			continue;
+		}
+		if (i == 0)
+		{
+			queued = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+		else
+		{
+			queued = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+		m_queuedCount.fetch_sub(1, std::memory_order_seq_cst);
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::TakeMainThreadJob(Queued& queued)
+{
+	std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+	if (m_mainThreadJobs.empty())
+	{
+		return false;
+	}
+	queued = std::move(m_mainThreadJobs.front());
+	m_mainThreadJobs.pop_front();
+	return true;
+}
+
+void JobSystem::Execute(Queued& queued)
+{
+	queued.work();
+	queued.work = nullptr;
+	Finish(queued.counter);
+}
+
+void JobSystem::Finish(JobCounter* counter)
+{
+	if (!counter)
+	{
+		return;
+	}
+
+	//decremented under the lock Run checks, so a job held for this counter is released exactly once
+	std::vector<JobCounter::Continuation> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->m_mutex);
+		if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			ready.swap(counter->m_continuations);
+		}
+	}
+	for (JobCounter::Continuation& continuation : ready)
+	{
+		Submit(continuation.work, continuation.counter, continuation.mainThread);
+	}
+}
+
+void JobSystem::WorkerMain(unsigned int worker)
+{
+	t_system = this;
+	t_worker = worker;
+	for (;;)
+	{
+		Queued queued;
+		if (TakeJob(worker, queued))
+		{
+			Execute(queued);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleepingCount.fetch_add(1, std::memory_order_seq_cst);
+		m_wake.wait(lock, [this]() { return m_stopping || m_queuedCount.load(std::memory_order_seq_cst) > 0; });
+		m_sleepingCount.fetch_sub(1, std::memory_order_seq_cst);
+		if (m_stopping && m_queuedCount.load(std::memory_order_seq_cst) == 0)
+		{
+			return;
+		}
+	}
+}
+
+unsigned int JobSystem::CurrentWorker() const
+{
+	return t_system == this ? t_worker : 0;
+}
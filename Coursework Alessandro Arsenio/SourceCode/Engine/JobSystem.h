@@ -0,0 +1,130 @@
+//
+// JobSystem.h - Work-stealing job scheduler
+//
+// Every worker owns a deque of jobs: it pushes and pops its own jobs at the back, so the job
+// it just spawned is the next it runs while its data is still in cache, and idle workers steal
+// from the front of the others, taking the oldest and usually largest pieces of work. The
+// thread that creates the system is worker 0 and has a deque too, but it only runs jobs while
+// it waits.
+//
+// A counter tracks a group of jobs; waiting on it runs other jobs instead of blocking, so
+// waiting inside a job cannot starve the pool. A job can be held back until a counter reaches
+// zero, which is how dependencies are expressed. Jobs that must run on the main thread, like
+// anything using the D3D immediate context, go on a separate queue the main thread drains.
+//
+// Jobs must not throw.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+	class JobSystem;
+
+	// Jobs still to finish in a group. Reusable once it has reached zero.
+	class JobCounter
+	{
+	public:
+		JobCounter() : m_pending(0) {}
+
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool IsDone() const		{ return m_pending.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		struct Continuation
+		{
+			std::function<void()> work;
+			JobCounter* counter;
+			bool mainThread;
+		};
+
+		std::atomic<int>				m_pending;
+		std::mutex						m_mutex;
+		std::vector<Continuation>		m_continuations;	//jobs waiting for m_pending to reach zero
+	};
+
+	class JobSystem
+	{
+	public:
+		typedef std::function<void()> Job;
+		typedef std::function<void(size_t begin, size_t end)> RangeJob;
+
+		// With no workers jobs only run on the main thread, while it waits. Wait for every job before destroying it.
+		explicit JobSystem(unsigned int workerCount);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// Queues a job, counted in counter until it finishes. After is a counter it waits for.
+		void Run(Job job, JobCounter* counter = nullptr, JobCounter* after = nullptr);
+
+		// Queues a job that only the main thread runs, in RunMainThreadJobs or Wait.
+		void RunOnMainThread(Job job, JobCounter* counter = nullptr, JobCounter* after = nullptr);
+
+		// Runs jobs until the counter reaches zero. The main thread runs its own queue as well.
+		void Wait(JobCounter& counter);
+
+		// Calls body over [begin, end) in pieces of about grain items, spread over the workers,
+		// and returns when all are done. A grain of 0 picks a few pieces per worker.
+		void ParallelFor(size_t begin, size_t end, size_t grain, const RangeJob& body);
+
+		// Runs every main thread job queued so far. Call it once a frame from the main thread.
+		void RunMainThreadJobs();
+
+		unsigned int GetWorkerCount() const		{ return (unsigned int)m_workers.size(); }
+		bool IsMainThread() const				{ return std::this_thread::get_id() == m_mainThread; }
+
+		// One worker per hardware thread, leaving one for the main thread.
+		static unsigned int DefaultWorkerCount();
+
+	private:
+		struct Queued
+		{
+			Job work;
+			JobCounter* counter;
+		};
+
+		struct WorkerQueue
+		{
+			std::mutex mutex;
+			std::deque<Queued> jobs;
+		};
+
+		void Submit(Job& job, JobCounter* counter, bool mainThread);
+		void Push(Queued&& queued);
+		bool TakeJob(unsigned int worker, Queued& queued);
+		bool TakeMainThreadJob(Queued& queued);
+		void Execute(Queued& queued);
+		void Finish(JobCounter* counter);
+		void WorkerMain(unsigned int worker);
+		unsigned int CurrentWorker() const;
+
+		std::vector<std::thread>					m_workers;
+		std::vector<std::unique_ptr<WorkerQueue>>	m_queues;			//0 is the main thread's
+		std::thread::id								m_mainThread;
+
+		std::mutex									m_mainThreadMutex;
+		std::deque<Queued>							m_mainThreadJobs;
+
+		//sleeping workers wake when a job is queued
+		std::atomic<int>							m_queuedCount;
+		std::atomic<int>							m_sleepingCount;
+		std::mutex									m_sleepMutex;
+		std::condition_variable						m_wake;
+		bool										m_stopping;
+	};
+}
@@ -0,0 +1,206 @@
+#include "pch.h"
+#include "Lz4.h"
+
+#include <string.h>
+#include <vector>
+
+namespace
+{
+	const size_t MIN_MATCH = 4;
+	const size_t LAST_LITERALS = 5;		//the last 5 bytes of a block are always literals
+	const size_t MF_LIMIT = 12;			//the last match must start at least 12 bytes before the end
+	const size_t MAX_OFFSET = 65535;
+	const int HASH_LOG = 12;
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Hash(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HASH_LOG);
+	}
+
+	//writes the 15+ continuation bytes used by both literal and match lengths
+	inline bool WriteLength(size_t length, uint8_t*& op, const uint8_t* oend)
+	{
+		while (length >= 255)
+		{
+			if (op >= oend) return false;
+			*op++ = 255;
+			length -= 255;
+		}
+		if (op >= oend) return false;
+		*op++ = (uint8_t)length;
+		return true;
+	}
+
+	bool WriteSequence(const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength, bool lastSequence, uint8_t*& op, const uint8_t* oend)
+	{
+		if (op >= oend) return false;
+		uint8_t* token = op++;
+
+		//literal run
+		if (literalLength >= 15)
+		{
+			*token = 15 << 4;
+			if (!WriteLength(literalLength - 15, op, oend)) return false;
+		}
+		else
+		{
+			*token = (uint8_t)(literalLength << 4);
+		}
+		if ((size_t)(oend - op) < literalLength) return false;
+		memcpy(op, literals, literalLength);
+		op += literalLength;
+
+		if (lastSequence)
+		{
+			return true;
+		}
+
+		//match offset and length
+		if ((size_t)(oend - op) < 2) return false;
+		*op++ = (uint8_t)(offset & 0xFF);
+		*op++ = (uint8_t)(offset >> 8);
+
+		size_t matchCode = matchLength - MIN_MATCH;
+		if (matchCode >= 15)
+		{
+			*token |= 15;
+			if (!WriteLength(matchCode - 15, op, oend)) return false;
+		}
+		else
+		{
+			*token |= (uint8_t)matchCode;
+		}
+		return true;
+	}
+}
+
+size_t DX::Lz4::Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+{
+	uint8_t* op = dst;
+	const uint8_t* oend = dst + dstCapacity;
+	size_t anchor = 0;
+
+	if (srcSize > MF_LIMIT)
+	{
+		//positions are stored +1 so that zero means "empty slot"
+		std::vector<uint32_t> table(size_t(1) << HASH_LOG, 0);
+		const size_t matchLimit = srcSize - LAST_LITERALS;
+		const size_t lastMatchStart = srcSize - MF_LIMIT;
+
+		size_t ip = 0;
+		while (ip <= lastMatchStart)
+		{
+			uint32_t sequence = Read32(src + ip);
+			uint32_t h = Hash(sequence);
+			size_t candidate = table[h];
+			table[h] = (uint32_t)(ip + 1);
+
+			if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || Read32(src + candidate - 1) != sequence)
+			{
+				ip++;
+				continue;
+			}
+
+			size_t ref = candidate - 1;
+			size_t length = MIN_MATCH;
+			while (ip + length < matchLimit && src[ref + length] == src[ip + length])
+			{
+				length++;
+			}
+
+			if (!WriteSequence(src + anchor, ip - anchor, ip - ref, length, false, op, oend))
+			{
+				return 0;
+			}
+
+			ip += length;
+			anchor = ip;
+		}
+	}
+
+	//whatever is left is emitted as the final literal run
+	if (!WriteSequence(src + anchor, srcSize - anchor, 0, 0, true, op, oend))
+	{
+		return 0;
+	}
+	return (size_t)(op - dst);
+}
+
+bool DX::Lz4::Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+	size_t ip = 0;
+	size_t op = 0;
+
+	while (ip < srcSize)
+	{
+		uint8_t token = src[ip++];
+
+		//literal run
+		size_t literalLength = token >> 4;
+		if (literalLength == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if (ip >= srcSize) return false;
+				b = src[ip++];
+				literalLength += b;
+			} while (b == 255);
+		}
+		if (literalLength > srcSize - ip || literalLength > dstSize - op)
+		{
+			return false;
+		}
+		memcpy(dst + op, src + ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		//the last sequence only carries literals
+		if (ip == srcSize)
+		{
+			break;
+		}
+
+		if (srcSize - ip < 2) return false;
+		size_t offset = size_t(src[ip]) | (size_t(src[ip + 1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > op)
+		{
+			return false;
+		}
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if (ip >= srcSize) return false;
+				b = src[ip++];
+				matchLength += b;
+			} while (b == 255);
+		}
+		matchLength += MIN_MATCH;
+		if (matchLength > dstSize - op)
+		{
+			return false;
+		}
+
+		//matches may overlap the bytes they are producing, so copy forwards one byte at a time
+		const uint8_t* match = dst + op - offset;
+		for (size_t i = 0; i < matchLength; i++)
+		{
+			dst[op + i] = match[i];
+		}
+		op += matchLength;
+	}
+
+	return op == dstSize;
+}
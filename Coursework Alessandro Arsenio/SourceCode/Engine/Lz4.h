@@ -0,0 +1,26 @@
+//
+// Lz4.h - Minimal LZ4 block format compressor / decompressor
+//
+// Only the raw block format is implemented (no frame header, no checksums), which is
+// all the asset pack needs: every block is stored with its compressed and uncompressed size.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace DX
+{
+	namespace Lz4
+	{
+		// Worst case size of a compressed block for an input of inputSize bytes.
+		inline size_t CompressBound(size_t inputSize) { return inputSize + (inputSize / 255) + 16; }
+
+		// Compresses src into dst. Returns the compressed size, or 0 if dst is too small.
+		size_t Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+		// Decompresses a whole block. dstSize must be the exact uncompressed size of the block.
+		bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+	}
+}
@@ -14,6 +14,55 @@ namespace
 #ifdef DXTK_AUDIO
     HDEVNOTIFY g_hNewAudio = nullptr;
 #endif
+
+    // The word after a switch, in quotes if it has spaces, or empty when the switch is not on the command line.
+    std::wstring SwitchValue(LPCWSTR cmdLine, const wchar_t* name)
+    {
+        size_t length = wcslen(name);
+        for (const wchar_t* found = cmdLine ? wcsstr(cmdLine, name) : nullptr; found; found = wcsstr(found + 1, name))
+        {
+            //-record must not match a longer switch that starts with it
+            const wchar_t* value = found + length;
+            if (*value != L' ' && *value != L'\t')
+            {
+                continue;
+            }
+            while (*value == L' ' || *value == L'\t')
+            {
+                value++;
+            }
+            const wchar_t* end;
+            if (*value == L'"')
+            {
+                value++;
+                end = wcschr(value, L'"');
+                end = end ? end : value + wcslen(value);
+            }
+            else
+            {
+                end = value + wcscspn(value, L" \t");
+            }
+            return std::wstring(value, end);
+        }
+        return std::wstring();
+    }
+
+    // Switches that write a file and exit instead of starting the game. The simulation core's tests
+    // and benchmarks are CMake targets, see CMakeLists.txt.
+    struct FileSwitch
+    {
+        const wchar_t* name;
+        bool (*write)(const wchar_t* filename);
+        const wchar_t* filename;
+    };
+
+    const FileSwitch g_fileSwitches[] =
+    {
+        { L"-buildpack",        &Game::BuildAssetPack,          L"Assets.pak" },                //cooks the loose assets
+        { L"-lodreport",        &Game::WriteLodReport,          L"LodReport.txt" },             //level of detail triangle counts and errors for every model
+        { L"-vertexreport",     &Game::WriteVertexFormatReport, L"VertexFormatReport.txt" },    //size and round trip error of every vertex format for every model
+        { L"-meshletreport",    &Game::WriteMeshletReport,      L"MeshletReport.txt" },         //triangles meshlet culling keeps from a fixed set of cameras
+    };
 };
 
 //GLOBALS
@@ -34,7 +83,6 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 {
 	//macros to tell the compiler the following parameters are unused and to optimise accordingly
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
 
     if (!XMVerifyCPUSupport())
         return 1;
@@ -43,8 +91,59 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     if (FAILED(hr))
         return 1;
 
+    // a switch that writes a file runs instead of the game, see g_fileSwitches
+    for (const FileSwitch& fileSwitch : g_fileSwitches)
+    {
+        if (lpCmdLine && wcsstr(lpCmdLine, fileSwitch.name))
+        {
+            bool written = fileSwitch.write(fileSwitch.filename);
+            CoUninitialize();
+            return written ? 0 : 1;
+        }
+    }
+
     g_game = std::make_unique<Game>();
 
+    // -serialload loads assets one after another, to compare against the parallel loader
+    if (lpCmdLine && wcsstr(lpCmdLine, L"-serialload"))
+    {
+        g_game->m_serialAssetLoading = true;
+    }
+
+    // -singlethreaded updates and renders back to back on the main thread, for debugging
+    if (lpCmdLine && wcsstr(lpCmdLine, L"-singlethreaded"))
+    {
+        g_game->m_singleThreadedFrames = true;
+    }
+
+    // -variablestep updates once a frame over the time since the last instead of at a fixed rate; -simrate hz sets
+    // that rate and -maxcatchup n the most updates a frame runs to catch up with the clock
+    if (lpCmdLine && wcsstr(lpCmdLine, L"-variablestep"))
+    {
+        g_game->m_fixedTimeStep = false;
+    }
+    std::wstring simulationRate = SwitchValue(lpCmdLine, L"-simrate");
+    if (!simulationRate.empty() && _wtof(simulationRate.c_str()) > 0)
+    {
+        g_game->m_simulationRate = _wtof(simulationRate.c_str());
+    }
+    std::wstring maxCatchUp = SwitchValue(lpCmdLine, L"-maxcatchup");
+    if (!maxCatchUp.empty())
+    {
+        g_game->m_maxCatchUpUpdates = (uint32_t)wcstoul(maxCatchUp.c_str(), nullptr, 10);
+    }
+
+    // -record file logs the session's input, timesteps and random seed; -replay file plays such a log back instead
+    // of the keyboard and mouse, then writes the world hash to ReplayResult.txt and exits, with 1 if -golden hash differs
+    g_game->m_recordPath = SwitchValue(lpCmdLine, L"-record");
+    g_game->m_replayPath = SwitchValue(lpCmdLine, L"-replay");
+    std::wstring golden = SwitchValue(lpCmdLine, L"-golden");
+    if (!golden.empty())
+    {
+        g_game->m_hasGoldenHash = true;
+        g_game->m_goldenHash = wcstoull(golden.c_str(), nullptr, 16);
+    }
+
     // Register class and create window
     {
         // Register Windows Class information. 
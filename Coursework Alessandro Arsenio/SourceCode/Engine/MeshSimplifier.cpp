@@ -0,0 +1,740 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <string.h>
+#include <unordered_map>
+
+using namespace DX;
+using namespace DX::MeshSimplifier;
+
+namespace
+{
+	struct Vec3
+	{
+		double x, y, z;
+	};
+
+	inline Vec3 Sub(const Vec3& a, const Vec3& b)		{ return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline Vec3 Cross(const Vec3& a, const Vec3& b)		{ return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	inline double Dot(const Vec3& a, const Vec3& b)		{ return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline double Length(const Vec3& a)					{ return std::sqrt(Dot(a, a)); }
+
+	// Symmetric 4x4 matrix of a sum of squared plane distances, stored as its upper triangle.
+	// weight is the sum of the plane weights, so Evaluate / weight is a mean squared distance.
+	struct Quadric
+	{
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+		double weight;
+
+		void Clear()
+		{
+			memset(this, 0, sizeof(*this));
+		}
+
+		void AddPlane(const Vec3& n, double d, double w)
+		{
+			a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+			b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+			c2 += w * n.z * n.z; cd += w * n.z * d;
+			d2 += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+			weight += q.weight;
+		}
+
+		double Evaluate(const Vec3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double e = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+				+ b2 * y * y + 2 * bc * y * z + 2 * bd * y
+				+ c2 * z * z + 2 * cd * z
+				+ d2;
+			return e > 0 ? e : 0;
+		}
+	};
+
+	enum VertexKind : uint8_t
+	{
+		KindInterior,
+		KindBorder,		//on exactly two border edges, may slide along them
+		KindLocked,		//corner, non-manifold, or border with lockBorder set
+	};
+
+	struct Collapse
+	{
+		double cost;
+		uint32_t from;
+		uint32_t to;
+		uint32_t fromStamp;
+		uint32_t toStamp;
+
+		bool operator>(const Collapse& other) const { return cost > other.cost; }
+	};
+
+	// FNV-1a over the raw bytes, for welding bit-identical keys.
+	template<typename T>
+	struct BytesHash
+	{
+		size_t operator()(const T& value) const
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < sizeof(T); i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+			return (size_t)hash;
+		}
+	};
+
+	template<typename T>
+	struct BytesEqual
+	{
+		bool operator()(const T& a, const T& b) const { return memcmp(&a, &b, sizeof(T)) == 0; }
+	};
+
+	struct PositionKey
+	{
+		float p[3];
+	};
+
+	class Simplifier
+	{
+	public:
+		Simplifier(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Options& options) :
+			m_vertices(vertices),
+			m_options(options),
+			m_maxCost(0)
+		{
+			BuildPositions();
+			BuildTriangles(indices);
+			ClassifyVertices();
+			BuildQuadrics();
+		}
+
+		float Run(size_t targetTriangles, std::vector<uint32_t>& result)
+		{
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+			for (uint32_t p = 0; p < m_positions.size(); p++)
+			{
+				Collapse best;
+				if (FindBestCollapse(p, best))
+				{
+					queue.push(best);
+				}
+			}
+
+			const double maxCost = double(m_options.maxError) * m_options.maxError;
+			std::vector<uint32_t> ring;
+			while (m_liveTriangles > targetTriangles && !queue.empty())
+			{
+				Collapse collapse = queue.top();
+				queue.pop();
+
+				//anything around either end changed since this was queued, it was re-queued then
+				if (m_dead[collapse.from] || m_dead[collapse.to]
+					|| m_stamps[collapse.from] != collapse.fromStamp || m_stamps[collapse.to] != collapse.toStamp)
+				{
+					continue;
+				}
+				if (collapse.cost > maxCost)
+				{
+					break;
+				}
+
+				Apply(collapse.from, collapse.to);
+				m_maxCost = std::max(m_maxCost, collapse.cost);
+
+				//re-evaluate everything whose one-ring just changed
+				Neighbours(collapse.to, ring);
+				ring.push_back(collapse.to);
+				for (uint32_t p : ring)
+				{
+					m_stamps[p]++;
+				}
+				for (uint32_t p : ring)
+				{
+					Collapse best;
+					if (FindBestCollapse(p, best))
+					{
+						queue.push(best);
+					}
+				}
+			}
+
+			result.clear();
+			result.reserve(m_liveTriangles * 3);
+			for (size_t t = 0; t < m_triangles.size() / 3; t++)
+			{
+				if (m_triangleAlive[t])
+				{
+					result.push_back(m_triangles[t * 3 + 0]);
+					result.push_back(m_triangles[t * 3 + 1]);
+					result.push_back(m_triangles[t * 3 + 2]);
+				}
+			}
+			return (float)std::sqrt(m_maxCost);
+		}
+
+		size_t GetTriangleCount() const { return m_liveTriangles; }
+
+	private:
+		//welds by position only, so triangles either side of a UV or normal seam share topology
+		void BuildPositions()
+		{
+			//work in a space where the bounding sphere has radius 1, so errors are relative
+			float center[3];
+			float radius;
+			ComputeBoundingSphere(m_vertices, center, radius);
+			double scale = radius > 0 ? 1.0 / radius : 1.0;
+
+			std::unordered_map<PositionKey, uint32_t, BytesHash<PositionKey>, BytesEqual<PositionKey>> lookup;
+			m_positionOf.resize(m_vertices.size());
+			for (uint32_t v = 0; v < m_vertices.size(); v++)
+			{
+				PositionKey key;
+				memcpy(key.p, m_vertices[v].position, sizeof(key.p));
+				auto inserted = lookup.emplace(key, (uint32_t)m_positions.size());
+				if (inserted.second)
+				{
+					const float* p = m_vertices[v].position;
+					m_positions.push_back({ (p[0] - center[0]) * scale, (p[1] - center[1]) * scale, (p[2] - center[2]) * scale });
+					m_wedges.push_back(std::vector<uint32_t>());
+				}
+				m_positionOf[v] = inserted.first->second;
+				m_wedges[m_positionOf[v]].push_back(v);
+			}
+
+			m_dead.assign(m_positions.size(), false);
+			m_stamps.assign(m_positions.size(), 0);
+			m_trianglesOf.resize(m_positions.size());
+		}
+
+		void BuildTriangles(const std::vector<uint32_t>& indices)
+		{
+			m_liveTriangles = 0;
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				uint32_t p0 = m_positionOf[indices[i + 0]];
+				uint32_t p1 = m_positionOf[indices[i + 1]];
+				uint32_t p2 = m_positionOf[indices[i + 2]];
+
+				//zero area triangles only get in the way of the flip tests
+				if (p0 == p1 || p1 == p2 || p0 == p2)
+				{
+					continue;
+				}
+
+				uint32_t t = (uint32_t)(m_triangles.size() / 3);
+				m_triangles.push_back(indices[i + 0]);
+				m_triangles.push_back(indices[i + 1]);
+				m_triangles.push_back(indices[i + 2]);
+				m_triangleAlive.push_back(true);
+				m_trianglesOf[p0].push_back(t);
+				m_trianglesOf[p1].push_back(t);
+				m_trianglesOf[p2].push_back(t);
+				m_liveTriangles++;
+			}
+		}
+
+		void ClassifyVertices()
+		{
+			//edges used by one triangle are border, by more than two non-manifold
+			std::unordered_map<uint64_t, uint32_t> edgeUse;
+			for (size_t t = 0; t < m_triangleAlive.size(); t++)
+			{
+				for (int e = 0; e < 3; e++)
+				{
+					edgeUse[EdgeKey(Corner(t, e), Corner(t, (e + 1) % 3))]++;
+				}
+			}
+
+			std::vector<uint32_t> borderEdges(m_positions.size(), 0);
+			m_kinds.assign(m_positions.size(), KindInterior);
+			for (const auto& edge : edgeUse)
+			{
+				uint32_t a = (uint32_t)(edge.first >> 32);
+				uint32_t b = (uint32_t)(edge.first & 0xFFFFFFFF);
+				if (edge.second == 1)
+				{
+					borderEdges[a]++;
+					borderEdges[b]++;
+				}
+				else if (edge.second > 2)
+				{
+					m_kinds[a] = KindLocked;
+					m_kinds[b] = KindLocked;
+				}
+			}
+
+			for (uint32_t p = 0; p < m_positions.size(); p++)
+			{
+				if (m_kinds[p] == KindLocked || borderEdges[p] == 0)
+				{
+					continue;
+				}
+				m_kinds[p] = (borderEdges[p] == 2 && !m_options.lockBorder) ? KindBorder : KindLocked;
+			}
+			m_edgeUse.swap(edgeUse);
+		}
+
+		void BuildQuadrics()
+		{
+			m_quadrics.resize(m_positions.size());
+			for (auto& q : m_quadrics)
+			{
+				q.Clear();
+			}
+
+			for (size_t t = 0; t < m_triangleAlive.size(); t++)
+			{
+				uint32_t p[3] = { Corner(t, 0), Corner(t, 1), Corner(t, 2) };
+				Vec3 normal = Cross(Sub(m_positions[p[1]], m_positions[p[0]]), Sub(m_positions[p[2]], m_positions[p[0]]));
+				double length = Length(normal);
+				if (length <= 0)
+				{
+					continue;
+				}
+
+				//area weighted, so big flat triangles pull harder than slivers
+				double area = length * 0.5;
+				Vec3 n = { normal.x / length, normal.y / length, normal.z / length };
+				double d = -Dot(n, m_positions[p[0]]);
+				for (int c = 0; c < 3; c++)
+				{
+					m_quadrics[p[c]].AddPlane(n, d, area);
+				}
+
+				//a plane through each border edge, perpendicular to the face, holds the outline in place
+				for (int e = 0; e < 3; e++)
+				{
+					uint32_t a = p[e];
+					uint32_t b = p[(e + 1) % 3];
+					if (m_edgeUse[EdgeKey(a, b)] != 1)
+					{
+						continue;
+					}
+					Vec3 edge = Sub(m_positions[b], m_positions[a]);
+					Vec3 m = Cross(edge, n);
+					double mLength = Length(m);
+					if (mLength <= 0)
+					{
+						continue;
+					}
+					m = { m.x / mLength, m.y / mLength, m.z / mLength };
+					double w = BorderWeight * Dot(edge, edge);
+					double md = -Dot(m, m_positions[a]);
+					m_quadrics[a].AddPlane(m, md, w);
+					m_quadrics[b].AddPlane(m, md, w);
+				}
+			}
+		}
+
+		bool FindBestCollapse(uint32_t from, Collapse& best)
+		{
+			if (m_dead[from] || m_kinds[from] == KindLocked)
+			{
+				return false;
+			}
+
+			//cost every edge first, then validate from the cheapest up; the topology checks
+			//are the expensive part and usually the first candidate passes
+			Neighbours(from, m_candidateRing);
+			m_candidates.clear();
+			for (uint32_t to : m_candidateRing)
+			{
+				m_candidates.push_back(std::make_pair(Cost(from, to), to));
+			}
+			std::sort(m_candidates.begin(), m_candidates.end());
+
+			for (const auto& candidate : m_candidates)
+			{
+				if (CanCollapse(from, candidate.second))
+				{
+					best.cost = candidate.first;
+					best.from = from;
+					best.to = candidate.second;
+					best.fromStamp = m_stamps[from];
+					best.toStamp = m_stamps[candidate.second];
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool CanCollapse(uint32_t from, uint32_t to)
+		{
+			uint32_t shared = SharedTriangles(from, to);
+
+			//border vertices may only travel along the border
+			if (m_kinds[from] == KindBorder && shared != 1)
+			{
+				return false;
+			}
+
+			//link condition: the two one-rings may only meet at the opposite corners of the edge,
+			//otherwise the collapse pinches the surface into a non-manifold fan
+			Neighbours(from, m_fromRing);
+			Neighbours(to, m_toRing);
+			uint32_t common = 0;
+			for (uint32_t p : m_fromRing)
+			{
+				if (std::binary_search(m_toRing.begin(), m_toRing.end(), p))
+				{
+					common++;
+				}
+			}
+			if (common != shared)
+			{
+				return false;
+			}
+
+			//no triangle may flip or collapse to a sliver
+			const Vec3& target = m_positions[to];
+			for (uint32_t t : m_trianglesOf[from])
+			{
+				if (!m_triangleAlive[t] || HasCorner(t, to))
+				{
+					continue;
+				}
+
+				Vec3 p[3];
+				Vec3 q[3];
+				for (int c = 0; c < 3; c++)
+				{
+					uint32_t corner = Corner(t, c);
+					p[c] = m_positions[corner];
+					q[c] = corner == from ? target : p[c];
+				}
+				Vec3 before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+				Vec3 after = Cross(Sub(q[1], q[0]), Sub(q[2], q[0]));
+				double beforeLength = Length(before);
+				double afterLength = Length(after);
+				if (afterLength <= 1e-12 || Dot(before, after) < MinFlipCosine * beforeLength * afterLength)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		double Cost(uint32_t from, uint32_t to) const
+		{
+			Quadric q = m_quadrics[from];
+			q.Add(m_quadrics[to]);
+			double geometric = q.weight > 0 ? q.Evaluate(m_positions[to]) / q.weight : 0;
+
+			//every wedge of the removed vertex is replaced by the closest wedge of the kept one;
+			//the worst of those attribute jumps is charged in proportion to the edge length
+			double attribute = 0;
+			for (uint32_t a : m_wedges[from])
+			{
+				double closest = -1;
+				for (uint32_t b : m_wedges[to])
+				{
+					double distance = AttributeDistance(a, b);
+					if (closest < 0 || distance < closest)
+					{
+						closest = distance;
+					}
+				}
+				attribute = std::max(attribute, closest);
+			}
+
+			Vec3 edge = Sub(m_positions[to], m_positions[from]);
+			return geometric + attribute * Dot(edge, edge);
+		}
+
+		double AttributeDistance(uint32_t a, uint32_t b) const
+		{
+			const Vertex& va = m_vertices[a];
+			const Vertex& vb = m_vertices[b];
+			double nDot = double(va.normal[0]) * vb.normal[0] + double(va.normal[1]) * vb.normal[1] + double(va.normal[2]) * vb.normal[2];
+			double du = double(va.texcoord[0]) - vb.texcoord[0];
+			double dv = double(va.texcoord[1]) - vb.texcoord[1];
+			return m_options.normalWeight * std::max(0.0, 1.0 - nDot) + m_options.texcoordWeight * (du * du + dv * dv);
+		}
+
+		void Apply(uint32_t from, uint32_t to)
+		{
+			//map each wedge of the removed position onto the closest wedge of the kept one
+			std::vector<std::pair<uint32_t, uint32_t>> wedgeMap;
+			for (uint32_t a : m_wedges[from])
+			{
+				uint32_t closest = m_wedges[to].front();
+				double closestDistance = AttributeDistance(a, closest);
+				for (uint32_t b : m_wedges[to])
+				{
+					double distance = AttributeDistance(a, b);
+					if (distance < closestDistance)
+					{
+						closest = b;
+						closestDistance = distance;
+					}
+				}
+				wedgeMap.push_back(std::make_pair(a, closest));
+			}
+
+			for (uint32_t t : m_trianglesOf[from])
+			{
+				if (!m_triangleAlive[t])
+				{
+					continue;
+				}
+				if (HasCorner(t, to))
+				{
+					m_triangleAlive[t] = false;
+					m_liveTriangles--;
+					continue;
+				}
+
+				for (int c = 0; c < 3; c++)
+				{
+					uint32_t& wedge = m_triangles[t * 3 + c];
+					if (m_positionOf[wedge] != from)
+					{
+						continue;
+					}
+					for (const auto& mapping : wedgeMap)
+					{
+						if (mapping.first == wedge)
+						{
+							wedge = mapping.second;
+							break;
+						}
+					}
+				}
+				m_trianglesOf[to].push_back(t);
+			}
+
+			m_quadrics[to].Add(m_quadrics[from]);
+			m_dead[from] = true;
+			m_trianglesOf[from].clear();
+			m_wedges[from].clear();
+
+			//drop the triangles that just died from the kept vertex's list
+			auto& list = m_trianglesOf[to];
+			list.erase(std::remove_if(list.begin(), list.end(), [this](uint32_t t) { return !m_triangleAlive[t]; }), list.end());
+		}
+
+		//sorted, unique positions sharing a live triangle with p
+		void Neighbours(uint32_t p, std::vector<uint32_t>& ring) const
+		{
+			ring.clear();
+			for (uint32_t t : m_trianglesOf[p])
+			{
+				if (!m_triangleAlive[t])
+				{
+					continue;
+				}
+				for (int c = 0; c < 3; c++)
+				{
+					uint32_t corner = Corner(t, c);
+					if (corner != p)
+					{
+						ring.push_back(corner);
+					}
+				}
+			}
+			std::sort(ring.begin(), ring.end());
+			ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+		}
+
+		uint32_t SharedTriangles(uint32_t a, uint32_t b) const
+		{
+			uint32_t count = 0;
+			for (uint32_t t : m_trianglesOf[a])
+			{
+				if (m_triangleAlive[t] && HasCorner(t, b))
+				{
+					count++;
+				}
+			}
+			return count;
+		}
+
+		inline uint32_t Corner(size_t t, int c) const	{ return m_positionOf[m_triangles[t * 3 + c]]; }
+		inline bool HasCorner(size_t t, uint32_t p) const	{ return Corner(t, 0) == p || Corner(t, 1) == p || Corner(t, 2) == p; }
+
+		static uint64_t EdgeKey(uint32_t a, uint32_t b)
+		{
+			return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+		}
+
+		static const double BorderWeight;
+		static const double MinFlipCosine;
+
+		const std::vector<Vertex>&				m_vertices;
+		Options									m_options;
+
+		std::vector<Vec3>						m_positions;		//welded, normalised to a unit bounding sphere
+		std::vector<uint32_t>					m_positionOf;		//vertex -> welded position
+		std::vector<std::vector<uint32_t>>		m_wedges;			//welded position -> vertices sharing it
+		std::vector<std::vector<uint32_t>>		m_trianglesOf;		//welded position -> triangles using it
+		std::vector<Quadric>					m_quadrics;
+		std::vector<uint8_t>					m_kinds;
+		std::vector<bool>						m_dead;
+		std::vector<uint32_t>					m_stamps;
+		std::unordered_map<uint64_t, uint32_t>	m_edgeUse;
+
+		std::vector<uint32_t>					m_triangles;		//vertex indices, three per triangle
+		std::vector<bool>						m_triangleAlive;
+		size_t									m_liveTriangles;
+		double									m_maxCost;
+
+		//scratch space reused across candidate searches
+		std::vector<uint32_t>					m_candidateRing;
+		std::vector<uint32_t>					m_fromRing;
+		std::vector<uint32_t>					m_toRing;
+		std::vector<std::pair<double, uint32_t>>	m_candidates;
+	};
+
+	const double Simplifier::BorderWeight = 10.0;
+	const double Simplifier::MinFlipCosine = 0.2;
+}
+
+void MeshSimplifier::WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::unordered_map<Vertex, uint32_t, BytesHash<Vertex>, BytesEqual<Vertex>> lookup;
+	std::vector<Vertex> welded;
+	std::vector<uint32_t> remap(vertices.size());
+
+	for (size_t v = 0; v < vertices.size(); v++)
+	{
+		auto inserted = lookup.emplace(vertices[v], (uint32_t)welded.size());
+		if (inserted.second)
+		{
+			welded.push_back(vertices[v]);
+		}
+		remap[v] = inserted.first->second;
+	}
+
+	for (auto& index : indices)
+	{
+		index = remap[index];
+	}
+	vertices.swap(welded);
+}
+
+float MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Options& options, std::vector<uint32_t>& result)
+{
+	Simplifier simplifier(vertices, indices, options);
+	size_t target = (size_t)(double(indices.size() / 3) * options.targetRatio);
+	return simplifier.Run(target, result);
+}
+
+std::vector<Lod> MeshSimplifier::GenerateLodChain(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const LodChainOptions& options)
+{
+	std::vector<Lod> chain;
+
+	Lod base;
+	base.indices = indices;
+	base.error = 0;
+	chain.push_back(base);
+
+	Options simplify;
+	simplify.maxError = options.maxError;
+	simplify.normalWeight = options.normalWeight;
+	simplify.texcoordWeight = options.texcoordWeight;
+
+	for (float ratio : options.ratios)
+	{
+		simplify.targetRatio = ratio;
+
+		Lod lod;
+		lod.error = Simplify(vertices, indices, simplify, lod.indices);
+
+		//stop once the error bound stops the simplifier from making real progress
+		if (lod.indices.empty() || lod.indices.size() * 10 > chain.back().indices.size() * 9)
+		{
+			break;
+		}
+		chain.push_back(std::move(lod));
+	}
+	return chain;
+}
+
+void MeshSimplifier::ComputeBoundingSphere(const std::vector<Vertex>& vertices, float center[3], float& radius)
+{
+	center[0] = center[1] = center[2] = 0;
+	radius = 0;
+	if (vertices.empty())
+	{
+		return;
+	}
+
+	auto distanceSq = [](const float* a, const float* b)
+	{
+		float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+		return dx * dx + dy * dy + dz * dz;
+	};
+
+	//start from the two points furthest apart along a sweep from an arbitrary vertex
+	const float* a = vertices[0].position;
+	const float* b = a;
+	for (const auto& v : vertices)
+	{
+		if (distanceSq(v.position, a) > distanceSq(b, a)) b = v.position;
+	}
+	const float* c = b;
+	for (const auto& v : vertices)
+	{
+		if (distanceSq(v.position, b) > distanceSq(c, b)) c = v.position;
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		center[i] = (b[i] + c[i]) * 0.5f;
+	}
+	radius = std::sqrt(distanceSq(b, c)) * 0.5f;
+
+	//grow the sphere over anything still outside it
+	for (const auto& v : vertices)
+	{
+		float d = std::sqrt(distanceSq(v.position, center));
+		if (d > radius)
+		{
+			float newRadius = (radius + d) * 0.5f;
+			float shift = (newRadius - radius) / d;
+			for (int i = 0; i < 3; i++)
+			{
+				center[i] += (v.position[i] - center[i]) * shift;
+			}
+			radius = newRadius;
+		}
+	}
+}
+
+int MeshSimplifier::SelectLod(const float* lodErrors, int lodCount, float radius, float distance, float projectionScale, float maxPixelError)
+{
+	//inside the bounding sphere, always full detail
+	if (lodCount <= 1 || distance <= radius)
+	{
+		return 0;
+	}
+
+	//the error grows with the projected size of the sphere: error * radius * scale / distance pixels
+	float pixelsPerUnitError = radius * projectionScale / distance;
+	int selected = 0;
+	for (int lod = 1; lod < lodCount; lod++)
+	{
+		if (lodErrors[lod] * pixelsPerUnitError > maxPixelError)
+		{
+			break;
+		}
+		selected = lod;
+	}
+	return selected;
+}
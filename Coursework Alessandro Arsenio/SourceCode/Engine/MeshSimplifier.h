@@ -0,0 +1,73 @@
+//
+// MeshSimplifier.h - Quadric error metric mesh simplification and LOD selection
+//
+// Simplification collapses edges onto one of their end points (half-edge collapse), so every
+// LOD indexes a subset of the same vertex array and they can all share one vertex buffer.
+// The cost of a collapse is the quadric error of the surviving position plus a penalty for
+// the normal / texture coordinate change it causes. Mesh borders and UV / normal seams are
+// kept: border vertices only slide along the border and corners never move.
+//
+// Errors are reported relative to the radius of the mesh's bounding sphere, so the same
+// threshold means the same thing on a rock and on a palm tree.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DX
+{
+	namespace MeshSimplifier
+	{
+		// Same layout as DirectX::VertexPositionNormalTexture.
+		struct Vertex
+		{
+			float position[3];
+			float normal[3];
+			float texcoord[2];
+		};
+
+		struct Options
+		{
+			float targetRatio = 0.5f;		//fraction of the triangles to keep
+			float maxError = 0.05f;			//stop before a collapse exceeds this relative error
+			float normalWeight = 0.5f;		//cost of bending a normal, per unit of (1 - cos)
+			float texcoordWeight = 1.0f;	//cost of moving a texture coordinate, per squared unit
+			bool lockBorder = false;		//keep border vertices exactly where they are
+		};
+
+		struct LodChainOptions
+		{
+			std::vector<float> ratios = { 0.5f, 0.25f, 0.125f };
+			float maxError = 0.05f;
+			float normalWeight = 0.5f;
+			float texcoordWeight = 1.0f;
+		};
+
+		struct Lod
+		{
+			std::vector<uint32_t> indices;
+			float error;					//relative to the bounding sphere radius
+		};
+
+		// Merges bit-identical vertices and rewrites the indices to match.
+		void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// Simplifies an indexed triangle list. The output indexes the same vertices.
+		// Returns the largest relative error of any collapse that was applied.
+		float Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Options& options, std::vector<uint32_t>& result);
+
+		// LOD 0 is the input itself; each further LOD is simplified from LOD 0 to the next ratio.
+		// Levels that would not remove at least a tenth of the previous level's triangles are skipped.
+		std::vector<Lod> GenerateLodChain(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const LodChainOptions& options);
+
+		// Centre and radius of a sphere around every vertex (Ritter's approximation).
+		void ComputeBoundingSphere(const std::vector<Vertex>& vertices, float center[3], float& radius);
+
+		// Picks the coarsest LOD whose error, projected on screen, stays under maxPixelError.
+		// projectionScale is the screen height in pixels over 2 * tan(fovY / 2).
+		int SelectLod(const float* lodErrors, int lodCount, float radius, float distance, float projectionScale, float maxPixelError);
+	}
+}
@@ -0,0 +1,385 @@
+#include "pch.h"
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+using namespace DX;
+using namespace DX::Meshlets;
+using DX::MeshSimplifier::Vertex;
+
+namespace
+{
+	inline void Sub(const float* a, const float* b, float* out)		{ out[0] = a[0] - b[0]; out[1] = a[1] - b[1]; out[2] = a[2] - b[2]; }
+	inline float Dot(const float* a, const float* b)					{ return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+	inline void Cross(const float* a, const float* b, float* out)
+	{
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+	inline float Normalize(float* v)
+	{
+		float length = std::sqrt(Dot(v, v));
+		if (length > 0)
+		{
+			v[0] /= length;
+			v[1] /= length;
+			v[2] /= length;
+		}
+		return length;
+	}
+
+	//the face normal, flipped to agree with the vertex normals so the cone test does not
+	//depend on which winding the model was exported with
+	void FaceNormal(const std::vector<Vertex>& vertices, const uint32_t* triangle, float* normal)
+	{
+		const Vertex& a = vertices[triangle[0]];
+		const Vertex& b = vertices[triangle[1]];
+		const Vertex& c = vertices[triangle[2]];
+		float e1[3], e2[3];
+		Sub(b.position, a.position, e1);
+		Sub(c.position, a.position, e2);
+		Cross(e1, e2, normal);
+		Normalize(normal);
+
+		float shading[3] = { a.normal[0] + b.normal[0] + c.normal[0], a.normal[1] + b.normal[1] + c.normal[1], a.normal[2] + b.normal[2] + c.normal[2] };
+		if (Dot(normal, shading) < 0)
+		{
+			normal[0] = -normal[0];
+			normal[1] = -normal[1];
+			normal[2] = -normal[2];
+		}
+	}
+
+	void ComputeBounds(const std::vector<Vertex>& vertices, const uint32_t* indices, size_t indexCount, Meshlet& meshlet)
+	{
+		//sphere around the axis aligned box, then shrunk to the farthest vertex
+		float lo[3], hi[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			lo[axis] = hi[axis] = vertices[indices[0]].position[axis];
+		}
+		for (size_t i = 1; i < indexCount; i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				lo[axis] = std::min(lo[axis], vertices[indices[i]].position[axis]);
+				hi[axis] = std::max(hi[axis], vertices[indices[i]].position[axis]);
+			}
+		}
+		float radiusSquared = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			meshlet.center[axis] = (lo[axis] + hi[axis]) * 0.5f;
+		}
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			float offset[3];
+			Sub(vertices[indices[i]].position, meshlet.center, offset);
+			radiusSquared = std::max(radiusSquared, Dot(offset, offset));
+		}
+		meshlet.radius = std::sqrt(radiusSquared);
+
+		//normal cone: the average direction, and the widest angle any face makes with it
+		std::vector<float> normals(indexCount);
+		float axis[3] = { 0, 0, 0 };
+		for (size_t t = 0; t < indexCount / 3; t++)
+		{
+			FaceNormal(vertices, indices + t * 3, &normals[t * 3]);
+			axis[0] += normals[t * 3 + 0];
+			axis[1] += normals[t * 3 + 1];
+			axis[2] += normals[t * 3 + 2];
+		}
+		Normalize(axis);
+
+		float minDot = 1.0f;
+		for (size_t t = 0; t < indexCount / 3; t++)
+		{
+			minDot = std::min(minDot, Dot(&normals[t * 3], axis));
+		}
+
+		memcpy(meshlet.coneAxis, axis, sizeof(axis));
+		memcpy(meshlet.coneApex, meshlet.center, sizeof(meshlet.center));
+
+		//past ~85 degrees the cone can hardly ever be culled and the apex runs off to infinity
+		if (minDot <= 0.1f)
+		{
+			meshlet.coneCutoff = 1.0f;
+			return;
+		}
+
+		//move the apex back along the axis until it is behind every triangle's plane, so a
+		//camera that sees the apex from behind sees every triangle from behind
+		float maxT = 0;
+		for (size_t t = 0; t < indexCount / 3; t++)
+		{
+			const float* normal = &normals[t * 3];
+			float toCenter[3];
+			Sub(meshlet.center, vertices[indices[t * 3]].position, toCenter);
+			maxT = std::max(maxT, Dot(toCenter, normal) / Dot(axis, normal));
+		}
+		for (int a = 0; a < 3; a++)
+		{
+			meshlet.coneApex[a] = meshlet.center[a] - axis[a] * maxT;
+		}
+
+		//the cone of back facing view directions is the normal cone widened by 90 degrees:
+		//cos(angle + 90) = -sin(angle)
+		meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
+
+void Meshlets::Build(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, size_t indexStart, size_t indexCount, std::vector<Meshlet>& meshlets)
+{
+	const size_t triangleCount = indexCount / 3;
+	const uint32_t* source = indices.data() + indexStart;
+
+	//triangles around each vertex, to grow clusters through neighbours
+	std::vector<uint32_t> adjacencyStart(vertices.size() + 1, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		adjacencyStart[source[i] + 1]++;
+	}
+	for (size_t v = 0; v < vertices.size(); v++)
+	{
+		adjacencyStart[v + 1] += adjacencyStart[v];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		adjacency[fill[source[i]]++] = (uint32_t)(i / 3);
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> vertexMeshlet(vertices.size(), UINT32_MAX);	//which meshlet last used each vertex
+	std::vector<uint32_t> ordered;
+	ordered.reserve(triangleCount * 3);
+
+	std::vector<uint32_t> clusterVertices;
+	std::vector<uint32_t> candidates;
+	size_t seed = 0;
+
+	while (true)
+	{
+		while (seed < triangleCount && emitted[seed])
+		{
+			seed++;
+		}
+		if (seed == triangleCount)
+		{
+			break;
+		}
+
+		uint32_t meshletId = (uint32_t)meshlets.size();
+		size_t clusterStart = ordered.size();
+		clusterVertices.clear();
+		float centroid[3] = { 0, 0, 0 };
+
+		auto addTriangle = [&](uint32_t t)
+		{
+			emitted[t] = true;
+			for (int c = 0; c < 3; c++)
+			{
+				uint32_t v = source[t * 3 + c];
+				ordered.push_back(v);
+				if (vertexMeshlet[v] != meshletId)
+				{
+					vertexMeshlet[v] = meshletId;
+					clusterVertices.push_back(v);
+					for (int axis = 0; axis < 3; axis++)
+					{
+						centroid[axis] += (vertices[v].position[axis] - centroid[axis]) / clusterVertices.size();
+					}
+					for (uint32_t a = adjacencyStart[v]; a < adjacencyStart[v + 1]; a++)
+					{
+						if (!emitted[adjacency[a]])
+						{
+							candidates.push_back(adjacency[a]);
+						}
+					}
+				}
+			}
+		};
+
+		candidates.clear();
+		addTriangle((uint32_t)seed);
+
+		while ((ordered.size() - clusterStart) / 3 < MaxTriangles)
+		{
+			//the neighbour adding the fewest new vertices, then the one closest to the centroid
+			int bestIndex = -1;
+			int bestNew = 4;
+			float bestDistance = 0;
+			for (size_t c = 0; c < candidates.size(); c++)
+			{
+				uint32_t t = candidates[c];
+				if (emitted[t])
+				{
+					candidates[c--] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+
+				int newVertices = 0;
+				float center[3] = { 0, 0, 0 };
+				for (int k = 0; k < 3; k++)
+				{
+					uint32_t v = source[t * 3 + k];
+					newVertices += vertexMeshlet[v] != meshletId;
+					for (int axis = 0; axis < 3; axis++)
+					{
+						center[axis] += vertices[v].position[axis] / 3.0f;
+					}
+				}
+				if (clusterVertices.size() + newVertices > MaxVertices)
+				{
+					continue;
+				}
+
+				float offset[3];
+				Sub(center, centroid, offset);
+				float distance = Dot(offset, offset);
+				if (newVertices < bestNew || (newVertices == bestNew && distance < bestDistance))
+				{
+					bestIndex = (int)c;
+					bestNew = newVertices;
+					bestDistance = distance;
+				}
+			}
+
+			if (bestIndex < 0)
+			{
+				break;
+			}
+			uint32_t t = candidates[bestIndex];
+			candidates[bestIndex] = candidates.back();
+			candidates.pop_back();
+			addTriangle(t);
+		}
+
+		Meshlet meshlet;
+		meshlet.indexStart = (uint32_t)(indexStart + clusterStart);
+		meshlet.indexCount = (uint32_t)(ordered.size() - clusterStart);
+		ComputeBounds(vertices, ordered.data() + clusterStart, meshlet.indexCount, meshlet);
+		meshlets.push_back(meshlet);
+	}
+
+	//a trailing partial triangle is left where it was
+	std::copy(ordered.begin(), ordered.end(), indices.begin() + indexStart);
+}
+
+Frustum Meshlets::ExtractFrustum(const float m[16])
+{
+	//row vectors: clip = p * m, so the planes come from the columns (Gribb / Hartmann)
+	auto column = [m](int c, float* out)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			out[r] = m[r * 4 + c];
+		}
+	};
+	float x[4], y[4], z[4], w[4];
+	column(0, x);
+	column(1, y);
+	column(2, z);
+	column(3, w);
+
+	Frustum frustum;
+	for (int i = 0; i < 4; i++)
+	{
+		frustum.planes[0][i] = w[i] + x[i];		//left
+		frustum.planes[1][i] = w[i] - x[i];		//right
+		frustum.planes[2][i] = w[i] + y[i];		//bottom
+		frustum.planes[3][i] = w[i] - y[i];		//top
+		frustum.planes[4][i] = z[i];			//near, D3D clip z starts at 0
+		frustum.planes[5][i] = w[i] - z[i];		//far
+	}
+	for (auto& plane : frustum.planes)
+	{
+		float length = std::sqrt(Dot(plane, plane));
+		if (length > 0)
+		{
+			for (float& p : plane)
+			{
+				p /= length;
+			}
+		}
+	}
+	return frustum;
+}
+
+size_t Meshlets::Cull(const Meshlet* meshlets, size_t count, const float world[16], const Frustum& frustum, const float modelCameraPosition[3],
+	std::vector<DrawRange>& ranges, CullStats* stats)
+{
+	//bounding spheres grow by the largest scale on any axis
+	float scale = 0;
+	for (int r = 0; r < 3; r++)
+	{
+		scale = std::max(scale, std::sqrt(Dot(&world[r * 4], &world[r * 4])));
+	}
+
+	size_t kept = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		const Meshlet& meshlet = meshlets[i];
+		size_t triangles = meshlet.indexCount / 3;
+		if (stats)
+		{
+			stats->meshlets++;
+			stats->triangles += triangles;
+		}
+
+		float center[3];
+		for (int c = 0; c < 3; c++)
+		{
+			center[c] = meshlet.center[0] * world[0 * 4 + c] + meshlet.center[1] * world[1 * 4 + c] + meshlet.center[2] * world[2 * 4 + c] + world[3 * 4 + c];
+		}
+		float radius = meshlet.radius * scale;
+
+		bool outside = false;
+		for (const auto& plane : frustum.planes)
+		{
+			if (Dot(plane, center) + plane[3] < -radius)
+			{
+				outside = true;
+				break;
+			}
+		}
+		if (outside)
+		{
+			if (stats)
+			{
+				stats->frustumCulled += triangles;
+			}
+			continue;
+		}
+
+		//which way a triangle faces survives any affine transform, so the cone is tested in model space
+		float view[3];
+		Sub(meshlet.coneApex, modelCameraPosition, view);
+		if (Normalize(view) > 0 && Dot(view, meshlet.coneAxis) >= meshlet.coneCutoff)
+		{
+			if (stats)
+			{
+				stats->backfaceCulled += triangles;
+			}
+			continue;
+		}
+
+		//meshlets are contiguous in the index buffer, so neighbours that both survive merge
+		if (!ranges.empty() && ranges.back().indexStart + ranges.back().indexCount == meshlet.indexStart)
+		{
+			ranges.back().indexCount += meshlet.indexCount;
+		}
+		else
+		{
+			DrawRange range = { meshlet.indexStart, meshlet.indexCount };
+			ranges.push_back(range);
+		}
+		kept += triangles;
+	}
+	return kept;
+}
@@ -0,0 +1,70 @@
+//
+// Meshlets.h - Splitting meshes into small clusters and culling them on the CPU
+//
+// A meshlet is a run of up to MaxTriangles connected triangles in the index buffer, with a
+// bounding sphere and a cone around its face normals. Each frame the meshlets of a model are
+// tested against the view frustum and their normal cone (a cluster whose triangles all face
+// away from the camera is skipped), and the survivors are drawn as a few index ranges; runs of
+// neighbouring survivors merge into one DrawIndexed.
+//
+// Matrices are SimpleMath's: 16 floats, row major, transforming row vectors.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "MeshSimplifier.h"
+
+namespace DX
+{
+	namespace Meshlets
+	{
+		const size_t MaxVertices = 64;
+		const size_t MaxTriangles = 124;
+
+		struct Meshlet
+		{
+			uint32_t indexStart;
+			uint32_t indexCount;
+			float center[3];		//bounding sphere, model space
+			float radius;
+			float coneApex[3];		//back facing when normalize(apex - camera) . axis >= cutoff
+			float coneAxis[3];
+			float coneCutoff;		//1 when the normals are too spread out to ever cull
+		};
+
+		struct DrawRange
+		{
+			uint32_t indexStart;
+			uint32_t indexCount;
+		};
+
+		// Six planes, (a, b, c, d) with a x + b y + c z + d >= 0 inside.
+		struct Frustum
+		{
+			float planes[6][4];
+		};
+
+		struct CullStats
+		{
+			size_t meshlets;
+			size_t triangles;
+			size_t frustumCulled;		//triangles
+			size_t backfaceCulled;		//triangles, of those inside the frustum
+		};
+
+		// Reorders indices[indexStart, indexStart + indexCount) into meshlets and appends them.
+		void Build(const std::vector<MeshSimplifier::Vertex>& vertices, std::vector<uint32_t>& indices, size_t indexStart, size_t indexCount, std::vector<Meshlet>& meshlets);
+
+		// D3D clip space, from view * projection.
+		Frustum ExtractFrustum(const float viewProjection[16]);
+
+		// Appends the index ranges of the visible meshlets. The frustum is in world space,
+		// the camera position in model space. Returns the number of triangles kept.
+		size_t Cull(const Meshlet* meshlets, size_t count, const float world[16], const Frustum& frustum, const float modelCameraPosition[3],
+			std::vector<DrawRange>& ranges, CullStats* stats = nullptr);
+	}
+}
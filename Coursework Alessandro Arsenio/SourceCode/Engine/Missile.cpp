@@ -1,24 +1,9 @@
 #include "pch.h"
 #include "Missile.h"
+#include "Simulation.h"
 
-#define MAXLIFETIME 5
-#define SPEED 50
-
-void Missile::Update()
+Missile::Missile()
 {
-    //take delta time from timer
-    float deltaTime = m_timer.GetElapsedSeconds();
-
-    //increment life time of missile
-    lifeTime += deltaTime;
-    //if the missile didn't hit anything after MAXLIFETIME seconds, delete it
-    if (lifeTime > MAXLIFETIME)
-    {
-        toDelete = true;
-    }
-    
-    //move missile
-    m_localPosition += (m_forward * SPEED) * deltaTime;
-
-    GameObject::Update();
-}
\ No newline at end of file
+    //moves along its forward and, if it didn't hit anything after its lifetime, is deleted
+    DX::AddMissileComponents(s_entities, m_entity);
+}
@@ -6,10 +6,7 @@ class Missile : public GameObject
 {
 public:
 
-	void Update();
-
-public:
-
-	float lifeTime = 0;
+	//flies forward until it hits something or its life time ends, moved by the entity systems
+	Missile();
 };
 
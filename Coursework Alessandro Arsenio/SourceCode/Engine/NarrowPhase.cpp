@@ -0,0 +1,344 @@
+#include "pch.h"
+#include "NarrowPhase.h"
+
+#include <immintrin.h>
+#include <algorithm>
+
+using namespace DX;
+using namespace DX::NarrowPhase;
+
+namespace
+{
+	//the same tests are written once over Lanes, four floats with SSE2 or eight with AVX
+#if defined(__AVX__)
+	typedef __m256 Lanes;
+	const size_t LaneCount = 8;
+	const char* const InstructionSet = "AVX";
+
+	inline Lanes Load(const float* p)				{ return _mm256_loadu_ps(p); }
+	inline Lanes Splat(float value)					{ return _mm256_set1_ps(value); }
+	inline Lanes Add(Lanes a, Lanes b)				{ return _mm256_add_ps(a, b); }
+	inline Lanes Sub(Lanes a, Lanes b)				{ return _mm256_sub_ps(a, b); }
+	inline Lanes Mul(Lanes a, Lanes b)				{ return _mm256_mul_ps(a, b); }
+	inline Lanes And(Lanes a, Lanes b)				{ return _mm256_and_ps(a, b); }
+	inline Lanes AndNot(Lanes mask, Lanes b)		{ return _mm256_andnot_ps(mask, b); }
+	inline Lanes Or(Lanes a, Lanes b)				{ return _mm256_or_ps(a, b); }
+	inline Lanes Less(Lanes a, Lanes b)				{ return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	inline Lanes Greater(Lanes a, Lanes b)			{ return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	inline Lanes LessOrEqual(Lanes a, Lanes b)		{ return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	inline uint32_t MoveMask(Lanes a)				{ return (uint32_t)_mm256_movemask_ps(a); }
+#else
+	typedef __m128 Lanes;
+	const size_t LaneCount = 4;
+	const char* const InstructionSet = "SSE2";
+
+	inline Lanes Load(const float* p)				{ return _mm_loadu_ps(p); }
+	inline Lanes Splat(float value)					{ return _mm_set1_ps(value); }
+	inline Lanes Add(Lanes a, Lanes b)				{ return _mm_add_ps(a, b); }
+	inline Lanes Sub(Lanes a, Lanes b)				{ return _mm_sub_ps(a, b); }
+	inline Lanes Mul(Lanes a, Lanes b)				{ return _mm_mul_ps(a, b); }
+	inline Lanes And(Lanes a, Lanes b)				{ return _mm_and_ps(a, b); }
+	inline Lanes AndNot(Lanes mask, Lanes b)		{ return _mm_andnot_ps(mask, b); }
+	inline Lanes Or(Lanes a, Lanes b)				{ return _mm_or_ps(a, b); }
+	inline Lanes Less(Lanes a, Lanes b)				{ return _mm_cmplt_ps(a, b); }
+	inline Lanes Greater(Lanes a, Lanes b)			{ return _mm_cmpgt_ps(a, b); }
+	inline Lanes LessOrEqual(Lanes a, Lanes b)		{ return _mm_cmple_ps(a, b); }
+	inline uint32_t MoveMask(Lanes a)				{ return (uint32_t)_mm_movemask_ps(a); }
+#endif
+
+	struct SphereLanes
+	{
+		Lanes x, y, z, radius;
+	};
+
+	struct BoxLanes
+	{
+		Lanes x, y, z;
+		Lanes extentX, extentY, extentZ;
+		Lanes orientationX, orientationY, orientationZ, orientationW;
+	};
+
+	// XMVector3LengthSq without SSE4: (x * x + y * y) + z * z.
+	inline Lanes LengthSquared(Lanes x, Lanes y, Lanes z)
+	{
+		return Add(Add(Mul(x, x), Mul(y, y)), Mul(z, z));
+	}
+
+	// BoundingSphere::Intersects(BoundingSphere): |b - a|^2 <= (ra + rb)^2.
+	inline Lanes TestSpheres(const SphereLanes& a, const SphereLanes& b)
+	{
+		Lanes radius = Add(a.radius, b.radius);
+		return LessOrEqual(LengthSquared(Sub(b.x, a.x), Sub(b.y, a.y), Sub(b.z, a.z)), Mul(radius, radius));
+	}
+
+	// XMQuaternionMultiply(q1, q2), which is q2 * q1, with the products summed in the order of its SSE code.
+	inline void QuaternionMultiply(const Lanes q1[4], const Lanes q2[4], Lanes result[4])
+	{
+		result[0] = Add(Add(Mul(q2[3], q1[0]), Mul(q2[0], q1[3])), Sub(Mul(q2[1], q1[2]), Mul(q2[2], q1[1])));
+		result[1] = Add(Sub(Mul(q2[3], q1[1]), Mul(q2[0], q1[2])), Add(Mul(q2[1], q1[3]), Mul(q2[2], q1[0])));
+		result[2] = Add(Add(Mul(q2[3], q1[2]), Mul(q2[0], q1[1])), Sub(Mul(q2[2], q1[3]), Mul(q2[1], q1[0])));
+		result[3] = Sub(Sub(Mul(q2[3], q1[3]), Mul(q2[0], q1[0])), Add(Mul(q2[1], q1[1]), Mul(q2[2], q1[2])));
+	}
+
+	// BoundingOrientedBox::Intersects(BoundingSphere): the sphere's center in box space, then its
+	// squared distance to the box against the squared radius.
+	inline Lanes TestSphereBox(const SphereLanes& sphere, const BoxLanes& box)
+	{
+		//XMVector3InverseRotate: conjugate(q) * v * q, v with w = 0
+		Lanes zero = Splat(0.0f);
+		Lanes v[4] = { Sub(sphere.x, box.x), Sub(sphere.y, box.y), Sub(sphere.z, box.z), zero };
+		Lanes q[4] = { box.orientationX, box.orientationY, box.orientationZ, box.orientationW };
+		Lanes conjugate[4] = { Sub(zero, q[0]), Sub(zero, q[1]), Sub(zero, q[2]), q[3] };
+		Lanes rotated[4], local[4];
+		QuaternionMultiply(q, v, rotated);
+		QuaternionMultiply(rotated, conjugate, local);
+
+		//distance to the nearest point of the box along each axis, 0 inside
+		Lanes extents[3] = { box.extentX, box.extentY, box.extentZ };
+		Lanes d[3];
+		for (int i = 0; i < 3; i++)
+		{
+			Lanes lessThanMin = Less(local[i], Sub(zero, extents[i]));
+			Lanes greaterThanMax = Greater(local[i], extents[i]);
+			Lanes minDelta = Add(local[i], extents[i]);
+			Lanes maxDelta = Sub(local[i], extents[i]);
+			d[i] = And(lessThanMin, minDelta);
+			d[i] = Or(AndNot(greaterThanMax, d[i]), And(greaterThanMax, maxDelta));
+		}
+		return LessOrEqual(LengthSquared(d[0], d[1], d[2]), Mul(sphere.radius, sphere.radius));
+	}
+
+	// Lanes past count repeat the last value, their results are masked off.
+	inline Lanes LoadPartial(const float* p, size_t count)
+	{
+		float padded[LaneCount];
+		for (size_t i = 0; i < LaneCount; i++)
+		{
+			padded[i] = p[i < count ? i : count - 1];
+		}
+		return Load(padded);
+	}
+
+	inline Lanes LoadLanes(const std::vector<float>& values, size_t start, size_t count)
+	{
+		return count == LaneCount ? Load(&values[start]) : LoadPartial(&values[start], count);
+	}
+
+	inline SphereLanes LoadSpheres(const SphereSet& spheres, size_t start, size_t count)
+	{
+		SphereLanes lanes = {
+			LoadLanes(spheres.x, start, count), LoadLanes(spheres.y, start, count), LoadLanes(spheres.z, start, count),
+			LoadLanes(spheres.radius, start, count) };
+		return lanes;
+	}
+
+	inline BoxLanes LoadBoxes(const BoxSet& boxes, size_t start, size_t count)
+	{
+		BoxLanes lanes = {
+			LoadLanes(boxes.x, start, count), LoadLanes(boxes.y, start, count), LoadLanes(boxes.z, start, count),
+			LoadLanes(boxes.extentX, start, count), LoadLanes(boxes.extentY, start, count), LoadLanes(boxes.extentZ, start, count),
+			LoadLanes(boxes.orientationX, start, count), LoadLanes(boxes.orientationY, start, count),
+			LoadLanes(boxes.orientationZ, start, count), LoadLanes(boxes.orientationW, start, count) };
+		return lanes;
+	}
+
+	inline SphereLanes SplatSphere(const Float3& center, float radius)
+	{
+		SphereLanes lanes = { Splat(center.x), Splat(center.y), Splat(center.z), Splat(radius) };
+		return lanes;
+	}
+
+	// Gathers the colliders a run of candidates names into lanes.
+	inline SphereLanes GatherSpheres(const SphereSet& spheres, const BroadPhasePair* pairs, size_t count, bool first)
+	{
+		float x[LaneCount], y[LaneCount], z[LaneCount], radius[LaneCount];
+		for (size_t i = 0; i < LaneCount; i++)
+		{
+			const BroadPhasePair& pair = pairs[i < count ? i : count - 1];
+			uint32_t index = first ? pair.a : pair.b;
+			x[i] = spheres.x[index];
+			y[i] = spheres.y[index];
+			z[i] = spheres.z[index];
+			radius[i] = spheres.radius[index];
+		}
+		SphereLanes lanes = { Load(x), Load(y), Load(z), Load(radius) };
+		return lanes;
+	}
+
+	inline BoxLanes GatherBoxes(const BoxSet& boxes, const BroadPhasePair* pairs, size_t count)
+	{
+		float values[10][LaneCount];
+		for (size_t i = 0; i < LaneCount; i++)
+		{
+			uint32_t index = pairs[i < count ? i : count - 1].b;
+			values[0][i] = boxes.x[index];
+			values[1][i] = boxes.y[index];
+			values[2][i] = boxes.z[index];
+			values[3][i] = boxes.extentX[index];
+			values[4][i] = boxes.extentY[index];
+			values[5][i] = boxes.extentZ[index];
+			values[6][i] = boxes.orientationX[index];
+			values[7][i] = boxes.orientationY[index];
+			values[8][i] = boxes.orientationZ[index];
+			values[9][i] = boxes.orientationW[index];
+		}
+		BoxLanes lanes = {
+			Load(values[0]), Load(values[1]), Load(values[2]), Load(values[3]), Load(values[4]),
+			Load(values[5]), Load(values[6]), Load(values[7]), Load(values[8]), Load(values[9]) };
+		return lanes;
+	}
+
+	inline void AppendHits(uint32_t mask, size_t count, uint32_t start, std::vector<uint32_t>& hits)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (mask & (1u << i))
+			{
+				hits.push_back(start + (uint32_t)i);
+			}
+		}
+	}
+
+	inline void AppendPairs(uint32_t mask, size_t count, const BroadPhasePair* pairs, std::vector<BroadPhasePair>& hits)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (mask & (1u << i))
+			{
+				hits.push_back(pairs[i]);
+			}
+		}
+	}
+}
+
+void SphereSet::Clear()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	radius.clear();
+}
+
+void SphereSet::Reserve(size_t count)
+{
+	x.reserve(count);
+	y.reserve(count);
+	z.reserve(count);
+	radius.reserve(count);
+}
+
+uint32_t SphereSet::Add(const Float3& center, float sphereRadius)
+{
+	x.push_back(center.x);
+	y.push_back(center.y);
+	z.push_back(center.z);
+	radius.push_back(sphereRadius);
+	return (uint32_t)(radius.size() - 1);
+}
+
+void BoxSet::Clear()
+{
+	for (std::vector<float>* values : { &x, &y, &z, &extentX, &extentY, &extentZ, &orientationX, &orientationY, &orientationZ, &orientationW })
+	{
+		values->clear();
+	}
+}
+
+void BoxSet::Reserve(size_t count)
+{
+	for (std::vector<float>* values : { &x, &y, &z, &extentX, &extentY, &extentZ, &orientationX, &orientationY, &orientationZ, &orientationW })
+	{
+		values->reserve(count);
+	}
+}
+
+uint32_t BoxSet::Add(const Float3& center, const Float3& extents, const float orientation[4])
+{
+	x.push_back(center.x);
+	y.push_back(center.y);
+	z.push_back(center.z);
+	extentX.push_back(extents.x);
+	extentY.push_back(extents.y);
+	extentZ.push_back(extents.z);
+	orientationX.push_back(orientation[0]);
+	orientationY.push_back(orientation[1]);
+	orientationZ.push_back(orientation[2]);
+	orientationW.push_back(orientation[3]);
+	return (uint32_t)(extentX.size() - 1);
+}
+
+const char* NarrowPhase::GetInstructionSet()
+{
+	return InstructionSet;
+}
+
+void NarrowPhase::SphereVsSpheres(const Float3& center, float radius, const SphereSet& spheres, std::vector<uint32_t>& hits)
+{
+	//the single sphere is a, as in BoundingSphere(center, radius).Intersects(spheres[i])
+	SphereLanes a = SplatSphere(center, radius);
+	size_t size = spheres.Size();
+	for (size_t start = 0; start < size; start += LaneCount)
+	{
+		size_t count = std::min(LaneCount, size - start);
+		uint32_t mask = MoveMask(TestSpheres(a, LoadSpheres(spheres, start, count)));
+		AppendHits(mask, count, (uint32_t)start, hits);
+	}
+}
+
+void NarrowPhase::SphereVsBoxes(const Float3& center, float radius, const BoxSet& boxes, std::vector<uint32_t>& hits)
+{
+	SphereLanes sphere = SplatSphere(center, radius);
+	size_t size = boxes.Size();
+	for (size_t start = 0; start < size; start += LaneCount)
+	{
+		size_t count = std::min(LaneCount, size - start);
+		uint32_t mask = MoveMask(TestSphereBox(sphere, LoadBoxes(boxes, start, count)));
+		AppendHits(mask, count, (uint32_t)start, hits);
+	}
+}
+
+void NarrowPhase::SpheresVsSpheres(const SphereSet& a, const SphereSet& b, std::vector<BroadPhasePair>& hits)
+{
+	size_t size = b.Size();
+	for (size_t i = 0; i < a.Size(); i++)
+	{
+		SphereLanes sphere = SplatSphere(Float3{ a.x[i], a.y[i], a.z[i] }, a.radius[i]);
+		for (size_t start = 0; start < size; start += LaneCount)
+		{
+			size_t count = std::min(LaneCount, size - start);
+			uint32_t mask = MoveMask(TestSpheres(sphere, LoadSpheres(b, start, count)));
+			for (size_t lane = 0; lane < count; lane++)
+			{
+				if (mask & (1u << lane))
+				{
+					BroadPhasePair pair = { (uint32_t)i, (uint32_t)(start + lane) };
+					hits.push_back(pair);
+				}
+			}
+		}
+	}
+}
+
+void NarrowPhase::TestSpherePairs(const SphereSet& a, const SphereSet& b, const std::vector<BroadPhasePair>& candidates, std::vector<BroadPhasePair>& hits)
+{
+	size_t size = candidates.size();
+	for (size_t start = 0; start < size; start += LaneCount)
+	{
+		size_t count = std::min(LaneCount, size - start);
+		const BroadPhasePair* pairs = &candidates[start];
+		uint32_t mask = MoveMask(TestSpheres(GatherSpheres(a, pairs, count, true), GatherSpheres(b, pairs, count, false)));
+		AppendPairs(mask, count, pairs, hits);
+	}
+}
+
+void NarrowPhase::TestSphereBoxPairs(const SphereSet& spheres, const BoxSet& boxes, const std::vector<BroadPhasePair>& candidates, std::vector<BroadPhasePair>& hits)
+{
+	size_t size = candidates.size();
+	for (size_t start = 0; start < size; start += LaneCount)
+	{
+		size_t count = std::min(LaneCount, size - start);
+		const BroadPhasePair* pairs = &candidates[start];
+		uint32_t mask = MoveMask(TestSphereBox(GatherSpheres(spheres, pairs, count, true), GatherBoxes(boxes, pairs, count)));
+		AppendPairs(mask, count, pairs, hits);
+	}
+}
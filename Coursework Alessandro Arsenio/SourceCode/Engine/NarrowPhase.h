@@ -0,0 +1,65 @@
+//
+// NarrowPhase.h - Batched sphere and oriented box overlap tests
+//
+// Colliders are kept as structures of arrays, one array per coordinate, so four spheres (eight
+// when the build enables AVX) are tested with each instruction. Tests take either one collider
+// against a whole set or a list of candidate pairs from the broad phase, and append the hits.
+//
+// The arithmetic follows DirectXCollision's SSE code operation for operation: the same
+// differences, products and sums in the same order, without fused multiply-adds. A batch test
+// answers exactly what BoundingSphere::Intersects and BoundingOrientedBox::Intersects would,
+// including for colliders that only just touch.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "BroadPhase.h"
+#include "Entities.h"
+
+namespace DX
+{
+	namespace NarrowPhase
+	{
+		struct SphereSet
+		{
+			std::vector<float> x, y, z;
+			std::vector<float> radius;
+
+			void Clear();
+			void Reserve(size_t count);
+			uint32_t Add(const Float3& center, float sphereRadius);
+			size_t Size() const { return radius.size(); }
+		};
+
+		// Extents are half sizes along the box's axes, the orientation a unit quaternion, as in BoundingOrientedBox.
+		struct BoxSet
+		{
+			std::vector<float> x, y, z;
+			std::vector<float> extentX, extentY, extentZ;
+			std::vector<float> orientationX, orientationY, orientationZ, orientationW;
+
+			void Clear();
+			void Reserve(size_t count);
+			uint32_t Add(const Float3& center, const Float3& extents, const float orientation[4]);
+			size_t Size() const { return extentX.size(); }
+		};
+
+		// Instruction set the tests were built for, "SSE2" or "AVX".
+		const char* GetInstructionSet();
+
+		// Appends the index of every sphere or box the sphere touches.
+		void SphereVsSpheres(const Float3& center, float radius, const SphereSet& spheres, std::vector<uint32_t>& hits);
+		void SphereVsBoxes(const Float3& center, float radius, const BoxSet& boxes, std::vector<uint32_t>& hits);
+
+		// Every sphere of a against every sphere of b, appending (index in a, index in b). a and b may be the same set.
+		void SpheresVsSpheres(const SphereSet& a, const SphereSet& b, std::vector<BroadPhasePair>& hits);
+
+		// Appends the candidates that touch, in their order. A pair's a indexes the first set and b the second.
+		void TestSpherePairs(const SphereSet& a, const SphereSet& b, const std::vector<BroadPhasePair>& candidates, std::vector<BroadPhasePair>& hits);
+		void TestSphereBoxPairs(const SphereSet& spheres, const BoxSet& boxes, const std::vector<BroadPhasePair>& candidates, std::vector<BroadPhasePair>& hits);
+	}
+}
@@ -0,0 +1,165 @@
+//
+// ObjectPool.h - Preallocated storage for objects that are created and destroyed often
+//
+// Objects live in blocks of slots allocated up front. Acquire constructs an object in a free
+// slot and Release destroys it and returns the slot, both in constant time and without touching
+// the heap. When every slot is taken the pool either adds a block, if it may grow, or returns
+// nullptr. Blocks are never moved or freed while the pool lives, so object pointers stay valid.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace DX
+{
+	struct ObjectPoolStats
+	{
+		size_t capacity;
+		size_t live;
+		size_t highWater;			//most objects live at once
+		size_t acquires;
+		size_t releases;
+		size_t grows;				//blocks added after the first
+		size_t failedAcquires;		//full and not allowed to grow
+	};
+
+	template<typename T>
+	class ObjectPool
+	{
+	public:
+		explicit ObjectPool(size_t capacity = 0, bool canGrow = true) :
+			m_canGrow(canGrow)
+		{
+			m_stats = ObjectPoolStats();
+			if (capacity > 0)
+			{
+				AddBlock(capacity);
+			}
+		}
+
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		~ObjectPool()
+		{
+			ReleaseAll();
+		}
+
+		// Makes room for at least capacity objects in total, allocating now rather than on a later Acquire.
+		void Reserve(size_t capacity)
+		{
+			if (capacity > m_stats.capacity)
+			{
+				AddBlock(capacity - m_stats.capacity);
+			}
+		}
+
+		void SetCanGrow(bool canGrow)
+		{
+			m_canGrow = canGrow;
+		}
+
+		// Default constructs an object in a free slot, nullptr when the pool is full and cannot grow.
+		T* Acquire()
+		{
+			if (m_free.empty())
+			{
+				if (!m_canGrow)
+				{
+					m_stats.failedAcquires++;
+					return nullptr;
+				}
+				//double the capacity so a steady stream of acquires grows only a few times
+				AddBlock(std::max<size_t>(m_stats.capacity, 16));
+				m_stats.grows++;
+			}
+
+			Slot* slot = m_free.back();
+			m_free.pop_back();
+			T* object = new (&slot->storage) T();
+			slot->live = true;
+
+			m_stats.acquires++;
+			m_stats.live++;
+			m_stats.highWater = std::max(m_stats.highWater, m_stats.live);
+			return object;
+		}
+
+		// Destroys an object returned by Acquire. Releasing it twice does nothing.
+		void Release(T* object)
+		{
+			if (object == nullptr)
+			{
+				return;
+			}
+			Slot* slot = reinterpret_cast<Slot*>(object);
+			if (!slot->live)
+			{
+				return;
+			}
+			object->~T();
+			slot->live = false;
+			m_free.push_back(slot);
+
+			m_stats.releases++;
+			m_stats.live--;
+		}
+
+		// Destroys every live object, keeping the storage.
+		void ReleaseAll()
+		{
+			for (size_t block = 0; block < m_blocks.size(); block++)
+			{
+				for (size_t i = 0; i < m_blockSizes[block]; i++)
+				{
+					Slot& slot = m_blocks[block][i];
+					if (slot.live)
+					{
+						Release(reinterpret_cast<T*>(&slot.storage));
+					}
+				}
+			}
+		}
+
+		ObjectPoolStats GetStats() const
+		{
+			return m_stats;
+		}
+
+	private:
+		// The storage comes first so an object's address is its slot's.
+		struct Slot
+		{
+			typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+			bool live;
+		};
+
+		void AddBlock(size_t count)
+		{
+			std::unique_ptr<Slot[]> block(new Slot[count]);
+			//free slots are handed out from the back, lowest address first
+			m_free.reserve(m_stats.capacity + count);
+			for (size_t i = count; i-- > 0;)
+			{
+				block[i].live = false;
+				m_free.push_back(&block[i]);
+			}
+			m_blocks.push_back(std::move(block));
+			m_blockSizes.push_back(count);
+			m_stats.capacity += count;
+		}
+
+		std::vector<std::unique_ptr<Slot[]>>	m_blocks;
+		std::vector<size_t>						m_blockSizes;
+		std::vector<Slot*>						m_free;			//reserved to the capacity, so Release never allocates
+		bool									m_canGrow;
+		ObjectPoolStats							m_stats;
+	};
+}
@@ -0,0 +1,80 @@
+#include "pch.h"
+#include "ParallelRecording.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace DX;
+
+void DX::PartitionDraws(const float* costs, size_t count, size_t batchCount, size_t minDraws, std::vector<DrawBatch>& batches)
+{
+	batches.clear();
+	if (count == 0)
+	{
+		return;
+	}
+	minDraws = std::max<size_t>(minDraws, 1);
+	size_t total = std::max<size_t>(std::min(batchCount, count / minDraws), 1);
+	double totalCost = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		totalCost += costs ? costs[i] : 1.0f;
+	}
+
+	//each batch ends at the draw nearest its share of the cost, keeping room for minDraws in every batch after it
+	size_t begin = 0;
+	double done = 0;
+	for (size_t batch = 0; batch < total; batch++)
+	{
+		size_t end = count;
+		if (batch + 1 < total)
+		{
+			double target = totalCost * double(batch + 1) / double(total);
+			size_t earliest = begin + minDraws;
+			size_t latest = count - (total - batch - 1) * minDraws;
+			end = begin;
+			while (end < latest)
+			{
+				double cost = costs ? costs[end] : 1.0f;
+				if (end >= earliest && done + cost * 0.5 > target)
+				{
+					break;
+				}
+				done += cost;
+				end++;
+			}
+		}
+		DrawBatch draws = { begin, end };
+		batches.push_back(draws);
+		begin = end;
+	}
+}
+
+RecordingStats DX::RecordInParallel(JobSystem& jobs, RecordingBackend& backend, const float* costs, size_t count, size_t minDraws)
+{
+	std::vector<DrawBatch> batches;
+	PartitionDraws(costs, count, backend.GetContextCount(), minDraws, batches);
+
+	//there are no more batches than contexts, so batch i records on context i
+	auto start = std::chrono::high_resolution_clock::now();
+	jobs.ParallelFor(0, batches.size(), 1, [&backend, &batches](size_t begin, size_t end)
+	{
+		for (size_t batch = begin; batch < end; batch++)
+		{
+			backend.RecordBatch((unsigned int)batch, batch, batches[batch]);
+		}
+	});
+	auto recorded = std::chrono::high_resolution_clock::now();
+	for (size_t batch = 0; batch < batches.size(); batch++)
+	{
+		backend.ExecuteBatch(batch);
+	}
+
+	RecordingStats stats;
+	stats.draws = count;
+	stats.batches = batches.size();
+	stats.recordTime = std::chrono::duration<double, std::milli>(recorded - start).count();
+	stats.executeTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recorded).count();
+	return stats;
+}
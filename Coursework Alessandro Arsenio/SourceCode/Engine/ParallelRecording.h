@@ -0,0 +1,59 @@
+//
+// ParallelRecording.h - Records a draw list on several workers and submits it in order
+//
+// The draw list is split into contiguous batches of about equal cost, one per recording
+// context, and each batch is recorded by a job of its own. Once every batch is recorded they
+// are executed one after another in list order, so the frame draws exactly what recording the
+// list front to back on one context would have drawn.
+//
+// What a context is stays behind RecordingBackend: Direct3D deferred contexts and command lists
+// in the game, a mock in the tests, so the splitting and ordering run headless.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+namespace DX
+{
+	class JobSystem;
+
+	// Draws [begin, end) of the list.
+	struct DrawBatch
+	{
+		size_t begin;
+		size_t end;
+	};
+
+	class RecordingBackend
+	{
+	public:
+		virtual ~RecordingBackend() {}
+
+		// Contexts that can record at the same time, at least one.
+		virtual unsigned int GetContextCount() const = 0;
+
+		// Records the draws into the context and keeps what it recorded as the batch's. Called from a
+		// worker; a context is only ever used by one batch a frame.
+		virtual void RecordBatch(unsigned int context, size_t batch, const DrawBatch& draws) = 0;
+
+		// Submits a recorded batch. Called on the thread that called RecordInParallel, in batch order.
+		virtual void ExecuteBatch(size_t batch) = 0;
+	};
+
+	struct RecordingStats
+	{
+		size_t draws;
+		size_t batches;
+		double recordTime;			//milliseconds until every batch was recorded
+		double executeTime;
+	};
+
+	// Splits count draws into at most batchCount batches, none under minDraws unless there are fewer draws than that,
+	// with about the same total cost each. Without costs every draw costs the same.
+	void PartitionDraws(const float* costs, size_t count, size_t batchCount, size_t minDraws, std::vector<DrawBatch>& batches);
+
+	// Records the draws on the backend's contexts in parallel, then executes them in order.
+	RecordingStats RecordInParallel(JobSystem& jobs, RecordingBackend& backend, const float* costs, size_t count, size_t minDraws);
+}
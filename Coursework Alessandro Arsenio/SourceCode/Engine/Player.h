@@ -6,6 +6,6 @@ class Player : public GameObject
 {
 public:
 
-	void Update();
+	void Update(const DX::FrameContext& frame);
 };
 
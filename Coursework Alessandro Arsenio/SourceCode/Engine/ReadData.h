@@ -6,6 +6,10 @@
 // For Windows desktop apps, it looks for files in the same folder as the running EXE if
 // it can't find them in the CWD
 //
+// If an asset pack is mounted, the file is served from the pack first
+//
+// MapData returns the same bytes as a DX::FileView, mapping large files instead of copying them
+//
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 //-------------------------------------------------------------------------------------
@@ -17,30 +21,46 @@
 #include <fstream>
 #include <vector>
 
+#include "AssetPack.h"
+#include "FileView.h"
 
 namespace DX
 {
+#if !defined(WINAPI_FAMILY) || (WINAPI_FAMILY == WINAPI_FAMILY_DESKTOP_APP)
+    inline void GetModuleRelativePath(_In_z_ const wchar_t* name, wchar_t (&filename)[_MAX_PATH])
+    {
+        wchar_t moduleName[_MAX_PATH];
+        if (!GetModuleFileNameW(nullptr, moduleName, _MAX_PATH))
+            throw std::exception("GetModuleFileName");
+
+        wchar_t drive[_MAX_DRIVE];
+        wchar_t path[_MAX_PATH];
+
+        if (_wsplitpath_s(moduleName, drive, _MAX_DRIVE, path, _MAX_PATH, nullptr, 0, nullptr, 0))
+            throw std::exception("_wsplitpath_s");
+
+        if (_wmakepath_s(filename, _MAX_PATH, drive, path, name, nullptr))
+            throw std::exception("_wmakepath_s");
+    }
+#endif
+
     inline std::vector<uint8_t> ReadData(_In_z_ const wchar_t* name)
     {
+        AssetPack* pack = AssetPack::GetMounted();
+        if (pack)
+        {
+            std::vector<uint8_t> packed;
+            if (pack->ReadEntry(name, packed))
+                return packed;
+        }
+
         std::ifstream inFile(name, std::ios::in | std::ios::binary | std::ios::ate);
 
 #if !defined(WINAPI_FAMILY) || (WINAPI_FAMILY == WINAPI_FAMILY_DESKTOP_APP)
         if (!inFile)
         {
-            wchar_t moduleName[_MAX_PATH];
-            if (!GetModuleFileNameW(nullptr, moduleName, _MAX_PATH))
-                throw std::exception("GetModuleFileName");
-
-            wchar_t drive[_MAX_DRIVE];
-            wchar_t path[_MAX_PATH];
-
-            if (_wsplitpath_s(moduleName, drive, _MAX_DRIVE, path, _MAX_PATH, nullptr, 0, nullptr, 0))
-                throw std::exception("_wsplitpath_s");
-
             wchar_t filename[_MAX_PATH];
-            if (_wmakepath_s(filename, _MAX_PATH, drive, path, name, nullptr))
-                throw std::exception("_wmakepath_s");
-
+            GetModuleRelativePath(name, filename);
             inFile.open(filename, std::ios::in | std::ios::binary | std::ios::ate);
         }
 #endif
@@ -67,4 +87,41 @@ namespace DX
 
         return blob;
     }
-}
\ No newline at end of file
+
+    inline FileView MapData(_In_z_ const wchar_t* name)
+    {
+        FileView view;
+
+        AssetPack* pack = AssetPack::GetMounted();
+        if (pack)
+        {
+            //stored entries are viewed in place, compressed ones are decompressed into the view
+            const uint8_t* data;
+            size_t size;
+            if (pack->GetMappedData(name, &data, &size))
+            {
+                view.Attach(data, size);
+                return view;
+            }
+
+            std::vector<uint8_t> packed;
+            if (pack->ReadEntry(name, packed))
+            {
+                view.Adopt(std::move(packed));
+                return view;
+            }
+        }
+
+        if (view.Open(name))
+            return view;
+
+#if !defined(WINAPI_FAMILY) || (WINAPI_FAMILY == WINAPI_FAMILY_DESKTOP_APP)
+        wchar_t filename[_MAX_PATH];
+        GetModuleRelativePath(name, filename);
+        if (view.Open(filename))
+            return view;
+#endif
+
+        throw std::exception("MapData");
+    }
+}
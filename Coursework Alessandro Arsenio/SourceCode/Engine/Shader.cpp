@@ -11,7 +11,7 @@ Shader::~Shader()
 {
 }
 
-bool Shader::InitStandard(ID3D11Device * device, WCHAR * vsFilename, WCHAR * psFilename)
+bool Shader::InitStandard(ID3D11Device * device, const WCHAR * vsFilename, const WCHAR * psFilename)
 {
 	D3D11_BUFFER_DESC	matrixBufferDesc;
 	D3D11_SAMPLER_DESC	samplerDesc;
@@ -19,7 +19,7 @@ bool Shader::InitStandard(ID3D11Device * device, WCHAR * vsFilename, WCHAR * psF
 	D3D11_BUFFER_DESC	cameraBufferDesc;
 
 	//LOAD SHADER:	VERTEX
-	auto vertexShaderBuffer = DX::ReadData(vsFilename);
+	auto vertexShaderBuffer = DX::MapData(vsFilename);
 	HRESULT result = device->CreateVertexShader(vertexShaderBuffer.data(), vertexShaderBuffer.size(), NULL, &m_vertexShader);
 	if (result != S_OK)
 	{
@@ -27,24 +27,34 @@ bool Shader::InitStandard(ID3D11Device * device, WCHAR * vsFilename, WCHAR * psF
 		return false;
 	}
 
-	// Create the vertex input layout description.
-	// This setup needs to match the VertexType stucture in the MeshClass and in the shader.
-	D3D11_INPUT_ELEMENT_DESC polygonLayout[] = {
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	// Create the vertex input layout descriptions, one per DX::VertexFormat.
+	// These need to match the encoders in VertexFormat.cpp and the input of the shader;
+	// the packed formats are expanded back to floats by the input assembler.
+	static const DXGI_FORMAT layoutFormats[DX::VertexFormatCount][3] = {
+		{ DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT },			//full
+		{ DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R16G16_FLOAT, DXGI_FORMAT_R8G8B8A8_SNORM },		//half
+		{ DXGI_FORMAT_R16G16B16A16_SNORM, DXGI_FORMAT_R16G16_FLOAT, DXGI_FORMAT_R8G8B8A8_SNORM },		//quantized
 	};
 
-	// Get a count of the elements in the layout.
-	unsigned int numElements;
-	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
-
-	// Create the vertex input layout.
-	device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer.data(), vertexShaderBuffer.size(), &m_layout);
+	for (int format = 0; format < DX::VertexFormatCount; format++)
+	{
+		D3D11_INPUT_ELEMENT_DESC polygonLayout[] = {
+			{ "POSITION", 0, layoutFormats[format][0], 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "TEXCOORD", 0, layoutFormats[format][1], 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+			{ "NORMAL", 0, layoutFormats[format][2], 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+		};
+
+		// Get a count of the elements in the layout.
+		unsigned int numElements;
+		numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
+
+		// Create the vertex input layout.
+		device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer.data(), vertexShaderBuffer.size(), m_layouts[format].ReleaseAndGetAddressOf());
+	}
 	
 
 	//LOAD SHADER:	PIXEL
-	auto pixelShaderBuffer = DX::ReadData(psFilename);	
+	auto pixelShaderBuffer = DX::MapData(psFilename);	
 	result = device->CreatePixelShader(pixelShaderBuffer.data(), pixelShaderBuffer.size(), NULL, &m_pixelShader);
 	if (result != S_OK)
 	{
@@ -227,9 +237,9 @@ bool Shader::SetReflectionShaderParameters(ID3D11DeviceContext* context, DirectX
 	return false;
 }
 
-void Shader::EnableShader(ID3D11DeviceContext * context)
+void Shader::EnableShader(ID3D11DeviceContext * context, DX::VertexFormat format)
 {
-	context->IASetInputLayout(m_layout);							//set the input layout for the shader to match out geometry
+	context->IASetInputLayout(m_layouts[format].Get());							//set the input layout for the shader to match out geometry
 	context->VSSetShader(m_vertexShader.Get(), 0, 0);				//turn on vertex shader
 	context->PSSetShader(m_pixelShader.Get(), 0, 0);				//turn on pixel shader
 	// Set the sampler state in the pixel shader.
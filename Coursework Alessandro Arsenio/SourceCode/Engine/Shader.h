@@ -2,6 +2,7 @@
 
 #include "DeviceResources.h"
 #include "Light.h"
+#include "VertexFormat.h"
 
 //Class from which we create all shader objects used by the framework
 //This single class can be expanded to accomodate shaders of all different types with different parameters
@@ -13,11 +14,11 @@ public:
 
 	//we could extend this to load in only a vertex shader, only a pixel shader etc.  or specialised init for Geometry or domain shader. 
 	//All the methods here simply create new versions corresponding to your needs
-	bool InitStandard(ID3D11Device * device, WCHAR * vsFilename, WCHAR * psFilename);		//Loads the Vert / pixel Shader pair
+	bool InitStandard(ID3D11Device * device, const WCHAR * vsFilename, const WCHAR * psFilename);		//Loads the Vert / pixel Shader pair
 	bool SetShaderParameters(ID3D11DeviceContext * context, DirectX::SimpleMath::Matrix  *world, DirectX::SimpleMath::Matrix  *view, DirectX::SimpleMath::Matrix  *projection, Light *sceneLight1, ID3D11ShaderResourceView* texture1);
 	bool SetMultiTextureShaderParameters(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix* world, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight1, ID3D11ShaderResourceView* texture1, ID3D11ShaderResourceView* texture2, ID3D11ShaderResourceView* texture3, float time);
 	bool SetReflectionShaderParameters(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix* world, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight1, ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* EnviromentTexture, DirectX::SimpleMath::Vector3* position);
-	void EnableShader(ID3D11DeviceContext * context);
+	void EnableShader(ID3D11DeviceContext * context, DX::VertexFormat format = DX::VertexFormatFull);
 
 private:
 	//standard matrix buffer supplied to all shaders
@@ -47,7 +48,7 @@ private:
 	//Shaders
 	Microsoft::WRL::ComPtr<ID3D11VertexShader>								m_vertexShader;
 	Microsoft::WRL::ComPtr<ID3D11PixelShader>								m_pixelShader;
-	ID3D11InputLayout*														m_layout;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout>								m_layouts[DX::VertexFormatCount];	//one per vertex buffer format
 	ID3D11Buffer*															m_matrixBuffer;
 	ID3D11SamplerState*														m_sampleState;
 	ID3D11Buffer*															m_lightBuffer;
@@ -0,0 +1,353 @@
+#include "pch.h"
+#include "Simulation.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DX;
+
+namespace
+{
+	//candidates per job when sweeping missiles, and the mover of a sweep that hit nothing
+	const size_t SweepGrain = 64;
+	const uint32_t MissedSweep = 0xffffffffu;
+
+	//FNV-1a, over values one at a time so struct padding never reaches it
+	const uint64_t HashBasis = 14695981039346656037ull;
+	const uint64_t HashPrime = 1099511628211ull;
+
+	void HashBytes(uint64_t& hash, const void* bytes, size_t size)
+	{
+		const uint8_t* data = static_cast<const uint8_t*>(bytes);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ data[i]) * HashPrime;
+		}
+	}
+
+	template<typename T>
+	void HashValue(uint64_t& hash, const T& value)
+	{
+		HashBytes(hash, &value, sizeof(value));
+	}
+
+	void HashFloat3(uint64_t& hash, const Float3& value)
+	{
+		HashValue(hash, value.x);
+		HashValue(hash, value.y);
+		HashValue(hash, value.z);
+	}
+
+	void AddScaled(Float3& position, const Float3& direction, float scale)
+	{
+		position.x += direction.x * scale;
+		position.y += direction.y * scale;
+		position.z += direction.z * scale;
+	}
+}
+
+void DX::MovePlayer(EntityStore& store, Entity player, const InputCommands& input, float deltaTime, float moveSpeed, float rotateSpeed)
+{
+	const Transform& transform = store.GetTransform(player);
+	Float3 position = transform.position;
+	Float3 rotation = transform.rotation;
+	const Float3 up = { 0.0f, 1.0f, 0.0f };
+	float step = moveSpeed * deltaTime;
+
+	if (input.m_yaw != 0)
+	{
+		rotation.y = rotation.y - input.m_yaw * rotateSpeed * deltaTime;
+	}
+	if (input.forward)
+	{
+		AddScaled(position, transform.forward, step);
+	}
+	if (input.right)
+	{
+		AddScaled(position, transform.right, step);
+	}
+	if (input.left)
+	{
+		AddScaled(position, transform.right, -step);
+	}
+	if (input.back)
+	{
+		AddScaled(position, transform.forward, -step);
+	}
+	if (input.up && transform.worldPosition.y < PlayerCeiling)
+	{
+		AddScaled(position, up, step);
+	}
+	if (input.down)
+	{
+		AddScaled(position, up, -step);
+	}
+
+	store.SetPosition(player, position);
+	store.SetRotation(player, rotation);
+}
+
+void DX::AddMissileComponents(EntityStore& store, Entity missile)
+{
+	store.AddComponents(missile, ComponentMotion | ComponentLifetime | TagMissile);
+	store.GetMotion(missile).speed = MissileSpeed;
+	store.GetLifetime(missile).maxAge = MissileLifetime;
+}
+
+void DX::LaunchMissile(EntityStore& store, Entity missile, Entity shooter)
+{
+	const Transform& from = store.GetTransform(shooter);
+	Float3 position = from.worldPosition;
+	AddScaled(position, from.forward, MissileLaunchDistance);
+	const Float3 scale = { 1.0f, 1.0f, 1.0f };
+	store.SetPosition(missile, position);
+	store.SetRotation(missile, from.rotation);
+	store.SetScale(missile, scale);
+
+	//placed now rather than at the next transform update, so its forward and collider are not where the pool last left them,
+	//and drawn from there rather than flying in from there
+	store.ResetInterpolation(missile);
+	UpdateTransform(store, missile);
+	store.AddComponents(missile, ComponentCollider);
+	Collider& collider = store.GetCollider(missile);
+	collider.center = collider.previousCenter = store.GetTransform(missile).worldPosition;
+	collider.radius = MissileRadius;
+}
+
+void DX::AddWatermineComponents(EntityStore& store, Entity watermine)
+{
+	store.AddComponents(watermine, ComponentMotion | TagWatermine);
+	Motion& motion = store.GetMotion(watermine);
+	motion.bobAmplitude = 2;
+	motion.bobRate = 80;
+	motion.spinRate = 40;
+}
+
+void DX::SetWatermineCenter(EntityStore& store, Entity watermine, float height)
+{
+	//the starting height is the phase too, so neighbouring watermines do not bob together
+	Motion& motion = store.GetMotion(watermine);
+	motion.bobCenter = height;
+	motion.bobPhase = height;
+}
+
+uint64_t DX::HashWorld(const EntityStore& store)
+{
+	uint64_t hash = HashBasis;
+	for (size_t index = 0; index < store.GetCount(); index++)
+	{
+		uint32_t components = store.components[index];
+		if (components == 0)
+		{
+			continue;
+		}
+		HashValue(hash, store.entities[index]);
+		HashValue(hash, components);
+		HashValue(hash, store.markedForDelete[index]);
+
+		const Transform& transform = store.transforms[index];
+		HashFloat3(hash, transform.position);
+		HashFloat3(hash, transform.rotation);
+		HashFloat3(hash, transform.scale);
+		HashFloat3(hash, transform.worldPosition);
+		HashValue(hash, transform.parent);
+		if (components & ComponentMotion)
+		{
+			HashValue(hash, store.motions[index].time);
+		}
+		if (components & ComponentCollider)
+		{
+			HashFloat3(hash, store.colliders[index].center);
+			HashValue(hash, store.colliders[index].radius);
+		}
+		if (components & ComponentLifetime)
+		{
+			HashValue(hash, store.lifetimes[index].age);
+		}
+	}
+	return hash;
+}
+
+StepInput::StepInput() :
+	m_latest(),
+	m_stepButton(false),
+	m_restart(false)
+{
+}
+
+void StepInput::Gather(const InputCommands& input)
+{
+	m_latest = input;
+	m_restart = m_restart || input.restart;
+
+	//only changes are queued. When full the newest state replaces the one before it, which was the
+	//opposite, so the queue still alternates and ends in the button's state now
+	bool last = m_buttonStates.empty() ? m_stepButton : m_buttonStates.back();
+	if (input.mouseButton != last)
+	{
+		if (m_buttonStates.size() < MaxButtonStates)
+		{
+			m_buttonStates.push_back(input.mouseButton);
+		}
+		else
+		{
+			m_buttonStates.pop_back();
+		}
+	}
+}
+
+InputCommands StepInput::Next()
+{
+	if (!m_buttonStates.empty())
+	{
+		m_stepButton = m_buttonStates.front();
+		m_buttonStates.erase(m_buttonStates.begin());
+	}
+	InputCommands input = m_latest;
+	input.mouseButton = m_stepButton;
+	input.restart = m_restart;
+	m_restart = m_latest.restart;
+	return input;
+}
+
+CollisionSystem::CollisionSystem() :
+	m_broadPhase(CollisionCellSize)
+{
+}
+
+void CollisionSystem::Insert(const Collider& collider, Entity entity, bool swept, uint32_t layer, uint32_t mask)
+{
+	//the collider's id is its index in the sphere set the narrow phase tests. A swept collider is
+	//filed under the sphere around its whole path since the last move
+	uint32_t id = m_spheres.Add(collider.center, collider.radius);
+	m_entities.push_back(entity);
+	if (!swept)
+	{
+		m_broadPhase.Insert(id, collider.center, collider.radius, layer, mask);
+		return;
+	}
+	const Float3& start = collider.previousCenter;
+	const Float3& end = collider.center;
+	Float3 middle = { (start.x + end.x) * 0.5f, (start.y + end.y) * 0.5f, (start.z + end.z) * 0.5f };
+	float dx = end.x - start.x, dy = end.y - start.y, dz = end.z - start.z;
+	m_broadPhase.Insert(id, middle, std::sqrt(dx * dx + dy * dy + dz * dz) * 0.5f + collider.radius, layer, mask);
+}
+
+CollisionResult CollisionSystem::Resolve(EntityStore& store, JobSystem& jobs, const HeightField& terrain, Entity player)
+{
+	CollisionResult result = {};
+
+	//watermines get the lowest ids, then missiles, then the player
+	m_broadPhase.Clear();
+	m_entities.clear();
+	m_spheres.Clear();
+	for (size_t index = 0; index < store.GetCount(); index++)
+	{
+		if ((store.components[index] & TagWatermine) && !store.markedForDelete[index])
+		{
+			Insert(store.colliders[index], store.entities[index], true, LayerWatermine, LayerMissile | LayerPlayer);
+		}
+	}
+	uint32_t firstMissile = (uint32_t)m_entities.size();
+	for (size_t index = 0; index < store.GetCount(); index++)
+	{
+		if ((store.components[index] & TagMissile) && !store.markedForDelete[index])
+		{
+			Insert(store.colliders[index], store.entities[index], true, LayerMissile, LayerWatermine);
+		}
+	}
+	uint32_t missileEnd = (uint32_t)m_entities.size();
+	uint32_t playerId = SweptCollision::Hit::NoTarget;
+	if (store.IsAlive(player) && !store.IsMarkedForDelete(player))
+	{
+		playerId = (uint32_t)m_entities.size();
+		Insert(store.GetCollider(player), player, false, LayerPlayer, LayerWatermine);
+	}
+	m_broadPhase.FindPairs(m_pairs);
+	result.candidates = m_pairs.size();
+
+	//missiles move far enough in a frame to pass through a watermine, so they are swept along their path since the
+	//last move, against the watermine's own path and against the terrain. The player is tested where it is.
+	m_playerPairs.clear();
+	m_missilePairs.clear();
+	for (const BroadPhasePair& pair : m_pairs)
+	{
+		//watermines never pair with each other, so the first of a pair is always the watermine
+		(pair.b == playerId ? m_playerPairs : m_missilePairs).push_back(pair);
+	}
+
+	//one slot per missile pair and per missile against the terrain, so the sweeps run in parallel and only read the colliders
+	size_t pairCount = m_missilePairs.size();
+	m_sweptHits.resize(pairCount + (missileEnd - firstMissile));
+	jobs.ParallelFor(0, m_sweptHits.size(), SweepGrain, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			SweptCollision::Hit& hit = m_sweptHits[i];
+			bool touching;
+			if (i < pairCount)
+			{
+				const BroadPhasePair& pair = m_missilePairs[i];
+				const Collider& watermine = store.GetCollider(m_entities[pair.a]);
+				const Collider& missile = store.GetCollider(m_entities[pair.b]);
+				hit.mover = pair.b;
+				hit.target = pair.a;
+				touching = SweptCollision::SweepSpheres(missile.previousCenter, missile.center, missile.radius, watermine.previousCenter, watermine.center, watermine.radius, hit.timeOfImpact);
+			}
+			else
+			{
+				hit.mover = firstMissile + uint32_t(i - pairCount);
+				hit.target = SweptCollision::Hit::NoTarget;
+				const Collider& missile = store.GetCollider(m_entities[hit.mover]);
+				touching = terrain.IntersectSegment(missile.previousCenter, missile.center, hit.timeOfImpact);
+			}
+			if (!touching)
+			{
+				hit.mover = MissedSweep;
+			}
+		}
+	});
+	m_sweptHits.erase(std::remove_if(m_sweptHits.begin(), m_sweptHits.end(), [](const SweptCollision::Hit& hit) { return hit.mover == MissedSweep; }), m_sweptHits.end());
+
+	//in the order they happened, so a missile stops at the first thing it reaches
+	SweptCollision::SortByTime(m_sweptHits);
+	for (const SweptCollision::Hit& hit : m_sweptHits)
+	{
+		Entity missile = m_entities[hit.mover];
+		if (store.IsMarkedForDelete(missile))
+		{
+			continue;
+		}
+		if (hit.target != SweptCollision::Hit::NoTarget)
+		{
+			//if a missile hit a watermine, set both to be deleted
+			Entity watermine = m_entities[hit.target];
+			if (store.IsMarkedForDelete(watermine))
+			{
+				continue;
+			}
+			store.MarkForDelete(watermine, true);
+			result.watermineHits++;
+		}
+		else
+		{
+			result.terrainHits++;
+		}
+		store.MarkForDelete(missile, true);
+	}
+
+	//test the player's candidates in one batch, the hits keep the order of the candidates
+	m_hits.clear();
+	NarrowPhase::TestSpherePairs(m_spheres, m_spheres, m_playerPairs, m_hits);
+	for (const BroadPhasePair& pair : m_hits)
+	{
+		if (!store.IsMarkedForDelete(m_entities[pair.a]))
+		{
+			store.MarkForDelete(player, true);
+			result.playerHit = true;
+			break;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,143 @@
+//
+// Simulation.h - The game's rules over the entity store, without platform or rendering types
+//
+// Moving the player from input, gathering input for the fixed steps, firing on release, setting
+// up missiles and watermines and the collision step that runs after the systems are written
+// against EntityStore and Float3 alone.
+// Game drives them from the window's input and puts GameObjects, pools and drawing on top; the
+// headless driver drives them from synthetic input, so both run the same update.
+//
+// Collisions find the candidates with the broad phase, sweep missiles along their path since
+// the last move against the watermines and the terrain in parallel, and test the player where
+// it is. What was hit is marked for deletion; releasing it is left to whoever created it.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Entities.h"
+#include "BroadPhase.h"
+#include "NarrowPhase.h"
+#include "SweptCollision.h"
+#include "InputCommands.h"
+
+namespace DX
+{
+	class JobSystem;
+
+	// A pair is tested when each side's mask has the other's layer.
+	enum CollisionLayer
+	{
+		LayerPlayer = 1,
+		LayerWatermine = 2,
+		LayerMissile = 4,
+	};
+
+	// A little wider than the player's collider, the largest.
+	const float CollisionCellSize = 8.0f;
+
+	// Missiles fly straight and are removed after MissileLifetime seconds if they hit nothing.
+	const float MissileSpeed = 50.0f;
+	const float MissileLifetime = 5.0f;
+	const float MissileRadius = 2.0f;
+	const float MissileLaunchDistance = 4.0f;	//in front of the shooter
+
+	const float WatermineRadius = 2.0f;
+	const float PlayerRadius = 3.0f;
+
+	// The player cannot rise above this height, it is a submarine.
+	const float PlayerCeiling = -1.0f;
+
+	// Turns by the input's yaw and moves along the player's forward, right and up vectors from the last
+	// transform update, speeds in units and degrees per second. Marks the player dirty.
+	void MovePlayer(EntityStore& store, Entity player, const InputCommands& input, float deltaTime, float moveSpeed, float rotateSpeed);
+
+	// Motion along forward and a lifetime, for an entity that has just been created or taken from a pool.
+	void AddMissileComponents(EntityStore& store, Entity missile);
+
+	// Places the missile in front of the shooter facing the same way, with its collider there too, so its
+	// first sweep starts where it was fired from, and is drawn from there too.
+	void LaunchMissile(EntityStore& store, Entity missile, Entity shooter);
+
+	// Bobbing and spinning motion; the bobbing is around the height SetWatermineCenter gives.
+	void AddWatermineComponents(EntityStore& store, Entity watermine);
+	void SetWatermineCenter(EntityStore& store, Entity watermine, float height);
+
+	// A hash of every live entity's handle, flags, transform, motion, collider and lifetime, in row order.
+	// Two runs of the same update on the same input give the same hash, to check a replay against a golden value.
+	uint64_t HashWorld(const EntityStore& store);
+
+	// Fires when the button is let go, once a click.
+	class FireTrigger
+	{
+	public:
+		FireTrigger() : m_pressed(false) {}
+
+		bool Update(bool pressed)
+		{
+			bool released = m_pressed && !pressed;
+			m_pressed = pressed;
+			return released;
+		}
+
+	private:
+		bool m_pressed;
+	};
+
+	// The input each fixed step reads, gathered from every frame since the last step. A fast frame can run
+	// no step at all, so the mouse button states the frames saw are queued and handed out one a step: a click
+	// begun and ended between two steps still reaches FireTrigger as a press and a release, a step later.
+	// Restart held on any of those frames is held for the next step.
+	class StepInput
+	{
+	public:
+		StepInput();
+
+		// Every frame, before the steps it runs.
+		void Gather(const InputCommands& input);
+
+		// Every step: the newest input, with the oldest button state no step has seen yet.
+		InputCommands Next();
+
+	private:
+		static const size_t			MaxButtonStates = 16;		//a stall that long drops clicks, a press and a release at a time
+
+		InputCommands				m_latest;
+		bool						m_stepButton;			//the button state the last step saw
+		std::vector<bool>			m_buttonStates;			//oldest first, each different from the one before
+		bool						m_restart;
+	};
+
+	struct CollisionResult
+	{
+		size_t candidates;			//pairs the broad phase found
+		size_t watermineHits;		//watermines a missile destroyed
+		size_t terrainHits;			//missiles that hit the terrain first
+		bool playerHit;
+	};
+
+	class CollisionSystem
+	{
+	public:
+		CollisionSystem();
+
+		// Tests the watermines and missiles in the store, and the player unless it is marked for deletion,
+		// after the systems have moved them. Everything hit is marked for deletion, the player included.
+		CollisionResult Resolve(EntityStore& store, JobSystem& jobs, const HeightField& terrain, Entity player);
+
+	private:
+		void Insert(const Collider& collider, Entity entity, bool swept, uint32_t layer, uint32_t mask);
+
+		SpatialHash							m_broadPhase;		//collision candidates, rebuilt every frame
+		std::vector<BroadPhasePair>			m_pairs;
+		std::vector<Entity>					m_entities;			//by broad phase id
+		NarrowPhase::SphereSet				m_spheres;			//by broad phase id
+		std::vector<BroadPhasePair>			m_hits;
+		std::vector<BroadPhasePair>			m_playerPairs;
+		std::vector<BroadPhasePair>			m_missilePairs;
+		std::vector<SweptCollision::Hit>	m_sweptHits;		//missiles against watermines and the terrain
+	};
+}
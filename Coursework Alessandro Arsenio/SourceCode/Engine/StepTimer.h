@@ -4,8 +4,8 @@
 
 #pragma once
 
+#include <chrono>
 #include <cmath>
-#include <exception>
 #include <stdint.h>
 
 namespace DX
@@ -21,22 +21,16 @@ namespace DX
             m_frameCount(0),
             m_framesPerSecond(0),
             m_framesThisSecond(0),
-            m_qpcSecondCounter(0),
+            m_clockSecondCounter(0),
             m_isFixedTimeStep(false),
-            m_targetElapsedTicks(TicksPerSecond / 60)
+            m_targetElapsedTicks(TicksPerSecond / 60),
+            m_maxCatchUpUpdates(0),
+            m_droppedUpdates(0)
         {
-            if (!QueryPerformanceFrequency(&m_qpcFrequency))
-            {
-                throw std::exception( "QueryPerformanceFrequency" );
-            }
-
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
-            {
-                throw std::exception( "QueryPerformanceCounter" );
-            }
+            m_clockLastTime = ReadClock();
 
             // Initialize max delta to 1/10 of a second.
-            m_qpcMaxDelta = static_cast<uint64_t>(m_qpcFrequency.QuadPart / 10);
+            m_clockMaxDelta = ClockFrequency / 10;
         }
 
         // Get elapsed time since the previous Update call.
@@ -60,6 +54,21 @@ namespace DX
         void SetTargetElapsedTicks(uint64_t targetElapsed)	{ m_targetElapsedTicks = targetElapsed; }
         void SetTargetElapsedSeconds(double targetElapsed)	{ m_targetElapsedTicks = SecondsToTicks(targetElapsed); }
 
+        // Set the most Updates one Tick runs in fixed timestep mode, 0 for no limit. When updating takes longer than
+        // the time it covers, every Tick would otherwise run more Updates than the last; the time past the limit is
+        // dropped instead, so the simulation runs slower than the clock rather than falling ever further behind.
+        void SetMaxCatchUpUpdates(uint32_t maxUpdates)		{ m_maxCatchUpUpdates = maxUpdates; }
+
+        // Get how many Updates have been dropped by the catch-up limit.
+        uint64_t GetDroppedUpdates() const					{ return m_droppedUpdates; }
+
+        // Get how far the clock is from the last Update towards the next, from 0 to 1, for drawing between the
+        // last two Updates. Always 1 in variable timestep mode, where the last Update is where the clock is.
+        double GetInterpolationAlpha() const
+        {
+            return m_isFixedTimeStep && m_targetElapsedTicks != 0 ? static_cast<double>(m_leftOverTicks) / m_targetElapsedTicks : 1.0;
+        }
+
         // Integer format represents time using 10,000,000 ticks per second.
         static const uint64_t TicksPerSecond = 10000000;
 
@@ -72,15 +81,12 @@ namespace DX
 
         void ResetElapsedTime()
         {
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
-            {
-                throw std::exception("QueryPerformanceCounter");
-            }
+            m_clockLastTime = ReadClock();
 
             m_leftOverTicks = 0;
             m_framesPerSecond = 0;
             m_framesThisSecond = 0;
-            m_qpcSecondCounter = 0;
+            m_clockSecondCounter = 0;
         }
 
         // Update timer state, calling the specified Update function the appropriate number of times.
@@ -88,27 +94,22 @@ namespace DX
         void Tick(const TUpdate& update)
         {
             // Query the current time.
-            LARGE_INTEGER currentTime;
-
-            if (!QueryPerformanceCounter(&currentTime))
-            {
-                throw std::exception( "QueryPerformanceCounter" );
-            }
+            uint64_t currentTime = ReadClock();
 
-            uint64_t timeDelta = static_cast<uint64_t>(currentTime.QuadPart - m_qpcLastTime.QuadPart);
+            uint64_t timeDelta = currentTime - m_clockLastTime;
 
-            m_qpcLastTime = currentTime;
-            m_qpcSecondCounter += timeDelta;
+            m_clockLastTime = currentTime;
+            m_clockSecondCounter += timeDelta;
 
             // Clamp excessively large time deltas (e.g. after paused in the debugger).
-            if (timeDelta > m_qpcMaxDelta)
+            if (timeDelta > m_clockMaxDelta)
             {
-                timeDelta = m_qpcMaxDelta;
+                timeDelta = m_clockMaxDelta;
             }
 
-            // Convert QPC units into a canonical tick format. This cannot overflow due to the previous clamp.
+            // Convert clock units into a canonical tick format. This cannot overflow due to the previous clamp.
             timeDelta *= TicksPerSecond;
-            timeDelta /= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+            timeDelta /= ClockFrequency;
 
             uint32_t lastFrameCount = m_frameCount;
 
@@ -130,12 +131,22 @@ namespace DX
 
                 m_leftOverTicks += timeDelta;
 
+                uint32_t updates = 0;
                 while (m_leftOverTicks >= m_targetElapsedTicks)
                 {
+                    // Past the catch-up limit, drop the whole steps still owed and keep the fraction.
+                    if (m_maxCatchUpUpdates != 0 && updates == m_maxCatchUpUpdates)
+                    {
+                        m_droppedUpdates += m_leftOverTicks / m_targetElapsedTicks;
+                        m_leftOverTicks %= m_targetElapsedTicks;
+                        break;
+                    }
+
                     m_elapsedTicks = m_targetElapsedTicks;
                     m_totalTicks += m_targetElapsedTicks;
                     m_leftOverTicks -= m_targetElapsedTicks;
                     m_frameCount++;
+                    updates++;
 
                     update();
                 }
@@ -157,19 +168,39 @@ namespace DX
                 m_framesThisSecond++;
             }
 
-            if (m_qpcSecondCounter >= static_cast<uint64_t>(m_qpcFrequency.QuadPart))
+            if (m_clockSecondCounter >= ClockFrequency)
             {
                 m_framesPerSecond = m_framesThisSecond;
                 m_framesThisSecond = 0;
-                m_qpcSecondCounter %= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+                m_clockSecondCounter %= ClockFrequency;
             }
         }
 
+        // Run one update covering elapsedTicks instead of the time the clock measured, for replaying
+        // recorded timesteps. Leaves the clock alone, so Tick carries on from the last time it read it.
+        template<typename TUpdate>
+        void Advance(uint64_t elapsedTicks, const TUpdate& update)
+        {
+            m_elapsedTicks = elapsedTicks;
+            m_totalTicks += elapsedTicks;
+            m_leftOverTicks = 0;
+            m_frameCount++;
+            m_framesThisSecond++;
+
+            update();
+        }
+
     private:
-        // Source timing data uses QPC units.
-        LARGE_INTEGER m_qpcFrequency;
-        LARGE_INTEGER m_qpcLastTime;
-        uint64_t m_qpcMaxDelta;
+        // Source timing data uses the steady clock's nanoseconds, read from QueryPerformanceCounter on Windows.
+        static const uint64_t ClockFrequency = 1000000000;
+
+        static uint64_t ReadClock()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        uint64_t m_clockLastTime;
+        uint64_t m_clockMaxDelta;
 
         // Derived timing data uses a canonical tick format.
         uint64_t m_elapsedTicks;
@@ -180,10 +211,12 @@ namespace DX
         uint32_t m_frameCount;
         uint32_t m_framesPerSecond;
         uint32_t m_framesThisSecond;
-        uint64_t m_qpcSecondCounter;
+        uint64_t m_clockSecondCounter;
 
         // Members for configuring fixed timestep mode.
         bool m_isFixedTimeStep;
         uint64_t m_targetElapsedTicks;
+        uint32_t m_maxCatchUpUpdates;
+        uint64_t m_droppedUpdates;
     };
 }
@@ -0,0 +1,218 @@
+#include "pch.h"
+#include "SweptCollision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace DX;
+using namespace DX::SweptCollision;
+
+namespace
+{
+	bool HitLess(const Hit& left, const Hit& right)
+	{
+		if (left.timeOfImpact != right.timeOfImpact)
+		{
+			return left.timeOfImpact < right.timeOfImpact;
+		}
+		return left.mover != right.mover ? left.mover < right.mover : left.target < right.target;
+	}
+
+	// Narrows [t0, t1] to where p + d * t stays inside [low, high].
+	bool ClipToRange(float p, float d, float low, float high, float& t0, float& t1)
+	{
+		if (d == 0)
+		{
+			return p >= low && p <= high;
+		}
+		float enter = (low - p) / d;
+		float exit = (high - p) / d;
+		if (enter > exit)
+		{
+			std::swap(enter, exit);
+		}
+		t0 = std::max(t0, enter);
+		t1 = std::min(t1, exit);
+		return t0 <= t1;
+	}
+}
+
+bool SweptCollision::SegmentVsSphere(const Float3& start, const Float3& end, const Float3& center, float radius, float& timeOfImpact)
+{
+	//|m + d * t| = radius, in doubles so the roots of short steps far from the origin keep their precision
+	double mx = start.x - center.x, my = start.y - center.y, mz = start.z - center.z;
+	double dx = end.x - start.x, dy = end.y - start.y, dz = end.z - start.z;
+	double c = mx * mx + my * my + mz * mz - double(radius) * radius;
+	if (c <= 0)
+	{
+		timeOfImpact = 0;
+		return true;
+	}
+	double b = mx * dx + my * dy + mz * dz;
+	if (b >= 0)
+	{
+		//still or moving away
+		return false;
+	}
+	double a = dx * dx + dy * dy + dz * dz;
+	double discriminant = b * b - a * c;
+	if (discriminant < 0)
+	{
+		return false;
+	}
+	double t = (-b - std::sqrt(discriminant)) / a;
+	if (t > 1)
+	{
+		return false;
+	}
+	timeOfImpact = float(t);
+	return true;
+}
+
+bool SweptCollision::SweepSpheres(const Float3& startA, const Float3& endA, float radiusA, const Float3& startB, const Float3& endB, float radiusB, float& timeOfImpact)
+{
+	Float3 start = { startA.x - startB.x, startA.y - startB.y, startA.z - startB.z };
+	Float3 end = { endA.x - endB.x, endA.y - endB.y, endA.z - endB.z };
+	Float3 origin = { 0, 0, 0 };
+	return SegmentVsSphere(start, end, origin, radiusA + radiusB, timeOfImpact);
+}
+
+void SweptCollision::SortByTime(std::vector<Hit>& hits)
+{
+	std::sort(hits.begin(), hits.end(), HitLess);
+}
+
+HeightField::HeightField() :
+	m_width(0),
+	m_depth(0),
+	m_spacing(1.0f),
+	m_inverseSpacing(1.0f)
+{
+	m_origin.x = m_origin.y = m_origin.z = 0;
+}
+
+void HeightField::Set(const float* heights, int width, int depth, float spacing, const Float3& origin)
+{
+	m_heights.assign(heights, heights + size_t(width) * depth);
+	m_width = width;
+	m_depth = depth;
+	m_spacing = spacing > 0 ? spacing : 1.0f;
+	m_inverseSpacing = 1.0f / m_spacing;
+	m_origin = origin;
+}
+
+void HeightField::Clear()
+{
+	m_heights.clear();
+	m_width = m_depth = 0;
+}
+
+bool HeightField::IsEmpty() const
+{
+	return m_width < 2 || m_depth < 2;
+}
+
+bool HeightField::GetHeight(float x, float z, float& height) const
+{
+	float gridX = (x - m_origin.x) * m_inverseSpacing;
+	float gridZ = (z - m_origin.z) * m_inverseSpacing;
+	if (IsEmpty() || gridX < 0 || gridZ < 0 || gridX > float(m_width - 1) || gridZ > float(m_depth - 1))
+	{
+		return false;
+	}
+	height = m_origin.y + Sample(gridX, gridZ);
+	return true;
+}
+
+float HeightField::Sample(float x, float z) const
+{
+	int i = std::min(std::max(int(std::floor(x)), 0), m_width - 2);
+	int j = std::min(std::max(int(std::floor(z)), 0), m_depth - 2);
+	float fx = x - float(i);
+	float fz = z - float(j);
+	const float* row = &m_heights[size_t(j) * m_width + i];
+	float h00 = row[0], h10 = row[1];
+	float h01 = row[m_width], h11 = row[m_width + 1];
+
+	//upper left triangle (0, 0) (0, 1) (1, 1), or lower right (0, 0) (1, 1) (1, 0)
+	if (fz >= fx)
+	{
+		return h00 + fz * (h01 - h00) + fx * (h11 - h01);
+	}
+	return h00 + fx * (h10 - h00) + fz * (h11 - h10);
+}
+
+bool HeightField::IntersectSegment(const Float3& start, const Float3& end, float& timeOfImpact) const
+{
+	if (IsEmpty())
+	{
+		return false;
+	}
+
+	//work in samples along x and z, keep y in world units
+	float startX = (start.x - m_origin.x) * m_inverseSpacing;
+	float startZ = (start.z - m_origin.z) * m_inverseSpacing;
+	float deltaX = (end.x - start.x) * m_inverseSpacing;
+	float deltaZ = (end.z - start.z) * m_inverseSpacing;
+	float deltaY = end.y - start.y;
+	float t0 = 0, t1 = 1;
+	if (!ClipToRange(startX, deltaX, 0, float(m_width - 1), t0, t1) || !ClipToRange(startZ, deltaZ, 0, float(m_depth - 1), t0, t1))
+	{
+		return false;
+	}
+
+	auto heightAbove = [&](float t)
+	{
+		return (start.y + deltaY * t) - Sample(startX + deltaX * t, startZ + deltaZ * t) - m_origin.y;
+	};
+	float previousT = t0;
+	float previous = heightAbove(t0);
+	if (previous <= 0)
+	{
+		timeOfImpact = t0;
+		return true;
+	}
+
+	//the surface is flat between the crossings of the lines x, z and x - z = whole numbers, so the height
+	//above it is linear between them: walk the crossings in order and interpolate the first one below
+	const float values[3] = { startX, startZ, startX - startZ };
+	const float deltas[3] = { deltaX, deltaZ, deltaX - deltaZ };
+	float next[3], steps[3];
+	for (int k = 0; k < 3; k++)
+	{
+		if (deltas[k] == 0)
+		{
+			next[k] = steps[k] = std::numeric_limits<float>::infinity();
+			continue;
+		}
+		float value = values[k] + deltas[k] * t0;
+		float line = deltas[k] > 0 ? std::floor(value) + 1 : std::ceil(value) - 1;
+		next[k] = t0 + (line - value) / deltas[k];
+		steps[k] = 1.0f / std::fabs(deltas[k]);
+	}
+
+	for (;;)
+	{
+		float t = std::min(std::min(std::min(next[0], next[1]), next[2]), t1);
+		float current = heightAbove(t);
+		if (current <= 0)
+		{
+			timeOfImpact = previousT + (t - previousT) * previous / (previous - current);
+			return true;
+		}
+		if (t >= t1)
+		{
+			return false;
+		}
+		for (int k = 0; k < 3; k++)
+		{
+			while (next[k] <= t)
+			{
+				next[k] += steps[k];
+			}
+		}
+		previousT = t;
+		previous = current;
+	}
+}
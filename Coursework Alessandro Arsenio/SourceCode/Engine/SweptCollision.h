@@ -0,0 +1,73 @@
+//
+// SweptCollision.h - Continuous collision tests for fast moving spheres
+//
+// A sphere tested only where it is at the end of a step passes through anything thinner than
+// the distance it moved. These tests take the whole path of the step instead, as a segment
+// from where the sphere was to where it is, and return the time of impact along it: 0 at the
+// start of the step, 1 at its end. A hit is found at any step length, so fast objects need no
+// substeps and a slow frame does not change what they hit.
+//
+// The height field is the surface Terrain draws: a grid of heights, each cell split into two
+// triangles along the diagonal from its (x, z) corner to its (x + 1, z + 1) corner.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Entities.h"
+
+namespace DX
+{
+	namespace SweptCollision
+	{
+		// Something a mover ran into during a step, target is NoTarget for the height field.
+		struct Hit
+		{
+			static const uint32_t NoTarget = 0xffffffffu;
+
+			uint32_t mover;
+			uint32_t target;
+			float timeOfImpact;
+		};
+
+		// First time the segment comes within radius of center, 0 when it starts there.
+		bool SegmentVsSphere(const Float3& start, const Float3& end, const Float3& center, float radius, float& timeOfImpact);
+
+		// Two spheres moving in straight lines over the same step, tested as one segment against their relative motion.
+		bool SweepSpheres(const Float3& startA, const Float3& endA, float radiusA, const Float3& startB, const Float3& endB, float radiusB, float& timeOfImpact);
+
+		// Earliest first, ties by mover then target, so hits are applied in the order they happened.
+		void SortByTime(std::vector<Hit>& hits);
+	}
+
+	class HeightField
+	{
+	public:
+		HeightField();
+
+		// heights[z * width + x] above origin, one sample every spacing units along x and z from it.
+		void Set(const float* heights, int width, int depth, float spacing, const Float3& origin);
+		void Clear();
+		bool IsEmpty() const;
+
+		// Height of the surface at x, z, false outside the field.
+		bool GetHeight(float x, float z, float& height) const;
+
+		// First time the segment reaches the surface, 0 when it starts below it. There is no surface outside the field.
+		bool IntersectSegment(const Float3& start, const Float3& end, float& timeOfImpact) const;
+
+	private:
+		// x and z in samples from the origin, clamped to the field.
+		float Sample(float x, float z) const;
+
+		std::vector<float>		m_heights;
+		int						m_width;
+		int						m_depth;
+		float					m_spacing;
+		float					m_inverseSpacing;
+		Float3					m_origin;
+	};
+}
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Terrain.h"
+#include "HeightMap.h"
 
 
 Terrain::Terrain()
@@ -434,19 +435,19 @@ bool Terrain::GenerateHeightMap(ID3D11Device* device)
 bool Terrain::GenerateRandomHeightMap(ID3D11Device* device, float intensity, float scaleFactor, float height)
 {
 	bool result;
-	SimplexNoise simplexnoise;
 	int index;
-	//loop through the terrain and set the hieghts how we want. This is where we generate the terrain
-	//in this case I will run a sin-wave through the terrain in one axis.
+	//the heights come from the platform independent generator, the headless driver makes the same terrain with it
+	std::vector<float> heights;
+	DX::GenerateHeightMap(heights, m_terrainWidth, m_terrainHeight, intensity, scaleFactor, height);
 
-	for (float j = 0; j < m_terrainHeight; j++)
+	for (int j = 0; j < m_terrainHeight; j++)
 	{
-		for (float i = 0; i < m_terrainWidth; i++)
+		for (int i = 0; i < m_terrainWidth; i++)
 		{
 			index = (m_terrainHeight * j) + i;
 
 			m_heightMap[index].x = (float)i;
-			m_heightMap[index].y = simplexnoise.fractal(8,(i/ scaleFactor), height, (j/ scaleFactor)) * intensity;
+			m_heightMap[index].y = heights[(m_terrainWidth * j) + i];
 			m_heightMap[index].z = (float)j;
 		}
 	}
@@ -548,6 +549,16 @@ float Terrain::GetHeightMapY(float x, float z)
 	int index = (m_terrainHeight * z) + x;
 	return m_heightMap[index].y;
 }
+
+int Terrain::GetTerrainWidth()
+{
+	return m_terrainWidth;
+}
+
+int Terrain::GetTerrainHeight()
+{
+	return m_terrainHeight;
+}
 bool Terrain::Update()
 {
 	return true;
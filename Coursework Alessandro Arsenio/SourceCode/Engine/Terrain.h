@@ -31,6 +31,8 @@ public:
 	bool Update();
 	float* GetWavelength();
 	float GetHeightMapY(float x, float z);
+	int GetTerrainWidth();
+	int GetTerrainHeight();
 	float* GetAmplitude();
 
 private:
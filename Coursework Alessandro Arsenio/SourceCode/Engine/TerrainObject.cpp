@@ -2,39 +2,35 @@
 #include "TerrainObject.h"
 
 
-void TerrainObject::Render(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight)
+void TerrainObject::Render(ID3D11DeviceContext* context, const GameObjectDraw& draw, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight)
 {
-	SimpleMath::Matrix m_world = SimpleMath::Matrix::Identity;
-	SimpleMath::Matrix translation = SimpleMath::Matrix::CreateTranslation(m_globalPosition);
-	SimpleMath::Matrix rotationX = SimpleMath::Matrix::CreateRotationX(XMConvertToRadians(m_orientation.x));
-	SimpleMath::Matrix rotationY = SimpleMath::Matrix::CreateRotationY(XMConvertToRadians(m_orientation.y));
-	SimpleMath::Matrix rotationZ = SimpleMath::Matrix::CreateRotationZ(XMConvertToRadians(m_orientation.z));
-	SimpleMath::Matrix scale = SimpleMath::Matrix::CreateScale(m_scale);
-	m_world = scale * m_world * rotationX * rotationY * rotationZ * translation;
+	//static terrain keeps the same cached world matrix every frame
+	SimpleMath::Matrix m_world = draw.world;
+	SimpleMath::Vector3 reflectedCamera = draw.cameraPosition;
 
 	if (isWater)
 	{
-		m_waterShader.EnableShader(context);
-		if (!m_isReflective)
+		m_waterShader->EnableShader(context);
+		if (!draw.reflective)
 		{
-			m_waterShader.SetWaterShaderParameters(context, &m_world, view, projection, sceneLight, m_albedoTexture, m_timer.GetTotalSeconds());
+			m_waterShader->SetWaterShaderParameters(context, &m_world, view, projection, sceneLight, draw.albedoTexture, draw.totalTime);
 		}
 		else
 		{
-			m_waterShader.SetWaterReflectionShaderParameters(context, &m_world, view, projection, sceneLight, m_albedoTexture, m_enviromentTexture, &m_cameraObject->getPosition(), m_timer.GetTotalSeconds());
+			m_waterShader->SetWaterReflectionShaderParameters(context, &m_world, view, projection, sceneLight, draw.albedoTexture, draw.environmentTexture, &reflectedCamera, draw.totalTime);
 		}
 	}
 	else
 	{
-		m_gameObjectShaderPair.EnableShader(context);
+		draw.shader->EnableShader(context);
 		//check if the terrain has more than one texture
 		if (hasHeightTextures)
 		{
-			m_gameObjectShaderPair.SetMultiTextureShaderParameters(context, &m_world, view, projection, sceneLight, m_heightTexture1, m_heightTexture2, m_heightTexture3, m_timer.GetTotalSeconds());
+			draw.shader->SetMultiTextureShaderParameters(context, &m_world, view, projection, sceneLight, m_heightTexture1, m_heightTexture2, m_heightTexture3, draw.totalTime);
 		}
 		else
 		{
-			m_gameObjectShaderPair.SetShaderParameters(context, &m_world, view, projection, sceneLight, m_albedoTexture);
+			draw.shader->SetShaderParameters(context, &m_world, view, projection, sceneLight, draw.albedoTexture);
 		}
 	}
 
@@ -52,10 +48,10 @@ Terrain* TerrainObject::getTerrain()
 	return &m_gameObjectTerrain;
 }
 
-void TerrainObject::setWaterShader(WaterShader* watershader)
+void TerrainObject::setWaterShader(std::shared_ptr<WaterShader> watershader)
 {
 	isWater = true;
-	m_waterShader = *watershader;
+	m_waterShader = watershader;
 }
 
 void TerrainObject::setHeightTextures(ID3D11ShaderResourceView* texture1,ID3D11ShaderResourceView* texture2,ID3D11ShaderResourceView* texture3)
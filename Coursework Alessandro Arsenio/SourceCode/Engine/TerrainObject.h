@@ -6,16 +6,17 @@ class TerrainObject: public GameObject
 {
 public:
 
-	void							Render(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight);
+	//reads only the draw and the terrain, shaders and textures, which do not change once loaded
+	void							Render(ID3D11DeviceContext* context, const GameObjectDraw& draw, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight) override;
 	void							setTerrain(Terrain* terrain);
 	Terrain*						getTerrain();
-	void							setWaterShader(WaterShader *watershader);
+	void							setWaterShader(std::shared_ptr<WaterShader> watershader);
 	void							setHeightTextures(ID3D11ShaderResourceView* texture1, ID3D11ShaderResourceView* texture2, ID3D11ShaderResourceView* texture3);
 
 private:
 
 	Terrain							m_gameObjectTerrain;
-	WaterShader						m_waterShader;
+	std::shared_ptr<WaterShader>	m_waterShader;
 	bool							isWater = false;
 	bool							hasHeightTextures = false;
 	ID3D11ShaderResourceView*       m_heightTexture1;
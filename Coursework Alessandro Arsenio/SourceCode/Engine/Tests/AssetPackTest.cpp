@@ -0,0 +1,281 @@
+//
+// AssetPackTest.cpp - Round trips data through the LZ4 codec and files through an asset pack
+//
+// Blocks of every awkward size and content have to decompress to what was compressed, and damaged
+// blocks have to fail rather than write out of bounds. Then loose files are cooked into a pack in
+// the working directory, reopened and read back entry by entry: stored entries have to start on
+// StoredAlignment, names have to match however they are spelled, duplicates have to stop the
+// writer, and a pack with a damaged table of contents has to be refused.
+//
+
+#include "pch.h"
+#include "AssetPack.h"
+#include "Lz4.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+	enum Content
+	{
+		ContentRandom,			//incompressible
+		ContentText,			//repeats with variation, compresses some
+		ContentZeros,			//one long match
+	};
+
+	std::vector<uint8_t> MakeData(size_t size, Content content, unsigned int seed)
+	{
+		std::mt19937 gen(seed);
+		std::vector<uint8_t> data(size, 0);
+		static const char words[] = "watermine missile terrain player camera ";
+		for (size_t i = 0; i < size; i++)
+		{
+			if (content == ContentRandom)
+			{
+				data[i] = uint8_t(gen());
+			}
+			else if (content == ContentText)
+			{
+				data[i] = gen() % 16 == 0 ? uint8_t('0' + gen() % 10) : uint8_t(words[i % (sizeof(words) - 1)]);
+			}
+		}
+		return data;
+	}
+
+	bool RoundTrips(const std::vector<uint8_t>& data, size_t& compressedSize)
+	{
+		std::vector<uint8_t> compressed(Lz4::CompressBound(data.size()));
+		compressedSize = Lz4::Compress(data.data(), data.size(), compressed.data(), compressed.size());
+		std::vector<uint8_t> decompressed(data.size() + 1, 0xcd);
+		return compressedSize > 0 && compressedSize <= compressed.size()
+			&& Lz4::Decompress(compressed.data(), compressedSize, decompressed.data(), data.size())
+			&& memcmp(decompressed.data(), data.data(), data.size()) == 0 && decompressed[data.size()] == 0xcd;
+	}
+
+	bool WriteFile(const std::string& path, const std::vector<uint8_t>& data)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		return !!file;
+	}
+
+	std::vector<uint8_t> ReadFile(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	std::wstring Widen(const std::string& text)
+	{
+		return std::wstring(text.begin(), text.end());
+	}
+
+	struct PackedFile
+	{
+		const char* path;			//loose file in the working directory
+		const wchar_t* name;		//name in the pack
+		const wchar_t* lookup;		//the same name spelled another way
+		size_t size;
+		Content content;
+		bool compress;
+	};
+}
+
+int main()
+{
+	size_t errors = 0;
+
+	//the codec on its own: empty, shorter than a match, around the end of block rules and around the pack's block size
+	{
+		static const size_t sizes[] = { 0, 1, 4, 5, 12, 13, 17, 255, 256, 4096,
+			AssetPack::BlockSize - 1, AssetPack::BlockSize, AssetPack::BlockSize + 1, 3 * AssetPack::BlockSize + 7 };
+		static const Content contents[] = { ContentRandom, ContentText, ContentZeros };
+		size_t runs = 0, failed = 0, overBound = 0;
+		for (size_t size : sizes)
+		{
+			for (Content content : contents)
+			{
+				std::vector<uint8_t> data = MakeData(size, content, unsigned(size));
+				size_t compressedSize = 0;
+				failed += RoundTrips(data, compressedSize) ? 0 : 1;
+				overBound += compressedSize > Lz4::CompressBound(size) ? 1 : 0;
+				runs++;
+			}
+		}
+
+		//too small a destination is refused, and damaged or truncated blocks fail without writing past the end
+		std::vector<uint8_t> data = MakeData(AssetPack::BlockSize, ContentText, 7);
+		std::vector<uint8_t> compressed(Lz4::CompressBound(data.size()));
+		size_t compressedSize = Lz4::Compress(data.data(), data.size(), compressed.data(), compressed.size());
+		size_t refused = Lz4::Compress(data.data(), data.size(), compressed.data(), 16) == 0 ? 0 : 1;
+		std::vector<uint8_t> out(data.size() + 16, 0xcd);
+		refused += Lz4::Decompress(compressed.data(), compressedSize / 2, out.data(), data.size()) ? 1 : 0;
+		refused += Lz4::Decompress(compressed.data(), compressedSize, out.data(), data.size() - 1) ? 1 : 0;
+		std::mt19937 gen(3);
+		size_t damagedAccepted = 0;
+		for (int i = 0; i < 1000; i++)
+		{
+			std::vector<uint8_t> damaged(compressed.begin(), compressed.begin() + compressedSize);
+			damaged[gen() % damaged.size()] ^= uint8_t(1 + gen() % 255);
+			bool accepted = Lz4::Decompress(damaged.data(), damaged.size(), out.data(), data.size());
+			damagedAccepted += accepted && memcmp(out.data(), data.data(), data.size()) != 0 ? 1 : 0;		//no checksum, only printed
+		}
+		for (size_t i = data.size(); i < out.size(); i++)
+		{
+			refused += out[i] != 0xcd ? 1 : 0;
+		}
+		printf("lz4: %u blocks, %u not round tripped, %u over the bound, %u bad blocks or destinations accepted, %u damaged blocks decoded to other data\n",
+			(unsigned)runs, (unsigned)failed, (unsigned)overBound, (unsigned)refused, (unsigned)damagedAccepted);
+		errors += failed + overBound + refused;
+	}
+
+	//a pack of stored and compressed entries, empty ones and ones ending on a block boundary included
+	static const PackedFile files[] =
+	{
+		{ "AssetPackTest_empty.bin", L"Assets/empty.bin", L"./assets/EMPTY.bin", 0, ContentText, true },
+		{ "AssetPackTest_emptystored.bin", L"Assets/emptystored.bin", L"assets\\emptystored.bin", 0, ContentText, false },
+		{ "AssetPackTest_small.txt", L"Assets/small.txt", L".\\Assets\\Small.txt", 100, ContentText, true },
+		{ "AssetPackTest_twoblocks.bin", L"Assets/twoblocks.bin", L"assets/TwoBlocks.bin", 2 * AssetPack::BlockSize, ContentText, true },
+		{ "AssetPackTest_justover.bin", L"Assets/justover.bin", L"assets/justover.BIN", 2 * AssetPack::BlockSize + 1, ContentZeros, true },
+		{ "AssetPackTest_noise.bin", L"Assets/noise.bin", L"ASSETS/NOISE.BIN", 100000, ContentRandom, true },
+		{ "AssetPackTest_shader.cso", L"Shaders/shader.cso", L"./shaders/shader.cso", 5000, ContentRandom, false },
+		{ "AssetPackTest_texture.dds", L"Textures/texture.dds", L"textures\\texture.dds", 70000, ContentText, false },
+	};
+	const size_t fileCount = sizeof(files) / sizeof(files[0]);
+	const char* packPath = "AssetPackTest.pack";
+	const char* corruptPath = "AssetPackTest_corrupt.pack";
+	std::vector<std::vector<uint8_t>> contents;
+	AssetPackWriter writer;
+	for (size_t i = 0; i < fileCount; i++)
+	{
+		contents.push_back(MakeData(files[i].size, files[i].content, unsigned(i + 1)));
+		if (!WriteFile(files[i].path, contents.back()))
+		{
+			printf("could not write %s\n", files[i].path);
+			return DX::Test::Result(1);
+		}
+		writer.AddFile(files[i].name, Widen(files[i].path).c_str(), files[i].compress);
+	}
+	writer.AddFile(L"Assets/missing.bin", L"AssetPackTest_missing.bin", true);		//left out, the game falls back to the loose file
+	bool written = writer.Write(Widen(packPath).c_str());
+
+	//every entry back as it went in, under either spelling, and the stored ones in place and aligned
+	{
+		AssetPack pack;
+		bool opened = written && pack.Open(Widen(packPath).c_str());
+		size_t wrong = 0, misaligned = 0;
+		for (size_t i = 0; opened && i < fileCount; i++)
+		{
+			std::vector<uint8_t> blob;
+			bool read = pack.ReadEntry(files[i].lookup, blob) && blob == contents[i];
+			const uint8_t* mapped = nullptr;
+			size_t mappedSize = 0;
+			bool inPlace = pack.GetMappedData(files[i].name, &mapped, &mappedSize);
+			bool mappedOk = files[i].compress ? !inPlace
+				: inPlace && mappedSize == contents[i].size() && memcmp(mapped, contents[i].data(), mappedSize) == 0;
+			wrong += read && mappedOk && pack.Contains(files[i].name) ? 0 : 1;
+		}
+		wrong += opened && !pack.Contains(L"Assets/missing.bin") && !pack.Contains(L"Assets/other.bin") ? 0 : 1;
+
+		//the entry table as written, for the offsets
+		std::vector<uint8_t> bytes = ReadFile(packPath);
+		AssetPack::Header header = {};
+		memcpy(&header, bytes.data(), std::min(bytes.size(), sizeof(header)));
+		for (uint32_t e = 0; e < header.entryCount && bytes.size() >= header.entryTableOffset + (e + 1) * sizeof(AssetPack::Entry); e++)
+		{
+			AssetPack::Entry entry;
+			memcpy(&entry, bytes.data() + header.entryTableOffset + e * sizeof(AssetPack::Entry), sizeof(entry));
+			misaligned += entry.flags == AssetPack::EntryStored && entry.offset % AssetPack::StoredAlignment != 0 ? 1 : 0;
+		}
+		bool counted = header.entryCount == fileCount;
+		printf("pack of %u bytes: %s, %u of %u entries wrong, %u stored entries off the %u byte alignment\n",
+			(unsigned)bytes.size(), opened ? "opened" : "NOT OPENED", (unsigned)wrong, (unsigned)fileCount,
+			(unsigned)misaligned, AssetPack::StoredAlignment);
+		errors += (opened && counted ? 0 : 1) + wrong + misaligned;
+	}
+
+	//damaged headers and tables are refused at Open, a damaged block fails its read
+	{
+		std::vector<uint8_t> bytes = ReadFile(packPath);
+		AssetPack::Header header;
+		memcpy(&header, bytes.data(), sizeof(header));
+		struct Damage
+		{
+			const char* what;
+			size_t offset;
+			uint64_t value;
+			size_t size;
+		};
+		const Damage damages[] =
+		{
+			{ "magic", offsetof(AssetPack::Header, magic), 0x21444142, 4 },
+			{ "version", offsetof(AssetPack::Header, version), AssetPack::Version + 1, 4 },
+			{ "entry count", offsetof(AssetPack::Header, entryCount), 0x10000000, 4 },
+			{ "block count", offsetof(AssetPack::Header, blockCount), 0x10000000, 4 },
+			{ "entry table offset", offsetof(AssetPack::Header, entryTableOffset), bytes.size(), 8 },
+			{ "block table offset", offsetof(AssetPack::Header, blockTableOffset), bytes.size() - 8, 8 },
+		};
+		size_t accepted = 0;
+		for (const Damage& damage : damages)
+		{
+			std::vector<uint8_t> corrupt = bytes;
+			memcpy(corrupt.data() + damage.offset, &damage.value, damage.size);
+			WriteFile(corruptPath, corrupt);
+			AssetPack pack;
+			if (pack.Open(Widen(corruptPath).c_str()))
+			{
+				printf("a pack with a bad %s was opened\n", damage.what);
+				accepted++;
+			}
+		}
+
+		//truncated inside the header
+		WriteFile(corruptPath, std::vector<uint8_t>(bytes.begin(), bytes.begin() + sizeof(header) - 1));
+		AssetPack truncated;
+		accepted += truncated.Open(Widen(corruptPath).c_str()) ? 1 : 0;
+
+		//every block pointed past the end of the file: the header is fine, the reads are not
+		std::vector<uint8_t> corrupt = bytes;
+		for (uint32_t b = 0; b < header.blockCount; b++)
+		{
+			uint64_t past = corrupt.size();
+			memcpy(corrupt.data() + header.blockTableOffset + b * sizeof(AssetPack::Block) + offsetof(AssetPack::Block, offset), &past, sizeof(past));
+		}
+		WriteFile(corruptPath, corrupt);
+		AssetPack pack;
+		size_t badReads = 0;
+		std::vector<uint8_t> blob;
+		bool opened = pack.Open(Widen(corruptPath).c_str());
+		badReads += opened && pack.ReadEntry(L"Assets/twoblocks.bin", blob) ? 1 : 0;
+		badReads += opened && pack.ReadEntry(L"Assets/noise.bin", blob) ? 1 : 0;
+		printf("%u damaged packs opened, %u reads through blocks past the end succeeded\n", (unsigned)accepted, (unsigned)badReads);
+		errors += accepted + badReads + (opened ? 0 : 1);
+	}
+
+	//the same name twice, however it is spelled, is one entry too many
+	{
+		AssetPackWriter duplicates;
+		duplicates.AddFile(L"Assets/small.txt", Widen(files[2].path).c_str(), true);
+		duplicates.AddFile(L"./ASSETS\\small.txt", Widen(files[3].path).c_str(), false);
+		bool refused = !duplicates.Write(Widen(corruptPath).c_str());
+		printf("a second entry with the same name %s\n", refused ? "stopped the writer" : "WAS WRITTEN");
+		errors += refused ? 0 : 1;
+	}
+
+	for (const PackedFile& file : files)
+	{
+		remove(file.path);
+	}
+	remove(packPath);
+	remove(corruptPath);
+	return DX::Test::Result(errors);
+}
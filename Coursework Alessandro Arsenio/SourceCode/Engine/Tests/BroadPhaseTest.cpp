@@ -0,0 +1,125 @@
+//
+// BroadPhaseTest.cpp - Times the spatial hash against the nested collision loop
+//
+// A tenth of the colliders are missiles and one is the player, spread at about the density of
+// the watermine grid. The nested loop is what Game::Update used to run over its object lists;
+// the spatial hash, rebuilt every frame the way the update uses it, has to find the same pairs.
+//
+
+#include "pch.h"
+#include "BroadPhase.h"
+#include "Simulation.h"
+#include "TestSupport.h"
+
+#include <cmath>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+namespace
+{
+	struct Sphere
+	{
+		DX::Float3 center;
+		float radius;
+
+		// BoundingSphere::Intersects: the squared distance between the centers against the squared sum of the radii.
+		bool Intersects(const Sphere& other) const
+		{
+			float x = other.center.x - center.x, y = other.center.y - center.y, z = other.center.z - center.z;
+			float radii = radius + other.radius;
+			return x * x + y * y + z * z <= radii * radii;
+		}
+	};
+
+	void Insert(DX::SpatialHash& broadPhase, uint32_t id, const Sphere& sphere, uint32_t layer, uint32_t mask)
+	{
+		broadPhase.Insert(id, sphere.center, sphere.radius, layer, mask);
+	}
+}
+
+int main()
+{
+	static const size_t counts[] = { 1000, 10000, 100000 };
+	bool identical = true;
+	for (size_t count : counts)
+	{
+		std::mt19937 gen((unsigned)count);
+		float side = std::sqrt(float(count)) * 16.0f;
+		std::uniform_real_distribution<float> across(0.0f, side);
+		std::uniform_real_distribution<float> depth(-30.0f, 0.0f);
+		std::vector<Sphere> watermines;
+		std::vector<Sphere> missiles;
+		for (size_t i = 0; i + 1 < count; i++)
+		{
+			Sphere sphere = { { across(gen), depth(gen), across(gen) }, 2.0f };
+			(i % 10 == 0 ? missiles : watermines).push_back(sphere);
+		}
+		Sphere player = { { across(gen), depth(gen), across(gen) }, 3.0f };
+		uint32_t playerId = (uint32_t)(watermines.size() + missiles.size());
+
+		std::vector<DX::BroadPhasePair> loopPairs;
+		DX::Test::Clock::time_point start = DX::Test::Clock::now();
+		for (size_t w = 0; w < watermines.size(); w++)
+		{
+			for (size_t m = 0; m < missiles.size(); m++)
+			{
+				if (missiles[m].Intersects(watermines[w]))
+				{
+					DX::BroadPhasePair pair = { (uint32_t)w, (uint32_t)(watermines.size() + m) };
+					loopPairs.push_back(pair);
+				}
+			}
+			if (player.Intersects(watermines[w]))
+			{
+				DX::BroadPhasePair pair = { (uint32_t)w, playerId };
+				loopPairs.push_back(pair);
+			}
+		}
+		double loopMs = DX::Test::MillisecondsSince(start);
+
+		//rebuilt from scratch every frame, the way Game::Update uses it
+		DX::SpatialHash broadPhase(DX::CollisionCellSize);
+		std::vector<DX::BroadPhasePair> candidates;
+		std::vector<DX::BroadPhasePair> hashPairs;
+		const int frames = 20;
+		start = DX::Test::Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			broadPhase.Clear();
+			for (size_t w = 0; w < watermines.size(); w++)
+			{
+				Insert(broadPhase, (uint32_t)w, watermines[w], DX::LayerWatermine, DX::LayerMissile | DX::LayerPlayer);
+			}
+			for (size_t m = 0; m < missiles.size(); m++)
+			{
+				Insert(broadPhase, (uint32_t)(watermines.size() + m), missiles[m], DX::LayerMissile, DX::LayerWatermine);
+			}
+			Insert(broadPhase, playerId, player, DX::LayerPlayer, DX::LayerWatermine);
+			broadPhase.FindPairs(candidates);
+
+			hashPairs.clear();
+			for (const DX::BroadPhasePair& pair : candidates)
+			{
+				const Sphere& other = pair.b == playerId ? player : missiles[pair.b - watermines.size()];
+				if (other.Intersects(watermines[pair.a]))
+				{
+					hashPairs.push_back(pair);
+				}
+			}
+		}
+		double hashMs = DX::Test::MillisecondsSince(start) / frames;
+
+		bool same = loopPairs.size() == hashPairs.size();
+		for (size_t i = 0; same && i < loopPairs.size(); i++)
+		{
+			same = loopPairs[i].a == hashPairs[i].a && loopPairs[i].b == hashPairs[i].b;
+		}
+		identical = identical && same;
+
+		printf("%6u colliders: nested loop %10.4f ms, spatial hash %8.4f ms (%.1fx), %u candidates, %u hits, %s\n",
+			(unsigned)count, loopMs, hashMs, hashMs > 0 ? loopMs / hashMs : 0.0, (unsigned)candidates.size(), (unsigned)hashPairs.size(),
+			same ? "same pairs" : "PAIRS DIFFER");
+	}
+	return DX::Test::Result(identical ? 0 : 1);
+}
@@ -0,0 +1,121 @@
+//
+// EntityBenchmark.cpp - Times updating 100, 10k and 100k watermines per object and with the systems
+//
+// The per object path is what Game::Update used to do: update every object through a virtual
+// call, each reading the update's shared time and input. The systems make one pass per
+// component array over the same entities.
+//
+
+#include "pch.h"
+#include "Entities.h"
+#include "FrameContext.h"
+#include "Simulation.h"
+#include "TestSupport.h"
+
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+namespace
+{
+	DX::EntityStore s_entities;
+
+	// What GameObject does for an update: a virtual call that runs the systems' steps for its own entity.
+	class ObjectFacade
+	{
+	public:
+		ObjectFacade()
+		{
+			m_entity = s_entities.Create(DX::ComponentRender);
+		}
+
+		virtual ~ObjectFacade()
+		{
+			s_entities.DestroyLater(m_entity);
+		}
+
+		virtual void Update(const DX::FrameContext& frame)
+		{
+			DX::UpdateEntity(s_entities, m_entity, frame.deltaTime);
+		}
+
+	protected:
+		DX::Entity m_entity;
+	};
+
+	// Watermine, placed and given its collider as Game::Initialize does.
+	class WatermineFacade : public ObjectFacade
+	{
+	public:
+		explicit WatermineFacade(const DX::Float3& position)
+		{
+			const DX::Float3 rotation = { 0.0f, 90.0f, 0.0f };
+			DX::AddWatermineComponents(s_entities, m_entity);
+			s_entities.SetPosition(m_entity, position);
+			DX::SetWatermineCenter(s_entities, m_entity, position.y);
+			s_entities.SetRotation(m_entity, rotation);
+			s_entities.AddComponents(m_entity, DX::ComponentCollider);
+			DX::Collider& collider = s_entities.GetCollider(m_entity);
+			collider.center = position;
+			collider.previousCenter = position;
+			collider.radius = DX::WatermineRadius;
+		}
+	};
+}
+
+int main()
+{
+	DX::FrameContext frameContext = {};
+	frameContext.deltaTime = 1.0f / 60.0f;
+	DX::EntityStore& store = s_entities;
+
+	static const size_t counts[] = { 100, 10000, 100000 };
+	for (size_t count : counts)
+	{
+		std::vector<ObjectFacade*> watermines;
+		watermines.reserve(count);
+		size_t side = (size_t)std::ceil(std::sqrt((double)count));
+		for (size_t i = 0; i < count; i++)
+		{
+			DX::Float3 position = { float(i % side) * 20, -4.0f - float(i % 7), float(i / side) * 20 };
+			watermines.push_back(new WatermineFacade(position));
+		}
+
+		//enough frames to time the small scenes, one warm up frame each
+		int frames = (int)std::max<size_t>(10, 1000000 / count);
+		for (ObjectFacade* watermine : watermines)
+		{
+			watermine->Update(frameContext);
+		}
+		DX::Test::Clock::time_point start = DX::Test::Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			for (ObjectFacade* watermine : watermines)
+			{
+				watermine->Update(frameContext);
+			}
+		}
+		double objectMs = DX::Test::MillisecondsSince(start) / frames;
+
+		DX::UpdateEntities(store, frameContext.deltaTime);
+		start = DX::Test::Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			DX::UpdateEntities(store, frameContext.deltaTime);
+		}
+		double systemMs = DX::Test::MillisecondsSince(start) / frames;
+
+		printf("%6u watermines: per object %8.4f ms/frame, systems %8.4f ms/frame (%.1fx), %.1f ns per entity\n",
+			(unsigned)count, objectMs, systemMs, systemMs > 0 ? objectMs / systemMs : 0.0, systemMs * 1e6 / count);
+
+		for (ObjectFacade* watermine : watermines)
+		{
+			delete watermine;
+		}
+		store.FlushDestroyed();
+	}
+
+	printf("component bytes per entity %u\n",
+		(unsigned)(sizeof(uint32_t) + sizeof(uint8_t) + sizeof(DX::Transform) + sizeof(DX::Motion) + sizeof(DX::Collider) + sizeof(DX::RenderHandle) + sizeof(DX::Lifetime)));
+	return 0;
+}
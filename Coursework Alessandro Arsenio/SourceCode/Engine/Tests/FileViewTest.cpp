@@ -0,0 +1,166 @@
+//
+// FileViewTest.cpp - Opens files either side of MinMappedSize and moves the views around
+//
+// Files below MinMappedSize have to come back buffered and files at or above it mapped, with the
+// same bytes either way. Missing files and directories have to fail to open. A view that is moved
+// from has to end up closed, while the one moved to keeps reading the same bytes, whichever kind
+// it was and whatever it held before. Attached and adopted views have to read what they were given.
+//
+
+#include "pch.h"
+#include "FileView.h"
+#include "TestSupport.h"
+
+#include <fstream>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+	std::vector<uint8_t> MakeData(size_t size, unsigned int seed)
+	{
+		std::vector<uint8_t> data(size);
+		uint32_t state = seed * 2654435761u + 1;
+		for (size_t i = 0; i < size; i++)
+		{
+			state = state * 1664525u + 1013904223u;
+			data[i] = uint8_t(state >> 24);
+		}
+		return data;
+	}
+
+	bool WriteFile(const std::string& path, const std::vector<uint8_t>& data)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		return !!file;
+	}
+
+	std::wstring Widen(const std::string& text)
+	{
+		return std::wstring(text.begin(), text.end());
+	}
+
+	bool Holds(const FileView& view, const std::vector<uint8_t>& data)
+	{
+		return view.IsOpen() && view.size() == data.size() && view.empty() == data.empty()
+			&& view.end() == view.begin() + view.size() && (data.empty() || memcmp(view.data(), data.data(), data.size()) == 0);
+	}
+
+	bool Closed(const FileView& view)
+	{
+		return !view.IsOpen() && !view.IsMapped() && view.data() == nullptr && view.size() == 0;
+	}
+
+	struct TestFile
+	{
+		const char* path;
+		size_t size;
+		bool mapped;
+	};
+}
+
+int main()
+{
+	size_t errors = 0;
+	static const TestFile files[] =
+	{
+		{ "FileViewTest_empty.bin", 0, false },
+		{ "FileViewTest_small.bin", 100, false },
+		{ "FileViewTest_below.bin", FileView::MinMappedSize - 1, false },
+		{ "FileViewTest_at.bin", FileView::MinMappedSize, true },
+		{ "FileViewTest_large.bin", 300000, true },
+	};
+	const size_t fileCount = sizeof(files) / sizeof(files[0]);
+	std::vector<std::vector<uint8_t>> contents;
+	for (size_t i = 0; i < fileCount; i++)
+	{
+		contents.push_back(MakeData(files[i].size, unsigned(i + 1)));
+		if (!WriteFile(files[i].path, contents.back()))
+		{
+			printf("could not write %s\n", files[i].path);
+			return DX::Test::Result(1);
+		}
+	}
+
+	//buffered below the threshold, mapped from it on, the same bytes either way
+	{
+		size_t wrong = 0;
+		for (size_t i = 0; i < fileCount; i++)
+		{
+			FileView view;
+			bool ok = view.Open(Widen(files[i].path).c_str()) && Holds(view, contents[i]) && view.IsMapped() == files[i].mapped;
+			view.Prefetch();
+			ok = ok && Holds(view, contents[i]);
+			view.Close();
+			ok = ok && Closed(view);
+			printf("%-24s %6u bytes: %s\n", files[i].path, (unsigned)files[i].size,
+				!ok ? "WRONG" : files[i].mapped ? "mapped" : "buffered");
+			wrong += ok ? 0 : 1;
+		}
+
+		//opening again replaces what the view held, a failed open leaves it closed
+		FileView view;
+		bool reopened = view.Open(Widen(files[4].path).c_str()) && view.Open(Widen(files[1].path).c_str())
+			&& Holds(view, contents[1]) && !view.IsMapped();
+		bool missing = !view.Open(L"FileViewTest_missing.bin") && Closed(view);
+		bool directory = !view.Open(L".") && Closed(view);
+		printf("reopened %s, missing file %s, directory %s\n", reopened ? "ok" : "WRONG",
+			missing ? "refused" : "OPENED", directory ? "refused" : "OPENED");
+		errors += wrong + (reopened ? 0 : 1) + (missing ? 0 : 1) + (directory ? 0 : 1);
+	}
+
+	//moved views keep reading the same bytes from the same place, and the views moved from are closed
+	{
+		size_t wrong = 0;
+		for (size_t from = 1; from < fileCount; from++)
+		{
+			for (size_t to = 0; to < fileCount; to++)
+			{
+				FileView source, target;
+				source.Open(Widen(files[from].path).c_str());
+				target.Open(Widen(files[to].path).c_str());
+				const uint8_t* data = source.data();
+				target = std::move(source);
+				bool ok = Holds(target, contents[from]) && target.data() == data && target.IsMapped() == files[from].mapped && Closed(source);
+
+				FileView constructed(std::move(target));
+				ok = ok && Holds(constructed, contents[from]) && constructed.data() == data && Closed(target);
+				constructed = std::move(constructed);
+				ok = ok && Holds(constructed, contents[from]);
+				wrong += ok ? 0 : 1;
+			}
+		}
+		printf("%u moves between views of every size, %u wrong\n", (unsigned)((fileCount - 1) * fileCount), (unsigned)wrong);
+		errors += wrong;
+	}
+
+	//attached views read memory owned elsewhere, adopted ones own the buffer they were given
+	{
+		const std::vector<uint8_t>& large = contents[4];
+		FileView attached;
+		attached.Open(Widen(files[3].path).c_str());
+		attached.Attach(large.data() + 10, 1000);
+		attached.Prefetch();
+		bool attachOk = !attached.IsMapped() && attached.data() == large.data() + 10 && attached.size() == 1000;
+
+		std::vector<uint8_t> blob = contents[2];
+		const uint8_t* blobData = blob.data();
+		FileView adopted;
+		adopted.Adopt(std::move(blob));
+		FileView moved(std::move(adopted));
+		bool adoptOk = Holds(moved, contents[2]) && moved.data() == blobData && !moved.IsMapped() && Closed(adopted);
+		printf("attach %s, adopt %s\n", attachOk ? "ok" : "WRONG", adoptOk ? "ok" : "WRONG");
+		errors += (attachOk ? 0 : 1) + (adoptOk ? 0 : 1);
+	}
+
+	for (const TestFile& file : files)
+	{
+		remove(file.path);
+	}
+	return DX::Test::Result(errors);
+}
@@ -0,0 +1,152 @@
+//
+// FrameContextBenchmark.cpp - Times 100k object updates copying the timer and input against a shared FrameContext
+//
+// Two facades over the same entity store, laid out like GameObject before and after it took a
+// FrameContext. Before, Game called Initialise on every object every frame, copying the timer and
+// the input into it and setting its parent again, then Update read them back. After, one context
+// is written per update and passed by const reference. The Windows only Input member the old
+// facade carried is stood in for by a buffer of about its size.
+//
+
+#include "pch.h"
+#include "Entities.h"
+#include "FrameContext.h"
+#include "StepTimer.h"
+#include "TestSupport.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	DX::EntityStore s_entities;
+
+	// The members GameObject has either way: its entity, tag, model and shader, textures, parent and camera, box collider, speeds and flags.
+	struct FacadeMembers
+	{
+		DX::Entity						entity;
+		std::string						tag;
+		std::shared_ptr<int>			model;
+		std::shared_ptr<int>			shader;
+		void*							textures[2];
+		void*							objects[2];
+		float							box[10];
+		float							speeds[2];
+		bool							flags[3];
+	};
+
+	class CopyingFacade : public FacadeMembers
+	{
+	public:
+		virtual ~CopyingFacade() {}
+
+		void Initialise(const DX::StepTimer& timer, const InputCommands* inputCommands, CopyingFacade* parent)
+		{
+			m_inputCommands = *inputCommands;
+			m_timer = timer;
+			s_entities.SetParent(entity, parent ? parent->entity : DX::InvalidEntity);
+		}
+
+		virtual void Update()
+		{
+			DX::UpdateEntity(s_entities, entity, float(m_timer.GetElapsedSeconds()));
+		}
+
+	private:
+		char							m_input[184];		//Input: keyboard and mouse, their state trackers and a copy of the commands
+		InputCommands					m_inputCommands;
+		DX::StepTimer					m_timer;
+	};
+
+	class SharedContextFacade : public FacadeMembers
+	{
+	public:
+		virtual ~SharedContextFacade() {}
+
+		virtual void Update(const DX::FrameContext& frame)
+		{
+			DX::UpdateEntity(s_entities, entity, frame.deltaTime);
+		}
+	};
+
+	// Spinning and bobbing like a watermine, so every update has work to do.
+	template<typename Facade>
+	std::vector<Facade*> CreateFacades(size_t count)
+	{
+		std::vector<Facade*> facades;
+		facades.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			Facade* facade = new Facade();
+			facade->entity = s_entities.Create(DX::ComponentRender | DX::ComponentMotion);
+			DX::Motion& motion = s_entities.GetMotion(facade->entity);
+			motion.spinRate = 40.0f;
+			motion.bobAmplitude = 2.0f;
+			facades.push_back(facade);
+		}
+		return facades;
+	}
+
+	template<typename Facade>
+	void DestroyFacades(std::vector<Facade*>& facades)
+	{
+		for (Facade* facade : facades)
+		{
+			s_entities.DestroyLater(facade->entity);
+			delete facade;
+		}
+		s_entities.FlushDestroyed();
+		facades.clear();
+	}
+}
+
+int main()
+{
+	const size_t count = 100000;
+	const int frames = 50;
+	const int repeats = 5;
+
+	DX::StepTimer timer;
+	timer.Advance(DX::StepTimer::TicksPerSecond / 60, []() {});
+	InputCommands input = {};
+	DX::FrameContext frame = {};
+	frame.deltaTime = float(timer.GetElapsedSeconds());
+	frame.input = input;
+
+	//the fastest of a few runs each, interleaved so neither gets a quieter machine
+	double copyingMs = 1e9, sharedMs = 1e9;
+	for (int repeat = 0; repeat < repeats; repeat++)
+	{
+		std::vector<CopyingFacade*> copying = CreateFacades<CopyingFacade>(count);
+		DX::Test::Clock::time_point start = DX::Test::Clock::now();
+		for (int f = 0; f < frames; f++)
+		{
+			for (CopyingFacade* facade : copying)
+			{
+				facade->Initialise(timer, &input, nullptr);
+				facade->Update();
+			}
+		}
+		copyingMs = std::min(copyingMs, DX::Test::MillisecondsSince(start) / frames);
+		DestroyFacades(copying);
+
+		std::vector<SharedContextFacade*> shared = CreateFacades<SharedContextFacade>(count);
+		start = DX::Test::Clock::now();
+		for (int f = 0; f < frames; f++)
+		{
+			for (SharedContextFacade* facade : shared)
+			{
+				facade->Update(frame);
+			}
+		}
+		sharedMs = std::min(sharedMs, DX::Test::MillisecondsSince(start) / frames);
+		DestroyFacades(shared);
+	}
+
+	printf("%u objects: copying timer and input %8.3f ms/frame, shared context %8.3f ms/frame (%.2fx)\n",
+		(unsigned)count, copyingMs, sharedMs, sharedMs > 0 ? copyingMs / sharedMs : 0.0);
+	printf("facade %u bytes copying, %u bytes with the shared context (StepTimer %u, InputCommands %u)\n",
+		(unsigned)sizeof(CopyingFacade), (unsigned)sizeof(SharedContextFacade), (unsigned)sizeof(DX::StepTimer), (unsigned)sizeof(InputCommands));
+	return 0;
+}
@@ -0,0 +1,137 @@
+//
+// FramePipelineTest.cpp - Checks the hand-off of frames between the update and render threads
+//
+// A writer publishes frames through a TripleBuffer as fast as it can against a reader polling,
+// then the FramePipeline runs single threaded and pipelined. No frame may be read torn or out of
+// order, and a pipelined frame renders either itself or the one before it.
+//
+
+#include "pch.h"
+#include "FramePipeline.h"
+#include "TripleBuffer.h"
+#include "TestSupport.h"
+
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const size_t ValueCount = 4096;
+
+	//a frame is whole when every value matches its number, so a reader seeing a frame while it is written would notice
+	struct TestFrame
+	{
+		uint64_t number = 0;
+		std::vector<uint64_t> values;
+	};
+
+	void WriteFrame(TestFrame& frame, uint64_t number)
+	{
+		frame.values.resize(ValueCount);
+		for (size_t i = 0; i < ValueCount; i++)
+		{
+			frame.values[i] = number * ValueCount + i;
+		}
+		frame.number = number;
+	}
+
+	bool IsWhole(const TestFrame& frame)
+	{
+		for (size_t i = 0; i < frame.values.size(); i++)
+		{
+			if (frame.values[i] != frame.number * ValueCount + i)
+			{
+				return false;
+			}
+		}
+		return frame.number == 0 || frame.values.size() == ValueCount;
+	}
+
+	//stands in for updating or drawing a frame
+	void Work(int iterations)
+	{
+		volatile float sink = 0;
+		for (int i = 0; i < iterations; i++)
+		{
+			sink = sink * 0.5f + float(i);
+		}
+	}
+}
+
+int main()
+{
+	size_t errors = 0;
+
+	//the buffer alone, a writer as fast as it can go against a reader polling: frames may be skipped, never torn or reordered
+	{
+		DX::TripleBuffer<TestFrame> frames;
+		const uint64_t frameCount = 20000;
+		std::thread writer([&]()
+		{
+			for (uint64_t number = 1; number <= frameCount; number++)
+			{
+				WriteFrame(frames.GetWriteBuffer(), number);
+				frames.Publish();
+			}
+		});
+		uint64_t last = 0, seen = 0, torn = 0, reordered = 0;
+		while (last < frameCount)
+		{
+			if (!frames.Acquire())
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			const TestFrame& frame = frames.GetReadBuffer();
+			torn += IsWhole(frame) ? 0 : 1;
+			reordered += frame.number > last ? 0 : 1;
+			last = frame.number;
+			seen++;
+		}
+		writer.join();
+		errors += size_t(torn + reordered);
+		printf("triple buffer: %u frames published, %u read, %u torn, %u out of order\n",
+			(unsigned)frameCount, (unsigned)seen, (unsigned)torn, (unsigned)reordered);
+	}
+
+	//the pipeline both ways: threaded, a frame renders the one before it or, if the update was quick, itself
+	const int frameCount = 500;
+	for (int threaded = 0; threaded < 2; threaded++)
+	{
+		DX::TripleBuffer<TestFrame> frames;
+		DX::FramePipeline pipeline(threaded != 0);
+		uint64_t torn = 0, wrongFrame = 0;
+		double simulation = 0, render = 0, waited = 0;
+		DX::Test::Clock::time_point start = DX::Test::Clock::now();
+		for (int number = 1; number <= frameCount; number++)
+		{
+			pipeline.Simulate([&, number]()
+			{
+				Work(20000);
+				WriteFrame(frames.GetWriteBuffer(), uint64_t(number));
+				frames.Publish();
+			});
+			pipeline.Render([&, number]()
+			{
+				frames.Acquire();
+				const TestFrame& frame = frames.GetReadBuffer();
+				Work(20000);
+				torn += IsWhole(frame) ? 0 : 1;
+				uint64_t oldest = pipeline.IsThreaded() ? uint64_t(number - 1) : uint64_t(number);
+				wrongFrame += frame.number >= oldest && frame.number <= uint64_t(number) ? 0 : 1;
+			});
+			DX::FramePipelineTimings timings = pipeline.GetTimings();
+			simulation += timings.simulation;
+			render += timings.render;
+			waited += timings.waitForSimulation;
+		}
+		pipeline.Finish();
+		double total = DX::Test::MillisecondsSince(start);
+		errors += size_t(torn + wrongFrame);
+		printf("%s: %8.4f ms/frame (update %.4f, render %.4f, waited %.4f), %u torn, %u wrong frames\n",
+			threaded ? "pipelined      " : "single threaded", total / frameCount, simulation / frameCount, render / frameCount, waited / frameCount,
+			(unsigned)torn, (unsigned)wrongFrame);
+	}
+	return DX::Test::Result(errors);
+}
@@ -0,0 +1,146 @@
+//
+// JobSystemTest.cpp - Checks the job system and times spawning and scaling
+//
+// Every index of a parallel for has to run once whatever the grain, dependent jobs in order,
+// nested parallel fors to completion and main thread jobs on the main thread. Then prints the
+// cost of spawning a job against a std::async, and a parallel for with more and more workers.
+// Configure with -DENGINE_THREAD_SANITIZER=ON to run it under ThreadSanitizer.
+//
+
+#include "pch.h"
+#include "JobSystem.h"
+#include "TestSupport.h"
+
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <thread>
+#include <vector>
+
+int main()
+{
+	size_t errors = 0;
+	unsigned int workerCount = DX::JobSystem::DefaultWorkerCount();
+
+	//correctness first: every index of a parallel for once, dependencies in order, nested waits, main thread jobs.
+	//At least four workers even on a small machine, so there is stealing for ThreadSanitizer to watch
+	{
+		const unsigned int checkWorkers = std::max(workerCount, 4u);
+		DX::JobSystem jobs(checkWorkers);
+		const size_t count = 100000;
+		std::vector<std::atomic<int>> visits(count);
+		static const size_t grains[] = { 0, 1, 7, 1000, count * 2 };
+		for (size_t grain : grains)
+		{
+			for (auto& visit : visits)
+			{
+				visit.store(0);
+			}
+			jobs.ParallelFor(0, count, grain, [&visits](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					visits[i].fetch_add(1);
+				}
+			});
+			for (auto& visit : visits)
+			{
+				errors += visit.load() != 1 ? 1 : 0;
+			}
+		}
+
+		//a fan in and a chain: each stage checks everything it depends on has finished
+		for (int round = 0; round < 100; round++)
+		{
+			DX::JobCounter first, second, third;
+			std::atomic<int> done(0);
+			std::atomic<int> misordered(0);
+			for (int i = 0; i < 64; i++)
+			{
+				jobs.Run([&done]() { done.fetch_add(1); }, &first);
+			}
+			jobs.Run([&done, &misordered]() { misordered.fetch_add(done.load() != 64 ? 1 : 0); done.fetch_add(1); }, &second, &first);
+			jobs.Run([&done, &misordered]() { misordered.fetch_add(done.load() != 65 ? 1 : 0); }, &third, &second);
+			jobs.Wait(third);
+			errors += misordered.load();
+		}
+
+		//jobs waiting on jobs they spawned, two levels deep
+		std::atomic<size_t> leaves(0);
+		jobs.ParallelFor(0, 64, 1, [&jobs, &leaves](size_t, size_t)
+		{
+			jobs.ParallelFor(0, 64, 1, [&leaves](size_t begin, size_t end) { leaves.fetch_add(end - begin); });
+		});
+		errors += leaves.load() != 64 * 64 ? 1 : 0;
+
+		//immediate context work queued from the workers has to run on the main thread
+		DX::JobCounter mainThreadJobs;
+		std::atomic<int> offMainThread(0);
+		std::thread::id mainThread = std::this_thread::get_id();
+		jobs.ParallelFor(0, 32, 1, [&](size_t, size_t)
+		{
+			jobs.RunOnMainThread([&offMainThread, mainThread]() { offMainThread.fetch_add(std::this_thread::get_id() != mainThread ? 1 : 0); }, &mainThreadJobs);
+		});
+		jobs.Wait(mainThreadJobs);
+		errors += offMainThread.load();
+
+		printf("%u workers, %u errors in the parallel for, dependency, nesting and main thread checks\n", checkWorkers, (unsigned)errors);
+	}
+
+	//spawn overhead: empty jobs through the deques, against a std::async per job
+	{
+		DX::JobSystem jobs(workerCount);
+		const int spawns = 100000;
+		DX::JobCounter counter;
+		std::atomic<int> ran(0);
+		DX::Test::Clock::time_point start = DX::Test::Clock::now();
+		for (int i = 0; i < spawns; i++)
+		{
+			jobs.Run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+		}
+		jobs.Wait(counter);
+		double jobMs = DX::Test::MillisecondsSince(start);
+		errors += ran.load() != spawns ? 1 : 0;
+
+		const int asyncs = 2000;
+		start = DX::Test::Clock::now();
+		std::vector<std::future<void>> futures;
+		futures.reserve(asyncs);
+		for (int i = 0; i < asyncs; i++)
+		{
+			futures.push_back(std::async(std::launch::async, [&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }));
+		}
+		for (auto& future : futures)
+		{
+			future.wait();
+		}
+		double asyncMs = DX::Test::MillisecondsSince(start);
+		printf("spawn and run: job %8.1f ns, std::async %8.1f ns\n", jobMs * 1e6 / spawns, asyncMs * 1e6 / asyncs);
+	}
+
+	//scaling: the same parallel for over a few million items with more and more workers
+	{
+		const size_t count = 1 << 22;
+		std::vector<float> values(count);
+		double serialMs = 0;
+		for (unsigned int workers : DX::Test::WorkerCounts(workerCount))
+		{
+			DX::JobSystem jobs(workers);
+			DX::Test::Clock::time_point start = DX::Test::Clock::now();
+			for (int pass = 0; pass < 4; pass++)
+			{
+				jobs.ParallelFor(0, count, 4096, [&values, pass](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; i++)
+					{
+						values[i] = std::sin(float(i) * 0.001f + pass) * std::cos(float(i) * 0.002f);
+					}
+				});
+			}
+			double ms = DX::Test::MillisecondsSince(start) / 4;
+			serialMs = workers == 0 ? ms : serialMs;
+			printf("%2u workers: %8.3f ms per pass, %.2fx\n", workers, ms, ms > 0 ? serialMs / ms : 0.0);
+		}
+	}
+	return DX::Test::Result(errors);
+}
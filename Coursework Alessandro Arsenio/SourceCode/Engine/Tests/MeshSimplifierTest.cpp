@@ -0,0 +1,178 @@
+//
+// MeshSimplifierTest.cpp - Builds LOD chains for a UV sphere and a flat grid and checks what they keep
+//
+// The sphere's levels have to lose triangles at every step, stay near their target ratios and keep
+// their errors rising but under the bound. The grid's border has to hold: locked, every border
+// vertex is still used; sliding, the corners are, and the grid keeps its area and facing. SelectLod
+// is checked against errors whose switching distances are known.
+//
+
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include "TestSupport.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace DX::MeshSimplifier;
+
+namespace
+{
+	// 64 by 64 quads with a seam down one side and a row of degenerate triangles at each pole, 8192 triangles.
+	void BuildSphere(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const int n = 64;
+		const float pi = 3.14159265f;
+		for (int i = 0; i <= n; i++)
+		{
+			for (int j = 0; j <= n; j++)
+			{
+				float theta = pi * float(i) / n, phi = 2.0f * pi * float(j) / n;
+				float x = std::sin(theta) * std::cos(phi), y = std::cos(theta), z = std::sin(theta) * std::sin(phi);
+				Vertex vertex = { { x, y, z }, { x, y, z }, { float(j) / n, float(i) / n } };
+				vertices.push_back(vertex);
+			}
+		}
+		for (int i = 0; i < n; i++)
+		{
+			for (int j = 0; j < n; j++)
+			{
+				uint32_t a = i * (n + 1) + j, b = a + 1, c = a + n + 1, d = c + 1;
+				indices.insert(indices.end(), { a, c, b, b, c, d });
+			}
+		}
+		WeldVertices(vertices, indices);
+	}
+
+	// A unit square of n by n quads facing up, texture coordinates following the positions.
+	void BuildGrid(int n, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		for (int i = 0; i <= n; i++)
+		{
+			for (int j = 0; j <= n; j++)
+			{
+				float x = float(j) / n, z = float(i) / n;
+				Vertex vertex = { { x, 0.0f, z }, { 0.0f, 1.0f, 0.0f }, { x, z } };
+				vertices.push_back(vertex);
+			}
+		}
+		for (int i = 0; i < n; i++)
+		{
+			for (int j = 0; j < n; j++)
+			{
+				uint32_t a = i * (n + 1) + j, b = a + 1, c = a + n + 1, d = c + 1;
+				indices.insert(indices.end(), { a, c, b, b, c, d });
+			}
+		}
+	}
+
+	bool OnBorder(const Vertex& vertex)
+	{
+		return vertex.position[0] == 0.0f || vertex.position[0] == 1.0f || vertex.position[2] == 0.0f || vertex.position[2] == 1.0f;
+	}
+
+	bool IsCorner(const Vertex& vertex)
+	{
+		return (vertex.position[0] == 0.0f || vertex.position[0] == 1.0f) && (vertex.position[2] == 0.0f || vertex.position[2] == 1.0f);
+	}
+
+	// Counts the vertices that have to survive and do not, and sums the area of the triangles
+	// facing up; any facing down is counted as flipped.
+	void CheckGrid(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, bool (*kept)(const Vertex&),
+		size_t& missing, double& area, size_t& flipped)
+	{
+		std::vector<bool> used(vertices.size(), false);
+		area = 0;
+		flipped = 0;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const float* a = vertices[indices[i]].position;
+			const float* b = vertices[indices[i + 1]].position;
+			const float* c = vertices[indices[i + 2]].position;
+			//y of (b - a) x (c - a), up for the grid's winding
+			double up = double(b[2] - a[2]) * (c[0] - a[0]) - double(b[0] - a[0]) * (c[2] - a[2]);
+			area += up * 0.5;
+			flipped += up < 0 ? 1 : 0;
+			used[indices[i]] = used[indices[i + 1]] = used[indices[i + 2]] = true;
+		}
+		missing = 0;
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			missing += kept(vertices[i]) && !used[i] ? 1 : 0;
+		}
+	}
+}
+
+int main()
+{
+	size_t errors = 0;
+
+	//the sphere's chain with the game's default options
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		BuildSphere(vertices, indices);
+		LodChainOptions options;
+		std::vector<Lod> chain = GenerateLodChain(vertices, indices, options);
+		size_t triangles = indices.size() / 3;
+		bool ok = chain.size() == options.ratios.size() + 1 && chain[0].indices == indices && chain[0].error == 0;
+		for (size_t lod = 1; lod < chain.size(); lod++)
+		{
+			size_t count = chain[lod].indices.size() / 3;
+			size_t previous = chain[lod - 1].indices.size() / 3;
+			size_t target = size_t(float(triangles) * options.ratios[lod - 1]);
+			ok = ok && count < previous && count <= target && count * 10 >= target * 9;
+			ok = ok && chain[lod].error >= chain[lod - 1].error && chain[lod].error <= options.maxError;
+			for (uint32_t index : chain[lod].indices)
+			{
+				ok = ok && index < vertices.size();
+			}
+		}
+		printf("sphere, %u triangles:", (unsigned)triangles);
+		for (size_t lod = 1; lod < chain.size(); lod++)
+		{
+			printf(" %u (error %.4f)", (unsigned)(chain[lod].indices.size() / 3), chain[lod].error);
+		}
+		printf(", %s\n", ok ? "each level smaller and within its bound" : "WRONG");
+		errors += ok ? 0 : 1;
+	}
+
+	//a grid with its border locked keeps every border vertex, sliding it keeps the corners and the outline
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		BuildGrid(32, vertices, indices);
+		for (int lock = 0; lock < 2; lock++)
+		{
+			Options options;
+			options.targetRatio = 0.1f;
+			options.lockBorder = lock != 0;
+			std::vector<uint32_t> result;
+			float error = Simplify(vertices, indices, options, result);
+			size_t missing, flipped;
+			double area;
+			CheckGrid(vertices, result, options.lockBorder ? OnBorder : IsCorner, missing, area, flipped);
+			bool ok = result.size() < indices.size() && missing == 0 && flipped == 0 && std::fabs(area - 1.0) < 1e-5 && error <= options.maxError;
+			printf("grid, border %s: %u of %u triangles, %u %s lost, area %.6f, %u flipped, %s\n",
+				options.lockBorder ? "locked" : "sliding", (unsigned)(result.size() / 3), (unsigned)(indices.size() / 3),
+				(unsigned)missing, options.lockBorder ? "border vertices" : "corners", area, (unsigned)flipped, ok ? "ok" : "WRONG");
+			errors += ok ? 0 : 1;
+		}
+	}
+
+	//a level is chosen once its error is a pixel or less: here from 10, 20 and 40 units away
+	{
+		static const float lodErrors[] = { 0.0f, 0.01f, 0.02f, 0.04f };
+		static const float distances[] = { 0.5f, 5.0f, 10.0f, 15.0f, 20.0f, 39.0f, 40.0f, 1000.0f };
+		static const int expected[] = { 0, 0, 1, 1, 2, 2, 3, 3 };
+		size_t wrong = 0;
+		for (size_t i = 0; i < sizeof(distances) / sizeof(distances[0]); i++)
+		{
+			wrong += SelectLod(lodErrors, 4, 1.0f, distances[i], 1000.0f, 1.0f) != expected[i] ? 1 : 0;
+		}
+		wrong += SelectLod(lodErrors, 1, 1.0f, 1000.0f, 1000.0f, 1.0f) != 0 ? 1 : 0;
+		printf("lod selection: %u wrong\n", (unsigned)wrong);
+		errors += wrong;
+	}
+	return DX::Test::Result(errors);
+}
@@ -0,0 +1,239 @@
+//
+// MeshletTest.cpp - Splits a sphere into meshlets and culls them from the -meshletreport cameras
+//
+// The meshlets have to stay within their vertex and triangle limits and keep every triangle of
+// the mesh. Each camera then keeps a known number of triangles, and no meshlet it culls may hold
+// a triangle that faces the camera with a corner inside the view, checked one triangle at a time.
+//
+
+#include "pch.h"
+#include "Meshlets.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+	// 64 by 64 quads of a unit sphere, as MeshSimplifierTest builds it, welded like the game's models.
+	void BuildSphere(std::vector<MeshSimplifier::Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const int n = 64;
+		const float pi = 3.14159265f;
+		for (int i = 0; i <= n; i++)
+		{
+			for (int j = 0; j <= n; j++)
+			{
+				float theta = pi * float(i) / n, phi = 2.0f * pi * float(j) / n;
+				float x = std::sin(theta) * std::cos(phi), y = std::cos(theta), z = std::sin(theta) * std::sin(phi);
+				MeshSimplifier::Vertex vertex = { { x, y, z }, { x, y, z }, { float(j) / n, float(i) / n } };
+				vertices.push_back(vertex);
+			}
+		}
+		for (int i = 0; i < n; i++)
+		{
+			for (int j = 0; j < n; j++)
+			{
+				uint32_t a = i * (n + 1) + j, b = a + 1, c = a + n + 1, d = c + 1;
+				indices.insert(indices.end(), { a, c, b, b, c, d });
+			}
+		}
+		MeshSimplifier::WeldVertices(vertices, indices);
+	}
+
+	void Normalize(float v[3])
+	{
+		float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		for (int i = 0; i < 3; i++)
+		{
+			v[i] /= length;
+		}
+	}
+
+	void Cross(const float a[3], const float b[3], float out[3])
+	{
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	// The report's view and projection, row vectors as Matrix::CreateLookAt and CreatePerspectiveFieldOfView
+	// build them: right handed, y up, 70 degrees at the default 1366 by 768 window from 0.01 to 1000.
+	void LookAtPerspective(const float eye[3], const float target[3], float viewProjection[16])
+	{
+		const float up[3] = { 0.0f, 1.0f, 0.0f };
+		float back[3] = { eye[0] - target[0], eye[1] - target[1], eye[2] - target[2] };
+		Normalize(back);
+		float right[3], upward[3];
+		Cross(up, back, right);
+		Normalize(right);
+		Cross(back, right, upward);
+		const float* axes[3] = { right, upward, back };
+		float view[16] = {};
+		for (int c = 0; c < 3; c++)
+		{
+			for (int r = 0; r < 3; r++)
+			{
+				view[r * 4 + c] = axes[c][r];
+			}
+			view[12 + c] = -(axes[c][0] * eye[0] + axes[c][1] * eye[1] + axes[c][2] * eye[2]);
+		}
+		view[15] = 1.0f;
+
+		const float fieldOfView = 70.0f * 3.14159265f / 180.0f, aspect = 1366.0f / 768.0f, nearPlane = 0.01f, farPlane = 1000.0f;
+		float height = 1.0f / std::tan(fieldOfView / 2.0f);
+		float range = farPlane / (nearPlane - farPlane);
+		float projection[16] = {
+			height / aspect, 0, 0, 0,
+			0, height, 0, 0,
+			0, 0, range, -1,
+			0, 0, range * nearPlane, 0 };
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				float sum = 0;
+				for (int k = 0; k < 4; k++)
+				{
+					sum += view[r * 4 + k] * projection[k * 4 + c];
+				}
+				viewProjection[r * 4 + c] = sum;
+			}
+		}
+	}
+
+	bool InFrustum(const Meshlets::Frustum& frustum, const float point[3])
+	{
+		for (const float* plane : frustum.planes)
+		{
+			if (plane[0] * point[0] + plane[1] * point[1] + plane[2] * point[2] + plane[3] < 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Whether the camera is in front of the triangle's plane, from its corners rather than its normals.
+	// The sphere's pole rows are slivers with no area to draw, whichever way rounding turns them.
+	bool FacesCamera(const float* a, const float* b, const float* c, const float eye[3])
+	{
+		float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		float normal[3];
+		Cross(ac, ab, normal);		//the sphere's triangles wind clockwise seen from outside
+		if (normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] < 1e-12f)
+		{
+			return false;
+		}
+		return normal[0] * (eye[0] - a[0]) + normal[1] * (eye[1] - a[1]) + normal[2] * (eye[2] - a[2]) > 0;
+	}
+
+	typedef std::array<uint32_t, 3> Triangle;
+
+	std::vector<Triangle> SortedTriangles(const std::vector<uint32_t>& indices)
+	{
+		std::vector<Triangle> triangles;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			triangles.push_back({ { indices[i], indices[i + 1], indices[i + 2] } });
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+}
+
+int main()
+{
+	size_t errors = 0;
+	std::vector<MeshSimplifier::Vertex> vertices;
+	std::vector<uint32_t> indices;
+	BuildSphere(vertices, indices);
+	std::vector<uint32_t> original = indices;
+	std::vector<Meshlets::Meshlet> meshlets;
+	Meshlets::Build(vertices, indices, 0, indices.size(), meshlets);
+
+	//within the limits, covering the index buffer in order, and the same triangles reordered
+	{
+		size_t oversized = 0, mostVertices = 0, mostTriangles = 0;
+		uint32_t next = 0;
+		for (const Meshlets::Meshlet& meshlet : meshlets)
+		{
+			std::vector<uint32_t> used(indices.begin() + meshlet.indexStart, indices.begin() + meshlet.indexStart + meshlet.indexCount);
+			std::sort(used.begin(), used.end());
+			used.erase(std::unique(used.begin(), used.end()), used.end());
+			mostVertices = std::max(mostVertices, used.size());
+			mostTriangles = std::max(mostTriangles, size_t(meshlet.indexCount / 3));
+			oversized += used.size() > Meshlets::MaxVertices || meshlet.indexCount / 3 > Meshlets::MaxTriangles || meshlet.indexStart != next ? 1 : 0;
+			next = meshlet.indexStart + meshlet.indexCount;
+		}
+		bool same = next == indices.size() && SortedTriangles(indices) == SortedTriangles(original);
+		printf("%u triangles in %u meshlets, at most %u vertices and %u triangles each, %u over the limits, %s\n",
+			(unsigned)(indices.size() / 3), (unsigned)meshlets.size(), (unsigned)mostVertices, (unsigned)mostTriangles,
+			(unsigned)oversized, same ? "every triangle kept" : "TRIANGLES CHANGED");
+		errors += oversized + (same ? 0 : 1);
+	}
+
+	//the report's cameras, in units of the bounding radius: six from outside, then two from close by looking past the sphere.
+	//From outside about half the sphere faces the camera, the cones keep a margin of the clusters on the rim
+	struct Camera
+	{
+		float position[3];
+		float target[3];
+		size_t kept;
+	};
+	static const Camera cameras[] =
+	{
+		{ { 0, 0, 3 }, { 0, 0, 0 }, 3766 },
+		{ { 0, 0, -3 }, { 0, 0, 0 }, 3589 },
+		{ { 3, 0, 0 }, { 0, 0, 0 }, 3499 },
+		{ { -3, 0, 0 }, { 0, 0, 0 }, 3496 },
+		{ { 0, 3, 0.01f }, { 0, 0, 0 }, 4046 },
+		{ { 2, 1, 2 }, { 0, 0, 0 }, 3846 },
+		{ { 0, 0, 1.2f }, { 2, 0, 1.2f }, 565 },
+		{ { 1.2f, 0.5f, 0 }, { 1.2f, 0.5f, 2 }, 572 },
+	};
+	const float world[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	for (const Camera& camera : cameras)
+	{
+		float viewProjection[16];
+		LookAtPerspective(camera.position, camera.target, viewProjection);
+		Meshlets::Frustum frustum = Meshlets::ExtractFrustum(viewProjection);
+		std::vector<Meshlets::DrawRange> ranges;
+		Meshlets::CullStats stats = { 0, 0, 0, 0 };
+		size_t kept = Meshlets::Cull(meshlets.data(), meshlets.size(), world, frustum, camera.position, ranges, &stats);
+
+		//every triangle the ranges leave out, against the camera one by one
+		std::vector<bool> drawn(indices.size() / 3, false);
+		size_t rangeTriangles = 0;
+		for (const Meshlets::DrawRange& range : ranges)
+		{
+			for (uint32_t i = range.indexStart; i < range.indexStart + range.indexCount; i += 3)
+			{
+				drawn[i / 3] = true;
+			}
+			rangeTriangles += range.indexCount / 3;
+		}
+		size_t visible = 0, missed = 0;
+		for (size_t t = 0; t < drawn.size(); t++)
+		{
+			const float* a = vertices[indices[t * 3]].position;
+			const float* b = vertices[indices[t * 3 + 1]].position;
+			const float* c = vertices[indices[t * 3 + 2]].position;
+			bool seen = FacesCamera(a, b, c, camera.position) && (InFrustum(frustum, a) || InFrustum(frustum, b) || InFrustum(frustum, c));
+			visible += seen ? 1 : 0;
+			missed += seen && !drawn[t] ? 1 : 0;
+		}
+		bool ok = missed == 0 && kept == rangeTriangles && kept == camera.kept
+			&& stats.triangles == indices.size() / 3 && kept + stats.frustumCulled + stats.backfaceCulled == stats.triangles;
+		printf("camera at (%5.2f %5.2f %5.2f): %4u of %u triangles kept (expected %4u) in %2u ranges, %4u visible, %u visible culled, %s\n",
+			camera.position[0], camera.position[1], camera.position[2], (unsigned)kept, (unsigned)stats.triangles, (unsigned)camera.kept,
+			(unsigned)ranges.size(), (unsigned)visible, (unsigned)missed, ok ? "ok" : "WRONG");
+		errors += ok ? 0 : 1;
+	}
+	return DX::Test::Result(errors);
+}
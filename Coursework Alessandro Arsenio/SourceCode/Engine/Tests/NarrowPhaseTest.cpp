@@ -0,0 +1,225 @@
+//
+// NarrowPhaseTest.cpp - Checks the batched collision tests against one collider at a time
+//
+// Random spheres and boxes, a third of the radii set to the exact distance and a float step
+// either side of it, so the tests are checked where the rounding decides. Every batched answer is
+// compared with a scalar copy of BoundingSphere::Intersects and BoundingOrientedBox::Intersects,
+// written out from DirectXCollision's SSE code with the same operations in the same order, so the
+// lanes, masks and gathers are checked to the last bit without DirectXMath.
+//
+
+#include "pch.h"
+#include "NarrowPhase.h"
+#include "TestSupport.h"
+
+#include <cmath>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+namespace
+{
+	struct Sphere
+	{
+		DX::Float3 center;
+		float radius;
+	};
+
+	struct Box
+	{
+		DX::Float3 center;
+		DX::Float3 extents;
+		float orientation[4];		//x, y, z, w
+	};
+
+	float Distance(const DX::Float3& a, const DX::Float3& b)
+	{
+		float x = b.x - a.x, y = b.y - a.y, z = b.z - a.z;
+		return std::sqrt(x * x + y * y + z * z);
+	}
+
+	// BoundingSphere::Intersects(BoundingSphere)
+	bool Intersects(const Sphere& a, const Sphere& b)
+	{
+		float x = b.center.x - a.center.x, y = b.center.y - a.center.y, z = b.center.z - a.center.z;
+		float radius = a.radius + b.radius;
+		return (x * x + y * y) + z * z <= radius * radius;
+	}
+
+	// XMQuaternionMultiply(q1, q2)
+	void QuaternionMultiply(const float q1[4], const float q2[4], float result[4])
+	{
+		result[0] = (q2[3] * q1[0] + q2[0] * q1[3]) + (q2[1] * q1[2] - q2[2] * q1[1]);
+		result[1] = (q2[3] * q1[1] - q2[0] * q1[2]) + (q2[1] * q1[3] + q2[2] * q1[0]);
+		result[2] = (q2[3] * q1[2] + q2[0] * q1[1]) + (q2[2] * q1[3] - q2[1] * q1[0]);
+		result[3] = (q2[3] * q1[3] - q2[0] * q1[0]) - (q2[1] * q1[1] + q2[2] * q1[2]);
+	}
+
+	// BoundingOrientedBox::Intersects(BoundingSphere): XMVector3InverseRotate of the offset, then the
+	// squared distance to the box against the squared radius
+	bool Intersects(const Box& box, const Sphere& sphere)
+	{
+		const float* q = box.orientation;
+		float v[4] = { sphere.center.x - box.center.x, sphere.center.y - box.center.y, sphere.center.z - box.center.z, 0.0f };
+		float conjugate[4] = { -q[0], -q[1], -q[2], q[3] };
+		float rotated[4], local[4];
+		QuaternionMultiply(q, v, rotated);
+		QuaternionMultiply(rotated, conjugate, local);
+
+		const float extents[3] = { box.extents.x, box.extents.y, box.extents.z };
+		float d[3];
+		for (int i = 0; i < 3; i++)
+		{
+			d[i] = local[i] < -extents[i] ? local[i] + extents[i] : 0.0f;
+			d[i] = local[i] > extents[i] ? local[i] - extents[i] : d[i];
+		}
+		return (d[0] * d[0] + d[1] * d[1]) + d[2] * d[2] <= sphere.radius * sphere.radius;
+	}
+}
+
+int main()
+{
+	const size_t count = 10000;
+	const int rounds = 20;
+	std::mt19937 gen(40);
+	std::uniform_real_distribution<float> across(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> size(0.1f, 4.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_int_distribution<int> nudge(0, 8);
+
+	//sets the radius to just reach the target, then moves it 0 or a float step in or out
+	auto touching = [&](float distance)
+	{
+		float radius = std::max(distance, 0.0f);
+		switch (nudge(gen))
+		{
+		case 0: return std::nextafter(radius, 0.0f);
+		case 1: return std::nextafter(radius, radius + 1.0f);
+		case 2: return radius;
+		default: return size(gen);
+		}
+	};
+
+	size_t mismatches = 0, hits = 0;
+	double batchMs[2] = {}, referenceMs[2] = {};
+	std::vector<Sphere> spheres(count);
+	std::vector<Box> boxes(count);
+	DX::NarrowPhase::SphereSet sphereSet;
+	DX::NarrowPhase::BoxSet boxSet;
+	std::vector<DX::BroadPhasePair> candidates, batchHits;
+	std::vector<uint32_t> found;
+	std::vector<bool> expected(count);
+	for (int round = 0; round < rounds; round++)
+	{
+		sphereSet.Clear();
+		boxSet.Clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			Sphere sphere = { { across(gen), across(gen), across(gen) }, size(gen) };
+			spheres[i] = sphere;
+			sphereSet.Add(sphere.center, sphere.radius);
+
+			Box box = { { across(gen), across(gen), across(gen) }, { size(gen), size(gen), size(gen) }, { unit(gen), unit(gen), unit(gen), unit(gen) } };
+			float length = std::sqrt(box.orientation[0] * box.orientation[0] + box.orientation[1] * box.orientation[1]
+				+ box.orientation[2] * box.orientation[2] + box.orientation[3] * box.orientation[3]);
+			for (float& value : box.orientation)
+			{
+				value /= length;
+			}
+			boxes[i] = box;
+			boxSet.Add(box.center, box.extents, box.orientation);
+		}
+
+		//one sphere against every sphere and every box
+		Sphere probe = { spheres[gen() % count].center, 0.0f };
+		probe.center.x += unit(gen);
+		for (int kind = 0; kind < 2; kind++)
+		{
+			const DX::Float3& target = kind == 0 ? spheres[round].center : boxes[round].center;
+			probe.radius = touching(Distance(probe.center, target) - (kind == 0 ? spheres[round].radius : 0.0f));
+
+			found.clear();
+			DX::Test::Clock::time_point start = DX::Test::Clock::now();
+			if (kind == 0)
+			{
+				DX::NarrowPhase::SphereVsSpheres(probe.center, probe.radius, sphereSet, found);
+			}
+			else
+			{
+				DX::NarrowPhase::SphereVsBoxes(probe.center, probe.radius, boxSet, found);
+			}
+			batchMs[kind] += DX::Test::MillisecondsSince(start);
+
+			start = DX::Test::Clock::now();
+			for (size_t i = 0; i < count; i++)
+			{
+				expected[i] = kind == 0 ? Intersects(probe, spheres[i]) : Intersects(boxes[i], probe);
+			}
+			referenceMs[kind] += DX::Test::MillisecondsSince(start);
+
+			size_t next = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				bool batch = next < found.size() && found[next] == i;
+				next += batch ? 1 : 0;
+				mismatches += batch != expected[i] ? 1 : 0;
+			}
+			mismatches += next != found.size() ? 1 : 0;
+			hits += found.size();
+		}
+
+		//candidate pairs, half of the spheres resized to about reach their box
+		candidates.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			DX::BroadPhasePair pair = { (uint32_t)i, (uint32_t)(gen() % count) };
+			candidates.push_back(pair);
+			if (i % 2 == 0)
+			{
+				spheres[i].radius = touching(Distance(spheres[i].center, boxes[pair.b].center) - boxes[pair.b].extents.x);
+				sphereSet.radius[i] = spheres[i].radius;
+			}
+		}
+		for (int kind = 0; kind < 2; kind++)
+		{
+			batchHits.clear();
+			DX::Test::Clock::time_point start = DX::Test::Clock::now();
+			if (kind == 0)
+			{
+				DX::NarrowPhase::TestSpherePairs(sphereSet, sphereSet, candidates, batchHits);
+			}
+			else
+			{
+				DX::NarrowPhase::TestSphereBoxPairs(sphereSet, boxSet, candidates, batchHits);
+			}
+			batchMs[kind] += DX::Test::MillisecondsSince(start);
+
+			start = DX::Test::Clock::now();
+			for (size_t i = 0; i < count; i++)
+			{
+				const DX::BroadPhasePair& pair = candidates[i];
+				expected[i] = kind == 0 ? Intersects(spheres[pair.a], spheres[pair.b]) : Intersects(boxes[pair.b], spheres[pair.a]);
+			}
+			referenceMs[kind] += DX::Test::MillisecondsSince(start);
+
+			size_t next = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				bool batch = next < batchHits.size() && batchHits[next].a == candidates[i].a && batchHits[next].b == candidates[i].b;
+				next += batch ? 1 : 0;
+				mismatches += batch != expected[i] ? 1 : 0;
+			}
+			mismatches += next != batchHits.size() ? 1 : 0;
+			hits += batchHits.size();
+		}
+	}
+
+	static const char* names[] = { "sphere-sphere", "sphere-box" };
+	for (int kind = 0; kind < 2; kind++)
+	{
+		printf("%-13s %s batch %8.4f ms, one at a time %8.4f ms (%.1fx)\n", names[kind], DX::NarrowPhase::GetInstructionSet(),
+			batchMs[kind] / rounds, referenceMs[kind] / rounds, batchMs[kind] > 0 ? referenceMs[kind] / batchMs[kind] : 0.0);
+	}
+	printf("%u hits, %u answers differ from the one at a time tests\n", (unsigned)hits, (unsigned)mismatches);
+	return DX::Test::Result(mismatches);
+}
@@ -0,0 +1,179 @@
+//
+// ParallelRecordingTest.cpp - Splits draw lists across mock contexts and checks what they execute
+//
+// Every draw has to execute once and in list order whatever the draw, context and minimum batch
+// counts, with no context recording two batches at once. Then prints how evenly the partition
+// shares out the cost and how recording scales with the workers.
+//
+
+#include "pch.h"
+#include "JobSystem.h"
+#include "ParallelRecording.h"
+#include "TestSupport.h"
+
+#include <atomic>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+namespace
+{
+	//a context that records draw numbers and flags two batches recording on it at once; executing appends them
+	//to what the immediate context ran. Each draw spins for its cost, standing in for the API calls
+	class MockContexts : public DX::RecordingBackend
+	{
+	public:
+		MockContexts(unsigned int count, const float* costs) :
+			m_busy(count),
+			m_lists(count),
+			m_costs(costs),
+			m_overlaps(0)
+		{
+		}
+
+		unsigned int GetContextCount() const override		{ return (unsigned int)m_busy.size(); }
+
+		void RecordBatch(unsigned int context, size_t batch, const DX::DrawBatch& draws) override
+		{
+			m_overlaps.fetch_add(m_busy[context].exchange(1));
+			std::vector<uint32_t>& list = m_lists[batch];
+			list.clear();
+			for (size_t i = draws.begin; i < draws.end; i++)
+			{
+				volatile float sink = 0;
+				int work = m_costs ? int(m_costs[i]) : 100;
+				for (int k = 0; k < work; k++)
+				{
+					sink = sink * 0.5f + float(k);
+				}
+				list.push_back((uint32_t)i);
+			}
+			m_busy[context].store(0);
+		}
+
+		void ExecuteBatch(size_t batch) override
+		{
+			executed.insert(executed.end(), m_lists[batch].begin(), m_lists[batch].end());
+			m_lists[batch].clear();
+		}
+
+		int GetOverlaps() const		{ return m_overlaps.load(); }
+
+		std::vector<uint32_t> executed;
+
+	private:
+		std::vector<std::atomic<int>>		m_busy;
+		std::vector<std::vector<uint32_t>>	m_lists;
+		const float*						m_costs;
+		std::atomic<int>					m_overlaps;
+	};
+}
+
+int main()
+{
+	size_t errors = 0;
+	std::mt19937 gen(46);
+	std::uniform_real_distribution<float> cost(10.0f, 1000.0f);
+	unsigned int workerCount = DX::JobSystem::DefaultWorkerCount();
+
+	//every draw executed once and in list order, whatever the counts, with batches no larger in number than the
+	//contexts and no smaller than the minimum
+	{
+		DX::JobSystem jobs(workerCount);
+		static const size_t counts[] = { 0, 1, 15, 16, 17, 100, 1000, 5000 };
+		static const unsigned int contextCounts[] = { 1, 2, 3, 8, 33 };
+		static const size_t minimums[] = { 1, 16, 64 };
+		size_t runs = 0, misordered = 0, badBatches = 0, overlaps = 0;
+		for (size_t count : counts)
+		{
+			std::vector<float> costs(count);
+			for (float& value : costs)
+			{
+				value = cost(gen);
+			}
+			for (unsigned int contexts : contextCounts)
+			{
+				for (size_t minDraws : minimums)
+				{
+					MockContexts mock(contexts, costs.data());
+					DX::RecordingStats stats = DX::RecordInParallel(jobs, mock, costs.data(), count, minDraws);
+					bool ordered = mock.executed.size() == count;
+					for (size_t i = 0; ordered && i < count; i++)
+					{
+						ordered = mock.executed[i] == i;
+					}
+					std::vector<DX::DrawBatch> batches;
+					DX::PartitionDraws(costs.data(), count, contexts, minDraws, batches);
+					bool batchesOk = batches.size() <= contexts && stats.batches == batches.size();
+					for (const DX::DrawBatch& batch : batches)
+					{
+						batchesOk = batchesOk && batch.end > batch.begin && (batch.end - batch.begin >= minDraws || count < minDraws);
+					}
+					misordered += ordered ? 0 : 1;
+					badBatches += batchesOk ? 0 : 1;
+					overlaps += mock.GetOverlaps();
+					runs++;
+				}
+			}
+		}
+		errors += misordered + badBatches + overlaps;
+		printf("%u runs: %u out of order, %u with bad batches, %u contexts recording two batches at once\n",
+			(unsigned)runs, (unsigned)misordered, (unsigned)badBatches, (unsigned)overlaps);
+	}
+
+	//balance: the costliest batch against an even split of the cost
+	{
+		const size_t count = 2000;
+		std::vector<float> costs(count);
+		double total = 0;
+		for (float& value : costs)
+		{
+			value = cost(gen);
+			total += value;
+		}
+		for (unsigned int contexts = 2; contexts <= 16; contexts *= 2)
+		{
+			std::vector<DX::DrawBatch> batches;
+			DX::PartitionDraws(costs.data(), count, contexts, 16, batches);
+			double largest = 0;
+			for (const DX::DrawBatch& batch : batches)
+			{
+				double sum = 0;
+				for (size_t i = batch.begin; i < batch.end; i++)
+				{
+					sum += costs[i];
+				}
+				largest = std::max(largest, sum);
+			}
+			printf("%2u contexts: %u batches, the costliest %.3fx an even share\n",
+				contexts, (unsigned)batches.size(), largest / (total / double(batches.size())));
+		}
+	}
+
+	//scaling: 2000 draws of mixed cost with more and more workers, one context each and one for the caller
+	{
+		const size_t count = 2000;
+		const int frames = 20;
+		std::vector<float> costs(count);
+		for (float& value : costs)
+		{
+			value = cost(gen);
+		}
+		double serialMs = 0;
+		for (unsigned int workers : DX::Test::WorkerCounts(workerCount))
+		{
+			DX::JobSystem jobs(workers);
+			MockContexts mock(workers + 1, costs.data());
+			DX::Test::Clock::time_point start = DX::Test::Clock::now();
+			for (int frame = 0; frame < frames; frame++)
+			{
+				mock.executed.clear();
+				DX::RecordInParallel(jobs, mock, costs.data(), count, 16);
+			}
+			double ms = DX::Test::MillisecondsSince(start) / frames;
+			serialMs = workers == 0 ? ms : serialMs;
+			printf("%2u workers: %8.4f ms/frame, %.2fx one context\n", workers, ms, ms > 0 ? serialMs / ms : 0.0);
+		}
+	}
+	return DX::Test::Result(errors);
+}
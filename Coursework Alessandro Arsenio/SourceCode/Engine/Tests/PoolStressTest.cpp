@@ -0,0 +1,162 @@
+//
+// PoolStressTest.cpp - Fires thousands of missiles a second through a pool and checks it stops growing
+//
+// Missiles are fired at a fixed rate through an ObjectPool and the entity systems the way
+// Game::Update does. Once the first missiles start expiring every acquire reuses a released slot
+// and entity, so after the warm up the pool must not grow and the heap must not be touched, which
+// a counting operator new checks.
+//
+
+#include "pch.h"
+#include "Entities.h"
+#include "ObjectPool.h"
+#include "Simulation.h"
+#include "TestSupport.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+	std::atomic<size_t> s_allocations(0);
+
+	//the game's missile pool starts this large
+	const size_t MissilePoolCapacity = 128;
+
+	DX::EntityStore s_entities;
+
+	// What the pool needs of Missile: an entity with the missile's components from construction to
+	// destruction, in a store every missile shares.
+	struct PooledMissile
+	{
+		DX::Entity entity;
+
+		PooledMissile()
+		{
+			entity = s_entities.Create(DX::ComponentRender);
+			DX::AddMissileComponents(s_entities, entity);
+		}
+
+		~PooledMissile()
+		{
+			s_entities.DestroyLater(entity);
+		}
+
+		void Place(const DX::Float3& position, const DX::Float3& rotation, float radius)
+		{
+			s_entities.SetPosition(entity, position);
+			s_entities.SetRotation(entity, rotation);
+			s_entities.AddComponents(entity, DX::ComponentCollider);
+			DX::Collider& collider = s_entities.GetCollider(entity);
+			collider.center = position;
+			collider.previousCenter = position;
+			collider.radius = radius;
+		}
+	};
+}
+
+// Every allocation in the process is counted, the standard library's included.
+void* operator new(size_t size)
+{
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+	void* memory = malloc(size ? size : 1);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+// C++14 deletes through the sized form when it knows the size, it has to go to the same free.
+void operator delete(void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+int main()
+{
+	const int missilesPerSecond = 3000;
+	const int framesPerSecond = 60;
+	const int warmUpFrames = 6 * framesPerSecond;
+	const int measuredFrames = 30 * framesPerSecond;
+	const float deltaTime = 1.0f / framesPerSecond;
+
+	DX::EntityStore& store = s_entities;
+	DX::ObjectPool<PooledMissile> pool(MissilePoolCapacity);
+	std::vector<PooledMissile*> live;
+	live.reserve(missilesPerSecond * 10);
+
+	DX::ObjectPoolStats warmStats = {};
+	size_t warmEntities = 0;
+	size_t fired = 0;
+	size_t warmAllocations = 0;
+	DX::Test::Clock::time_point start = DX::Test::Clock::now();
+	for (int frame = 0; frame < warmUpFrames + measuredFrames; frame++)
+	{
+		if (frame == warmUpFrames)
+		{
+			warmStats = pool.GetStats();
+			warmEntities = store.GetSlotCount();
+			warmAllocations = s_allocations.load();
+			start = DX::Test::Clock::now();
+		}
+
+		//spread the shots evenly, fired counts every missile so far
+		size_t due = (size_t)(frame + 1) * missilesPerSecond / framesPerSecond;
+		for (; fired < due; fired++)
+		{
+			PooledMissile* missile = pool.Acquire();
+			if (missile == nullptr)
+			{
+				break;
+			}
+			DX::Float3 position = { 0.0f, -5.0f, 0.0f };
+			DX::Float3 rotation = { 0.0f, float(fired % 360), 0.0f };
+			missile->Place(position, rotation, 2.0f);
+			live.push_back(missile);
+		}
+
+		DX::UpdateEntities(store, deltaTime);
+
+		//expired missiles go back to the pool, order does not matter here
+		for (size_t i = 0; i < live.size();)
+		{
+			if (store.IsMarkedForDelete(live[i]->entity))
+			{
+				pool.Release(live[i]);
+				live[i] = live.back();
+				live.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+		store.FlushDestroyed();
+	}
+	double ms = DX::Test::MillisecondsSince(start) / measuredFrames;
+	size_t allocations = s_allocations.load() - warmAllocations;
+
+	DX::ObjectPoolStats stats = pool.GetStats();
+	printf("%d missiles per second for %d s after a %d s warm up: %.4f ms/frame\n",
+		missilesPerSecond, measuredFrames / framesPerSecond, warmUpFrames / framesPerSecond, ms);
+	printf("pool: capacity %u, live %u, high water %u, %u acquires, %u releases, %u grows (%u after warm up), %u failed\n",
+		(unsigned)stats.capacity, (unsigned)stats.live, (unsigned)stats.highWater, (unsigned)stats.acquires, (unsigned)stats.releases,
+		(unsigned)stats.grows, (unsigned)(stats.grows - warmStats.grows), (unsigned)stats.failedAcquires);
+	printf("entity slots: %u after warm up, %u at the end\n", (unsigned)warmEntities, (unsigned)store.GetSlotCount());
+	printf("heap allocations after warm up: %u\n", (unsigned)allocations);
+
+	for (PooledMissile* missile : live)
+	{
+		pool.Release(missile);
+	}
+	store.FlushDestroyed();
+	return DX::Test::Result((stats.grows == warmStats.grows ? 0 : 1) + (allocations == 0 ? 0 : 1));
+}
@@ -0,0 +1,297 @@
+//
+// SceneQueryTest.cpp - Times the scene tree's builds and queries against a loop over every box
+//
+// Boxes are spread at about the density of the watermine grid, a tenth of them moving every frame.
+// The tree is built one box at a time and in bulk, then frustum, sphere, ray and nearest queries
+// from random spots are timed, and every one has to find what a loop over all the boxes finds.
+//
+
+#include "pch.h"
+#include "AabbTree.h"
+#include "Entities.h"
+#include "Meshlets.h"
+#include "TestSupport.h"
+
+#include <cmath>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+namespace
+{
+	//the game's scene tree margin
+	const float TreeMargin = 2.0f;
+
+	DX::Aabb BoxAround(const DX::Float3& center, float radius)
+	{
+		DX::Aabb box = {
+			{ center.x - radius, center.y - radius, center.z - radius },
+			{ center.x + radius, center.y + radius, center.z + radius } };
+		return box;
+	}
+
+	void Normalize(float v[3])
+	{
+		float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		for (int i = 0; i < 3; i++)
+		{
+			v[i] /= length;
+		}
+	}
+
+	void Cross(const float a[3], const float b[3], float out[3])
+	{
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	// The camera's view and projection, row vectors as Matrix::CreateLookAt and CreatePerspectiveFieldOfView
+	// build them: right handed, y up, a quarter turn field of view at 16:9 from 0.1 to 200.
+	void LookAtPerspective(const float eye[3], const float target[3], float viewProjection[16])
+	{
+		const float up[3] = { 0.0f, 1.0f, 0.0f };
+		float back[3] = { eye[0] - target[0], eye[1] - target[1], eye[2] - target[2] };
+		Normalize(back);
+		float right[3], upward[3];
+		Cross(up, back, right);
+		Normalize(right);
+		Cross(back, right, upward);
+		const float* axes[3] = { right, upward, back };
+		float view[16] = {};
+		for (int c = 0; c < 3; c++)
+		{
+			for (int r = 0; r < 3; r++)
+			{
+				view[r * 4 + c] = axes[c][r];
+			}
+			view[12 + c] = -(axes[c][0] * eye[0] + axes[c][1] * eye[1] + axes[c][2] * eye[2]);
+		}
+		view[15] = 1.0f;
+
+		const float fieldOfView = 0.785398163f, aspect = 16.0f / 9.0f, nearPlane = 0.1f, farPlane = 200.0f;
+		float height = 1.0f / std::tan(fieldOfView / 2.0f);
+		float range = farPlane / (nearPlane - farPlane);
+		float projection[16] = {
+			height / aspect, 0, 0, 0,
+			0, height, 0, 0,
+			0, 0, range, -1,
+			0, 0, range * nearPlane, 0 };
+
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				float sum = 0;
+				for (int k = 0; k < 4; k++)
+				{
+					sum += view[r * 4 + k] * projection[k * 4 + c];
+				}
+				viewProjection[r * 4 + c] = sum;
+			}
+		}
+	}
+
+	//the loop's tests, one box at a time
+	float DistanceSquared(const float point[3], const DX::Aabb& box)
+	{
+		float distance = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			float d = std::max(std::max(box.min[i] - point[i], point[i] - box.max[i]), 0.0f);
+			distance += d * d;
+		}
+		return distance;
+	}
+
+	bool RayHits(const float origin[3], const float direction[3], float maxDistance, const DX::Aabb& box)
+	{
+		float enter = 0, exit = maxDistance;
+		for (int i = 0; i < 3; i++)
+		{
+			if (direction[i] == 0)
+			{
+				if (origin[i] < box.min[i] || origin[i] > box.max[i])
+				{
+					return false;
+				}
+				continue;
+			}
+			float inverse = 1.0f / direction[i];
+			float t1 = (box.min[i] - origin[i]) * inverse;
+			float t2 = (box.max[i] - origin[i]) * inverse;
+			enter = std::max(enter, std::min(t1, t2));
+			exit = std::min(exit, std::max(t1, t2));
+		}
+		return enter <= exit;
+	}
+
+	bool InFrustum(const DX::Meshlets::Frustum& frustum, const DX::Aabb& box)
+	{
+		for (const auto& plane : frustum.planes)
+		{
+			float ahead = plane[3];
+			for (int i = 0; i < 3; i++)
+			{
+				ahead += plane[i] * (plane[i] >= 0 ? box.max[i] : box.min[i]);
+			}
+			if (ahead < 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	static const size_t counts[] = { 1000, 10000, 100000 };
+	const int queries = 200;
+	size_t errors = 0;
+	for (size_t count : counts)
+	{
+		std::mt19937 gen((unsigned)count);
+		float side = std::sqrt(float(count)) * 16.0f;
+		std::uniform_real_distribution<float> across(0.0f, side);
+		std::uniform_real_distribution<float> depth(-30.0f, 0.0f);
+		std::uniform_real_distribution<float> size(1.0f, 3.0f);
+		std::uniform_real_distribution<float> step(-3.0f, 3.0f);
+		std::vector<DX::Aabb> boxes(count);
+		std::vector<void*> owners(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			DX::Float3 center = { across(gen), depth(gen), across(gen) };
+			boxes[i] = BoxAround(center, size(gen));
+			owners[i] = reinterpret_cast<void*>(i);
+		}
+
+		DX::AabbTree incremental(TreeMargin);
+		std::vector<int32_t> proxies(count);
+		DX::Test::Clock::time_point start = DX::Test::Clock::now();
+		for (size_t i = 0; i < count; i++)
+		{
+			proxies[i] = incremental.CreateProxy(boxes[i], owners[i]);
+		}
+		double insertMs = DX::Test::MillisecondsSince(start);
+
+		DX::AabbTree tree(TreeMargin);
+		start = DX::Test::Clock::now();
+		tree.CreateProxies(boxes.data(), owners.data(), count, proxies.data());
+		double bulkMs = DX::Test::MillisecondsSince(start);
+		printf("%6u boxes: inserted one by one %8.3f ms, area ratio %.1f, height %d; bulk built %8.3f ms, area ratio %.1f, height %d\n",
+			(unsigned)count, insertMs, incremental.GetAreaRatio(), incremental.GetHeight(), bulkMs, tree.GetAreaRatio(), tree.GetHeight());
+
+		const int frames = 10;
+		size_t reinserted = 0;
+		start = DX::Test::Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			for (size_t i = (size_t)frame; i < count; i += 10)
+			{
+				float dx = step(gen), dz = step(gen);
+				boxes[i].min[0] += dx;
+				boxes[i].max[0] += dx;
+				boxes[i].min[2] += dz;
+				boxes[i].max[2] += dz;
+				reinserted += tree.MoveProxy(proxies[i], boxes[i]) ? 1 : 0;
+			}
+		}
+		double moveMs = DX::Test::MillisecondsSince(start) / frames;
+		if (!tree.Validate())
+		{
+			errors++;
+		}
+		printf("        moving a tenth: %8.4f ms/frame, %.0f%% reinserted, area ratio %.1f\n",
+			moveMs, 100.0 * reinserted / std::max<size_t>(count / 10 * frames, 1), tree.GetAreaRatio());
+
+		//frustum, sphere, ray and nearest queries from the same random spots, timed against the loop
+		double treeMs[4] = {}, loopMs[4] = {};
+		std::vector<int32_t> found;
+		std::vector<DX::AabbRayHit> hits;
+		std::vector<DX::AabbNearest> nearest;
+		std::vector<size_t> treeSet, loopSet;
+		std::vector<float> distances;
+		auto ownerOf = [&](int32_t proxy) { return reinterpret_cast<size_t>(tree.GetUserData(proxy)); };
+		for (int query = 0; query < queries; query++)
+		{
+			float point[3] = { across(gen), -10.0f, across(gen) };
+			float target[3] = { across(gen), -15.0f, across(gen) };
+			float viewProjection[16];
+			LookAtPerspective(point, target, viewProjection);
+			DX::Meshlets::Frustum frustum = DX::Meshlets::ExtractFrustum(viewProjection);
+			float ray[3] = { target[0] - point[0], target[1] - point[1], target[2] - point[2] };
+			Normalize(ray);
+			const float radius = 20.0f;
+			const size_t k = 8;
+
+			for (int kind = 0; kind < 4; kind++)
+			{
+				found.clear();
+				hits.clear();
+				nearest.clear();
+				start = DX::Test::Clock::now();
+				switch (kind)
+				{
+				case 0: tree.QueryFrustum(frustum, found); break;
+				case 1: tree.QuerySphere(point, radius, found); break;
+				case 2: tree.QueryRay(point, ray, 200.0f, hits); break;
+				default: tree.QueryNearest(point, k, nearest); break;
+				}
+				treeMs[kind] += DX::Test::MillisecondsSince(start);
+
+				loopSet.clear();
+				distances.clear();
+				start = DX::Test::Clock::now();
+				for (size_t i = 0; i < count; i++)
+				{
+					switch (kind)
+					{
+					case 0: if (InFrustum(frustum, boxes[i])) loopSet.push_back(i); break;
+					case 1: if (DistanceSquared(point, boxes[i]) <= radius * radius) loopSet.push_back(i); break;
+					case 2: if (RayHits(point, ray, 200.0f, boxes[i])) loopSet.push_back(i); break;
+					default: distances.push_back(DistanceSquared(point, boxes[i])); break;
+					}
+				}
+				if (kind == 3)
+				{
+					std::partial_sort(distances.begin(), distances.begin() + std::min(k, count), distances.end());
+				}
+				loopMs[kind] += DX::Test::MillisecondsSince(start);
+
+				treeSet.clear();
+				for (int32_t proxy : found)
+				{
+					treeSet.push_back(ownerOf(proxy));
+				}
+				for (const DX::AabbRayHit& hit : hits)
+				{
+					treeSet.push_back(ownerOf(hit.proxy));
+				}
+				std::sort(treeSet.begin(), treeSet.end());
+				if (kind < 3 && treeSet != loopSet)
+				{
+					errors++;
+				}
+				for (size_t i = 0; kind == 3 && i < std::min(k, count); i++)
+				{
+					if (i >= nearest.size() || nearest[i].distanceSquared != distances[i])
+					{
+						errors++;
+						break;
+					}
+				}
+			}
+		}
+
+		static const char* names[] = { "frustum", "sphere", "ray", "8 nearest" };
+		for (int kind = 0; kind < 4; kind++)
+		{
+			printf("        %-9s query: tree %8.4f ms, loop %8.4f ms (%.1fx)\n",
+				names[kind], treeMs[kind] / queries, loopMs[kind] / queries, treeMs[kind] > 0 ? loopMs[kind] / treeMs[kind] : 0.0);
+		}
+	}
+
+	printf("%u queries differ from the loop\n", (unsigned)errors);
+	return DX::Test::Result(errors);
+}
@@ -0,0 +1,103 @@
+//
+// SlotMapTest.cpp - Removes a random tenth of 100000 entities and checks what is left
+//
+// Times removal through the store's destroy queue against erasing from a list in an index loop,
+// the way Game::Update used to. Survivors have to keep their data, and removed handles have to
+// stay dead once their slots are reused.
+//
+
+#include "pch.h"
+#include "Entities.h"
+#include "TestSupport.h"
+
+#include <random>
+#include <vector>
+
+int main()
+{
+	const size_t count = 100000;
+	const size_t removed = count / 10;
+	DX::EntityStore store;
+	std::vector<DX::Entity> entities;
+	entities.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		DX::Entity entity = store.Create(DX::ComponentMotion);
+		store.GetMotion(entity).speed = float(i);
+		entities.push_back(entity);
+	}
+	DX::UpdateTransforms(store);
+
+	std::vector<size_t> order(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		order[i] = i;
+	}
+	std::mt19937 gen(1);
+	std::shuffle(order.begin(), order.end(), gen);
+	std::vector<bool> dead(count, false);
+	for (size_t i = 0; i < removed; i++)
+	{
+		dead[order[i]] = true;
+	}
+
+	DX::Test::Clock::time_point start = DX::Test::Clock::now();
+	for (size_t i = 0; i < count; i++)
+	{
+		if (dead[i])
+		{
+			store.DestroyLater(entities[i]);
+		}
+	}
+	store.FlushDestroyed();
+	double slotMapMs = DX::Test::MillisecondsSince(start);
+
+	std::vector<size_t> list(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		list[i] = i;
+	}
+	start = DX::Test::Clock::now();
+	for (size_t i = 0; i < list.size();)
+	{
+		if (dead[list[i]])
+		{
+			list.erase(list.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+	double eraseMs = DX::Test::MillisecondsSince(start);
+
+	//survivors keep their data, removed handles stay dead even once their slots are reused
+	size_t errors = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (dead[i] == store.IsAlive(entities[i]) || (!dead[i] && store.GetMotion(entities[i]).speed != float(i)))
+		{
+			errors++;
+		}
+	}
+	for (size_t i = 0; i < removed; i++)
+	{
+		store.Create(0);
+	}
+	for (size_t i = 0; i < removed; i++)
+	{
+		if (store.IsAlive(entities[order[i]]))
+		{
+			errors++;
+		}
+	}
+	if (store.GetSlotCount() != count || store.GetCount() != count || list.size() != count - removed)
+	{
+		errors++;
+	}
+
+	printf("removing %u of %u entities: slot map %.4f ms, erase in an index loop %.4f ms (%.1fx)\n",
+		(unsigned)removed, (unsigned)count, slotMapMs, eraseMs, slotMapMs > 0 ? eraseMs / slotMapMs : 0.0);
+	printf("%u errors, %u slots after refilling\n", (unsigned)errors, (unsigned)store.GetSlotCount());
+	return DX::Test::Result(errors);
+}
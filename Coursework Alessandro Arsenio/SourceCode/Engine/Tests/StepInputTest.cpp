@@ -0,0 +1,116 @@
+//
+// StepInputTest.cpp - Clicks at frame rate, fixed steps at their own, and counts what fires
+//
+// Frames run as many fixed steps as the clock gives them, often none at a high frame rate, and
+// StepInput hands each step the input gathered since the last. Every click has to fire once
+// whatever the frame and step rates, a restart tapped between steps has to reach one, and a long
+// stall has to drop whole clicks and leave the button where it is.
+//
+
+#include "pch.h"
+#include "Simulation.h"
+#include "TestSupport.h"
+
+#include <vector>
+
+namespace
+{
+	// Frames of a click pattern, a step wherever the step clock passes the frame clock. The button
+	// is down for pressFrames out of every period frames
+	size_t CountFired(int framesPerStep, int stepsPerFrame, int period, int pressFrames, int frames)
+	{
+		DX::StepInput stepInput;
+		DX::FireTrigger fireTrigger;
+		size_t fired = 0;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			InputCommands input = {};
+			input.mouseButton = (frame % period) < pressFrames;
+			stepInput.Gather(input);
+			int steps = frame % framesPerStep == framesPerStep - 1 ? stepsPerFrame : 0;
+			for (int step = 0; step < steps; step++)
+			{
+				fired += fireTrigger.Update(stepInput.Next().mouseButton) ? 1 : 0;
+			}
+		}
+
+		//let the queue drain on frames with the button up
+		InputCommands idle = {};
+		for (int step = 0; step < 64; step++)
+		{
+			stepInput.Gather(idle);
+			fired += fireTrigger.Update(stepInput.Next().mouseButton) ? 1 : 0;
+		}
+		return fired;
+	}
+}
+
+int main()
+{
+	size_t errors = 0;
+
+	//every click fires once, one step a frame, a step every few frames, and bursts of steps after idle frames,
+	//as long as the steps keep up with the button's changes, two a click; a human clicks far slower than 60 a second
+	static const int framesPerStep[] = { 1, 2, 3, 4, 8 };
+	static const int stepsPerFrame[] = { 1, 2, 5 };
+	static const int periods[] = { 2, 3, 5, 7 };
+	size_t runs = 0, wrong = 0;
+	for (int everyFrames : framesPerStep)
+	{
+		for (int steps : stepsPerFrame)
+		{
+			for (int period : periods)
+			{
+				if (steps * period < 2 * everyFrames)
+				{
+					continue;
+				}
+				for (int press = 1; press < period; press++)
+				{
+					const int frames = period * 50;
+					size_t fired = CountFired(everyFrames, steps, period, press, frames);
+					wrong += fired != size_t(frames / period) ? 1 : 0;
+					runs++;
+				}
+			}
+		}
+	}
+	printf("%u click patterns: %u fired the wrong number of times\n", (unsigned)runs, (unsigned)wrong);
+	errors += wrong;
+
+	//a restart tapped on a frame that runs no step still reaches the next step, once
+	{
+		DX::StepInput stepInput;
+		InputCommands input = {};
+		input.restart = true;
+		stepInput.Gather(input);
+		input.restart = false;
+		stepInput.Gather(input);
+		bool first = stepInput.Next().restart;
+		bool second = stepInput.Next().restart;
+		printf("restart tapped between steps: %s the next step, %s the one after\n", first ? "reached" : "missed", second ? "held for" : "released by");
+		errors += first && !second ? 0 : 1;
+	}
+
+	//a stall with far more clicks than the queue holds drops whole clicks, and the button ends up as it is now
+	{
+		DX::StepInput stepInput;
+		InputCommands input = {};
+		for (int frame = 0; frame < 1001; frame++)
+		{
+			input.mouseButton = frame % 2 == 0;
+			stepInput.Gather(input);
+		}
+		DX::FireTrigger fireTrigger;
+		size_t fired = 0;
+		bool button = false;
+		for (int step = 0; step < 64; step++)
+		{
+			button = stepInput.Next().mouseButton;
+			fired += fireTrigger.Update(button) ? 1 : 0;
+		}
+		printf("500 clicks and a press in one stall: %u fired, the button %s\n", (unsigned)fired, button ? "down" : "up");
+		errors += fired > 0 && fired <= 500 && button ? 0 : 1;
+	}
+	return DX::Test::Result(errors);
+}
@@ -0,0 +1,169 @@
+//
+// SweptCollisionTest.cpp - Fires missiles at tick rates from 10 to 240 Hz and checks what they hit
+//
+// Missiles fly over rolling terrain and a field of still watermines. Swept, every missile must end
+// on the same watermine or on the terrain at every rate; tested only where they are at the end of
+// each tick, as before, they pass through watermines and terrain at low rates, which is printed
+// for comparison.
+//
+
+#include "pch.h"
+#include "SweptCollision.h"
+#include "TestSupport.h"
+
+#include <cmath>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+namespace
+{
+	const float TwoPi = 6.283185307f;
+}
+
+int main()
+{
+	const int size = 256;
+	std::vector<float> heights(size * size);
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			heights[z * size + x] = -24.0f + 9.0f * std::sin(x * 0.07f) + 7.0f * std::cos(z * 0.05f + 1.0f) + 3.0f * std::sin((x + z) * 0.21f);
+		}
+	}
+	DX::HeightField field;
+	DX::Float3 origin = { 0, 0, 0 };
+	field.Set(heights.data(), size, size, 1.0f, origin);
+
+	std::mt19937 gen(41);
+	std::uniform_real_distribution<float> across(8.0f, float(size) - 8.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const float mineRadius = 2.0f, missileRadius = 2.0f, speed = 50.0f, lifetime = 5.0f;
+	std::vector<DX::Float3> mines;
+	while (mines.size() < 400)
+	{
+		DX::Float3 mine = { across(gen), 0, across(gen) };
+		float ground = 0;
+		field.GetHeight(mine.x, mine.z, ground);
+		if (ground < -4.0f - mineRadius)
+		{
+			mine.y = ground + mineRadius + unit(gen) * (-4.0f - mineRadius - ground);
+			mines.push_back(mine);
+		}
+	}
+	const size_t missileCount = 200;
+	std::vector<DX::Float3> starts(missileCount), directions(missileCount);
+	for (size_t i = 0; i < missileCount; i++)
+	{
+		float ground = 0;
+		starts[i].x = across(gen);
+		starts[i].z = across(gen);
+		field.GetHeight(starts[i].x, starts[i].z, ground);
+		starts[i].y = std::min(ground + 6.0f, -2.0f);
+		float yaw = unit(gen) * TwoPi, pitch = -0.3f * unit(gen);
+		directions[i].x = std::sin(yaw) * std::cos(pitch);
+		directions[i].y = std::sin(pitch);
+		directions[i].z = std::cos(yaw) * std::cos(pitch);
+	}
+	auto positionAt = [&](size_t missile, float time)
+	{
+		DX::Float3 position = { starts[missile].x + directions[missile].x * speed * time,
+			starts[missile].y + directions[missile].y * speed * time,
+			starts[missile].z + directions[missile].z * speed * time };
+		return position;
+	};
+
+	//what each missile ended on: a watermine, the terrain, or nothing
+	const int32_t nothing = -1, terrain = -2;
+	static const int rates[] = { 10, 20, 30, 60, 120, 144, 240 };
+	std::vector<int32_t> reference;
+	size_t differences = 0;
+	for (int swept = 1; swept >= 0; swept--)
+	{
+		for (int rate : rates)
+		{
+			std::vector<int32_t> outcomes(missileCount, nothing);
+			std::vector<bool> minesAlive(mines.size(), true);
+			std::vector<DX::SweptCollision::Hit> hits;
+			float step = 1.0f / rate;
+			DX::Test::Clock::time_point start = DX::Test::Clock::now();
+			for (int tick = 0; tick * step < lifetime; tick++)
+			{
+				hits.clear();
+				float begin = tick * step, end = std::min((tick + 1) * step, lifetime);
+				for (size_t m = 0; m < missileCount; m++)
+				{
+					if (outcomes[m] != nothing)
+					{
+						continue;
+					}
+					DX::Float3 from = positionAt(m, begin), to = positionAt(m, end);
+					DX::SweptCollision::Hit hit = { (uint32_t)m, DX::SweptCollision::Hit::NoTarget, 0 };
+					for (size_t w = 0; w < mines.size(); w++)
+					{
+						if (!minesAlive[w])
+						{
+							continue;
+						}
+						hit.target = (uint32_t)w;
+						bool touching = swept
+							? DX::SweptCollision::SegmentVsSphere(from, to, mines[w], mineRadius + missileRadius, hit.timeOfImpact)
+							: DX::SweptCollision::SegmentVsSphere(to, to, mines[w], mineRadius + missileRadius, hit.timeOfImpact);
+						if (touching)
+						{
+							hits.push_back(hit);
+						}
+					}
+					hit.target = DX::SweptCollision::Hit::NoTarget;
+					float ground = 0;
+					bool below = swept
+						? field.IntersectSegment(from, to, hit.timeOfImpact)
+						: field.GetHeight(to.x, to.z, ground) && to.y <= ground;
+					if (below)
+					{
+						hits.push_back(hit);
+					}
+				}
+
+				DX::SweptCollision::SortByTime(hits);
+				for (const DX::SweptCollision::Hit& hit : hits)
+				{
+					if (outcomes[hit.mover] != nothing || (hit.target != DX::SweptCollision::Hit::NoTarget && !minesAlive[hit.target]))
+					{
+						continue;
+					}
+					if (hit.target == DX::SweptCollision::Hit::NoTarget)
+					{
+						outcomes[hit.mover] = terrain;
+					}
+					else
+					{
+						outcomes[hit.mover] = (int32_t)hit.target;
+						minesAlive[hit.target] = false;
+					}
+				}
+			}
+			double ms = DX::Test::MillisecondsSince(start);
+
+			if (reference.empty())
+			{
+				reference = outcomes;
+			}
+			size_t differ = 0, mineHits = 0, terrainHits = 0;
+			for (size_t m = 0; m < missileCount; m++)
+			{
+				differ += outcomes[m] != reference[m] ? 1 : 0;
+				mineHits += outcomes[m] >= 0 ? 1 : 0;
+				terrainHits += outcomes[m] == terrain ? 1 : 0;
+			}
+			if (swept)
+			{
+				differences += differ;
+			}
+			printf("%s %3d Hz: %3u watermines hit, %3u missiles hit the terrain, %3u differ from swept at 10 Hz, %8.3f ms\n",
+				swept ? "swept   " : "discrete", rate, (unsigned)mineHits, (unsigned)terrainHits, (unsigned)differ, ms);
+		}
+	}
+	return DX::Test::Result(differences);
+}
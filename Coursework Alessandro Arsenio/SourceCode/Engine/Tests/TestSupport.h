@@ -0,0 +1,48 @@
+//
+// TestSupport.h - What the core's tests and benchmarks share
+//
+// Every test is its own executable built by CMakeLists.txt against EngineCore. It prints what it
+// measured to stdout and returns non-zero when a check failed, which is all ctest looks at. The
+// benchmarks print the same way and are run by hand.
+//
+
+#pragma once
+
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+namespace DX
+{
+	namespace Test
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		inline double MillisecondsSince(Clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+
+		// 0 (everything on the caller), then 1, 2, 4... workers up to and including most.
+		inline std::vector<unsigned int> WorkerCounts(unsigned int most)
+		{
+			std::vector<unsigned int> counts(1, 0);
+			for (unsigned int workers = 1; workers < most; workers *= 2)
+			{
+				counts.push_back(workers);
+			}
+			if (most != 0)
+			{
+				counts.push_back(most);
+			}
+			return counts;
+		}
+
+		// The exit code for a test: prints a summary line so a failure is visible in ctest's output.
+		inline int Result(size_t errors)
+		{
+			printf("%s\n", errors == 0 ? "passed" : "FAILED");
+			return errors == 0 ? 0 : 1;
+		}
+	}
+}
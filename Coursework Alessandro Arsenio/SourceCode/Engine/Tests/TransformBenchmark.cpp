@@ -0,0 +1,62 @@
+//
+// TransformBenchmark.cpp - Times the transform system with more and more of the entities moving
+//
+// Every fourth entity is a root with three children offset from it, like the camera and the
+// player. Moving a root also places its children, moving a child places only the child, and an
+// unmoved entity should cost next to nothing.
+//
+
+#include "pch.h"
+#include "Entities.h"
+#include "TestSupport.h"
+
+#include <vector>
+
+int main()
+{
+	static const size_t counts[] = { 10000, 100000 };
+	static const size_t changes[] = { 0, 10, 100, 1000, 10000, 100000 };
+	const int frames = 100;
+	for (size_t count : counts)
+	{
+		DX::EntityStore store;
+		std::vector<DX::Entity> entities;
+		entities.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			DX::Entity entity = store.Create(0);
+			DX::Float3 position = { float(i % 4) * 2, 0.0f, float(i / 4) * 2 };
+			store.SetPosition(entity, position);
+			if (i % 4 != 0)
+			{
+				store.SetParent(entity, entities[i - i % 4]);
+			}
+			entities.push_back(entity);
+		}
+		DX::UpdateTransforms(store);
+
+		for (size_t changed : changes)
+		{
+			if (changed > count)
+			{
+				continue;
+			}
+
+			//a different spread of entities each frame so nothing stays in the cache between frames
+			DX::Test::Clock::time_point start = DX::Test::Clock::now();
+			for (int frame = 0; frame < frames; frame++)
+			{
+				for (size_t i = 0; i < changed; i++)
+				{
+					DX::Entity entity = entities[(i * 7919 + frame * 104729) % count];
+					DX::Float3 rotation = { 0.0f, float(frame), 0.0f };
+					store.SetRotation(entity, rotation);
+				}
+				DX::UpdateTransforms(store);
+			}
+			double ms = DX::Test::MillisecondsSince(start) / frames;
+			printf("%6u entities, %6u changed per frame: %8.4f ms/frame\n", (unsigned)count, (unsigned)changed, ms);
+		}
+	}
+	return 0;
+}
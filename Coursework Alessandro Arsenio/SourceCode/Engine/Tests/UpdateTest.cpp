@@ -0,0 +1,120 @@
+//
+// UpdateTest.cpp - Times the entity update over 50k entities and checks it against the serial one
+//
+// Bobbing and spinning watermines, missiles flying until their lifetimes end, and movers with a
+// follower each, like the player and the camera. The update runs with more and more workers, and
+// every worker count has to end in exactly the state the serial update reaches. Prints how the
+// last frame split the transforms into hierarchies, and checks the store refuses a parent that
+// would make a cycle.
+//
+
+#include "pch.h"
+#include "Entities.h"
+#include "JobSystem.h"
+#include "TestSupport.h"
+
+#include <random>
+#include <string.h>
+
+int main()
+{
+	const size_t count = 50000;
+	const float deltaTime = 1.0f / 60.0f;
+	const int frames = 120;
+	auto build = [&](DX::EntityStore& store)
+	{
+		std::mt19937 gen(43);
+		std::uniform_real_distribution<float> across(0.0f, 1000.0f);
+		std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+		for (size_t i = 0; i < count; i++)
+		{
+			DX::Float3 position = { across(gen), -10.0f, across(gen) };
+			DX::Float3 rotation = { 0.0f, angle(gen), 0.0f };
+			if (i % 50 < 40)
+			{
+				DX::Entity mine = store.Create(DX::ComponentMotion | DX::ComponentCollider | DX::TagWatermine);
+				store.SetPosition(mine, position);
+				DX::Motion& motion = store.GetMotion(mine);
+				motion.bobCenter = position.y;
+				motion.bobAmplitude = 1.0f;
+				motion.bobRate = 90.0f;
+				motion.bobPhase = float(i % 7);
+				motion.spinRate = 45.0f;
+			}
+			else if (i % 50 < 48)
+			{
+				DX::Entity missile = store.Create(DX::ComponentMotion | DX::ComponentCollider | DX::ComponentLifetime | DX::TagMissile);
+				store.SetPosition(missile, position);
+				store.SetRotation(missile, rotation);
+				store.GetMotion(missile).speed = 50.0f;
+				store.GetLifetime(missile).maxAge = 0.5f + float(i % 100) / 50.0f;
+			}
+			else
+			{
+				DX::Entity mover = store.Create(DX::ComponentMotion | DX::ComponentCollider);
+				store.SetPosition(mover, position);
+				store.SetRotation(mover, rotation);
+				store.GetMotion(mover).speed = 10.0f;
+				DX::Entity follower = store.Create(0);
+				DX::Float3 offset = { 0.0f, 2.0f, -6.0f };
+				store.SetPosition(follower, offset);
+				store.SetParent(follower, mover);
+				i++;
+			}
+		}
+		DX::UpdateTransforms(store);
+	};
+
+	DX::EntityStore serial;
+	build(serial);
+	DX::Test::Clock::time_point start = DX::Test::Clock::now();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		DX::UpdateEntities(serial, deltaTime);
+	}
+	double serialMs = DX::Test::MillisecondsSince(start) / frames;
+	printf("%u entities, serial update: %8.4f ms/frame\n", (unsigned)serial.GetCount(), serialMs);
+
+	size_t differences = 0;
+	for (unsigned int workers : DX::Test::WorkerCounts(DX::JobSystem::DefaultWorkerCount()))
+	{
+		DX::JobSystem jobs(workers);
+		DX::EntityStore store;
+		build(store);
+		DX::TransformUpdateStats stats = {};
+		start = DX::Test::Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			stats = DX::UpdateEntities(store, deltaTime, jobs);
+		}
+		double ms = DX::Test::MillisecondsSince(start) / frames;
+
+		size_t differ = 0;
+		for (size_t i = 0; i < store.GetCount(); i++)
+		{
+			const DX::Transform& a = store.transforms[i];
+			const DX::Transform& b = serial.transforms[i];
+			bool same = memcmp(a.world, b.world, sizeof(a.world)) == 0
+				&& memcmp(&a.position, &b.position, sizeof(a.position)) == 0
+				&& memcmp(&a.rotation, &b.rotation, sizeof(a.rotation)) == 0
+				&& memcmp(&store.colliders[i].center, &serial.colliders[i].center, sizeof(DX::Float3)) == 0
+				&& store.markedForDelete[i] == serial.markedForDelete[i]
+				&& store.transformDirty[i] == serial.transformDirty[i];
+			differ += same ? 0 : 1;
+		}
+		differences += differ;
+		printf("%2u workers: %8.4f ms/frame, %.2fx the serial update, %u entities differ\n",
+			workers, ms, ms > 0 ? serialMs / ms : 0.0, (unsigned)differ);
+		printf("            last frame placed %u in %u hierarchies, largest %u, critical path %u\n",
+			(unsigned)stats.placed, (unsigned)stats.hierarchies, (unsigned)stats.largestHierarchy, (unsigned)stats.criticalPath);
+	}
+
+	//a parent below the child would make a cycle, the store has to refuse it and keep the hierarchy as it was
+	DX::Entity top = serial.Create(0);
+	DX::Entity middle = serial.Create(0);
+	DX::Entity bottom = serial.Create(0);
+	bool linked = serial.SetParent(middle, top) && serial.SetParent(bottom, middle);
+	bool refused = !serial.SetParent(top, bottom) && !serial.SetParent(top, top) && serial.GetTransform(top).parent == DX::InvalidEntity;
+	printf("cycles: %s\n", linked && refused ? "refused" : "NOT REFUSED");
+	return DX::Test::Result(differences + (linked && refused ? 0 : 1));
+}
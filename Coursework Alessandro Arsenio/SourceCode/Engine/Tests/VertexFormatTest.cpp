@@ -0,0 +1,166 @@
+//
+// VertexFormatTest.cpp - Checks the half float conversions and each vertex format's round trip error
+//
+// Every one of the 65536 halves has to decode to the value its bits stand for and encode back to
+// the same bits, NaNs aside. Floats spread over the whole range have to round to the nearest half,
+// ties to even, as the GPU's conversion does. Then a synthetic mesh away from the origin goes through
+// every format, and each has to stay within the error its bits allow.
+//
+
+#include "pch.h"
+#include "VertexFormat.h"
+#include "TestSupport.h"
+
+#include <cmath>
+#include <string.h>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+	bool IsHalfNaN(uint16_t half)
+	{
+		return (half & 0x7c00) == 0x7c00 && (half & 0x03ff) != 0;
+	}
+
+	// What the bits of a half stand for, from the definition rather than from the conversion under test.
+	double HalfValue(uint16_t half)
+	{
+		int exponent = (half >> 10) & 0x1f;
+		int mantissa = half & 0x03ff;
+		double value = exponent == 0 ? std::ldexp(double(mantissa), -24)
+			: exponent == 0x1f ? HUGE_VAL
+			: std::ldexp(1.0 + mantissa / 1024.0, exponent - 15);
+		return (half & 0x8000) ? -value : value;
+	}
+
+	// The nearest half to a float, ties to the even one. Past the largest half, 65504, a float rounds to
+	// infinity from 65520 on, halfway to where the next half would be.
+	uint16_t NearestHalf(float value)
+	{
+		uint16_t sign = std::signbit(value) ? 0x8000 : 0;
+		double magnitude = std::fabs(double(value));
+		if (magnitude >= 65520.0)
+		{
+			return sign | 0x7c00;
+		}
+		//halves below infinity are ordered like their bits, find the last at or below the value
+		uint16_t lo = 0, hi = 0x7bff;
+		while (lo < hi)
+		{
+			uint16_t mid = uint16_t((lo + hi + 1) / 2);
+			if (HalfValue(mid) <= magnitude)
+			{
+				lo = mid;
+			}
+			else
+			{
+				hi = uint16_t(mid - 1);
+			}
+		}
+		double below = HalfValue(lo);
+		double above = lo == 0x7bff ? 65536.0 : HalfValue(uint16_t(lo + 1));
+		double toBelow = magnitude - below, toAbove = above - magnitude;
+		bool up = toAbove < toBelow || (toAbove == toBelow && (lo & 1) != 0);
+		return sign | uint16_t(up ? lo + 1 : lo);
+	}
+
+	// A wavy band far from the origin, so positions are relative to their bounding box, with texture
+	// coordinates up to 4 and normals in every direction.
+	std::vector<MeshSimplifier::Vertex> BuildMesh()
+	{
+		std::vector<MeshSimplifier::Vertex> vertices;
+		for (int i = 0; i < 1000; i++)
+		{
+			float a = float(i) * 0.1f;
+			float nx = std::cos(a) * std::cos(a * 0.37f), ny = std::sin(a) * std::cos(a * 0.37f), nz = std::sin(a * 0.37f);
+			MeshSimplifier::Vertex vertex = {
+				{ 100.0f + 50.0f * std::cos(a), 20.0f * std::sin(a * 0.3f), -30.0f + float(i) * 0.01f },
+				{ nx, ny, nz },
+				{ float(i) / 1000.0f * 4.0f, 0.5f } };
+			vertices.push_back(vertex);
+		}
+		return vertices;
+	}
+}
+
+int main()
+{
+	size_t errors = 0;
+
+	//every half: decoded to what its bits mean, and encoded back to the same bits
+	{
+		size_t misdecoded = 0, misencoded = 0;
+		for (uint32_t bits = 0; bits < 0x10000; bits++)
+		{
+			uint16_t half = uint16_t(bits);
+			float value = HalfToFloat(half);
+			if (IsHalfNaN(half))
+			{
+				misdecoded += std::isnan(value) ? 0 : 1;
+				misencoded += IsHalfNaN(FloatToHalf(value)) ? 0 : 1;
+				continue;
+			}
+			misdecoded += double(value) != HalfValue(half) ? 1 : 0;
+			misencoded += FloatToHalf(value) != half ? 1 : 0;
+		}
+		printf("65536 halves: %u decoded wrong, %u not encoded back to their bits\n", (unsigned)misdecoded, (unsigned)misencoded);
+		errors += misdecoded + misencoded;
+	}
+
+	//floats over the whole range, subnormals, overflow and exact ties included, rounded to the nearest half
+	{
+		size_t samples = 0, misrounded = 0;
+		for (uint32_t i = 0; i < 200000; i++)
+		{
+			uint32_t bits = i * 21474u + 12345u;
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			if (std::isnan(value))
+			{
+				continue;
+			}
+			misrounded += FloatToHalf(value) != NearestHalf(value) ? 1 : 0;
+			samples++;
+		}
+		//halfway between two halves: 1 + 1/2048 goes down to even 1, 1 + 3/2048 up to even 1 + 2/1024
+		static const float ties[] = { 1.0f + 1.0f / 2048.0f, 1.0f + 3.0f / 2048.0f, 65519.0f, 65520.0f, 0.5f * 5.9604645e-8f };
+		for (float value : ties)
+		{
+			misrounded += FloatToHalf(value) != NearestHalf(value) ? 1 : 0;
+			misrounded += FloatToHalf(-value) != NearestHalf(-value) ? 1 : 0;
+			samples += 2;
+		}
+		printf("%u floats: %u not rounded to the nearest half\n", (unsigned)samples, (unsigned)misrounded);
+		errors += misrounded;
+	}
+
+	//each format within what its bits allow: halves keep 11 significant bits, snorm16 steps 1/32767 of the
+	//bounding box, snorm8 normals 1/127 a component
+	{
+		std::vector<MeshSimplifier::Vertex> vertices = BuildMesh();
+		std::vector<uint8_t> encoded;
+		float scale = EncodeVertices(VertexFormatQuantized, vertices.data(), vertices.size(), encoded).scale;
+		const float maxTexcoord = 4.0f;
+		const float snorm8Degrees = 0.5f;
+		const float acosDegrees = 0.05f;		//acos of a float cosine one rounding below 1 is already 0.02 degrees
+		struct Bound { VertexFormat format; size_t stride; float position; float normalDegrees; float texcoord; };
+		const Bound bounds[] = {
+			{ VertexFormatFull, 32, 0.0f, acosDegrees, 0.0f },
+			{ VertexFormatHalf, 16, scale * std::ldexp(1.0f, -11), snorm8Degrees, maxTexcoord * std::ldexp(1.0f, -11) },
+			{ VertexFormatQuantized, 16, scale * std::ldexp(1.0f, -15), snorm8Degrees, maxTexcoord * std::ldexp(1.0f, -11) },
+		};
+		for (const Bound& bound : bounds)
+		{
+			VertexRoundTripError error = MeasureRoundTrip(bound.format, vertices.data(), vertices.size());
+			bool ok = GetVertexStride(bound.format) == bound.stride && error.position <= bound.position
+				&& error.normalDegrees <= bound.normalDegrees && error.texcoord <= bound.texcoord;
+			printf("%-9ls %2u bytes: position %.6f (at most %.6f), normal %.4f degrees (at most %.2f), texcoord %.6f (at most %.6f) %s\n",
+				GetVertexFormatName(bound.format), (unsigned)GetVertexStride(bound.format), error.position, bound.position,
+				error.normalDegrees, bound.normalDegrees, error.texcoord, bound.texcoord, ok ? "ok" : "WRONG");
+			errors += ok ? 0 : 1;
+		}
+	}
+	return DX::Test::Result(errors);
+}
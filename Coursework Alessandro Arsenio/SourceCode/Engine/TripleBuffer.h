@@ -0,0 +1,66 @@
+//
+// TripleBuffer.h - Lock-free hand-off of whole frames from one thread to another
+//
+// One thread writes frames and another reads them. Each owns one of three buffers, and the
+// third holds the newest finished frame. Publishing swaps the writer's buffer with that one and
+// acquiring swaps the reader's, with a single atomic exchange each, so neither side ever waits
+// for the other and the reader always sees a whole frame. The reader skips frames when the
+// writer is faster; a frame that was not republished is read again.
+//
+// Only one thread may write and only one may read. Buffers are reused, so a frame type with
+// vectors keeps their capacity from frame to frame.
+//
+
+#pragma once
+
+#include <atomic>
+
+namespace DX
+{
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer() :
+			m_write(0),
+			m_ready(1),
+			m_read(2)
+		{
+		}
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		// The buffer the writer fills. It holds whatever frame was in it three publishes ago.
+		T& GetWriteBuffer()					{ return m_buffers[m_write]; }
+
+		// Makes the write buffer the newest frame and hands the writer another.
+		void Publish()
+		{
+			m_write = m_ready.exchange(m_write | NewFrame, std::memory_order_acq_rel) & IndexMask;
+		}
+
+		// Takes the newest frame for reading, false when nothing was published since the last call.
+		bool Acquire()
+		{
+			if ((m_ready.load(std::memory_order_relaxed) & NewFrame) == 0)
+			{
+				return false;
+			}
+			m_read = m_ready.exchange(m_read, std::memory_order_acq_rel) & IndexMask;
+			return true;
+		}
+
+		// The frame last acquired, a default constructed T before the first.
+		const T& GetReadBuffer() const		{ return m_buffers[m_read]; }
+
+	private:
+		static const unsigned int IndexMask = 3;
+		static const unsigned int NewFrame = 4;		//set in m_ready by Publish, cleared by Acquire
+
+		T							m_buffers[3];
+		unsigned int				m_write;		//only the writer's
+		std::atomic<unsigned int>	m_ready;
+		unsigned int				m_read;			//only the reader's
+	};
+}
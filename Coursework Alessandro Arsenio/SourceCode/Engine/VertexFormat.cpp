@@ -0,0 +1,348 @@
+#include "pch.h"
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+using namespace DX;
+using DX::MeshSimplifier::Vertex;
+
+namespace
+{
+	//matches ModelClass::VertexType
+	struct FullVertex
+	{
+		float position[3];
+		float texcoord[2];
+		float normal[3];
+	};
+
+	struct HalfVertex
+	{
+		uint16_t position[4];
+		uint16_t texcoord[2];
+		int8_t normal[4];
+	};
+
+	struct QuantizedVertex
+	{
+		int16_t position[4];
+		uint16_t texcoord[2];
+		int8_t normal[4];
+	};
+
+	static_assert(sizeof(FullVertex) == 32, "full vertex must stay 32 bytes");
+	static_assert(sizeof(HalfVertex) == 16, "half vertex must stay 16 bytes");
+	static_assert(sizeof(QuantizedVertex) == 16, "quantized vertex must stay 16 bytes");
+
+	//D3D snorm conversion: round to nearest, and -1 has two encodings so decoding clamps
+	int16_t ToSnorm16(float value)
+	{
+		value = std::min(std::max(value, -1.0f), 1.0f);
+		return (int16_t)std::lround(value * 32767.0f);
+	}
+
+	float FromSnorm16(int16_t value)
+	{
+		return std::max(value / 32767.0f, -1.0f);
+	}
+
+	int8_t ToSnorm8(float value)
+	{
+		value = std::min(std::max(value, -1.0f), 1.0f);
+		return (int8_t)std::lround(value * 127.0f);
+	}
+
+	float FromSnorm8(int8_t value)
+	{
+		return std::max(value / 127.0f, -1.0f);
+	}
+
+	void Normalize(float v[3])
+	{
+		float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		if (length > 0)
+		{
+			v[0] /= length;
+			v[1] /= length;
+			v[2] /= length;
+		}
+	}
+
+	VertexQuantization ComputeQuantization(const Vertex* vertices, size_t count)
+	{
+		VertexQuantization quantization = { { 0, 0, 0 }, 1.0f };
+		if (count == 0)
+		{
+			return quantization;
+		}
+
+		float lo[3], hi[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			lo[axis] = hi[axis] = vertices[0].position[axis];
+		}
+		for (size_t v = 1; v < count; v++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				lo[axis] = std::min(lo[axis], vertices[v].position[axis]);
+				hi[axis] = std::max(hi[axis], vertices[v].position[axis]);
+			}
+		}
+
+		float extent = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			quantization.offset[axis] = (lo[axis] + hi[axis]) * 0.5f;
+			extent = std::max(extent, (hi[axis] - lo[axis]) * 0.5f);
+		}
+		quantization.scale = extent > 0 ? extent : 1.0f;
+		return quantization;
+	}
+
+	template<typename T>
+	T* Allocate(std::vector<uint8_t>& encoded, size_t count)
+	{
+		encoded.assign(count * sizeof(T), 0);
+		return reinterpret_cast<T*>(encoded.data());
+	}
+}
+
+size_t DX::GetVertexStride(VertexFormat format)
+{
+	switch (format)
+	{
+	case VertexFormatHalf:		return sizeof(HalfVertex);
+	case VertexFormatQuantized:	return sizeof(QuantizedVertex);
+	default:					return sizeof(FullVertex);
+	}
+}
+
+const wchar_t* DX::GetVertexFormatName(VertexFormat format)
+{
+	switch (format)
+	{
+	case VertexFormatHalf:		return L"half";
+	case VertexFormatQuantized:	return L"quantized";
+	default:					return L"full";
+	}
+}
+
+VertexQuantization DX::EncodeVertices(VertexFormat format, const Vertex* vertices, size_t count, std::vector<uint8_t>& encoded)
+{
+	if (format == VertexFormatFull)
+	{
+		FullVertex* out = Allocate<FullVertex>(encoded, count);
+		for (size_t v = 0; v < count; v++)
+		{
+			memcpy(out[v].position, vertices[v].position, sizeof(out[v].position));
+			memcpy(out[v].texcoord, vertices[v].texcoord, sizeof(out[v].texcoord));
+			memcpy(out[v].normal, vertices[v].normal, sizeof(out[v].normal));
+		}
+		VertexQuantization identity = { { 0, 0, 0 }, 1.0f };
+		return identity;
+	}
+
+	VertexQuantization quantization = ComputeQuantization(vertices, count);
+	float inverseScale = 1.0f / quantization.scale;
+
+	if (format == VertexFormatHalf)
+	{
+		HalfVertex* out = Allocate<HalfVertex>(encoded, count);
+		for (size_t v = 0; v < count; v++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				out[v].position[axis] = FloatToHalf((vertices[v].position[axis] - quantization.offset[axis]) * inverseScale);
+				out[v].normal[axis] = ToSnorm8(vertices[v].normal[axis]);
+			}
+			out[v].position[3] = FloatToHalf(1.0f);
+			out[v].texcoord[0] = FloatToHalf(vertices[v].texcoord[0]);
+			out[v].texcoord[1] = FloatToHalf(vertices[v].texcoord[1]);
+		}
+	}
+	else
+	{
+		QuantizedVertex* out = Allocate<QuantizedVertex>(encoded, count);
+		for (size_t v = 0; v < count; v++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				out[v].position[axis] = ToSnorm16((vertices[v].position[axis] - quantization.offset[axis]) * inverseScale);
+				out[v].normal[axis] = ToSnorm8(vertices[v].normal[axis]);
+			}
+			out[v].position[3] = 32767;
+			out[v].texcoord[0] = FloatToHalf(vertices[v].texcoord[0]);
+			out[v].texcoord[1] = FloatToHalf(vertices[v].texcoord[1]);
+		}
+	}
+	return quantization;
+}
+
+void DX::DecodeVertices(VertexFormat format, const uint8_t* encoded, size_t count, const VertexQuantization& quantization, std::vector<Vertex>& vertices)
+{
+	vertices.resize(count);
+	for (size_t v = 0; v < count; v++)
+	{
+		Vertex& out = vertices[v];
+		if (format == VertexFormatFull)
+		{
+			const FullVertex& in = reinterpret_cast<const FullVertex*>(encoded)[v];
+			memcpy(out.position, in.position, sizeof(out.position));
+			memcpy(out.texcoord, in.texcoord, sizeof(out.texcoord));
+			memcpy(out.normal, in.normal, sizeof(out.normal));
+			continue;
+		}
+
+		float position[3];
+		const uint16_t* texcoord;
+		const int8_t* normal;
+		if (format == VertexFormatHalf)
+		{
+			const HalfVertex& in = reinterpret_cast<const HalfVertex*>(encoded)[v];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				position[axis] = HalfToFloat(in.position[axis]);
+			}
+			texcoord = in.texcoord;
+			normal = in.normal;
+		}
+		else
+		{
+			const QuantizedVertex& in = reinterpret_cast<const QuantizedVertex*>(encoded)[v];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				position[axis] = FromSnorm16(in.position[axis]);
+			}
+			texcoord = in.texcoord;
+			normal = in.normal;
+		}
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			out.position[axis] = position[axis] * quantization.scale + quantization.offset[axis];
+			out.normal[axis] = FromSnorm8(normal[axis]);
+		}
+		//the vertex shaders renormalize after the world transform
+		Normalize(out.normal);
+		out.texcoord[0] = HalfToFloat(texcoord[0]);
+		out.texcoord[1] = HalfToFloat(texcoord[1]);
+	}
+}
+
+VertexRoundTripError DX::MeasureRoundTrip(VertexFormat format, const Vertex* vertices, size_t count)
+{
+	std::vector<uint8_t> encoded;
+	VertexQuantization quantization = EncodeVertices(format, vertices, count, encoded);
+	std::vector<Vertex> decoded;
+	DecodeVertices(format, encoded.data(), count, quantization, decoded);
+
+	VertexRoundTripError error = { 0, 0, 0 };
+	for (size_t v = 0; v < count; v++)
+	{
+		const Vertex& a = vertices[v];
+		const Vertex& b = decoded[v];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			error.position = std::max(error.position, std::fabs(a.position[axis] - b.position[axis]));
+		}
+		for (int axis = 0; axis < 2; axis++)
+		{
+			error.texcoord = std::max(error.texcoord, std::fabs(a.texcoord[axis] - b.texcoord[axis]));
+		}
+
+		//compare directions only, the source normals are not always unit length
+		float normal[3] = { a.normal[0], a.normal[1], a.normal[2] };
+		Normalize(normal);
+		float cosine = normal[0] * b.normal[0] + normal[1] * b.normal[1] + normal[2] * b.normal[2];
+		cosine = std::min(std::max(cosine, -1.0f), 1.0f);
+		error.normalDegrees = std::max(error.normalDegrees, std::acos(cosine) * 57.2957795f);
+	}
+	return error;
+}
+
+uint16_t DX::FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	//nan stays nan, inf and anything too large saturate to inf
+	if (((bits >> 23) & 0xff) == 0xff)
+	{
+		return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	}
+	if (exponent >= 31)
+	{
+		return (uint16_t)(sign | 0x7c00);
+	}
+
+	if (exponent <= 0)
+	{
+		//denormal or zero; shift in the implicit bit and round to nearest even
+		if (exponent < -10)
+		{
+			return (uint16_t)sign;
+		}
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t midpoint = 1u << (shift - 1);
+		if (remainder > midpoint || (remainder == midpoint && (half & 1)))
+		{
+			half++;
+		}
+		return (uint16_t)(sign | half);
+	}
+
+	uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+	{
+		//a carry out of the mantissa correctly bumps the exponent, up to inf
+		half++;
+	}
+	return (uint16_t)(sign | half);
+}
+
+float DX::HalfToFloat(uint16_t value)
+{
+	uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+
+	uint32_t bits;
+	if (exponent == 0x1f)
+	{
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else if (exponent != 0)
+	{
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+	else if (mantissa == 0)
+	{
+		bits = sign;
+	}
+	else
+	{
+		//denormal, normalize it for the wider exponent
+		exponent = 127 - 15 + 1;
+		while (!(mantissa & 0x400))
+		{
+			mantissa <<= 1;
+			exponent--;
+		}
+		bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
@@ -0,0 +1,56 @@
+//
+// VertexFormat.h - Vertex buffer formats for ModelClass meshes and their CPU encoders
+//
+// Every format keeps the position / texcoord / normal order the vertex shaders read, and only
+// uses DXGI formats the input assembler expands back to floats, so the same shaders draw all
+// of them. The compact formats store positions relative to the mesh's bounding box; the
+// VertexQuantization that undoes this is folded into the world matrix when drawing.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "MeshSimplifier.h"
+
+namespace DX
+{
+	enum VertexFormat
+	{
+		VertexFormatFull,		//32 bytes: float3 position, float2 texcoord, float3 normal
+		VertexFormatHalf,		//16 bytes: half4 position, half2 texcoord, snorm8x4 normal
+		VertexFormatQuantized,	//16 bytes: snorm16x4 position, half2 texcoord, snorm8x4 normal
+		VertexFormatCount
+	};
+
+	// Maps encoded positions back to model space: model = encoded * scale + offset.
+	// The scale is the same on every axis so normals only need renormalizing.
+	struct VertexQuantization
+	{
+		float offset[3];
+		float scale;
+	};
+
+	// Largest differences seen when decoding what was encoded.
+	struct VertexRoundTripError
+	{
+		float position;		//model space units
+		float normalDegrees;
+		float texcoord;
+	};
+
+	size_t GetVertexStride(VertexFormat format);
+	const wchar_t* GetVertexFormatName(VertexFormat format);
+
+	// Packs the vertices into a vertex buffer image, returning the transform that unpacks them.
+	VertexQuantization EncodeVertices(VertexFormat format, const MeshSimplifier::Vertex* vertices, size_t count, std::vector<uint8_t>& encoded);
+
+	void DecodeVertices(VertexFormat format, const uint8_t* encoded, size_t count, const VertexQuantization& quantization, std::vector<MeshSimplifier::Vertex>& vertices);
+
+	VertexRoundTripError MeasureRoundTrip(VertexFormat format, const MeshSimplifier::Vertex* vertices, size_t count);
+
+	uint16_t FloatToHalf(float value);
+	float HalfToFloat(uint16_t value);
+}
@@ -11,7 +11,7 @@ WaterShader::~WaterShader()
 {
 }
 
-bool WaterShader::InitStandard(ID3D11Device* device, WCHAR* vsFilename, WCHAR* psFilename, WCHAR* gsFilename)
+bool WaterShader::InitStandard(ID3D11Device* device, const WCHAR* vsFilename, const WCHAR* psFilename, const WCHAR* gsFilename)
 {
 	D3D11_BUFFER_DESC	matrixBufferDesc;
 	D3D11_SAMPLER_DESC	samplerDesc;
@@ -19,7 +19,7 @@ bool WaterShader::InitStandard(ID3D11Device* device, WCHAR* vsFilename, WCHAR* p
 	D3D11_BUFFER_DESC	cameraBufferDesc;
 
 	//LOAD SHADER:	VERTEX
-	auto vertexShaderBuffer = DX::ReadData(vsFilename);
+	auto vertexShaderBuffer = DX::MapData(vsFilename);
 	HRESULT result = device->CreateVertexShader(vertexShaderBuffer.data(), vertexShaderBuffer.size(), NULL, &m_vertexShader);
 	if (result != S_OK)
 	{
@@ -55,7 +55,7 @@ bool WaterShader::InitStandard(ID3D11Device* device, WCHAR* vsFilename, WCHAR* p
 	};
 
 	UINT stream = (UINT)0;
-	auto geometryShaderBuffer = DX::ReadData(gsFilename);
+	auto geometryShaderBuffer = DX::MapData(gsFilename);
 	result = device->CreateGeometryShaderWithStreamOutput(geometryShaderBuffer.data(), geometryShaderBuffer.size(), decl,  //so declaration
 		(UINT)3, //numentries
 		//ARRAYSIZE(decl), //numentries
@@ -73,7 +73,7 @@ bool WaterShader::InitStandard(ID3D11Device* device, WCHAR* vsFilename, WCHAR* p
 	}
 
 	//LOAD SHADER:	PIXEL
-	auto pixelShaderBuffer = DX::ReadData(psFilename);
+	auto pixelShaderBuffer = DX::MapData(psFilename);
 	result = device->CreatePixelShader(pixelShaderBuffer.data(), pixelShaderBuffer.size(), NULL, &m_pixelShader);
 	if (result != S_OK)
 	{
@@ -13,7 +13,7 @@ public:
 
 	//we could extend this to load in only a vertex shader, only a pixel shader etc.  or specialised init for Geometry or domain shader. 
 	//All the methods here simply create new versions corresponding to your needs
-	bool InitStandard(ID3D11Device* device, WCHAR* vsFilename, WCHAR* psFilename, WCHAR* gsFilename);		//Loads the Vert / pixel Shader pair
+	bool InitStandard(ID3D11Device* device, const WCHAR* vsFilename, const WCHAR* psFilename, const WCHAR* gsFilename);		//Loads the Vert / pixel Shader pair
 	bool SetWaterShaderParameters(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix* world, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight1, ID3D11ShaderResourceView* texture1, float time);
 	bool SetWaterReflectionShaderParameters(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix* world, DirectX::SimpleMath::Matrix* view, DirectX::SimpleMath::Matrix* projection, Light* sceneLight1, ID3D11ShaderResourceView* texture, ID3D11ShaderResourceView* EnviromentTexture, DirectX::SimpleMath::Vector3* position, float time);
 	void EnableShader(ID3D11DeviceContext* context);
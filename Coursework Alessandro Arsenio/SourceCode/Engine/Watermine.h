@@ -4,11 +4,8 @@
 class Watermine: public GameObject
 {
 public:
-	void Update();
+	//bobs up and down and spins, moved by the entity systems
+	Watermine();
 	void setLocalPosition(DirectX::SimpleMath::Vector3 newPosition);
-
-public:
-	float lifeTime = 0;
-	SimpleMath::Vector3 startingPosition;
 };
 
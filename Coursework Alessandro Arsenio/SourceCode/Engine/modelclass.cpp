@@ -6,10 +6,38 @@
 
 using namespace DirectX;
 
+namespace
+{
+	//the rest of an obj / mtl line without surrounding blanks (names may contain spaces)
+	std::string TrimName(const char* text)
+	{
+		std::string name(text);
+		size_t first = name.find_first_not_of(" \t\r");
+		size_t last = name.find_last_not_of(" \t\r");
+		return first == std::string::npos ? std::string() : name.substr(first, last - first + 1);
+	}
+
+	//exporters write map_Kd as the folder they were in or as a path on the artist's machine, neither of which
+	//is shipped; those materials keep the texture the game gives the model
+	bool IsShippedMapName(const std::string& map)
+	{
+		if (map.empty() || map == "." || map == ".." || map.back() == '/' || map.back() == '\\')
+		{
+			return false;
+		}
+		bool absolute = map[0] == '/' || map[0] == '\\' || (map.size() > 1 && map[1] == ':');
+		return !absolute;
+	}
+}
+
 ModelClass::ModelClass()
 {
 	m_vertexBuffer = 0;
 	m_indexBuffer = 0;
+	m_boundingRadius = 0.0f;
+	m_vertexFormat = DX::VertexFormatFull;
+	m_buildMeshlets = false;
+	m_quantization = { { 0.0f, 0.0f, 0.0f }, 1.0f };
 
 }
 ModelClass::~ModelClass()
@@ -17,16 +45,32 @@ ModelClass::~ModelClass()
 }
 
 
-bool ModelClass::InitializeModel(ID3D11Device *device, char* filename)
+bool ModelClass::InitializeModel(ID3D11Device *device, const char* filename)
 {
-	LoadModel(filename);
-	InitializeBuffers(device);
-	return false;
+	if (!LoadModel(filename))
+	{
+		return false;
+	}
+	return InitializeBuffers(device);
+}
+
+bool ModelClass::InitializeModelWithLods(ID3D11Device *device, const char* filename, const DX::MeshSimplifier::LodChainOptions& options)
+{
+	if (!LoadModel(filename))
+	{
+		return false;
+	}
+
+	//a model that cannot be simplified still renders at full detail
+	GenerateLods(options);
+	return InitializeBuffers(device);
 }
 
 bool ModelClass::InitializeTeapot(ID3D11Device* device)
 {
-	GeometricPrimitive::CreateTeapot(preFabVertices, preFabIndices, 1, 8, false);
+	std::vector<uint16_t> indices;
+	GeometricPrimitive::CreateTeapot(preFabVertices, indices, 1, 8, false);
+	preFabIndices.assign(indices.begin(), indices.end());
 	m_vertexCount	= preFabVertices.size();
 	m_indexCount	= preFabIndices.size();
 
@@ -42,7 +86,9 @@ bool ModelClass::InitializeTeapot(ID3D11Device* device)
 
 bool ModelClass::InitializeSphere(ID3D11Device *device)
 {
-	GeometricPrimitive::CreateSphere(preFabVertices, preFabIndices, 1, 20, false);
+	std::vector<uint16_t> indices;
+	GeometricPrimitive::CreateSphere(preFabVertices, indices, 1, 20, false);
+	preFabIndices.assign(indices.begin(), indices.end());
 	m_vertexCount = preFabVertices.size();
 	m_indexCount = preFabIndices.size();
 
@@ -58,8 +104,10 @@ bool ModelClass::InitializeSphere(ID3D11Device *device)
 
 bool ModelClass::InitializeBox(ID3D11Device * device, float xwidth, float yheight, float zdepth)
 {
-	GeometricPrimitive::CreateBox(preFabVertices, preFabIndices,
+	std::vector<uint16_t> indices;
+	GeometricPrimitive::CreateBox(preFabVertices, indices,
 		DirectX::SimpleMath::Vector3(xwidth, yheight, zdepth),true);
+	preFabIndices.assign(indices.begin(), indices.end());
 	m_vertexCount = preFabVertices.size();
 	m_indexCount = preFabIndices.size();
 
@@ -141,7 +189,7 @@ bool ModelClass::InitializeQuad(ID3D11Device* device, float xwidth, float yheigh
 }
 
 // Helper for flipping winding of geometric primitives for LH vs. RH coords
-inline void  ModelClass::ReverseWinding(std::vector<uint16_t >& indices, std::vector<VertexPositionNormalTexture>& vertices)
+inline void  ModelClass::ReverseWinding(std::vector<uint32_t >& indices, std::vector<VertexPositionNormalTexture>& vertices)
 {
 	assert((indices.size() % 3) == 0);
 	for (auto it = indices.begin(); it != indices.end(); it += 3)
@@ -170,50 +218,461 @@ void ModelClass::Shutdown()
 
 void ModelClass::Render(ID3D11DeviceContext* deviceContext)
 {
+	Render(deviceContext, 0);
+}
+
+
+int ModelClass::RenderCulled(ID3D11DeviceContext* deviceContext, int lod, const DirectX::SimpleMath::Matrix& world, const DX::Meshlets::Frustum& frustum, const DirectX::SimpleMath::Vector3& cameraPosition,
+	ID3D11ShaderResourceView* defaultTexture)
+{
+	if (m_lods.empty())
+	{
+		return 0;
+	}
+	lod = std::min(std::max(lod, 0), (int)m_lods.size() - 1);
+	if (m_meshlets.empty())
+	{
+		Render(deviceContext, lod, defaultTexture);
+		return (int)m_lods[lod].indexCount / 3;
+	}
+
+	//the normal cones are in model space, so bring the camera there
+	DirectX::SimpleMath::Vector3 modelCamera = DirectX::SimpleMath::Vector3::Transform(cameraPosition, world.Invert());
+	const float camera[3] = { modelCamera.x, modelCamera.y, modelCamera.z };
+
+	//scratch, one per thread, since workers recording on deferred contexts may draw the same model at once
+	thread_local std::vector<DX::Meshlets::DrawRange> drawRanges;
+
+	bool buffersBound = false;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> callerTexture(defaultTexture);
+	ID3D11ShaderResourceView* bound = nullptr;
+	int triangles = 0;
+	for (size_t submesh = 0; submesh < m_lods[lod].submeshes.size(); submesh++)
+	{
+		drawRanges.clear();
+		CullRange(m_lods[lod].submeshes[submesh], world, frustum, camera, drawRanges, nullptr);
+		if (drawRanges.empty())
+		{
+			continue;
+		}
+
+		if (!buffersBound)
+		{
+			RenderBuffers(deviceContext);
+			buffersBound = true;
+		}
+		BindMaterial(deviceContext, (int)submesh, callerTexture, bound);
+		for (const DX::Meshlets::DrawRange& range : drawRanges)
+		{
+			deviceContext->DrawIndexed(range.indexCount, range.indexStart, 0);
+			triangles += range.indexCount / 3;
+		}
+	}
+	BindMaterial(deviceContext, -1, callerTexture, bound);
+	return triangles;
+}
+
+
+void ModelClass::Render(ID3D11DeviceContext* deviceContext, int lod, ID3D11ShaderResourceView* defaultTexture)
+{
+	if (m_lods.empty())
+	{
+		return;
+	}
+	lod = std::min(std::max(lod, 0), (int)m_lods.size() - 1);
+
 	// Put the vertex and index buffers on the graphics pipeline to prepare them for drawing.
 	RenderBuffers(deviceContext);
-	deviceContext->DrawIndexed(m_indexCount, 0, 0);
+
+	//submeshes are sorted by material, so consecutive draws mostly keep the same texture
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> callerTexture(defaultTexture);
+	ID3D11ShaderResourceView* bound = nullptr;
+	const std::vector<Range>& submeshes = m_lods[lod].submeshes;
+	for (size_t submesh = 0; submesh < submeshes.size(); submesh++)
+	{
+		BindMaterial(deviceContext, (int)submesh, callerTexture, bound);
+		deviceContext->DrawIndexed(submeshes[submesh].indexCount, submeshes[submesh].indexStart, 0);
+	}
+	BindMaterial(deviceContext, -1, callerTexture, bound);
 
 	return;
 }
 
 
+void ModelClass::BindMaterial(ID3D11DeviceContext* deviceContext, int submesh, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& callerTexture, ID3D11ShaderResourceView*& bound)
+{
+	//the caller's texture is already bound, and bound stays nullptr while it is. Only a material with a texture of
+	//its own replaces it; untextured submeshes and -1 put the caller's back, if it was replaced
+	ID3D11ShaderResourceView* texture = nullptr;
+	if (submesh >= 0)
+	{
+		int material = m_submeshes[submesh].material;
+		if (material >= 0 && material < (int)m_materialTextures.size() && m_materialTextures[material])
+		{
+			texture = m_materialTextures[material].Get();
+		}
+	}
+	if (texture == bound)
+	{
+		return;
+	}
+	if (texture)
+	{
+		//the caller may not have passed the texture it bound, read it from the slot before replacing it
+		if (!bound && !callerTexture)
+		{
+			deviceContext->PSGetShaderResources(0, 1, callerTexture.ReleaseAndGetAddressOf());
+		}
+		deviceContext->PSSetShaderResources(0, 1, &texture);
+	}
+	else
+	{
+		ID3D11ShaderResourceView* restore = callerTexture.Get();
+		deviceContext->PSSetShaderResources(0, 1, &restore);
+	}
+	bound = texture;
+}
+
+
+int ModelClass::GetSubmeshCount() const
+{
+	return (int)m_submeshes.size();
+}
+
+const std::string& ModelClass::GetSubmeshName(int submesh) const
+{
+	return m_submeshes[submesh].name;
+}
+
+int ModelClass::GetSubmeshMaterial(int submesh) const
+{
+	return m_submeshes[submesh].material;
+}
+
+int ModelClass::GetMaterialCount() const
+{
+	return (int)m_materials.size();
+}
+
+const ModelClass::Material& ModelClass::GetMaterial(int material) const
+{
+	return m_materials[material];
+}
+
+void ModelClass::SetMaterialTexture(int material, ID3D11ShaderResourceView* texture)
+{
+	if (material >= 0 && material < (int)m_materials.size())
+	{
+		m_materialTextures.resize(m_materials.size());
+		m_materialTextures[material] = texture;
+	}
+}
+
+
 int ModelClass::GetIndexCount()
 {
 	return m_indexCount;
 }
 
+bool ModelClass::LoadGeometry(const char* filename)
+{
+	if (!LoadModel(filename))
+	{
+		return false;
+	}
+	ComputeBounds();
+	return true;
+}
+
+bool ModelClass::GenerateLods(const DX::MeshSimplifier::LodChainOptions& options)
+{
+	using DX::MeshSimplifier::Vertex;
+	static_assert(sizeof(Vertex) == sizeof(VertexPositionNormalTexture), "simplifier vertex must match VertexPositionNormalTexture");
+
+	if (preFabVertices.empty() || preFabIndices.empty())
+	{
+		return false;
+	}
+	if (m_lods.empty())
+	{
+		AddSingleLevel();
+	}
+
+	//the obj loader unrolls every triangle, weld first so the simplifier sees connected surfaces
+	std::vector<Vertex> vertices(preFabVertices.size());
+	memcpy(vertices.data(), preFabVertices.data(), vertices.size() * sizeof(Vertex));
+	std::vector<uint32_t> indices(preFabIndices.begin(), preFabIndices.begin() + m_lods[0].indexCount);
+	DX::MeshSimplifier::WeldVertices(vertices, indices);
+
+	//each submesh is simplified on its own so no triangle changes material; the edges between
+	//submeshes are borders to the simplifier, which keeps them from opening up
+	std::vector<std::vector<DX::MeshSimplifier::Lod>> chains;
+	size_t levelCount = 1;
+	for (const Range& range : m_lods[0].submeshes)
+	{
+		std::vector<uint32_t> submeshIndices(indices.begin() + range.indexStart, indices.begin() + range.indexStart + range.indexCount);
+		chains.push_back(DX::MeshSimplifier::GenerateLodChain(vertices, submeshIndices, options));
+		levelCount = std::max(levelCount, chains.back().size());
+	}
+
+	//every level shares the welded vertices, their indices go one after another in the same buffer;
+	//a submesh that ran out of levels repeats its coarsest one
+	preFabVertices.resize(vertices.size());
+	memcpy(preFabVertices.data(), vertices.data(), vertices.size() * sizeof(Vertex));
+	preFabIndices.clear();
+	m_lods.clear();
+	m_lodErrors.clear();
+	for (size_t lod = 0; lod < levelCount; lod++)
+	{
+		LodLevel level;
+		level.indexStart = (UINT)preFabIndices.size();
+		float error = 0.0f;
+		for (const auto& chain : chains)
+		{
+			const DX::MeshSimplifier::Lod& source = chain[std::min(lod, chain.size() - 1)];
+			Range range;
+			range.indexStart = (UINT)preFabIndices.size();
+			range.indexCount = (UINT)source.indices.size();
+			range.meshletStart = 0;
+			range.meshletCount = 0;
+			level.submeshes.push_back(range);
+			preFabIndices.insert(preFabIndices.end(), source.indices.begin(), source.indices.end());
+			error = std::max(error, source.error);
+		}
+		level.indexCount = (UINT)preFabIndices.size() - level.indexStart;
+		m_lods.push_back(level);
+		m_lodErrors.push_back(error);
+	}
+
+	m_vertexCount = (int)preFabVertices.size();
+	m_indexCount = (int)preFabIndices.size();
+	m_meshlets.clear();
+	ComputeBounds();
+	return m_lods.size() > 1;
+}
+
+bool ModelClass::GenerateMeshlets()
+{
+	using DX::MeshSimplifier::Vertex;
+
+	if (preFabVertices.empty() || preFabIndices.empty())
+	{
+		return false;
+	}
+	if (m_lods.empty())
+	{
+		AddSingleLevel();
+	}
+
+	//same layout, see GenerateLods
+	std::vector<Vertex> vertices(preFabVertices.size());
+	memcpy(vertices.data(), preFabVertices.data(), vertices.size() * sizeof(Vertex));
+
+	//meshlets never straddle two submeshes, so each keeps a single material
+	m_meshlets.clear();
+	for (LodLevel& level : m_lods)
+	{
+		for (Range& range : level.submeshes)
+		{
+			range.meshletStart = (UINT)m_meshlets.size();
+			DX::Meshlets::Build(vertices, preFabIndices, range.indexStart, range.indexCount, m_meshlets);
+			range.meshletCount = (UINT)m_meshlets.size() - range.meshletStart;
+		}
+	}
+	return true;
+}
+
+bool ModelClass::HasMeshlets() const
+{
+	return !m_meshlets.empty();
+}
+
+void ModelClass::CullMeshlets(int lod, const DirectX::SimpleMath::Matrix& world, const DX::Meshlets::Frustum& frustum, const DirectX::SimpleMath::Vector3& cameraPosition,
+	std::vector<DX::Meshlets::DrawRange>& ranges, DX::Meshlets::CullStats* stats) const
+{
+	if (m_meshlets.empty() || m_lods.empty())
+	{
+		return;
+	}
+	lod = std::min(std::max(lod, 0), (int)m_lods.size() - 1);
+
+	DirectX::SimpleMath::Vector3 modelCamera = DirectX::SimpleMath::Vector3::Transform(cameraPosition, world.Invert());
+	const float camera[3] = { modelCamera.x, modelCamera.y, modelCamera.z };
+	for (const Range& range : m_lods[lod].submeshes)
+	{
+		CullRange(range, world, frustum, camera, ranges, stats);
+	}
+}
+
+void ModelClass::CullRange(const Range& range, const DirectX::SimpleMath::Matrix& world, const DX::Meshlets::Frustum& frustum, const float modelCamera[3],
+	std::vector<DX::Meshlets::DrawRange>& ranges, DX::Meshlets::CullStats* stats) const
+{
+	if (range.meshletCount)
+	{
+		DX::Meshlets::Cull(&m_meshlets[range.meshletStart], range.meshletCount, &world._11, frustum, modelCamera, ranges, stats);
+	}
+}
+
+void ModelClass::AddSingleLevel()
+{
+	//models built in code have no groups, draw them as one submesh
+	if (m_submeshes.empty())
+	{
+		Submesh submesh;
+		submesh.material = -1;
+		m_submeshes.push_back(submesh);
+	}
+
+	LodLevel level;
+	level.indexStart = 0;
+	level.indexCount = (UINT)preFabIndices.size();
+	Range range;
+	range.indexStart = 0;
+	range.indexCount = level.indexCount;
+	range.meshletStart = 0;
+	range.meshletCount = 0;
+	level.submeshes.push_back(range);
+	m_lods.push_back(level);
+	m_lodErrors.push_back(0.0f);
+}
+
+void ModelClass::SetBuildMeshlets(bool build)
+{
+	assert(!m_vertexBuffer);
+	m_buildMeshlets = build;
+}
+
+int ModelClass::GetLodCount() const
+{
+	return (int)m_lods.size();
+}
+
+int ModelClass::GetLodTriangleCount(int lod) const
+{
+	return (lod >= 0 && lod < (int)m_lods.size()) ? (int)m_lods[lod].indexCount / 3 : 0;
+}
+
+float ModelClass::GetLodError(int lod) const
+{
+	return (lod >= 0 && lod < (int)m_lodErrors.size()) ? m_lodErrors[lod] : 0.0f;
+}
+
+int ModelClass::SelectLod(float worldRadius, float distance, float projectionScale, float maxPixelError) const
+{
+	if (m_lodErrors.empty())
+	{
+		return 0;
+	}
+	return DX::MeshSimplifier::SelectLod(m_lodErrors.data(), (int)m_lodErrors.size(), worldRadius, distance, projectionScale, maxPixelError);
+}
+
+void ModelClass::SetVertexFormat(DX::VertexFormat format)
+{
+	assert(!m_vertexBuffer);
+	m_vertexFormat = format;
+}
+
+DX::VertexFormat ModelClass::GetVertexFormat() const
+{
+	return m_vertexFormat;
+}
+
+int ModelClass::GetVertexCount() const
+{
+	return m_vertexCount;
+}
+
+DirectX::SimpleMath::Matrix ModelClass::GetDequantizeTransform() const
+{
+	return DirectX::SimpleMath::Matrix::CreateScale(m_quantization.scale)
+		* DirectX::SimpleMath::Matrix::CreateTranslation(m_quantization.offset[0], m_quantization.offset[1], m_quantization.offset[2]);
+}
+
+DX::VertexRoundTripError ModelClass::MeasureVertexFormat(DX::VertexFormat format) const
+{
+	//same layout, see GenerateLods
+	return DX::MeasureRoundTrip(format, reinterpret_cast<const DX::MeshSimplifier::Vertex*>(preFabVertices.data()), preFabVertices.size());
+}
+
+DirectX::SimpleMath::Vector3 ModelClass::GetBoundingCenter() const
+{
+	return m_boundingCenter;
+}
+
+float ModelClass::GetBoundingRadius() const
+{
+	return m_boundingRadius;
+}
+
+void ModelClass::ComputeBounds()
+{
+	//same layout, see GenerateLods
+	std::vector<DX::MeshSimplifier::Vertex> vertices(preFabVertices.size());
+	memcpy(vertices.data(), preFabVertices.data(), vertices.size() * sizeof(DX::MeshSimplifier::Vertex));
+
+	float center[3];
+	DX::MeshSimplifier::ComputeBoundingSphere(vertices, center, m_boundingRadius);
+	m_boundingCenter = DirectX::SimpleMath::Vector3(center[0], center[1], center[2]);
+}
+
+void ModelClass::ReleaseGeometry()
+{
+	//swap with empties so the capacity goes too
+	std::vector<VertexPositionNormalTexture>().swap(preFabVertices);
+	std::vector<uint32_t>().swap(preFabIndices);
+}
+
+size_t ModelClass::GetCpuMemoryBytes() const
+{
+	return preFabVertices.capacity() * sizeof(VertexPositionNormalTexture) + preFabIndices.capacity() * sizeof(uint32_t)
+		+ m_meshlets.capacity() * sizeof(DX::Meshlets::Meshlet);
+}
+
+size_t ModelClass::GetGpuMemoryBytes() const
+{
+	//matches the buffer sizes created in InitializeBuffers
+	size_t bytes = 0;
+	if (m_vertexBuffer)
+	{
+		bytes += DX::GetVertexStride(m_vertexFormat) * m_vertexCount;
+	}
+	if (m_indexBuffer)
+	{
+		bytes += sizeof(uint32_t) * m_indexCount;
+	}
+	return bytes;
+}
+
 
 bool ModelClass::InitializeBuffers(ID3D11Device* device)
 {
-	VertexType* vertices;
-	unsigned long* indices;
+	std::vector<uint8_t> vertices;
+	uint32_t* indices;
 	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
     D3D11_SUBRESOURCE_DATA vertexData, indexData;
 	HRESULT result;
 	int i;
 
-	// Create the vertex array.
-	vertices = new VertexType[m_vertexCount];
-	if(!vertices)
+	//models without generated levels draw everything as level 0
+	if (m_lods.empty())
 	{
-		return false;
+		AddSingleLevel();
+	}
+	ComputeBounds();
+	if (m_buildMeshlets && m_meshlets.empty())
+	{
+		GenerateMeshlets();
 	}
 
 	// Create the index array.
-	indices = new unsigned long[m_indexCount];
+	indices = new uint32_t[m_indexCount];
 	if(!indices)
 	{
 		return false;
 	}
 	
-	// Load the vertex array and index array with data from the pre-fab
-	for (i = 0; i < m_vertexCount; i++)
-	{
-		vertices[i].position	= DirectX::SimpleMath::Vector3(preFabVertices[i].position.x, preFabVertices[i].position.y, preFabVertices[i].position.z);
-		vertices[i].texture		= DirectX::SimpleMath::Vector2(preFabVertices[i].textureCoordinate.x, preFabVertices[i].textureCoordinate.y);
-		vertices[i].normal		= DirectX::SimpleMath::Vector3(preFabVertices[i].normal.x, preFabVertices[i].normal.y, preFabVertices[i].normal.z);
-	}
+	// Load the vertex array in the chosen format and the index array with data from the pre-fab
+	m_quantization = DX::EncodeVertices(m_vertexFormat, reinterpret_cast<const DX::MeshSimplifier::Vertex*>(preFabVertices.data()), m_vertexCount, vertices);
 	for (i = 0; i < m_indexCount; i++)
 	{
 		indices[i] = preFabIndices[i];
@@ -221,14 +680,14 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 
 	// Set up the description of the static vertex buffer.
     vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    vertexBufferDesc.ByteWidth = sizeof(VertexType) * m_vertexCount;
+    vertexBufferDesc.ByteWidth = (UINT)vertices.size();
     vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vertexBufferDesc.CPUAccessFlags = 0;
     vertexBufferDesc.MiscFlags = 0;
 	vertexBufferDesc.StructureByteStride = 0;
 
 	// Give the subresource structure a pointer to the vertex data.
-    vertexData.pSysMem = vertices;
+    vertexData.pSysMem = vertices.data();
 	vertexData.SysMemPitch = 0;
 	vertexData.SysMemSlicePitch = 0;
 
@@ -241,7 +700,7 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 
 	// Set up the description of the static index buffer.
     indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_indexCount;
+    indexBufferDesc.ByteWidth = sizeof(uint32_t) * m_indexCount;	//DXGI_FORMAT_R32_UINT, see RenderBuffers
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
     indexBufferDesc.CPUAccessFlags = 0;
     indexBufferDesc.MiscFlags = 0;
@@ -260,9 +719,6 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 	}
 
 	// Release the arrays now that the vertex and index buffers have been created and loaded.
-	delete [] vertices;
-	vertices = 0;
-
 	delete [] indices;
 	indices = 0;
 
@@ -296,7 +752,7 @@ void ModelClass::RenderBuffers(ID3D11DeviceContext* deviceContext)
 	unsigned int offset;
 
 	// Set vertex buffer stride and offset.
-	stride = sizeof(VertexType); 
+	stride = (unsigned int)DX::GetVertexStride(m_vertexFormat);
 	offset = 0;
     
 	// Set the vertex buffer to active in the input assembler so it can be rendered.
@@ -312,56 +768,92 @@ void ModelClass::RenderBuffers(ID3D11DeviceContext* deviceContext)
 }
 
 
-bool ModelClass::LoadModel(char* filename)
+bool ModelClass::LoadModel(const char* filename)
 {
 	std::vector<XMFLOAT3> verts;
 	std::vector<XMFLOAT3> norms;
 	std::vector<XMFLOAT2> texCs;
 	std::vector<unsigned int> faces;
-
-	FILE* file;// = fopen(filename, "r");
-	errno_t err;
-	err = fopen_s(&file, filename, "r");
-	if (err != 0)
-		//if (file == NULL)
+	std::vector<int> faceSubmeshes;		//submesh of every face, in file order
+
+	//o / g name the group and usemtl its material; every distinct pair becomes a submesh
+	std::string groupName;
+	int material = -1;
+	int submesh = -1;
+	std::string directory(filename);
+	size_t slash = directory.find_last_of("/\\");
+	directory = (slash == std::string::npos) ? std::string() : directory.substr(0, slash + 1);
+
+	//read the whole file up front, from the mounted asset pack if it has it
+	std::vector<uint8_t> fileData;
+	if (!ReadModelFile(filename, fileData))
 	{
 		return false;
 	}
 
-	while (true)
+	const char* cursor = reinterpret_cast<const char*>(fileData.data());
+	const char* end = cursor + fileData.size();
+	std::string line;
+
+	while (cursor < end)
 	{
+		const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+		if (!lineEnd)
+		{
+			lineEnd = end;
+		}
+		line.assign(cursor, lineEnd);
+		cursor = lineEnd + 1;
+
 		char lineHeader[128];
 
 		// Read first word of the line
-		int res = fscanf_s(file, "%s", lineHeader, sizeof(lineHeader));
-		if (res == EOF)
+		int headerLength = 0;
+		int res = sscanf_s(line.c_str(), "%127s%n", lineHeader, (unsigned)sizeof(lineHeader), &headerLength);
+		if (res != 1)
 		{
-			break; // exit loop
+			continue; // empty line
 		}
 		else // Parse
 		{
+			const char* values = line.c_str() + headerLength;
+
 			if (strcmp(lineHeader, "v") == 0) // Vertex
 			{
 				XMFLOAT3 vertex;
-				fscanf_s(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
+				sscanf_s(values, "%f %f %f", &vertex.x, &vertex.y, &vertex.z);
 				verts.push_back(vertex);
 			}
 			else if (strcmp(lineHeader, "vt") == 0) // Tex Coord
 			{
 				XMFLOAT2 uv;
-				fscanf_s(file, "%f %f\n", &uv.x, &uv.y);
+				sscanf_s(values, "%f %f", &uv.x, &uv.y);
 				texCs.push_back(uv);
 			}
 			else if (strcmp(lineHeader, "vn") == 0) // Normal
 			{
 				XMFLOAT3 normal;
-				fscanf_s(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
+				sscanf_s(values, "%f %f %f", &normal.x, &normal.y, &normal.z);
 				norms.push_back(normal);
 			}
+			else if (strcmp(lineHeader, "mtllib") == 0) // Material library, next to the obj
+			{
+				LoadMaterials((directory + TrimName(values)).c_str());
+			}
+			else if (strcmp(lineHeader, "usemtl") == 0)
+			{
+				material = FindMaterial(TrimName(values));
+				submesh = -1;
+			}
+			else if (strcmp(lineHeader, "o") == 0 || strcmp(lineHeader, "g") == 0)
+			{
+				groupName = TrimName(values);
+				submesh = -1;
+			}
 			else if (strcmp(lineHeader, "f") == 0) // Face
 			{
 				unsigned int face[9];
-				int matches = fscanf_s(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &face[0], &face[1], &face[2],
+				int matches = sscanf_s(values, "%d/%d/%d %d/%d/%d %d/%d/%d", &face[0], &face[1], &face[2],
 					&face[3], &face[4], &face[5],
 					&face[6], &face[7], &face[8]);
 				if (matches != 9)
@@ -375,6 +867,25 @@ bool ModelClass::LoadModel(char* filename)
 					faces.push_back(face[i]);
 				}
 
+				if (submesh < 0)
+				{
+					for (size_t s = 0; s < m_submeshes.size() && submesh < 0; s++)
+					{
+						if (m_submeshes[s].name == groupName && m_submeshes[s].material == material)
+						{
+							submesh = (int)s;
+						}
+					}
+					if (submesh < 0)
+					{
+						Submesh added;
+						added.name = groupName;
+						added.material = material;
+						submesh = (int)m_submeshes.size();
+						m_submeshes.push_back(added);
+					}
+				}
+				faceSubmeshes.push_back(submesh);
 
 			}
 		}
@@ -404,13 +915,50 @@ bool ModelClass::LoadModel(char* filename)
 
 		//increase index count
 		preFabVertices.push_back(tempVertex);
-		
-		int tempIndex;
-		tempIndex = vIndex;
-		preFabIndices.push_back(tempIndex);
 		vIndex++;
 	}
 
+	//every face is three unrolled vertices; group the faces by submesh, and the submeshes by
+	//material so a renderer walking them in order changes textures as little as possible
+	std::vector<int> order(m_submeshes.size());
+	for (size_t s = 0; s < order.size(); s++)
+	{
+		order[s] = (int)s;
+	}
+	std::stable_sort(order.begin(), order.end(), [this](int a, int b) { return m_submeshes[a].material < m_submeshes[b].material; });
+
+	std::vector<std::vector<uint32_t>> submeshFaces(m_submeshes.size());
+	for (size_t f = 0; f < faceSubmeshes.size(); f++)
+	{
+		submeshFaces[faceSubmeshes[f]].push_back((uint32_t)f);
+	}
+
+	LodLevel level;
+	level.indexStart = 0;
+	std::vector<Submesh> sorted;
+	for (int s : order)
+	{
+		Range range;
+		range.indexStart = (UINT)preFabIndices.size();
+		range.meshletStart = 0;
+		range.meshletCount = 0;
+		for (uint32_t f : submeshFaces[s])
+		{
+			preFabIndices.push_back(f * 3 + 0);
+			preFabIndices.push_back(f * 3 + 1);
+			preFabIndices.push_back(f * 3 + 2);
+		}
+		range.indexCount = (UINT)preFabIndices.size() - range.indexStart;
+		level.submeshes.push_back(range);
+		sorted.push_back(m_submeshes[s]);
+	}
+	level.indexCount = (UINT)preFabIndices.size();
+	m_submeshes.swap(sorted);
+	m_lods.clear();
+	m_lodErrors.clear();
+	m_lods.push_back(level);
+	m_lodErrors.push_back(0.0f);
+
 	m_indexCount = vIndex;
 
 	verts.clear();
@@ -421,6 +969,123 @@ bool ModelClass::LoadModel(char* filename)
 }
 
 
+bool ModelClass::LoadMaterials(const char* filename)
+{
+	std::vector<uint8_t> fileData;
+	if (!ReadModelFile(filename, fileData))
+	{
+		return false;
+	}
+
+	std::string directory(filename);
+	size_t slash = directory.find_last_of("/\\");
+	directory = (slash == std::string::npos) ? std::string() : directory.substr(0, slash + 1);
+
+	const char* cursor = reinterpret_cast<const char*>(fileData.data());
+	const char* end = cursor + fileData.size();
+	std::string line;
+	Material* current = nullptr;
+
+	while (cursor < end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+		if (!lineEnd)
+		{
+			lineEnd = end;
+		}
+		line.assign(cursor, lineEnd);
+		cursor = lineEnd + 1;
+
+		char lineHeader[128];
+		int headerLength = 0;
+		if (sscanf_s(line.c_str(), "%127s%n", lineHeader, (unsigned)sizeof(lineHeader), &headerLength) != 1)
+		{
+			continue;
+		}
+		const char* values = line.c_str() + headerLength;
+
+		if (strcmp(lineHeader, "newmtl") == 0)
+		{
+			current = &m_materials[FindMaterial(TrimName(values))];
+		}
+		else if (!current)
+		{
+			continue;
+		}
+		else if (strcmp(lineHeader, "Kd") == 0)
+		{
+			sscanf_s(values, "%f %f %f", &current->diffuse.x, &current->diffuse.y, &current->diffuse.z);
+		}
+		else if (strcmp(lineHeader, "map_Kd") == 0)
+		{
+			//options such as -s come first, the file name is last
+			std::string map = TrimName(values);
+			size_t space = map.find_last_of(" \t");
+			if (space != std::string::npos)
+			{
+				map = map.substr(space + 1);
+			}
+			if (IsShippedMapName(map))
+			{
+				current->diffuseMap = directory + map;
+			}
+		}
+	}
+	return true;
+}
+
+int ModelClass::FindMaterial(const std::string& name)
+{
+	//usemtl may name a material before (or without) its mtllib, it simply stays untextured
+	for (size_t m = 0; m < m_materials.size(); m++)
+	{
+		if (m_materials[m].name == name)
+		{
+			return (int)m;
+		}
+	}
+
+	Material material;
+	material.name = name;
+	material.diffuse = DirectX::SimpleMath::Vector3(0.8f, 0.8f, 0.8f);
+	m_materials.push_back(material);
+	return (int)m_materials.size() - 1;
+}
+
+
+bool ModelClass::ReadModelFile(const char* filename, std::vector<uint8_t>& fileData)
+{
+	DX::AssetPack* pack = DX::AssetPack::GetMounted();
+	if (pack)
+	{
+		//pack names are wide, model paths are plain ASCII
+		std::wstring name(filename, filename + strlen(filename));
+		if (pack->ReadEntry(name.c_str(), fileData))
+		{
+			return true;
+		}
+	}
+
+	FILE* file;// = fopen(filename, "r");
+	errno_t err;
+	err = fopen_s(&file, filename, "rb");
+	if (err != 0)
+		//if (file == NULL)
+	{
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	fileData.resize(length > 0 ? (size_t)length : 0);
+	size_t bytesRead = fread(fileData.data(), 1, fileData.size(), file);
+	fclose(file);
+
+	return bytesRead == fileData.size();
+}
+
 void ModelClass::ReleaseModel()
 {
 	return;
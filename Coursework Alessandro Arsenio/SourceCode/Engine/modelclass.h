@@ -9,6 +9,9 @@
 // INCLUDES //
 //////////////
 #include "pch.h"
+#include "MeshSimplifier.h"
+#include "VertexFormat.h"
+#include "Meshlets.h"
 //#include <d3dx10math.h>
 //#include <fstream>
 //using namespace std;
@@ -21,35 +24,121 @@ using namespace DirectX;
 
 class ModelClass
 {
-private:
-	struct VertexType
+public:
+	//from the .mtl named by the obj's mtllib
+	struct Material
 	{
-		DirectX::SimpleMath::Vector3 position;
-		DirectX::SimpleMath::Vector2 texture;
-		DirectX::SimpleMath::Vector3 normal;
+		std::string name;
+		DirectX::SimpleMath::Vector3 diffuse;
+		std::string diffuseMap;		//map_Kd, relative to the obj's folder; empty when untextured or the .mtl names a path that is not shipped
 	};
 
-public:
 	ModelClass();
 	~ModelClass();
 
-	bool InitializeModel(ID3D11Device *device, char* filename);
+	bool InitializeModel(ID3D11Device *device, const char* filename);
+	bool InitializeModelWithLods(ID3D11Device *device, const char* filename, const DX::MeshSimplifier::LodChainOptions& options);
 	bool InitializeTeapot(ID3D11Device*);
 	bool InitializeSphere(ID3D11Device*);
 	bool InitializeBox(ID3D11Device*, float xwidth, float yheight, float zdepth);
 	bool InitializeQuad(ID3D11Device* device, float xwidth, float yheight,float zdepth);
 	void Shutdown();
 	void Render(ID3D11DeviceContext*);
+	void Render(ID3D11DeviceContext*, int lod, ID3D11ShaderResourceView* defaultTexture = nullptr);
+
+	//draws the meshlets of the level that pass the frustum and normal cone tests, returns the triangles drawn
+	int RenderCulled(ID3D11DeviceContext*, int lod, const DirectX::SimpleMath::Matrix& world, const DX::Meshlets::Frustum& frustum, const DirectX::SimpleMath::Vector3& cameraPosition,
+		ID3D11ShaderResourceView* defaultTexture = nullptr);
+
+	//submeshes are the o / g / usemtl groups of the obj, kept in one buffer and drawn in material order.
+	//a submesh whose material has a texture binds it, the others draw with the texture the caller bound
+	int GetSubmeshCount() const;
+	const std::string& GetSubmeshName(int submesh) const;
+	int GetSubmeshMaterial(int submesh) const;		//-1 when the group has no material
+	int GetMaterialCount() const;
+	const Material& GetMaterial(int material) const;
+	void SetMaterialTexture(int material, ID3D11ShaderResourceView* texture);
 	
 	int GetIndexCount();
 
+	//CPU side only, for tools that inspect the geometry without a device
+	bool LoadGeometry(const char* filename);
+
+	//welds the loaded geometry and appends the simplified levels to the index list
+	bool GenerateLods(const DX::MeshSimplifier::LodChainOptions& options);
+	int GetLodCount() const;
+	int GetLodTriangleCount(int lod) const;
+	float GetLodError(int lod) const;
+
+	//coarsest level whose error covers at most maxPixelError pixels; radius is in world units
+	int SelectLod(float worldRadius, float distance, float projectionScale, float maxPixelError) const;
+
+	//splits every level into meshlets for RenderCulled, reordering its indices
+	bool GenerateMeshlets();
+	bool HasMeshlets() const;
+	void CullMeshlets(int lod, const DirectX::SimpleMath::Matrix& world, const DX::Meshlets::Frustum& frustum, const DirectX::SimpleMath::Vector3& cameraPosition,
+		std::vector<DX::Meshlets::DrawRange>& ranges, DX::Meshlets::CullStats* stats = nullptr) const;
+
+	//build meshlets when the model is initialized
+	void SetBuildMeshlets(bool build);
+
+	//format of the vertex buffer, must be chosen before the model is initialized
+	void SetVertexFormat(DX::VertexFormat format);
+	DX::VertexFormat GetVertexFormat() const;
+	int GetVertexCount() const;
+
+	//maps the stored positions back to model space, apply before the world matrix
+	DirectX::SimpleMath::Matrix GetDequantizeTransform() const;
+
+	//encodes the loaded geometry in another format and compares it against the original
+	DX::VertexRoundTripError MeasureVertexFormat(DX::VertexFormat format) const;
+
+	//model space bounding sphere
+	DirectX::SimpleMath::Vector3 GetBoundingCenter() const;
+	float GetBoundingRadius() const;
+
+	//frees the CPU copy of the geometry once the GPU buffers exist
+	void ReleaseGeometry();
+	size_t GetCpuMemoryBytes() const;
+	size_t GetGpuMemoryBytes() const;
+
 
 private:
+	struct Submesh
+	{
+		std::string name;
+		int material;
+	};
+
+	struct Range
+	{
+		UINT indexStart;
+		UINT indexCount;
+		UINT meshletStart;
+		UINT meshletCount;
+	};
+
+	//ranges of the index buffer, level 0 is the full mesh; each level has one range per submesh, back to back
+	struct LodLevel
+	{
+		UINT indexStart;
+		UINT indexCount;
+		std::vector<Range> submeshes;
+	};
+
 	bool InitializeBuffers(ID3D11Device*);
 	void ShutdownBuffers();
 	void RenderBuffers(ID3D11DeviceContext*);
-	bool LoadModel(char*);
-	inline void ReverseWinding(std::vector<uint16_t >& indices, std::vector<VertexPositionNormalTexture>& vertices);
+	bool LoadModel(const char*);
+	bool LoadMaterials(const char* filename);
+	int FindMaterial(const std::string& name);
+	bool ReadModelFile(const char* filename, std::vector<uint8_t>& fileData);
+	inline void ReverseWinding(std::vector<uint32_t >& indices, std::vector<VertexPositionNormalTexture>& vertices);
+	void ComputeBounds();
+	void AddSingleLevel();
+	void CullRange(const Range& range, const DirectX::SimpleMath::Matrix& world, const DX::Meshlets::Frustum& frustum, const float modelCamera[3],
+		std::vector<DX::Meshlets::DrawRange>& ranges, DX::Meshlets::CullStats* stats) const;
+	void BindMaterial(ID3D11DeviceContext*, int submesh, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& callerTexture, ID3D11ShaderResourceView*& bound);
 	void ReleaseModel();
 
 private:
@@ -58,7 +147,23 @@ private:
 
 	//arrays for our generated objects Made by directX
 	std::vector<VertexPositionNormalTexture> preFabVertices;
-	std::vector<uint16_t> preFabIndices;
+	std::vector<uint32_t> preFabIndices;
+
+	std::vector<Submesh> m_submeshes;
+	std::vector<Material> m_materials;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> m_materialTextures;
+
+	std::vector<LodLevel> m_lods;
+	std::vector<float> m_lodErrors;		//relative to m_boundingRadius
+
+	std::vector<DX::Meshlets::Meshlet> m_meshlets;
+	bool m_buildMeshlets;
+
+	DX::VertexFormat m_vertexFormat;
+	DX::VertexQuantization m_quantization;
+
+	DirectX::SimpleMath::Vector3 m_boundingCenter;
+	float m_boundingRadius;
 
 };
 
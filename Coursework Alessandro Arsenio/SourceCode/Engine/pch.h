@@ -5,6 +5,19 @@
 
 #pragma once
 
+// The simulation core and the headless driver define ENGINE_HEADLESS and see only the standard
+// library, see CMakeLists.txt. Everything else is the Windows game.
+#ifdef ENGINE_HEADLESS
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+
+#include <stdio.h>
+
+#else
+
 #include <WinSDKVer.h>
 #ifndef _WIN32_WINNT
 #define _WIN32_WINNT 0x0600
@@ -90,4 +103,6 @@ namespace DX
             throw com_exception(hr);
         }
     }
-}
\ No newline at end of file
+}
+
+#endif